@@ -32,6 +32,7 @@
 #include "linden_common.h"
 
 #include "llcommon.h"
+#include "llstringtable.h"
 #include "llthread.h"
 
 //static
@@ -40,6 +41,7 @@ void LLCommon::initClass()
 	LLMemory::initClass();
 	LLTimer::initClass();
 	LLThreadSafeRefCount::initThreadSafeRefCount();
+	gStringTable.initThreadSafety();
 // 	LLWorkerThread::initClass();
 // 	LLFrameCallbackManager::initClass();
 }
@@ -49,6 +51,8 @@ void LLCommon::cleanupClass()
 {
 // 	LLFrameCallbackManager::cleanupClass();
 // 	LLWorkerThread::cleanupClass();
+	gStringTable.dumpStats();
+	gStringTable.cleanupThreadSafety();
 	LLThreadSafeRefCount::cleanupThreadSafeRefCount();
 	LLTimer::cleanupClass();
 	LLMemory::cleanupClass();
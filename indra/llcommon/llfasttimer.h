@@ -35,6 +35,7 @@
 
 #define FAST_TIMER_ON 1
 
+#include "llfasttimertrace.h"
 
 class LL_COMMON_API LLFastTimer
 {
@@ -253,6 +254,8 @@ public:
 
 		sStart[sCurDepth] = cpu_clocks;
 		sCurDepth++;
+
+		mTraceStart = LLFastTimerTrace::isEnabled() ? getCPUClockCount64() : 0;
 #endif
 	};
 	~LLFastTimer()
@@ -273,6 +276,11 @@ public:
 		// Subtract delta from parents
 		for (i=0; i<sCurDepth; i++)
 			sStart[i] += delta;
+
+		if (mTraceStart)
+		{
+			LLFastTimerTrace::record(mType, mTraceStart, getCPUClockCount64());
+		}
 #endif
 	}
 
@@ -300,6 +308,7 @@ public:
 	static S32 sLastFrameIndex;
 	
 	EFastTimerType mType;
+	U64 mTraceStart;	// 0 unless LLFastTimerTrace is recording
 };
 
 
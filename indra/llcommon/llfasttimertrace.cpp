@@ -0,0 +1,297 @@
+/**
+ * @file llfasttimertrace.cpp
+ * @brief Ring buffer recording of individual LLFastTimer intervals
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ *
+ * Copyright (c) 2011, Linden Research, Inc.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llfasttimertrace.h"
+
+#include <fstream>
+#include <vector>
+
+#include "aithreadsafe.h"
+#include "llfasttimer.h"
+
+// Per thread capacity.  The main thread records a few thousand intervals
+// per frame, so this holds several seconds of it.  32 bytes an event.
+static const U32 TRACE_BUFFER_EVENTS = 1 << 18;
+
+namespace
+{
+	struct TraceEvent
+	{
+		U64 mStart;
+		U64 mEnd;
+		const char* mName;		// NULL for LLFastTimer types
+		S32 mType;
+	};
+
+	// Written only by its own thread, read by dump().
+	struct TraceBuffer
+	{
+		TraceBuffer(const std::string& name, U32 id)
+			: mName(name), mID(id), mEvents(new TraceEvent[TRACE_BUFFER_EVENTS]), mWritten(0), mFull(false) {}
+
+		const std::string mName;
+		const U32 mID;
+		TraceEvent* const mEvents;
+		LLAtomicU32 mWritten;	// total events recorded, wraps
+		volatile bool mFull;	// mWritten has reached TRACE_BUFFER_EVENTS at least once
+	};
+
+	typedef std::vector<TraceBuffer*> buffer_list_t;
+
+	// Buffers are never freed; a thread that exits leaves its history behind.
+	AIThreadSafeSimple<buffer_list_t>& buffers()
+	{
+		static AIThreadSafeSimpleDCRootPool<buffer_list_t>* buffers_ptr = new AIThreadSafeSimpleDCRootPool<buffer_list_t>;
+		return *buffers_ptr;
+	}
+
+	ll_thread_local TraceBuffer* tThreadBuffer = NULL;
+	ll_thread_local char tThreadName[64];
+
+	std::vector<std::string> sTimerNames;
+
+	TraceBuffer* create_thread_buffer()
+	{
+		AIAccess<buffer_list_t> buffer_list(buffers());
+		std::string name(tThreadName);
+		if (name.empty())
+		{
+			name = llformat("thread %u", LLThread::currentID());
+		}
+		tThreadBuffer = new TraceBuffer(name, buffer_list->size() + 1);
+		buffer_list->push_back(tThreadBuffer);
+		return tThreadBuffer;
+	}
+
+	inline void record_event(S32 type, const char* name, U64 start, U64 end)
+	{
+		TraceBuffer* buffer = tThreadBuffer ? tThreadBuffer : create_thread_buffer();
+		U32 written = buffer->mWritten;
+		TraceEvent& event = buffer->mEvents[written & (TRACE_BUFFER_EVENTS - 1)];
+		event.mStart = start;
+		event.mEnd = end;
+		event.mName = name;
+		event.mType = type;
+		if (written + 1 == TRACE_BUFFER_EVENTS)
+		{
+			buffer->mFull = true;
+		}
+		// Publish the event.
+		buffer->mWritten = written + 1;
+	}
+
+	void write_json_string(std::ostream& out, const std::string& str)
+	{
+		out << '"';
+		for (std::string::const_iterator iter = str.begin(); iter != str.end(); ++iter)
+		{
+			if (*iter == '"' || *iter == '\\')
+			{
+				out << '\\';
+			}
+			if ((U8)*iter >= 0x20)
+			{
+				out << *iter;
+			}
+		}
+		out << '"';
+	}
+}
+
+bool LLFastTimerTrace::sEnabled = false;
+
+//static
+void LLFastTimerTrace::setThreadName(const std::string& name)
+{
+	strncpy(tThreadName, name.c_str(), sizeof(tThreadName) - 1);
+	tThreadName[sizeof(tThreadName) - 1] = '\0';
+}
+
+//static
+void LLFastTimerTrace::setTimerName(S32 type, const std::string& name)
+{
+	if (type < 0)
+	{
+		return;
+	}
+	if ((S32)sTimerNames.size() <= type)
+	{
+		sTimerNames.resize(type + 1);
+	}
+	sTimerNames[type] = name;
+}
+
+//static
+std::string LLFastTimerTrace::getTimerName(S32 type)
+{
+	if (type >= 0 && type < (S32)sTimerNames.size() && !sTimerNames[type].empty())
+	{
+		return sTimerNames[type];
+	}
+	return llformat("Timer %d", type);
+}
+
+//static
+void LLFastTimerTrace::setEnabled(bool enabled)
+{
+	if (enabled != sEnabled)
+	{
+		// Make sure the buffer list exists before any other thread needs it.
+		buffers();
+		sEnabled = enabled;
+		llinfos << "Fast timer trace " << (enabled ? "enabled" : "disabled") << llendl;
+	}
+}
+
+//static
+void LLFastTimerTrace::record(S32 type, U64 start, U64 end)
+{
+	record_event(type, NULL, start, end);
+}
+
+//static
+void LLFastTimerTrace::record(const char* name, U64 start, U64 end)
+{
+	record_event(-1, name, start, end);
+}
+
+//static
+bool LLFastTimerTrace::dump(const std::string& filename, F32 seconds)
+{
+	std::ofstream out(filename.c_str());
+	if (!out.is_open())
+	{
+		llwarns << "Unable to write fast timer trace to " << filename << llendl;
+		return false;
+	}
+	dump(out, seconds);
+	out.close();
+	if (out.fail())
+	{
+		llwarns << "Error writing fast timer trace to " << filename << llendl;
+		return false;
+	}
+	llinfos << "Wrote the last " << seconds << " seconds of fast timer trace to " << filename << llendl;
+	return true;
+}
+
+//static
+void LLFastTimerTrace::dump(std::ostream& out, F32 seconds)
+{
+	const U64 now = get_clock_count();
+	const F64 clocks_per_usec = (F64)LLFastTimer::sClockResolution / 1000000.0;
+	const U64 window = (U64)((F64)seconds * (F64)LLFastTimer::sClockResolution);
+	const U64 cutoff = now > window ? now - window : 0;
+
+	// Snapshot the buffers first, so the file doesn't slow the recording threads.
+	typedef std::vector<TraceEvent> event_list_t;
+	std::vector<std::pair<const TraceBuffer*, event_list_t> > snapshots;
+	{
+		AIAccess<buffer_list_t> buffer_list(buffers());
+		for (buffer_list_t::const_iterator iter = buffer_list->begin(); iter != buffer_list->end(); ++iter)
+		{
+			TraceBuffer* buffer = *iter;
+			snapshots.push_back(std::make_pair(buffer, event_list_t()));
+			event_list_t& events = snapshots.back().second;
+
+			bool full = buffer->mFull;
+			U32 written = buffer->mWritten;
+			U32 count = full ? TRACE_BUFFER_EVENTS : llmin(written, TRACE_BUFFER_EVENTS);
+			U32 first = written - count;
+			events.reserve(count);
+			for (U32 i = first; i != written; i++)
+			{
+				events.push_back(buffer->mEvents[i & (TRACE_BUFFER_EVENTS - 1)]);
+			}
+
+			// Drop what the owning thread overwrote while we were copying,
+			// including the slot it may be writing right now.
+			S64 overwritten = (S64)((U32)buffer->mWritten - written) + 1 - (S64)(TRACE_BUFFER_EVENTS - count);
+			if (overwritten > 0)
+			{
+				events.erase(events.begin(), events.begin() + llmin((U32)overwritten, count));
+			}
+			if (!events.empty() && count == TRACE_BUFFER_EVENTS && events.front().mEnd > cutoff)
+			{
+				llinfos << "Fast timer trace of " << buffer->mName << " is shorter than " << seconds
+						<< " seconds, the ring buffer wrapped" << llendl;
+			}
+		}
+	}
+
+	U64 base = now;
+	for (size_t i = 0; i < snapshots.size(); i++)
+	{
+		const event_list_t& events = snapshots[i].second;
+		for (event_list_t::const_iterator iter = events.begin(); iter != events.end(); ++iter)
+		{
+			if (iter->mEnd >= cutoff)
+			{
+				base = llmin(base, iter->mStart);
+			}
+		}
+	}
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first_event = true;
+	for (size_t i = 0; i < snapshots.size(); i++)
+	{
+		const TraceBuffer* buffer = snapshots[i].first;
+		if (!first_event)
+		{
+			out << ",\n";
+		}
+		first_event = false;
+		out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->mID << ",\"args\":{\"name\":";
+		write_json_string(out, buffer->mName);
+		out << "}}";
+
+		const event_list_t& events = snapshots[i].second;
+		for (event_list_t::const_iterator iter = events.begin(); iter != events.end(); ++iter)
+		{
+			const TraceEvent& event = *iter;
+			if (event.mEnd < cutoff)
+			{
+				continue;
+			}
+			out << ",\n{\"name\":";
+			write_json_string(out, event.mName ? std::string(event.mName) : getTimerName(event.mType));
+			out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->mID
+				<< llformat(",\"ts\":%.3f,\"dur\":%.3f}",
+							(F64)(event.mStart - base) / clocks_per_usec,
+							(F64)(event.mEnd - event.mStart) / clocks_per_usec);
+		}
+	}
+	out << "\n]}\n";
+}
@@ -0,0 +1,92 @@
+/**
+ * @file llfasttimertrace.h
+ * @brief Ring buffer recording of individual LLFastTimer intervals
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ *
+ * Copyright (c) 2011, Linden Research, Inc.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFASTTIMERTRACE_H
+#define LL_LLFASTTIMERTRACE_H
+
+#include <iosfwd>
+#include <string>
+
+#include "lltimer.h"
+
+// While enabled, every LLFastTimer interval and every LLQueuedThread request
+// is recorded, with the thread it ran on, into a per thread ring buffer.
+// dump() writes the most recent intervals as a Chrome trace event file that
+// chrome://tracing and Perfetto can load, to see what actually happened
+// during a hitch rather than the per frame totals of the fast timer view.
+//
+// Recording is lock free; each thread only writes its own buffer.
+class LL_COMMON_API LLFastTimerTrace
+{
+public:
+	// Names the calling thread in dumps.  LLThread does this for its threads.
+	static void setThreadName(const std::string& name);
+	// Display name of an LLFastTimer type.  Unnamed types are shown by number.
+	static void setTimerName(S32 type, const std::string& name);
+	static std::string getTimerName(S32 type);
+
+	// Buffers are allocated per thread the first time it records, and kept.
+	static void setEnabled(bool enabled);
+	static bool isEnabled()			{ return sEnabled; }
+
+	// Any thread.  Times are get_clock_count() values.
+	static void record(S32 type, U64 start, U64 end);
+	static void record(const char* name, U64 start, U64 end);	// name must be a string literal
+
+	// Writes the intervals that ended in the last seconds.  Returns false on failure.
+	static bool dump(const std::string& filename, F32 seconds);
+	static void dump(std::ostream& out, F32 seconds);
+
+	// Records the enclosing scope on any thread, like an LLFastTimer without the totals.
+	class Scope
+	{
+	public:
+		Scope(const char* name)
+			: mName(name), mStart(sEnabled ? get_clock_count() : 0) {}
+		~Scope()
+		{
+			if (mStart)
+			{
+				record(mName, mStart, get_clock_count());
+			}
+		}
+
+	private:
+		const char* mName;
+		U64 mStart;
+	};
+
+private:
+	static bool sEnabled;
+};
+
+#endif // LL_LLFASTTIMERTRACE_H
@@ -32,6 +32,7 @@
 #include "linden_common.h"
 #include "llqueuedthread.h"
 
+#include "llfasttimertrace.h"
 #include "llstl.h"
 #include "lltimer.h"	// ms_sleep()
 
@@ -447,7 +448,11 @@ S32 LLQueuedThread::processNextRequest()
 	if (req)
 	{
 		// process request
-		bool complete = req->processRequest();
+		bool complete;
+		{
+			LLFastTimerTrace::Scope trace("Process Request");
+			complete = req->processRequest();
+		}
 
 		if (complete)
 		{
@@ -35,6 +35,7 @@
 
 #include "llstringtable.h"
 #include "llstl.h"
+#include "llthread.h"
 
 LLStringTable gStringTable(32768);
 
@@ -55,8 +56,30 @@ LLStringTableEntry::~LLStringTableEntry()
 	mCount = 0;
 }
 
+// Per-thread direct mapped cache of recent lookups, shared by all tables.
+// Entries are validated against the owning table and the global removal
+// generation, then by string compare, so a stale slot is only ever a miss.
+// Removed entries are retired rather than freed (see removeString()), so the
+// entry a slot points at stays valid until the next quiescent point.
+const U32 STRING_TABLE_THREAD_CACHE_SIZE = 256;	// power of 2
+
+struct LLStringTableCacheSlot
+{
+	const LLStringTable*	mTable;
+	U32						mGeneration;
+	LLStringTableEntry*		mEntry;
+};
+
+static ll_thread_local LLStringTableCacheSlot sThreadCache[STRING_TABLE_THREAD_CACHE_SIZE];
+
+// Bumped whenever any table deletes an entry or is destroyed, invalidating all thread caches.
+static LLAtomicU32 sCacheGeneration(1);
+
 LLStringTable::LLStringTable(int tablesize)
-: mUniqueEntries(0)
+: mUniqueEntries(0),
+  mCacheHits(0),
+  mCacheMisses(0),
+  mContendedLocks(0)
 {
 	S32 i;
 	if (!tablesize)
@@ -73,9 +96,13 @@ LLStringTable::LLStringTable(int tablesize)
 			break;
 		}
 	}
-	mMaxEntries = tablesize;
+	mMaxEntries = llmax(tablesize, (S32)STRING_TABLE_SHARDS);
+
+	for (U32 shard = 0; shard < STRING_TABLE_SHARDS; shard++)
+	{
+		mShardMutex[shard] = NULL;
+	}
 
-#if !STRING_TABLE_HASH_MAP
 	// ALlocate strings
 	mStringList = new string_list_ptr_t[mMaxEntries];
 	// Clear strings
@@ -83,12 +110,13 @@ LLStringTable::LLStringTable(int tablesize)
 	{
 		mStringList[i] = NULL;
 	}
-#endif
 }
 
 LLStringTable::~LLStringTable()
 {
-#if !STRING_TABLE_HASH_MAP
+	sCacheGeneration++;
+	cleanupThreadSafety();
+
 	if (mStringList)
 	{
 		for (S32 i = 0; i < mMaxEntries; i++)
@@ -104,11 +132,75 @@ LLStringTable::~LLStringTable()
 		delete [] mStringList;
 		mStringList = NULL;
 	}
-#else
-	// Need to clean up the string hash
-	for_each(mStringHash.begin(), mStringHash.end(), DeletePairedPointer());
-	mStringHash.clear();
-#endif
+}
+
+void LLStringTable::initThreadSafety()
+{
+	for (U32 shard = 0; shard < STRING_TABLE_SHARDS; shard++)
+	{
+		if (!mShardMutex[shard])
+		{
+			mShardMutex[shard] = new LLMutex;
+		}
+	}
+}
+
+void LLStringTable::cleanupThreadSafety()
+{
+	// Going back to single threaded, so nothing else can be looking.
+	freeRetiredEntries();
+
+	for (U32 shard = 0; shard < STRING_TABLE_SHARDS; shard++)
+	{
+		delete mShardMutex[shard];
+		mShardMutex[shard] = NULL;
+	}
+}
+
+void LLStringTable::freeRetiredEntries()
+{
+	for (U32 shard = 0; shard < STRING_TABLE_SHARDS; shard++)
+	{
+		// removeString() may still be retiring entries on other threads
+		std::vector<LLStringTableEntry*> doomed;
+		lockShard(shard);
+		doomed.swap(mRetiredEntries[shard]);
+		unlockShard(shard);
+
+		for_each(doomed.begin(), doomed.end(), DeletePointer());
+	}
+}
+
+void LLStringTable::dumpStats()
+{
+	U32 hits = mCacheHits;
+	U32 misses = mCacheMisses;
+	U32 lookups = hits + misses;
+	llinfos << "LLStringTable: " << (S32)mUniqueEntries << " strings, "
+			<< lookups << " lookups, "
+			<< (lookups ? (100.f * hits / lookups) : 0.f) << "% thread cache hits, "
+			<< (U32)mContendedLocks << " contended locks" << llendl;
+}
+
+// Shards are picked from the low bits of the bucket index, so every string
+// in a bucket is always guarded by the same mutex.
+void LLStringTable::lockShard(U32 hash_value)
+{
+	LLMutex* mutex = mShardMutex[hash_value & (STRING_TABLE_SHARDS - 1)];
+	if (mutex && !mutex->tryLock())
+	{
+		mContendedLocks++;
+		mutex->lock();
+	}
+}
+
+void LLStringTable::unlockShard(U32 hash_value)
+{
+	LLMutex* mutex = mShardMutex[hash_value & (STRING_TABLE_SHARDS - 1)];
+	if (mutex)
+	{
+		mutex->unlock();
+	}
 }
 
 
@@ -159,49 +251,81 @@ LLStringTableEntry* LLStringTable::checkStringEntry(const std::string& str)
 
 LLStringTableEntry* LLStringTable::checkStringEntry(const char *str)
 {
-	if (str)
+	if (!str)
 	{
-		char *ret_val;
-		LLStringTableEntry	*entry;
-		U32					hash_value = hash_my_string(str, mMaxEntries);
-#if STRING_TABLE_HASH_MAP
-#if 1 // Microsoft
-		string_hash_t::iterator lower = mStringHash.lower_bound(hash_value);
-		string_hash_t::iterator upper = mStringHash.upper_bound(hash_value);
-#else // stlport
-		std::pair<string_hash_t::iterator, string_hash_t::iterator> P = mStringHash.equal_range(hash_value);
-		string_hash_t::iterator lower = P.first;
-		string_hash_t::iterator upper = P.second;
-#endif
-		for (string_hash_t::iterator iter = lower; iter != upper; iter++)
+		return NULL;
+	}
+
+	U32 hash_value = hash_my_string(str, mMaxEntries);
+
+	// lock free path: this thread looked the string up recently
+	LLStringTableCacheSlot& slot = sThreadCache[hash_value & (STRING_TABLE_THREAD_CACHE_SIZE - 1)];
+	U32 generation = sCacheGeneration;
+	if (slot.mTable == this && slot.mGeneration == generation
+		&& !strncmp(slot.mEntry->mString, str, MAX_STRINGS_LENGTH))
+	{
+		mCacheHits++;
+		return slot.mEntry;
+	}
+
+	lockShard(hash_value);
+	LLStringTableEntry* entry = findEntry(hash_value, str);
+	unlockShard(hash_value);
+
+	mCacheMisses++;
+	if (entry)
+	{
+		slot.mTable = this;
+		slot.mGeneration = generation;
+		slot.mEntry = entry;
+	}
+	return entry;
+}
+
+// Caller must hold the shard lock for hash_value.
+LLStringTableEntry* LLStringTable::findEntry(U32 hash_value, const char *str)
+{
+	LLStringTableEntry	*entry;
+	string_list_t		*strlist = mStringList[hash_value];
+	if (strlist)
+	{
+		string_list_t::iterator iter;
+		for (iter = strlist->begin(); iter != strlist->end(); iter++)
 		{
-			entry = iter->second;
-			ret_val = entry->mString;
-			if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
+			entry = *iter;
+			if (!strncmp(entry->mString, str, MAX_STRINGS_LENGTH))
 			{
 				return entry;
 			}
 		}
-#else
-		string_list_t		*strlist = mStringList[hash_value];
-		if (strlist)
+	}
+	return NULL;
+}
+
+// Caller must hold the shard lock for hash_value.
+LLStringTableEntry* LLStringTable::reviveEntry(U32 hash_value, const char *str)
+{
+	std::vector<LLStringTableEntry*>& retired = mRetiredEntries[hash_value & (STRING_TABLE_SHARDS - 1)];
+	for (std::vector<LLStringTableEntry*>::iterator iter = retired.begin(); iter != retired.end(); ++iter)
+	{
+		LLStringTableEntry* entry = *iter;
+		if (!strncmp(entry->mString, str, MAX_STRINGS_LENGTH))
 		{
-			string_list_t::iterator iter;
-			for (iter = strlist->begin(); iter != strlist->end(); iter++)
-			{
-				entry = *iter;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					return entry;
-				}
-			}
+			*iter = retired.back();
+			retired.pop_back();
+			entry->mCount = 1;
+			return entry;
 		}
-#endif
 	}
 	return NULL;
 }
 
+// Caller must hold the shard lock for hash_value and have unlinked entry.
+void LLStringTable::retireEntry(U32 hash_value, LLStringTableEntry* entry)
+{
+	mRetiredEntries[hash_value & (STRING_TABLE_SHARDS - 1)].push_back(entry);
+}
+
 char* LLStringTable::addString(const std::string& str)
 {
 	//RN: safe to use temporary c_str since string is copied
@@ -231,61 +355,33 @@ LLStringTableEntry* LLStringTable::addStringEntry(const char *str)
 {
 	if (str)
 	{
-		char *ret_val = NULL;
-		LLStringTableEntry	*entry;
 		U32					hash_value = hash_my_string(str, mMaxEntries);
-#if STRING_TABLE_HASH_MAP
-#if 1 // Microsoft
-		string_hash_t::iterator lower = mStringHash.lower_bound(hash_value);
-		string_hash_t::iterator upper = mStringHash.upper_bound(hash_value);
-#else // stlport
-		std::pair<string_hash_t::iterator, string_hash_t::iterator> P = mStringHash.equal_range(hash_value);
-		string_hash_t::iterator lower = P.first;
-		string_hash_t::iterator upper = P.second;
-#endif
-		for (string_hash_t::iterator iter = lower; iter != upper; iter++)
+
+		lockShard(hash_value);
+
+		LLStringTableEntry* entry = findEntry(hash_value, str);
+		if (entry)
 		{
-			entry = iter->second;
-			ret_val = entry->mString;
-			if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-			{
-				entry->incCount();
-				return entry;
-			}
+			entry->incCount();
+			unlockShard(hash_value);
+			return entry;
 		}
 
 		// not found, so add!
-		LLStringTableEntry* newentry = new LLStringTableEntry(str);
-		ret_val = newentry->mString;
-		mStringHash.insert(string_hash_t::value_type(hash_value, newentry));
-#else
-		string_list_t		*strlist = mStringList[hash_value];
-
-		if (strlist)
+		LLStringTableEntry* newentry = reviveEntry(hash_value, str);
+		if (!newentry)
 		{
-			string_list_t::iterator iter;
-			for (iter = strlist->begin(); iter != strlist->end(); iter++)
-			{
-				entry = *iter;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					entry->incCount();
-					return entry;
-				}
-			}
+			newentry = new LLStringTableEntry(str);
 		}
-		else
+		string_list_t		*strlist = mStringList[hash_value];
+		if (!strlist)
 		{
 			mStringList[hash_value] = new string_list_t;
 			strlist = mStringList[hash_value];
 		}
-
-		// not found, so add!
-		LLStringTableEntry *newentry = new LLStringTableEntry(str);
-		//ret_val = newentry->mString;
 		strlist->push_front(newentry);
-#endif
+		unlockShard(hash_value);
+
 		mUniqueEntries++;
 		return newentry;
 	}
@@ -302,37 +398,8 @@ void LLStringTable::removeString(const char *str)
 		char *ret_val;
 		LLStringTableEntry	*entry;
 		U32					hash_value = hash_my_string(str, mMaxEntries);
-#if STRING_TABLE_HASH_MAP
-		{
-#if 1 // Microsoft
-			string_hash_t::iterator lower = mStringHash.lower_bound(hash_value);
-			string_hash_t::iterator upper = mStringHash.upper_bound(hash_value);
-#else // stlport
-			std::pair<string_hash_t::iterator, string_hash_t::iterator> P = mStringHash.equal_range(hash_value);
-			string_hash_t::iterator lower = P.first;
-			string_hash_t::iterator upper = P.second;
-#endif
-			for (string_hash_t::iterator iter = lower; iter != upper; iter++)
-			{
-				entry = iter->second;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					if (!entry->decCount())
-					{
-						mUniqueEntries--;
-						if (mUniqueEntries < 0)
-						{
-							llerror("LLStringTable:removeString trying to remove too many strings!", 0);
-						}
-						delete iter->second;
-						mStringHash.erase(iter);
-					}
-					return;
-				}
-			}
-		}
-#else
+
+		lockShard(hash_value);
 		string_list_t		*strlist = mStringList[hash_value];
 
 		if (strlist)
@@ -351,14 +418,23 @@ void LLStringTable::removeString(const char *str)
 						{
 							llerror("LLStringTable:removeString trying to remove too many strings!", 0);
 						}
+						sCacheGeneration++;
 						strlist->remove(entry);
-						delete entry;
+						if (mShardMutex[0])
+						{
+							// Another thread's cache may still hold this entry
+							retireEntry(hash_value, entry);
+						}
+						else
+						{
+							delete entry;
+						}
 					}
-					return;
+					break;
 				}
 			}
 		}
-#endif
+		unlockShard(hash_value);
 	}
 }
 
@@ -37,26 +37,17 @@
 #include "lldefs.h"
 #include "llformat.h"
 #include "llstl.h"
+#include "llapr.h"
 #include <list>
 #include <set>
+#include <vector>
 
-#if LL_WINDOWS
-# if (_MSC_VER >= 1300 && _MSC_VER < 1400)
-#  define STRING_TABLE_HASH_MAP 1
-# endif
-#else
-//# define STRING_TABLE_HASH_MAP 1
-#endif
+const U32 MAX_STRINGS_LENGTH = 256;
 
-#if STRING_TABLE_HASH_MAP
-# if LL_WINDOWS
-#  include <hash_map>
-# else
-#  include <ext/hash_map>
-# endif
-#endif
+// Number of independently locked bucket groups once a table is made thread safe
+const U32 STRING_TABLE_SHARDS = 16;
 
-const U32 MAX_STRINGS_LENGTH = 256;
+class LLMutex;
 
 class LL_COMMON_API LLStringTableEntry
 {
@@ -71,12 +62,36 @@ public:
 	S32  mCount;
 };
 
+// Lookups (checkString*) first consult a small per-thread cache of recently
+// found entries and take no lock on a hit. Everything else locks only the
+// shard owning the string's bucket, and only after initThreadSafety() has
+// been called; until then (e.g. during static initialization, before APR
+// is up) the table behaves exactly like the old single threaded one.
+// Since a thread cache slot may still point at an entry after another thread
+// removed its last reference, a thread safe table doesn't free entries in
+// removeString(): they are unlinked and parked on their shard's retired
+// list, revived by a later addString() of the same string, and deleted by
+// freeRetiredEntries().
 class LL_COMMON_API LLStringTable
 {
 public:
 	LLStringTable(int tablesize);
 	~LLStringTable();
 
+	// Create / destroy the shard mutexes. Not thread safe themselves.
+	void initThreadSafety();
+	void cleanupThreadSafety();
+
+	// Deletes retired entries.  Only call this at a quiescent point, when no
+	// other thread can be in the middle of a lookup in this table.
+	void freeRetiredEntries();
+
+	// Statistics
+	U32 getCacheHits()			{ return mCacheHits; }
+	U32 getCacheMisses()		{ return mCacheMisses; }
+	U32 getContendedLocks()		{ return mContendedLocks; }
+	void dumpStats();
+
 	char *checkString(const char *str);
 	char *checkString(const std::string& str);
 	LLStringTableEntry *checkStringEntry(const char *str);
@@ -89,20 +104,26 @@ public:
 	void  removeString(const char *str);
 
 	S32 mMaxEntries;
-	S32 mUniqueEntries;
-	
-#if STRING_TABLE_HASH_MAP
-#if LL_WINDOWS
-	typedef std::hash_multimap<U32, LLStringTableEntry *> string_hash_t;
-#else
-	typedef __gnu_cxx::hash_multimap<U32, LLStringTableEntry *> string_hash_t;
-#endif
-	string_hash_t mStringHash;
-#else
+	LLAtomicS32 mUniqueEntries;
+
+private:
+	LLStringTableEntry* findEntry(U32 hash_value, const char *str);
+	LLStringTableEntry* reviveEntry(U32 hash_value, const char *str);
+	void retireEntry(U32 hash_value, LLStringTableEntry* entry);
+	void lockShard(U32 hash_value);
+	void unlockShard(U32 hash_value);
+
+	LLMutex* mShardMutex[STRING_TABLE_SHARDS];
+	std::vector<LLStringTableEntry*> mRetiredEntries[STRING_TABLE_SHARDS];
+
+	LLAtomicU32 mCacheHits;
+	LLAtomicU32 mCacheMisses;
+	LLAtomicU32 mContendedLocks;
+
+public:
 	typedef std::list<LLStringTableEntry *> string_list_t;
 	typedef string_list_t * string_list_ptr_t;
 	string_list_ptr_t	*mStringList;
-#endif	
 };
 
 extern LL_COMMON_API LLStringTable gStringTable;
@@ -35,6 +35,7 @@
 #include "apr_portable.h"
 
 #include "llthread.h"
+#include "llfasttimertrace.h"
 
 #include "lltimer.h"
 
@@ -95,6 +96,8 @@ void *APR_THREAD_FUNC LLThread::staticRun(apr_thread_t *apr_threadp, void *datap
 	// Create a thread local data.
 	LLThreadLocalData::create(threadp);
 
+	LLFastTimerTrace::setThreadName(threadp->mName);
+
 	// Run the user supplied function
 	threadp->run();
 
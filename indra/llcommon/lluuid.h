@@ -319,6 +319,13 @@ struct lluuid_less
 
 typedef std::set<LLUUID, lluuid_less> uuid_list_t;
 
+// Hash function picked up by boost::unordered_map / boost::unordered_set
+// through argument dependent lookup.
+inline std::size_t hash_value(const LLUUID& uuid)
+{
+	return (std::size_t)uuid.getCRC32();
+}
+
 /*
  * Sub-classes for keeping transaction IDs and asset IDs
  * straight.
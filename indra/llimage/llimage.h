@@ -236,6 +236,9 @@ public:
 	// Src and dst are same size.  Src has 4 components.  Dst has 3 components.
 	void compositeUnscaled4onto3( LLImageRaw* src );
 
+	// Multiply the color channels by alpha.  Image must have 4 components.
+	void premultiplyAlpha();
+
 protected:
 	// Create an image from a local file (generally used in tools)
 	//bool createFromFile(const std::string& filename, bool j2c_lowest_mip_only = false);
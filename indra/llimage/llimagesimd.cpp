@@ -0,0 +1,674 @@
+/**
+ * @file llimagesimd.cpp
+ * @brief SSE2 pixel kernels used by LLImageRaw and LLImageBase.
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ *
+ * Copyright (c) 2011, Linden Research, Inc.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llimagesimd.h"
+
+#include "llmath.h"		// llfloor(), llround(); also pulls in the SSE2 intrinsics
+#include "llrand.h"
+#include "lltimer.h"
+
+// SSE2 is the baseline instruction set of this tree (see llsimdmath.h), so
+// the vectorized kernels need no runtime CPU check.
+
+//static
+bool LLImageSIMD::sUseSIMD = true;
+
+//----------------------------------------------------------------------------
+// Helpers
+
+// Loads 4 RGB pixels (12 bytes) as 4 RGBx pixels; the x bytes are zero.
+// Never reads past the 12 bytes.
+static inline __m128i load_rgb_as_rgbx(const U8* src)
+{
+	const __m128i mask_p0 = _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF);
+	const __m128i mask_p1 = _mm_set_epi32(0x00FFFFFF, 0, 0x00FFFFFF, 0);
+
+	S32 tail;
+	memcpy(&tail, src + 8, 4);		/* Flawfinder: ignore */
+	__m128i v = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)src), _mm_cvtsi32_si128(tail));
+	// Low qword: pixels 0 and 1 in bytes 0-5.  High qword: pixels 2 and 3 in bytes 6-11.
+	v = _mm_unpacklo_epi64(v, _mm_srli_si128(v, 6));
+	return _mm_or_si128(_mm_and_si128(v, mask_p0), _mm_and_si128(_mm_slli_epi64(v, 8), mask_p1));
+}
+
+// Stores the RGB bytes of 4 RGBx pixels (12 bytes).  Never writes past the 12 bytes.
+static inline void store_rgbx_as_rgb(U8* dst, __m128i v)
+{
+	const __m128i mask_p0 = _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF);
+	const __m128i mask_p1 = _mm_set_epi32(0x0000FFFF, (S32)0xFF000000, 0x0000FFFF, (S32)0xFF000000);
+
+	// Each qword now holds two packed RGB pixels in bytes 0-5.
+	v = _mm_or_si128(_mm_and_si128(v, mask_p0), _mm_and_si128(_mm_srli_epi64(v, 8), mask_p1));
+	v = _mm_or_si128(_mm_move_epi64(v), _mm_slli_si128(_mm_srli_si128(v, 8), 6));
+
+	_mm_storel_epi64((__m128i*)dst, v);
+	S32 tail = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+	memcpy(dst + 8, &tail, 4);		/* Flawfinder: ignore */
+}
+
+// fastFractionalMult() on 8 U16 lanes.  a * b + 128 fits in 16 bits for any U8 a, b.
+static inline __m128i fast_fractional_mult_epi16(__m128i a, __m128i b)
+{
+	__m128i i = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(i, _mm_srli_epi16(i, 8)), 8);
+}
+
+// Broadcasts the alpha of each of the two RGBA pixels held in 8 U16 lanes.
+static inline __m128i broadcast_alpha_epi16(__m128i v)
+{
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+// Converts one 4 component pixel to 4 floats.
+static inline __m128 load_pixel_ps(const U8* src)
+{
+	S32 pixel;
+	memcpy(&pixel, src, 4);		/* Flawfinder: ignore */
+	const __m128i zero = _mm_setzero_si128();
+	__m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pixel), zero);
+	return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+}
+
+//----------------------------------------------------------------------------
+// Format conversion and compositing
+
+//static
+void LLImageSIMD::copy4onto3(const U8* src, U8* dst, S32 pixels)
+{
+	if (!sUseSIMD)
+	{
+		copy4onto3Scalar(src, dst, pixels);
+		return;
+	}
+
+	for ( ; pixels >= 4; pixels -= 4)
+	{
+		store_rgbx_as_rgb(dst, _mm_loadu_si128((const __m128i*)src));
+		src += 16;
+		dst += 12;
+	}
+	copy4onto3Scalar(src, dst, pixels);
+}
+
+//static
+void LLImageSIMD::copy3onto4(const U8* src, U8* dst, S32 pixels)
+{
+	if (!sUseSIMD)
+	{
+		copy3onto4Scalar(src, dst, pixels);
+		return;
+	}
+
+	const __m128i alpha = _mm_set1_epi32((S32)0xFF000000);
+	for ( ; pixels >= 4; pixels -= 4)
+	{
+		_mm_storeu_si128((__m128i*)dst, _mm_or_si128(load_rgb_as_rgbx(src), alpha));
+		src += 12;
+		dst += 16;
+	}
+	copy3onto4Scalar(src, dst, pixels);
+}
+
+//static
+void LLImageSIMD::composite4onto3(const U8* src, U8* dst, S32 pixels)
+{
+	if (!sUseSIMD)
+	{
+		composite4onto3Scalar(src, dst, pixels);
+		return;
+	}
+
+	// The scalar code special cases alpha 0 and 255, but since
+	// fastFractionalMult(x, 255) == x and fastFractionalMult(x, 0) == 0
+	// the general blend gives the same result for both.
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi16(255);
+	for ( ; pixels >= 4; pixels -= 4)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i*)src);
+		__m128i d = load_rgb_as_rgbx(dst);
+
+		__m128i s_lo = _mm_unpacklo_epi8(s, zero);
+		__m128i s_hi = _mm_unpackhi_epi8(s, zero);
+		__m128i a_lo = broadcast_alpha_epi16(s_lo);
+		__m128i a_hi = broadcast_alpha_epi16(s_hi);
+
+		__m128i r_lo = _mm_add_epi16(fast_fractional_mult_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(max, a_lo)),
+									 fast_fractional_mult_epi16(s_lo, a_lo));
+		__m128i r_hi = _mm_add_epi16(fast_fractional_mult_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(max, a_hi)),
+									 fast_fractional_mult_epi16(s_hi, a_hi));
+
+		// The scalar sum wraps at 256 rather than saturating.
+		store_rgbx_as_rgb(dst, _mm_packus_epi16(_mm_and_si128(r_lo, max), _mm_and_si128(r_hi, max)));
+		src += 16;
+		dst += 12;
+	}
+	composite4onto3Scalar(src, dst, pixels);
+}
+
+//static
+void LLImageSIMD::premultiplyAlpha(U8* data, S32 pixels)
+{
+	if (!sUseSIMD)
+	{
+		premultiplyAlphaScalar(data, pixels);
+		return;
+	}
+
+	// Alpha itself is multiplied by 255, which leaves it unchanged.
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i keep_rgb = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+	const __m128i alpha_one = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+	for ( ; pixels >= 4; pixels -= 4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)data);
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+		__m128i a_lo = _mm_or_si128(_mm_and_si128(broadcast_alpha_epi16(lo), keep_rgb), alpha_one);
+		__m128i a_hi = _mm_or_si128(_mm_and_si128(broadcast_alpha_epi16(hi), keep_rgb), alpha_one);
+		_mm_storeu_si128((__m128i*)data, _mm_packus_epi16(fast_fractional_mult_epi16(lo, a_lo),
+														  fast_fractional_mult_epi16(hi, a_hi)));
+		data += 16;
+	}
+	premultiplyAlphaScalar(data, pixels);
+}
+
+//----------------------------------------------------------------------------
+// Scaling
+
+//static
+void LLImageSIMD::copyLineScaled(const U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len,
+								 S32 in_pixel_step, S32 out_pixel_step, S32 components)
+{
+	// Only RGBA maps cleanly onto one register per pixel.
+	if (!sUseSIMD || components != 4)
+	{
+		copyLineScaledScalar(in, out, in_pixel_len, out_pixel_len, in_pixel_step, out_pixel_step, components);
+		return;
+	}
+
+	// Same arithmetic as the scalar version, in the same order, one channel
+	// per lane, so the float results are bit identical.
+	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
+	const F32 norm_factor = 1.f / ratio;
+	const __m128 norm = _mm_set1_ps(norm_factor);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128i byte_mask = _mm_set1_epi32(0xFF);
+
+	for( S32 x = 0; x < out_pixel_len; x++ )
+	{
+		const F32 sample0 = x * ratio;
+		const F32 sample1 = (x+1) * ratio;
+		const S32 index0 = llfloor(sample0);			// left integer (floor)
+		const S32 index1 = llfloor(sample1);			// right integer (floor)
+		const F32 fract0 = 1.f - (sample0 - F32(index0));	// spill over on left
+		const F32 fract1 = sample1 - F32(index1);			// spill-over on right
+
+		U8* outp = out + x * out_pixel_step * 4;
+		if( index0 == index1 )
+		{
+			// Interval is embedded in one input pixel
+			memcpy(outp, in + index0 * in_pixel_step * 4, 4);		/* Flawfinder: ignore */
+			continue;
+		}
+
+		// Left straddle
+		__m128 sum = _mm_mul_ps(load_pixel_ps(in + index0 * in_pixel_step * 4), _mm_set1_ps(fract0));
+
+		// Central interval
+		for( S32 u = index0 + 1; u < index1; u++ )
+		{
+			sum = _mm_add_ps(sum, load_pixel_ps(in + u * in_pixel_step * 4));
+		}
+
+		// right straddle
+		// Watch out for reading off of end of input array.
+		if( fract1 && index1 < in_pixel_len )
+		{
+			sum = _mm_add_ps(sum, _mm_mul_ps(load_pixel_ps(in + index1 * in_pixel_step * 4), _mm_set1_ps(fract1)));
+		}
+
+		// llround() is llfloor(val + 0.5f); the sums are never negative so truncation is floor.
+		// Like the scalar U8 cast, keep only the low byte.
+		__m128i v = _mm_and_si128(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sum, norm), half)), byte_mask);
+		v = _mm_packus_epi16(_mm_packs_epi32(v, v), v);
+		S32 pixel = _mm_cvtsi128_si32(v);
+		memcpy(outp, &pixel, 4);		/* Flawfinder: ignore */
+	}
+}
+
+//static
+void LLImageSIMD::generateMip(const U8* indata, U8* mipdata, S32 width, S32 height, S32 nchannels)
+{
+	if (!sUseSIMD || (nchannels != 4 && nchannels != 1))
+	{
+		generateMipScalar(indata, mipdata, width, height, nchannels);
+		return;
+	}
+
+	llassert(width > 0 && height > 0);
+	const S32 in_stride = width * 2 * nchannels;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i low_bytes = _mm_set1_epi16(0x00FF);
+	for (S32 h = 0; h < height; h++)
+	{
+		const U8* row0 = indata + h * 2 * in_stride;
+		const U8* row1 = row0 + in_stride;
+		U8* out = mipdata + h * width * nchannels;
+
+		S32 w = 0;
+		if (nchannels == 4)
+		{
+			// 4 output pixels from 8 input pixels on each row.  The sums of
+			// four bytes fit in 16 bits, so the result is exact.
+			for ( ; w + 4 <= width; w += 4)
+			{
+				__m128i a = _mm_loadu_si128((const __m128i*)(row0 + w * 8));
+				__m128i b = _mm_loadu_si128((const __m128i*)(row0 + w * 8 + 16));
+				__m128i c = _mm_loadu_si128((const __m128i*)(row1 + w * 8));
+				__m128i d = _mm_loadu_si128((const __m128i*)(row1 + w * 8 + 16));
+
+				// Vertical sums, two input pixels per register.
+				__m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(c, zero));
+				__m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(c, zero));
+				__m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(d, zero));
+				__m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(d, zero));
+
+				// Horizontal sums of neighbouring pixels.
+				__m128i lo = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+				__m128i hi = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+
+				_mm_storeu_si128((__m128i*)(out + w * 4),
+								 _mm_packus_epi16(_mm_srli_epi16(lo, 2), _mm_srli_epi16(hi, 2)));
+			}
+		}
+		else
+		{
+			// 8 output pixels from 16 input pixels on each row.
+			for ( ; w + 8 <= width; w += 8)
+			{
+				__m128i a = _mm_loadu_si128((const __m128i*)(row0 + w * 2));
+				__m128i c = _mm_loadu_si128((const __m128i*)(row1 + w * 2));
+				__m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, low_bytes), _mm_srli_epi16(a, 8)),
+											_mm_add_epi16(_mm_and_si128(c, low_bytes), _mm_srli_epi16(c, 8)));
+				sum = _mm_srli_epi16(sum, 2);
+				_mm_storel_epi64((__m128i*)(out + w), _mm_packus_epi16(sum, sum));
+			}
+		}
+
+		// Leftover pixels of the row.
+		for ( ; w < width; w++)
+		{
+			for (S32 i = 0; i < nchannels; i++)
+			{
+				S32 left = w * 2 * nchannels + i;
+				S32 right = left + nchannels;
+				out[w * nchannels + i] = (U8)(((U32)(row0[left]) + row0[right] + row1[left] + row1[right]) >> 2);
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------
+// Scalar reference implementations.  These are the original LLImageRaw and
+// LLImageBase loops and define the expected output of the kernels above.
+
+//static
+void LLImageSIMD::copy4onto3Scalar(const U8* src_data, U8* dst_data, S32 pixels)
+{
+	for( S32 i=0; i<pixels; i++ )
+	{
+		dst_data[0] = src_data[0];
+		dst_data[1] = src_data[1];
+		dst_data[2] = src_data[2];
+		src_data += 4;
+		dst_data += 3;
+	}
+}
+
+//static
+void LLImageSIMD::copy3onto4Scalar(const U8* src_data, U8* dst_data, S32 pixels)
+{
+	for( S32 i=0; i<pixels; i++ )
+	{
+		dst_data[0] = src_data[0];
+		dst_data[1] = src_data[1];
+		dst_data[2] = src_data[2];
+		dst_data[3] = 255;
+		src_data += 3;
+		dst_data += 4;
+	}
+}
+
+//static
+void LLImageSIMD::composite4onto3Scalar(const U8* src_data, U8* dst_data, S32 pixels)
+{
+	while( pixels-- > 0 )
+	{
+		U8 alpha = src_data[3];
+		if( alpha )
+		{
+			if( 255 == alpha )
+			{
+				dst_data[0] = src_data[0];
+				dst_data[1] = src_data[1];
+				dst_data[2] = src_data[2];
+			}
+			else
+			{
+
+				U8 transparency = 255 - alpha;
+				dst_data[0] = fastFractionalMult( dst_data[0], transparency ) + fastFractionalMult( src_data[0], alpha );
+				dst_data[1] = fastFractionalMult( dst_data[1], transparency ) + fastFractionalMult( src_data[1], alpha );
+				dst_data[2] = fastFractionalMult( dst_data[2], transparency ) + fastFractionalMult( src_data[2], alpha );
+			}
+		}
+
+		src_data += 4;
+		dst_data += 3;
+	}
+}
+
+//static
+void LLImageSIMD::premultiplyAlphaScalar(U8* data, S32 pixels)
+{
+	for( S32 i=0; i<pixels; i++ )
+	{
+		U8 alpha = data[3];
+		data[0] = fastFractionalMult( data[0], alpha );
+		data[1] = fastFractionalMult( data[1], alpha );
+		data[2] = fastFractionalMult( data[2], alpha );
+		data += 4;
+	}
+}
+
+//static
+void LLImageSIMD::copyLineScaledScalar(const U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len,
+									   S32 in_pixel_step, S32 out_pixel_step, S32 components)
+{
+	llassert( components >= 1 && components <= 4 );
+
+	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
+	const F32 norm_factor = 1.f / ratio;
+
+	S32 goff = components >= 2 ? 1 : 0;
+	S32 boff = components >= 3 ? 2 : 0;
+	for( S32 x = 0; x < out_pixel_len; x++ )
+	{
+		// Sample input pixels in range from sample0 to sample1.
+		// Avoid floating point accumulation error... don't just add ratio each time.  JC
+		const F32 sample0 = x * ratio;
+		const F32 sample1 = (x+1) * ratio;
+		const S32 index0 = llfloor(sample0);			// left integer (floor)
+		const S32 index1 = llfloor(sample1);			// right integer (floor)
+		const F32 fract0 = 1.f - (sample0 - F32(index0));	// spill over on left
+		const F32 fract1 = sample1 - F32(index1);			// spill-over on right
+
+		if( index0 == index1 )
+		{
+			// Interval is embedded in one input pixel
+			S32 t0 = x * out_pixel_step * components;
+			S32 t1 = index0 * in_pixel_step * components;
+			U8* outp = out + t0;
+			const U8* inp = in + t1;
+			for (S32 i = 0; i < components; ++i)
+			{
+				*outp = *inp;
+				++outp;
+				++inp;
+			}
+		}
+		else
+		{
+			// Left straddle
+			S32 t1 = index0 * in_pixel_step * components;
+			F32 r = in[t1 + 0] * fract0;
+			F32 g = in[t1 + goff] * fract0;
+			F32 b = in[t1 + boff] * fract0;
+			F32 a = 0;
+			if( components == 4)
+			{
+				a = in[t1 + 3] * fract0;
+			}
+
+			// Central interval
+			if (components < 4)
+			{
+				for( S32 u = index0 + 1; u < index1; u++ )
+				{
+					S32 t2 = u * in_pixel_step * components;
+					r += in[t2 + 0];
+					g += in[t2 + goff];
+					b += in[t2 + boff];
+				}
+			}
+			else
+			{
+				for( S32 u = index0 + 1; u < index1; u++ )
+				{
+					S32 t2 = u * in_pixel_step * components;
+					r += in[t2 + 0];
+					g += in[t2 + 1];
+					b += in[t2 + 2];
+					a += in[t2 + 3];
+				}
+			}
+
+			// right straddle
+			// Watch out for reading off of end of input array.
+			if( fract1 && index1 < in_pixel_len )
+			{
+				S32 t3 = index1 * in_pixel_step * components;
+				if (components < 4)
+				{
+					U8 in0 = in[t3 + 0];
+					U8 in1 = in[t3 + goff];
+					U8 in2 = in[t3 + boff];
+					r += in0 * fract1;
+					g += in1 * fract1;
+					b += in2 * fract1;
+				}
+				else
+				{
+					U8 in0 = in[t3 + 0];
+					U8 in1 = in[t3 + 1];
+					U8 in2 = in[t3 + 2];
+					U8 in3 = in[t3 + 3];
+					r += in0 * fract1;
+					g += in1 * fract1;
+					b += in2 * fract1;
+					a += in3 * fract1;
+				}
+			}
+
+			r *= norm_factor;
+			g *= norm_factor;
+			b *= norm_factor;
+			a *= norm_factor;  // skip conditional
+
+			S32 t4 = x * out_pixel_step * components;
+			out[t4 + 0] = U8(llround(r));
+			if (components >= 2)
+				out[t4 + 1] = U8(llround(g));
+			if (components >= 3)
+				out[t4 + 2] = U8(llround(b));
+			if( components == 4)
+				out[t4 + 3] = U8(llround(a));
+		}
+	}
+}
+
+static void avg4_colors4(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
+{
+	dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
+	dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
+	dst[2] = (U8)(((U32)(a[2]) + b[2] + c[2] + d[2])>>2);
+	dst[3] = (U8)(((U32)(a[3]) + b[3] + c[3] + d[3])>>2);
+}
+
+static void avg4_colors3(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
+{
+	dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
+	dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
+	dst[2] = (U8)(((U32)(a[2]) + b[2] + c[2] + d[2])>>2);
+}
+
+static void avg4_colors2(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
+{
+	dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
+	dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
+}
+
+//static
+void LLImageSIMD::generateMipScalar(const U8* indata, U8* mipdata, S32 width, S32 height, S32 nchannels)
+{
+	llassert(width > 0 && height > 0);
+	U8* data = mipdata;
+	S32 in_width = width*2;
+	for (S32 h=0; h<height; h++)
+	{
+		for (S32 w=0; w<width; w++)
+		{
+			switch(nchannels)
+			{
+			  case 4:
+				avg4_colors4(indata, indata+4, indata+4*in_width, indata+4*in_width+4, data);
+				break;
+			  case 3:
+				avg4_colors3(indata, indata+3, indata+3*in_width, indata+3*in_width+3, data);
+				break;
+			  case 2:
+				avg4_colors2(indata, indata+2, indata+2*in_width, indata+2*in_width+2, data);
+				break;
+			  case 1:
+				*(U8*)data = (U8)(((U32)(indata[0]) + indata[1] + indata[in_width] + indata[in_width+1])>>2);
+				break;
+			  default:
+				llerrs << "generateMmip called with bad num channels" << llendl;
+			}
+			indata += nchannels*2;
+			data += nchannels;
+		}
+		indata += nchannels*in_width; // skip odd lines
+	}
+}
+
+//----------------------------------------------------------------------------
+// Benchmark
+
+static const char* KERNEL_NAMES[] =
+{
+	"copy4onto3",
+	"copy3onto4",
+	"composite4onto3",
+	"premultiplyAlpha",
+	"generateMip",
+	"copyLineScaled"
+};
+static const S32 KERNEL_COUNT = sizeof(KERNEL_NAMES) / sizeof(KERNEL_NAMES[0]);
+
+// Runs one kernel over a size x size image.
+static void run_kernel(S32 kernel, U8* rgba, U8* rgba2, U8* rgb, U8* scaled, S32 size)
+{
+	const S32 pixels = size * size;
+	switch (kernel)
+	{
+	  case 0:
+		LLImageSIMD::copy4onto3(rgba, rgb, pixels);
+		break;
+	  case 1:
+		LLImageSIMD::copy3onto4(rgb, rgba2, pixels);
+		break;
+	  case 2:
+		LLImageSIMD::composite4onto3(rgba, rgb, pixels);
+		break;
+	  case 3:
+		LLImageSIMD::premultiplyAlpha(rgba2, pixels);
+		break;
+	  case 4:
+		LLImageSIMD::generateMip(rgba, scaled, size / 2, size / 2, 4);
+		break;
+	  default:
+		// Three quarter box downscale of every column, as LLImageRaw::scale() does.
+		for (S32 col = 0; col < size; col++)
+		{
+			LLImageSIMD::copyLineScaled(rgba + col * 4, rgba2 + col * 4, size, size * 3 / 4, size, size, 4);
+		}
+		break;
+	}
+}
+
+//static
+void LLImageSIMD::benchmark()
+{
+	const S32 SIZE = 1024;
+	const S32 PASSES = 10;
+	const S32 pixels = SIZE * SIZE;
+
+	U8* rgba = new U8[pixels * 4];
+	U8* rgba2 = new U8[pixels * 4];
+	U8* rgb = new U8[pixels * 3];
+	U8* scaled = new U8[pixels];
+	for (S32 i = 0; i < pixels * 4; i++)
+	{
+		rgba[i] = (U8)ll_rand(256);
+	}
+
+	bool use_simd = sUseSIMD;
+	llinfos << "Image kernel benchmark, " << SIZE << "x" << SIZE << " RGBA, ms per pass:" << llendl;
+	for (S32 kernel = 0; kernel < KERNEL_COUNT; kernel++)
+	{
+		F64 seconds[2];
+		for (S32 mode = 0; mode < 2; mode++)
+		{
+			sUseSIMD = (mode == 1);
+			run_kernel(kernel, rgba, rgba2, rgb, scaled, SIZE);	// warm up the caches
+			LLTimer timer;
+			for (S32 pass = 0; pass < PASSES; pass++)
+			{
+				run_kernel(kernel, rgba, rgba2, rgb, scaled, SIZE);
+			}
+			seconds[mode] = timer.getElapsedTimeF64() / PASSES;
+		}
+		llinfos << "  " << KERNEL_NAMES[kernel] << ": scalar " << seconds[0] * 1000.0
+				<< " SSE2 " << seconds[1] * 1000.0 << " speedup "
+				<< (seconds[1] > 0.0 ? seconds[0] / seconds[1] : 0.0) << "x" << llendl;
+	}
+	sUseSIMD = use_simd;
+
+	delete[] rgba;
+	delete[] rgba2;
+	delete[] rgb;
+	delete[] scaled;
+}
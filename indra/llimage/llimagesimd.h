@@ -0,0 +1,84 @@
+/**
+ * @file llimagesimd.h
+ * @brief SSE2 pixel kernels used by LLImageRaw and LLImageBase.
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ *
+ * Copyright (c) 2011, Linden Research, Inc.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMAGESIMD_H
+#define LL_LLIMAGESIMD_H
+
+// Inner loops of the LLImageRaw copy, composite, scale and mip operations.
+// Every kernel has a vectorized implementation and the original scalar one;
+// the vectorized versions must produce exactly the same bytes as the scalar
+// ones (see tests/llimagesimd_test.cpp), so callers may switch between them
+// freely. Buffers need no particular alignment.
+class LLImageSIMD
+{
+public:
+	// When false, all kernels run the scalar reference code.  For tests and benchmarks.
+	static bool sUseSIMD;
+
+	// Calculates (U8)(255*(a/255.f)*(b/255.f) + 0.5f).  Thanks, Jim Blinn!
+	static U8 fastFractionalMult(U8 a, U8 b)
+	{
+		U32 i = a * b + 128;
+		return U8((i + (i>>8)) >> 8);
+	}
+
+	// RGBA -> RGB, dropping alpha.
+	static void copy4onto3(const U8* src, U8* dst, S32 pixels);
+	// RGB -> RGBA, alpha set to 255.
+	static void copy3onto4(const U8* src, U8* dst, S32 pixels);
+	// Alpha blends RGBA src over RGB dst.
+	static void composite4onto3(const U8* src, U8* dst, S32 pixels);
+	// Multiplies the color channels of an RGBA buffer by its alpha, in place.
+	static void premultiplyAlpha(U8* data, S32 pixels);
+
+	// Box filters one row or column of in_pixel_len pixels down (or up) to out_pixel_len pixels.
+	// Steps are in pixels, so a column is scaled with in_pixel_step == out_pixel_step == width.
+	static void copyLineScaled(const U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len,
+							   S32 in_pixel_step, S32 out_pixel_step, S32 components);
+
+	// 2x2 box filter of a (2*width)x(2*height) image into width x height.
+	static void generateMip(const U8* indata, U8* mipdata, S32 width, S32 height, S32 nchannels);
+
+	// Scalar reference versions of the above.
+	static void copy4onto3Scalar(const U8* src, U8* dst, S32 pixels);
+	static void copy3onto4Scalar(const U8* src, U8* dst, S32 pixels);
+	static void composite4onto3Scalar(const U8* src, U8* dst, S32 pixels);
+	static void premultiplyAlphaScalar(U8* data, S32 pixels);
+	static void copyLineScaledScalar(const U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len,
+									 S32 in_pixel_step, S32 out_pixel_step, S32 components);
+	static void generateMipScalar(const U8* indata, U8* mipdata, S32 width, S32 height, S32 nchannels);
+
+	// Times every kernel over a 1024x1024 image in both modes and logs the results.
+	static void benchmark();
+};
+
+#endif // LL_LLIMAGESIMD_H
@@ -0,0 +1,204 @@
+/**
+ * @file llimagesimd_test.cpp
+ * @brief Checks the SSE2 image kernels against the scalar reference code.
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ *
+ * Copyright (c) 2011, Linden Research, Inc.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "../llcommon/linden_common.h"
+#include <vector>
+// Class to test
+#include "../llimagesimd.h"
+#include "../llcommon/llrand.h"
+// Tut header
+#include "../test/lltut.h"
+
+// -------------------------------------------------------------------------------------------
+// TUT
+// -------------------------------------------------------------------------------------------
+
+namespace tut
+{
+	// Every test compares the vectorized kernel with its scalar reference on
+	// random data, over sizes that exercise both the vector loops and their
+	// scalar tails.  The output must match exactly.
+	struct imagesimd_test
+	{
+		imagesimd_test()
+		{
+			LLImageSIMD::sUseSIMD = true;
+		}
+
+		static void fill(std::vector<U8>& data)
+		{
+			for (size_t i = 0; i < data.size(); i++)
+			{
+				data[i] = (U8)ll_rand(256);
+			}
+		}
+
+		// Random RGBA with plenty of fully opaque and fully transparent pixels.
+		static void fillRGBA(std::vector<U8>& data)
+		{
+			fill(data);
+			for (size_t i = 3; i < data.size(); i += 4)
+			{
+				switch (ll_rand(4))
+				{
+				  case 0: data[i] = 0; break;
+				  case 1: data[i] = 255; break;
+				  default: break;
+				}
+			}
+		}
+	};
+
+	typedef test_group<imagesimd_test> imagesimd_t;
+	typedef imagesimd_t::object imagesimd_object_t;
+	tut::imagesimd_t tut_imagesimd("imagesimd");
+
+	template<> template<>
+	void imagesimd_object_t::test<1>()
+	{
+		// RGBA <-> RGB
+		for (S32 pixels = 1; pixels < 70; pixels++)
+		{
+			std::vector<U8> rgba(pixels * 4);
+			fillRGBA(rgba);
+
+			std::vector<U8> rgb(pixels * 3), rgb_ref(pixels * 3);
+			LLImageSIMD::copy4onto3(&rgba[0], &rgb[0], pixels);
+			LLImageSIMD::copy4onto3Scalar(&rgba[0], &rgb_ref[0], pixels);
+			ensure("copy4onto3 matches scalar", rgb == rgb_ref);
+
+			std::vector<U8> out(pixels * 4), out_ref(pixels * 4);
+			LLImageSIMD::copy3onto4(&rgb[0], &out[0], pixels);
+			LLImageSIMD::copy3onto4Scalar(&rgb[0], &out_ref[0], pixels);
+			ensure("copy3onto4 matches scalar", out == out_ref);
+		}
+	}
+
+	template<> template<>
+	void imagesimd_object_t::test<2>()
+	{
+		// Compositing and premultiplication, including every (color, alpha) pair.
+		const S32 pixels = 256 * 256;
+		std::vector<U8> rgba(pixels * 4), rgb(pixels * 3);
+		for (S32 i = 0; i < pixels; i++)
+		{
+			rgba[i * 4 + 0] = (U8)(i & 0xFF);
+			rgba[i * 4 + 1] = (U8)(255 - (i & 0xFF));
+			rgba[i * 4 + 2] = (U8)ll_rand(256);
+			rgba[i * 4 + 3] = (U8)(i >> 8);
+			rgb[i * 3 + 0] = (U8)(i >> 8);
+			rgb[i * 3 + 1] = (U8)(i & 0xFF);
+			rgb[i * 3 + 2] = (U8)ll_rand(256);
+		}
+
+		std::vector<U8> dst(rgb), dst_ref(rgb);
+		LLImageSIMD::composite4onto3(&rgba[0], &dst[0], pixels);
+		LLImageSIMD::composite4onto3Scalar(&rgba[0], &dst_ref[0], pixels);
+		ensure("composite4onto3 matches scalar", dst == dst_ref);
+
+		std::vector<U8> pre(rgba), pre_ref(rgba);
+		LLImageSIMD::premultiplyAlpha(&pre[0], pixels);
+		LLImageSIMD::premultiplyAlphaScalar(&pre_ref[0], pixels);
+		ensure("premultiplyAlpha matches scalar", pre == pre_ref);
+
+		// Odd lengths for the tails.
+		for (S32 count = 1; count < 20; count++)
+		{
+			std::vector<U8> src(count * 4), d(count * 3);
+			fillRGBA(src);
+			fill(d);
+			std::vector<U8> d_ref(d);
+			LLImageSIMD::composite4onto3(&src[0], &d[0], count);
+			LLImageSIMD::composite4onto3Scalar(&src[0], &d_ref[0], count);
+			ensure("composite4onto3 tail matches scalar", d == d_ref);
+
+			std::vector<U8> p(src), p_ref(src);
+			LLImageSIMD::premultiplyAlpha(&p[0], count);
+			LLImageSIMD::premultiplyAlphaScalar(&p_ref[0], count);
+			ensure("premultiplyAlpha tail matches scalar", p == p_ref);
+		}
+	}
+
+	template<> template<>
+	void imagesimd_object_t::test<3>()
+	{
+		// Mipmap generation for every channel count.
+		for (S32 nchannels = 1; nchannels <= 4; nchannels++)
+		{
+			for (S32 width = 1; width < 24; width++)
+			{
+				S32 height = 1 + ll_rand(8);
+				std::vector<U8> in(width * 2 * height * 2 * nchannels);
+				fill(in);
+				std::vector<U8> mip(width * height * nchannels), mip_ref(width * height * nchannels);
+				LLImageSIMD::generateMip(&in[0], &mip[0], width, height, nchannels);
+				LLImageSIMD::generateMipScalar(&in[0], &mip_ref[0], width, height, nchannels);
+				ensure("generateMip matches scalar", mip == mip_ref);
+			}
+		}
+	}
+
+	template<> template<>
+	void imagesimd_object_t::test<4>()
+	{
+		// Box filtered rows and columns, shrinking and growing.
+		const S32 components[] = { 1, 3, 4 };
+		for (S32 c = 0; c < 3; c++)
+		{
+			for (S32 i = 0; i < 200; i++)
+			{
+				S32 in_len = 1 + ll_rand(300);
+				S32 out_len = 1 + ll_rand(300);
+				S32 step = 1 + ll_rand(3);
+				std::vector<U8> in(in_len * step * components[c]);
+				fill(in);
+				std::vector<U8> out(out_len * step * components[c]), out_ref(out_len * step * components[c]);
+				LLImageSIMD::copyLineScaled(&in[0], &out[0], in_len, out_len, step, step, components[c]);
+				LLImageSIMD::copyLineScaledScalar(&in[0], &out_ref[0], in_len, out_len, step, step, components[c]);
+				ensure("copyLineScaled matches scalar", out == out_ref);
+			}
+		}
+	}
+
+	template<> template<>
+	void imagesimd_object_t::test<5>()
+	{
+		// With SIMD disabled the kernels are the scalar code.
+		LLImageSIMD::sUseSIMD = false;
+		std::vector<U8> rgba(64 * 4), rgb(64 * 3), rgb_ref(64 * 3);
+		fillRGBA(rgba);
+		LLImageSIMD::copy4onto3(&rgba[0], &rgb[0], 64);
+		LLImageSIMD::copy4onto3Scalar(&rgba[0], &rgb_ref[0], 64);
+		LLImageSIMD::sUseSIMD = true;
+		ensure("scalar fallback", rgb == rgb_ref);
+	}
+}
@@ -0,0 +1,143 @@
+/** 
+ * @file llinventoryindex.cpp
+ * @brief Secondary inventory indexes by asset, type, link target and name.
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llinventoryindex.h"
+
+#include "llinventory.h"
+#include "llstring.h"
+
+LLInventoryIndex::LLInventoryIndex()
+{
+}
+
+// static
+std::string LLInventoryIndex::makeNameKey(const std::string& name)
+{
+	std::string key(name);
+	LLStringUtil::toLower(key);
+	return key;
+}
+
+void LLInventoryIndex::addItem(const LLInventoryItem* item)
+{
+	if (!item) return;
+	const LLUUID& id = item->getUUID();
+	removeObject(id);
+
+	// Use the item's own fields. The viewer subclasses redirect these
+	// getters through the link target, which may not be loaded yet.
+	LLItemKeys keys;
+	keys.mIsLink = item->getIsLinkType();
+	keys.mAssetID = item->LLInventoryItem::getAssetUUID();
+	keys.mInvType = item->LLInventoryItem::getInventoryType();
+
+	if (keys.mIsLink)
+	{
+		insertKey(mByLinkTarget, keys.mAssetID, id);
+	}
+	else
+	{
+		insertKey(mByAsset, keys.mAssetID, id);
+		insertKey(mByType, (S32)keys.mInvType, id);
+	}
+	mItemKeys[id] = keys;
+}
+
+void LLInventoryIndex::addCategory(const LLInventoryCategory* cat)
+{
+	if (!cat) return;
+	const LLUUID& id = cat->getUUID();
+	removeObject(id);
+
+	std::string name = makeNameKey(cat->LLInventoryObject::getName());
+	insertKey(mCategoriesByName, name, id);
+	mCategoryNames[id] = name;
+}
+
+void LLInventoryIndex::removeObject(const LLUUID& id)
+{
+	item_keys_t::iterator item_it = mItemKeys.find(id);
+	if (item_it != mItemKeys.end())
+	{
+		const LLItemKeys& keys = item_it->second;
+		if (keys.mIsLink)
+		{
+			eraseKey(mByLinkTarget, keys.mAssetID, id);
+		}
+		else
+		{
+			eraseKey(mByAsset, keys.mAssetID, id);
+			eraseKey(mByType, (S32)keys.mInvType, id);
+		}
+		mItemKeys.erase(item_it);
+		return;
+	}
+
+	category_names_t::iterator cat_it = mCategoryNames.find(id);
+	if (cat_it != mCategoryNames.end())
+	{
+		eraseKey(mCategoriesByName, cat_it->second, id);
+		mCategoryNames.erase(cat_it);
+	}
+}
+
+void LLInventoryIndex::clear()
+{
+	mItemKeys.clear();
+	mCategoryNames.clear();
+	mByAsset.clear();
+	mByType.clear();
+	mByLinkTarget.clear();
+	mCategoriesByName.clear();
+}
+
+const LLInventoryIndex::id_set_t* LLInventoryIndex::getItemsByAsset(const LLUUID& asset_id) const
+{
+	return findKey(mByAsset, asset_id);
+}
+
+const LLInventoryIndex::id_set_t* LLInventoryIndex::getItemsByType(LLInventoryType::EType inv_type) const
+{
+	return findKey(mByType, (S32)inv_type);
+}
+
+const LLInventoryIndex::id_set_t* LLInventoryIndex::getLinksTo(const LLUUID& target_id) const
+{
+	return findKey(mByLinkTarget, target_id);
+}
+
+const LLInventoryIndex::id_set_t* LLInventoryIndex::getCategoriesByName(const std::string& name) const
+{
+	return findKey(mCategoriesByName, makeNameKey(name));
+}
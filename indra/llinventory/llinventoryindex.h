@@ -0,0 +1,139 @@
+/** 
+ * @file llinventoryindex.h
+ * @brief LLInventoryIndex class declaration.
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYINDEX_H
+#define LL_LLINVENTORYINDEX_H
+
+#include <string>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "llinventorytype.h"
+#include "lluuid.h"
+
+class LLInventoryItem;
+class LLInventoryCategory;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LLInventoryIndex
+//
+// Secondary lookup tables for an inventory. Maps asset id, inventory
+// type and link target of items, and lowercased category names, to the
+// ids of the objects that have them, so that common queries don't have to walk the whole
+// parent-child tree.
+//
+//   NOTE: The index only stores ids. The owner is responsible for calling
+//   addItem()/removeItem() whenever an item is added, deleted or modified;
+//   keys are remembered per item so removal works even after the item
+//   was changed in place.
+//
+//   Link items are only indexed by their link target. Asset and type
+//   queries return real items only.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLInventoryIndex
+{
+public:
+	typedef boost::unordered_set<LLUUID> id_set_t;
+
+	LLInventoryIndex();
+
+	// (Re)index an item or category. Adding an already known id first
+	// drops its old keys.
+	void addItem(const LLInventoryItem* item);
+	void addCategory(const LLInventoryCategory* cat);
+
+	// Remove an object of either kind. Unknown ids are ignored.
+	void removeObject(const LLUUID& id);
+	void clear();
+
+	// Queries. Return NULL when nothing matches. The returned set points
+	// into the index and is only valid until the next modification.
+	const id_set_t* getItemsByAsset(const LLUUID& asset_id) const;
+	const id_set_t* getItemsByType(LLInventoryType::EType inv_type) const;
+	const id_set_t* getLinksTo(const LLUUID& target_id) const;
+	// Case insensitive.
+	const id_set_t* getCategoriesByName(const std::string& name) const;
+
+	S32 getItemCount() const { return (S32)mItemKeys.size(); }
+	S32 getCategoryCount() const { return (S32)mCategoryNames.size(); }
+
+	static std::string makeNameKey(const std::string& name);
+
+private:
+	struct LLItemKeys
+	{
+		LLItemKeys() : mInvType(LLInventoryType::IT_NONE), mIsLink(false) {}
+		LLUUID mAssetID; // link target for links
+		LLInventoryType::EType mInvType;
+		bool mIsLink;
+	};
+
+	template<typename KEY>
+	static void insertKey(boost::unordered_map<KEY, id_set_t>& index, const KEY& key, const LLUUID& id)
+	{
+		index[key].insert(id);
+	}
+
+	template<typename KEY>
+	static void eraseKey(boost::unordered_map<KEY, id_set_t>& index, const KEY& key, const LLUUID& id)
+	{
+		typename boost::unordered_map<KEY, id_set_t>::iterator it = index.find(key);
+		if (it != index.end())
+		{
+			it->second.erase(id);
+			if (it->second.empty())
+			{
+				index.erase(it);
+			}
+		}
+	}
+
+	template<typename KEY>
+	static const id_set_t* findKey(const boost::unordered_map<KEY, id_set_t>& index, const KEY& key)
+	{
+		typename boost::unordered_map<KEY, id_set_t>::const_iterator it = index.find(key);
+		return (it != index.end()) ? &it->second : NULL;
+	}
+
+	typedef boost::unordered_map<LLUUID, LLItemKeys> item_keys_t;
+	typedef boost::unordered_map<LLUUID, std::string> category_names_t;
+
+	item_keys_t mItemKeys;
+	category_names_t mCategoryNames;
+
+	boost::unordered_map<LLUUID, id_set_t> mByAsset;
+	boost::unordered_map<S32, id_set_t> mByType;
+	boost::unordered_map<LLUUID, id_set_t> mByLinkTarget;
+	boost::unordered_map<std::string, id_set_t> mCategoriesByName;
+};
+
+#endif // LL_LLINVENTORYINDEX_H
@@ -38,8 +38,49 @@
 #include "llmath.h"
 #include "llmemtype.h"
 #include "llstl.h"
+#include "llthread.h"
 #include <iterator> //VS2010
 
+/** 
+ * Heap buffer chunk pool
+ */
+static const S32 DEFAULT_HEAP_BUFFER_SIZE = 16384;
+
+// Enough to cover a few concurrent HTTP bodies per thread without
+// holding on to a large amount of idle memory.
+static const S32 MAX_POOLED_HEAP_BUFFERS = 32;
+
+// Free chunks are linked through their first bytes. The pool is per
+// thread so that neither allocation nor release needs a lock.
+static ll_thread_local U8* sFreeHeapBuffers = NULL;
+static ll_thread_local S32 sFreeHeapBufferCount = 0;
+
+static U8* allocate_heap_chunk(S32 size)
+{
+	if((DEFAULT_HEAP_BUFFER_SIZE == size) && sFreeHeapBuffers)
+	{
+		U8* chunk = sFreeHeapBuffers;
+		memcpy(&sFreeHeapBuffers, chunk, sizeof(U8*));	/*Flawfinder: ignore*/
+		--sFreeHeapBufferCount;
+		return chunk;
+	}
+	return new U8[size];
+}
+
+static void free_heap_chunk(U8* chunk, S32 size)
+{
+	if(chunk
+	   && (DEFAULT_HEAP_BUFFER_SIZE == size)
+	   && (sFreeHeapBufferCount < MAX_POOLED_HEAP_BUFFERS))
+	{
+		memcpy(chunk, &sFreeHeapBuffers, sizeof(U8*));	/*Flawfinder: ignore*/
+		sFreeHeapBuffers = chunk;
+		++sFreeHeapBufferCount;
+		return;
+	}
+	delete[] chunk;
+}
+
 /** 
  * LLSegment
  */
@@ -109,7 +150,6 @@ LLHeapBuffer::LLHeapBuffer() :
 	mReclaimedBytes(0)
 {
 	LLMemType m1(LLMemType::MTYPE_IO_BUFFER);
-	const S32 DEFAULT_HEAP_BUFFER_SIZE = 16384;
 	allocate(DEFAULT_HEAP_BUFFER_SIZE);
 }
 
@@ -144,7 +184,7 @@ LLHeapBuffer::LLHeapBuffer(const U8* src, S32 len) :
 LLHeapBuffer::~LLHeapBuffer()
 {
 	LLMemType m1(LLMemType::MTYPE_IO_BUFFER);
-	delete[] mBuffer;
+	free_heap_chunk(mBuffer, mSize);
 	mBuffer = NULL;
 	mSize = 0;
 	mNextFree = NULL;
@@ -155,6 +195,12 @@ S32 LLHeapBuffer::bytesLeft() const
 	return (mSize - (mNextFree - mBuffer));
 }
 
+// static
+S32 LLHeapBuffer::getPooledChunkCount()
+{
+	return sFreeHeapBufferCount;
+}
+
 // virtual
 bool LLHeapBuffer::createSegment(
 	S32 channel,
@@ -218,7 +264,7 @@ void LLHeapBuffer::allocate(S32 size)
 {
 	LLMemType m1(LLMemType::MTYPE_IO_BUFFER);
 	mReclaimedBytes = 0;	
-	mBuffer = new U8[size];
+	mBuffer = allocate_heap_chunk(size);
 	if(mBuffer)
 	{
 		mSize = size;
@@ -716,6 +762,124 @@ U8* LLBufferArray::seek(
 	return rv;
 }
 
+S32 LLBufferArray::gatherSegments(
+	S32 channel,
+	U8* start,
+	LLSegment* segments,
+	S32 max_segments) const
+{
+	if(!segments || (max_segments <= 0))
+	{
+		return 0;
+	}
+	const_segment_iterator_t it;
+	const_segment_iterator_t end = mSegments.end();
+	U8* first = NULL;
+	if(start)
+	{
+		it = getSegment(start);
+		if(it == end)
+		{
+			return 0;
+		}
+		if((++start < ((*it).data() + (*it).size()))
+		   && (*it).isOnChannel(channel))
+		{
+			// it's in the same segment
+			first = start;
+		}
+		else
+		{
+			++it;
+		}
+	}
+	else
+	{
+		it = mSegments.begin();
+	}
+
+	S32 count = 0;
+	for( ; it != end; ++it)
+	{
+		if(!(*it).isOnChannel(channel))
+		{
+			continue;
+		}
+		U8* data = first ? first : (*it).data();
+		S32 size = (*it).size() - (data - (*it).data());
+		first = NULL;
+		if(size <= 0)
+		{
+			continue;
+		}
+		if(count
+		   && (segments[count - 1].data() + segments[count - 1].size() == data))
+		{
+			// contiguous with the previous run
+			segments[count - 1] = LLSegment(
+				channel,
+				segments[count - 1].data(),
+				segments[count - 1].size() + size);
+			continue;
+		}
+		if(count == max_segments)
+		{
+			break;
+		}
+		segments[count++] = LLSegment(channel, data, size);
+	}
+	return count;
+}
+
+U8* LLBufferArray::getContiguousData(S32 channel, S32& len) const
+{
+	len = 0;
+	U8* rv = NULL;
+	const_segment_iterator_t it = mSegments.begin();
+	const_segment_iterator_t end = mSegments.end();
+	for( ; it != end; ++it)
+	{
+		if(!(*it).isOnChannel(channel) || !(*it).size())
+		{
+			continue;
+		}
+		if(!rv)
+		{
+			rv = (*it).data();
+		}
+		else if((rv + len) != (*it).data())
+		{
+			// scattered
+			len = 0;
+			return NULL;
+		}
+		len += (*it).size();
+	}
+	return rv;
+}
+
+U8* LLBufferArray::readContiguous(
+	S32 channel,
+	S32& len,
+	std::vector<U8>& scratch) const
+{
+	LLMemType m1(LLMemType::MTYPE_IO_BUFFER);
+	U8* rv = getContiguousData(channel, len);
+	if(rv)
+	{
+		return rv;
+	}
+	len = countAfter(channel, NULL);
+	if(len <= 0)
+	{
+		len = 0;
+		return NULL;
+	}
+	scratch.resize(len);
+	readAfter(channel, NULL, &scratch[0], len);
+	return &scratch[0];
+}
+
 bool LLBufferArray::takeContents(LLBufferArray& source)
 {
 	LLMemType m1(LLMemType::MTYPE_IO_BUFFER);
@@ -198,7 +198,8 @@ public:
  *
  * This class is a simple buffer implementation which allocates chunks
  * off the heap. Once a buffer is constructed, it's buffer has a fixed
- * length.
+ * length. Default sized chunks are recycled through a small per thread
+ * pool instead of going back to the heap every time.
  */
 class LLHeapBuffer : public LLBuffer
 {
@@ -281,6 +282,11 @@ public:
 	 */
 	virtual S32 capacity() const { return mSize; }
 
+	/** 
+	 * @brief Return the number of chunks pooled by the calling thread.
+	 */
+	static S32 getPooledChunkCount();
+
 protected:
 	U8* mBuffer;
 	S32 mSize;
@@ -300,7 +306,9 @@ private:
  * @brief Class to represent scattered memory buffers and in-order segments
  * of that buffered data.
  *
- * *NOTE: This class needs to have an iovec interface
+ * Use gatherSegments() to hand a channel to scatter/gather (writev
+ * style) I/O, and getContiguousData() or readContiguous() to read a
+ * channel as one block without flattening it when it is not needed.
  */
 class LLBufferArray
 {
@@ -454,6 +462,55 @@ public:
 	 * @return Returns the address of the last read byte.
 	 */
 	U8* seek(S32 channel, U8* start, S32 delta) const;
+
+	/** 
+	 * @brief Describe the bytes on a channel as a list of contiguous
+	 * runs of memory, for scatter/gather I/O.
+	 *
+	 * Adjacent segments which are also adjacent in memory are merged
+	 * into one entry.
+	 * @param channel The channel to gather.
+	 * @param start The start address in the array. The first entry
+	 * begins after this byte. You can specify NULL to start at the
+	 * beginning.
+	 * @param segments[out] Array of at least max_segments entries.
+	 * @param max_segments The size of segments.
+	 * @return Returns the number of entries filled in, which is zero if
+	 * there is no data on the channel after start.
+	 */
+	S32 gatherSegments(
+		S32 channel,
+		U8* start,
+		LLSegment* segments,
+		S32 max_segments) const;
+
+	/** 
+	 * @brief Get all bytes on a channel as one block of memory without
+	 * copying.
+	 *
+	 * This works whenever the channel data is adjacent in memory, which
+	 * is the usual case for bodies that fit in one buffer since
+	 * consecutive appends are carved out of the same chunk.
+	 * @param channel The channel to read.
+	 * @param len[out] The number of bytes on the channel.
+	 * @return Returns the first byte on the channel, or NULL if the
+	 * channel is empty or scattered.
+	 */
+	U8* getContiguousData(S32 channel, S32& len) const;
+
+	/** 
+	 * @brief Get all bytes on a channel as one block of memory, only
+	 * copying them into scratch if they are scattered.
+	 *
+	 * The returned memory stays valid until this buffer array or
+	 * scratch is changed.
+	 * @param channel The channel to read.
+	 * @param len[out] The number of bytes on the channel.
+	 * @param scratch Storage used when the data has to be gathered.
+	 * @return Returns the first byte on the channel, or NULL if the
+	 * channel is empty.
+	 */
+	U8* readContiguous(S32 channel, S32& len, std::vector<U8>& scratch) const;
 	//@}
 
 	/* @name Buffer interaction
@@ -91,6 +91,9 @@ LLCircuitData::LLCircuitData(const LLHost &host, TPACKETID in_id,
 	mLastPingID(0),
 	mPingDelay(INITIAL_PING_VALUE_MSEC), 
 	mPingDelayAveraged((F32)INITIAL_PING_VALUE_MSEC), 
+	mRecentlyReceivedReliablePackets(LL_MAX_OUT_PACKET_ID, LL_DUPLICATE_SUPPRESSION_WINDOW),
+	mUnackedPackets(LL_MAX_OUT_PACKET_ID, LL_MAX_OUT_PACKET_ID),
+	mFinalRetryPackets(LL_MAX_OUT_PACKET_ID, LL_MAX_OUT_PACKET_ID),
 	mUnackedPacketCount(0),
 	mUnackedPacketBytes(0),
 	mLastPacketInTime(0.0),
@@ -110,6 +113,7 @@ LLCircuitData::LLCircuitData(const LLHost &host, TPACKETID in_id,
 	mPeriodTime(0.0),
 	mExistenceTimer(),
 	mCurrentResendCount(0),
+	mPacketsResent(0),
 	mLastPacketGap(0),
 	mHeartbeatInterval(circuit_heartbeat_interval), 
 	mHeartbeatTimeout(circuit_timeout)
@@ -138,11 +142,14 @@ LLCircuitData::~LLCircuitData()
 
 	// remove all pending reliable messages on this circuit
 	std::vector<TPACKETID> doomed;
-	reliable_iter iter;
-	reliable_iter end = mUnackedPackets.end();
-	for(iter = mUnackedPackets.begin(); iter != end; ++iter)
+	for (S32 i = 0; i < mUnackedPackets.slotCount(); ++i)
 	{
-		packetp = iter->second;
+		packetp = mUnackedPackets.slot(i);
+		if (!packetp)
+		{
+			continue;
+		}
+		mUnackedPackets.clearSlot(i);
 		gMessageSystem->mFailedResendPackets++;
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -161,10 +168,14 @@ LLCircuitData::~LLCircuitData()
 	}
 
 	// remove all pending final retry reliable messages on this circuit
-	end = mFinalRetryPackets.end();
-	for(iter = mFinalRetryPackets.begin(); iter != end; ++iter)
+	for (S32 i = 0; i < mFinalRetryPackets.slotCount(); ++i)
 	{
-		packetp = iter->second;
+		packetp = mFinalRetryPackets.slot(i);
+		if (!packetp)
+		{
+			continue;
+		}
+		mFinalRetryPackets.clearSlot(i);
 		gMessageSystem->mFailedResendPackets++;
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -196,13 +207,11 @@ LLCircuitData::~LLCircuitData()
 
 void LLCircuitData::ackReliablePacket(TPACKETID packet_num)
 {
-	reliable_iter iter;
 	LLReliablePacket *packetp;
 
-	iter = mUnackedPackets.find(packet_num);
-	if (iter != mUnackedPackets.end())
+	packetp = mUnackedPackets.find(packet_num);
+	if (packetp)
 	{
-		packetp = iter->second;
 
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -228,15 +237,14 @@ void LLCircuitData::ackReliablePacket(TPACKETID packet_num)
 		mUnackedPacketBytes -= packetp->mBufferLength;
 
 		// Cleanup
+		mUnackedPackets.remove(packet_num);
 		delete packetp;
-		mUnackedPackets.erase(iter);
 		return;
 	}
 
-	iter = mFinalRetryPackets.find(packet_num);
-	if (iter != mFinalRetryPackets.end())
+	packetp = mFinalRetryPackets.find(packet_num);
+	if (packetp)
 	{
-		packetp = iter->second;
 		// llinfos << "Packet " << packet_num << " removed from the pending list" << llendl;
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -262,8 +270,8 @@ void LLCircuitData::ackReliablePacket(TPACKETID packet_num)
 		mUnackedPacketBytes -= packetp->mBufferLength;
 
 		// Cleanup
+		mFinalRetryPackets.remove(packet_num);
 		delete packetp;
-		mFinalRetryPackets.erase(iter);
 	}
 	else
 	{
@@ -280,18 +288,18 @@ S32 LLCircuitData::resendUnackedPackets(const F64 now)
 	LLReliablePacket *packetp;
 
 
-	//
-	// Theoretically we should search through the list for the packet with the oldest
-	// packet ID, as otherwise when we WRAP we will resend reliable packets out of order.
-	// Since resends are ALREADY out of order, and wrapping is highly rare (16+million packets),
-	// I'm not going to worry about this for now - djs
-	//
-
-	reliable_iter iter;
+	// The unacked window is kept in send order, so this walks from the
+	// oldest packet to the newest even across a wrap of the packet IDs.
+	// Emptied slots are only trimmed once the walk is done.
 	BOOL have_resend_overflow = FALSE;
-	for (iter = mUnackedPackets.begin(); iter != mUnackedPackets.end();)
+	S32 resend_backlog_bytes = 0;	// due for a resend but held back by the throttle
+	for (S32 i = 0; i < mUnackedPackets.slotCount(); ++i)
 	{
-		packetp = iter->second;
+		packetp = mUnackedPackets.slot(i);
+		if (!packetp)
+		{
+			continue;
+		}
 
 		// Only check overflow if we haven't had one yet.
 		if (!have_resend_overflow)
@@ -312,25 +320,20 @@ S32 LLCircuitData::resendUnackedPackets(const F64 now)
 					// This circuit has overflowed.  Do not retry.  Do not pass go.
 					packetp->mRetries = 0;
 					// Remove it from this list and add it to the final list.
-					mUnackedPackets.erase(iter++);
-					mFinalRetryPackets[packetp->mPacketID] = packetp;
-				}
-				else
-				{
-					++iter;
+					mUnackedPackets.clearSlot(i);
+					mFinalRetryPackets.insert(packetp->mPacketID, packetp);
 				}
 				// Move on to the next unacked packet.
 				continue;
 			}
-			
-			if (mUnackedPacketBytes > 256000 && !(getPacketsOut() % 1024))
+
+			// Stop resending.  There are less than 512000 unacked packets.
+			// Keep walking only to total what is due and held back.
+			if (now > packetp->mExpirationTime)
 			{
-				// Warn if we've got a lot of resends waiting.
-				llwarns << mHost << " has " << mUnackedPacketBytes 
-						<< " bytes of reliable messages waiting" << llendl;
+				resend_backlog_bytes += packetp->mBufferLength;
 			}
-			// Stop resending.  There are less than 512000 unacked packets.
-			break;
+			continue;
 		}
 
 		if (now > packetp->mExpirationTime)
@@ -339,6 +342,7 @@ S32 LLCircuitData::resendUnackedPackets(const F64 now)
 			
 			// retry		
 			mCurrentResendCount++;
+			mPacketsResent++;
 
 			gMessageSystem->mResentPackets++;
 
@@ -372,28 +376,31 @@ S32 LLCircuitData::resendUnackedPackets(const F64 now)
 			if (!packetp->mRetries)
 			{
 				// Last resend, remove it from this list and add it to the final list.
-				mUnackedPackets.erase(iter++);
-				mFinalRetryPackets[packetp->mPacketID] = packetp;
-			}
-			else
-			{
-				// Don't remove it yet, it still gets to try to resend at least once.
-				++iter;
+				// Otherwise it still gets to try to resend at least once.
+				mUnackedPackets.clearSlot(i);
+				mFinalRetryPackets.insert(packetp->mPacketID, packetp);
 			}
 			resent_packets++;
 		}
-		else
+	}
+	mUnackedPackets.trim();
+
+	if (have_resend_overflow)
+	{
+		if (mUnackedPacketBytes > 256000 && !(getPacketsOut() % 1024))
 		{
-			// Don't need to do anything with this packet, keep iterating.
-			++iter;
+			// Warn if we've got a lot of resends waiting.
+			llwarns << mHost << " has " << mUnackedPacketBytes 
+					<< " bytes of reliable messages waiting" << llendl;
 		}
+		mThrottles.noteQueueDepth(TC_RESEND, resend_backlog_bytes * 8.f);
 	}
 
 
-	for (iter = mFinalRetryPackets.begin(); iter != mFinalRetryPackets.end();)
+	for (S32 i = 0; i < mFinalRetryPackets.slotCount(); ++i)
 	{
-		packetp = iter->second;
-		if (now > packetp->mExpirationTime)
+		packetp = mFinalRetryPackets.slot(i);
+		if (packetp && now > packetp->mExpirationTime)
 		{
 			// fail (too many retries)
 			//llinfos << "Packet " << packetp->mPacketID << " removed from the pending list: exceeded retry limit" << llendl;
@@ -420,14 +427,11 @@ S32 LLCircuitData::resendUnackedPackets(const F64 now)
 			mUnackedPacketCount--;
 			mUnackedPacketBytes -= packetp->mBufferLength;
 
-			mFinalRetryPackets.erase(iter++);
+			mFinalRetryPackets.clearSlot(i);
 			delete packetp;
 		}
-		else
-		{
-			++iter;
-		}
 	}
+	mFinalRetryPackets.trim();
 
 	return mUnackedPacketCount;
 }
@@ -579,11 +583,11 @@ void LLCircuitData::addReliablePacket(S32 mSocket, U8 *buf_ptr, S32 buf_len, LLR
 
 	if (params && params->mRetries)
 	{
-		mUnackedPackets[packet_info->mPacketID] = packet_info;
+		mUnackedPackets.insert(packet_info->mPacketID, packet_info);
 	}
 	else
 	{
-		mFinalRetryPackets[packet_info->mPacketID] = packet_info;
+		mFinalRetryPackets.insert(packet_info->mPacketID, packet_info);
 	}
 }
 
@@ -607,7 +611,7 @@ void LLCircuit::resendUnackedPackets(S32& unacked_list_length, S32& unacked_list
 
 BOOL LLCircuitData::isDuplicateResend(TPACKETID packetnum)
 {
-	return (mRecentlyReceivedReliablePackets.find(packetnum) != mRecentlyReceivedReliablePackets.end());
+	return mRecentlyReceivedReliablePackets.find(packetnum) != 0;
 }
 
 
@@ -835,6 +839,9 @@ void LLCircuit::updateWatchDogTimers(LLMessageSystem *msgsys)
 				mPingSet.insert(cdp);
     
 			    // Update our throttles
+			    cdp->mThrottles.updateLinkStats(cdp->getPingDelayAveraged(),
+												cdp->getPacketsOut(),
+												cdp->getPacketsResent());
 			    cdp->mThrottles.dynamicAdjust();
     
 			    // Update some stats, this is not terribly important
@@ -870,91 +877,32 @@ BOOL LLCircuitData::updateWatchDogTimers(LLMessageSystem *msgsys)
 	// for the packet that it was out of order with was received BEFORE
 	// the ping was sent.
 
-	// Find the current oldest reliable packetID
-	// This is to handle the case if we actually manage to wrap our
-	// packet IDs - the oldest will actually have a higher packet ID
-	// than the current.
-	BOOL wrapped = FALSE;
-	reliable_iter iter;
-	iter = mUnackedPackets.upper_bound(getPacketOutID());
-	if (iter == mUnackedPackets.end())
+	// Find the current oldest reliable packetID.
+	// Both lists are kept in send order, so wrapping our packet IDs needs
+	// no special handling: the oldest is simply the first of either list.
+	TPACKETID packet_id;
+	if (mUnackedPackets.empty() && mFinalRetryPackets.empty())
 	{
-		// Nothing AFTER this one, so we want the lowest packet ID
-		// then.
-		iter = mUnackedPackets.begin();
-		wrapped = TRUE;
+		// Wow!  No unacked packets at all!
+		// Send the ID of the last packet we sent out.
+		// This will flush all of the destination's
+		// unacked packets, theoretically.
+		packet_id = getPacketOutID();
 	}
-
-	TPACKETID packet_id = 0;
-
-	// Check against the "final" packets
-	BOOL wrapped_final = FALSE;
-	reliable_iter iter_final;
-	iter_final = mFinalRetryPackets.upper_bound(getPacketOutID());
-	if (iter_final == mFinalRetryPackets.end())
+	else if (mFinalRetryPackets.empty())
 	{
-		iter_final = mFinalRetryPackets.begin();
-		wrapped_final = TRUE;
+		packet_id = mUnackedPackets.oldestID();
 	}
-
-	//llinfos << mHost << " - unacked count " << mUnackedPackets.size() << llendl;
-	//llinfos << mHost << " - final count " << mFinalRetryPackets.size() << llendl;
-	if (wrapped != wrapped_final)
+	else if (mUnackedPackets.empty())
 	{
-		// One of the "unacked" or "final" lists hasn't wrapped.  Whichever one
-		// hasn't has the oldest packet.
-		if (!wrapped)
-		{
-			// Hasn't wrapped, so the one on the
-			// unacked packet list is older
-			packet_id = iter->first;
-			//llinfos << mHost << ": nowrapped unacked" << llendl;
-		}
-		else
-		{
-			packet_id = iter_final->first;
-			//llinfos << mHost << ": nowrapped final" << llendl;
-		}
+		packet_id = mFinalRetryPackets.oldestID();
 	}
 	else
 	{
-		// They both wrapped, we can just use the minimum of the two.
-		if ((iter == mUnackedPackets.end()) && (iter_final == mFinalRetryPackets.end()))
+		packet_id = mUnackedPackets.oldestID();
+		if (mUnackedPackets.isOlder(mFinalRetryPackets.oldestID(), packet_id))
 		{
-			// Wow!  No unacked packets at all!
-			// Send the ID of the last packet we sent out.
-			// This will flush all of the destination's
-			// unacked packets, theoretically.
-			//llinfos << mHost << ": No unacked!" << llendl;
-			packet_id = getPacketOutID();
-		}
-		else
-		{
-			BOOL had_unacked = FALSE;
-			if (iter != mUnackedPackets.end())
-			{
-				// Unacked list has the lowest so far
-				packet_id = iter->first;
-				had_unacked = TRUE;
-				//llinfos << mHost << ": Unacked" << llendl;
-			}
-
-			if (iter_final != mFinalRetryPackets.end())
-			{
-				// Use the lowest of the unacked list and the final list
-				if (had_unacked)
-				{
-					// Both had a packet, use the lowest.
-					packet_id = llmin(packet_id, iter_final->first);
-					//llinfos << mHost << ": Min of unacked/final" << llendl;
-				}
-				else
-				{
-					// Only the final had a packet, use it.
-					packet_id = iter_final->first;
-					//llinfos << mHost << ": Final!" << llendl;
-				}
-			}
+			packet_id = mFinalRetryPackets.oldestID();
 		}
 	}
 
@@ -1009,43 +957,12 @@ void LLCircuitData::clearDuplicateList(TPACKETID oldest_id)
 
 	//llinfos << mHost << ": clearing before oldest " << oldest_id << llendl;
 	//llinfos << "Recent list before: " << mRecentlyReceivedReliablePackets.size() << llendl;
-	if (oldest_id < mHighestPacketID)
-	{
-		// Clean up everything with a packet ID less than oldest_id.
-		packet_time_map::iterator pit_start;
-		packet_time_map::iterator pit_end;
-		pit_start = mRecentlyReceivedReliablePackets.begin();
-		pit_end = mRecentlyReceivedReliablePackets.lower_bound(oldest_id);
-		mRecentlyReceivedReliablePackets.erase(pit_start, pit_end);
-	}
 
-	// Do timeout checks on everything with an ID > mHighestPacketID.
-	// This should be empty except for wrapping IDs.  Thus, this should be
-	// highly rare.
-	U64 mt_usec = LLMessageSystem::getMessageTimeUsecs();
+	// The window is ordered by arrival around the wrap of the ID space, so
+	// this also takes care of the wrapped IDs that used to need timeouts.
+	// IDs far ahead of anything seen are bounded by the window size.
+	mRecentlyReceivedReliablePackets.removeBefore(oldest_id);
 
-	packet_time_map::iterator pit;
-	for(pit = mRecentlyReceivedReliablePackets.upper_bound(mHighestPacketID);
-		pit != mRecentlyReceivedReliablePackets.end(); )
-	{
-		// Validate that the packet ID seems far enough away
-		if ((pit->first - mHighestPacketID) < 100)
-		{
-			llwarns << "Probably incorrectly timing out non-wrapped packets!" << llendl;
-		}
-		U64 delta_t_usec = mt_usec - (*pit).second;
-		F64 delta_t_sec = delta_t_usec * SEC_PER_USEC;
-		if (delta_t_sec > LL_DUPLICATE_SUPPRESSION_TIMEOUT)
-		{
-			// enough time has elapsed we're not likely to get a duplicate on this one
-			llinfos << "Clearing " << pit->first << " from recent list" << llendl;
-			mRecentlyReceivedReliablePackets.erase(pit++);
-		}
-		else
-		{
-			++pit;
-		}
-	}
 	//llinfos << "Recent list after: " << mRecentlyReceivedReliablePackets.size() << llendl;
 }
 
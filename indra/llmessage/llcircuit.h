@@ -44,6 +44,7 @@
 #include "net.h"
 #include "llhost.h"
 #include "llpacketack.h"
+#include "llpacketidring.h"
 #include "lluuid.h"
 #include "llthrottle.h"
 #include "llstat.h"
@@ -59,6 +60,10 @@ const U32 INITIAL_PING_VALUE_MSEC = 1000; // initial value for the ping delay, o
 
 const TPACKETID LL_MAX_OUT_PACKET_ID = 0x01000000;
 
+// Duplicate suppression remembers at most this many incoming packet IDs
+// behind the newest one, normally the peer's OldestUnacked trims it first.
+const S32 LL_DUPLICATE_SUPPRESSION_WINDOW = 65536;
+
 // 0 - flags
 // [1,4] - packetid
 // 5 - data offset (after message name)
@@ -126,6 +131,7 @@ public:
 	S32			getBytesOut() const;
 	U32			getPacketsOut() const;
 	U32			getPacketsLost() const;
+	U32			getPacketsResent() const		{ return mPacketsResent; }
 	TPACKETID	getPacketOutID() const;
 	BOOL		getTrusted() const;
 	F32 getAgeInSeconds() const;
@@ -243,14 +249,13 @@ protected:
 	typedef std::map<TPACKETID, U64> packet_time_map;
 
 	packet_time_map							mPotentialLostPackets;
-	packet_time_map							mRecentlyReceivedReliablePackets;
+	LLPacketIDRing<U8>						mRecentlyReceivedReliablePackets;	// 1 for each reliable ID seen
 	std::vector<TPACKETID> mAcks;
 
-	typedef std::map<TPACKETID, LLReliablePacket *> reliable_map;
-	typedef reliable_map::iterator					reliable_iter;
+	typedef LLPacketIDRing<LLReliablePacket *> reliable_ring;
 
-	reliable_map							mUnackedPackets;
-	reliable_map							mFinalRetryPackets;
+	reliable_ring							mUnackedPackets;
+	reliable_ring							mFinalRetryPackets;
 
 	S32										mUnackedPacketCount;
 	S32										mUnackedPacketBytes;
@@ -281,6 +286,7 @@ protected:
 	LLTimer	mExistenceTimer;	    // initialized when circuit created, used to track bandwidth numbers
 
 	S32		mCurrentResendCount;	// Number of resent packets since last spam
+	U32		mPacketsResent;			// Total resent packets, feeds the throttle's link estimate
     LLStatRate  mOutOfOrderRate;    // Rate of out of order packets coming in.
     U32     mLastPacketGap;         // Gap in sequence number of last packet.
 
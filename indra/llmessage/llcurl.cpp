@@ -53,6 +53,7 @@
 
 #include "llbufferstream.h"
 #include "llsdserialize.h"
+#include "lluri.h"
 #include "llstl.h"
 #include "llthread.h"
 #include "llsocks5.h"
@@ -70,13 +71,13 @@
 
 	Furthermore, it would behoove us to keep track of which
 	hosts an easy handle was used for and pick an easy handle
-	that matches the next request.  This code does not current
-	do this.
+	that matches the next request.  Multi::allocEasy() does
+	this when it is given the host.
  */
 
 //////////////////////////////////////////////////////////////////////////////
 
-static const U32 EASY_HANDLE_POOL_SIZE		= 5;
+static const U32 EASY_HANDLE_POOL_SIZE		= 16;
 static const S32 MULTI_PERFORM_CALL_REPEAT	= 5;
 static const S32 CURL_REQUEST_TIMEOUT = 30; // seconds
 static const S32 MAX_ACTIVE_REQUEST_COUNT = 100;
@@ -94,6 +95,7 @@ std::string LLCurl::sCAPath;
 std::string LLCurl::sCAFile;
 
 bool LLCurl::sMultiThreaded = false;
+bool LLCurl::sPipelining = false;
 static U32 sMainThreadID = 0;
 
 void check_curl_code(CURLcode code)
@@ -128,6 +130,12 @@ void LLCurl::setCAFile(const std::string& file)
 	sCAFile = file;
 }
 
+//static
+void LLCurl::setPipelining(bool pipelining)
+{
+	sPipelining = pipelining;
+}
+
 //static
 std::string LLCurl::getVersionString()
 {
@@ -539,6 +547,7 @@ void LLCurl::Easy::prepRequest(const std::string& url,
 	setopt(CURLOPT_TIMEOUT, llmax(time_out, CURL_REQUEST_TIMEOUT));
 
 	setoptString(CURLOPT_URL, url);
+	mHost = LLURI(url).authority();
 
 	mResponder = responder;
 
@@ -584,6 +593,13 @@ LLCurl::Multi::Multi()
 	
 	llassert_always(mCurlMultiHandle);
 	++gCurlMultiCount;
+
+	// Keep enough connections cached for every handle in the pool.
+	check_curl_multi_code(curl_multi_setopt(mCurlMultiHandle, CURLMOPT_MAXCONNECTS, (long)MAX_ACTIVE_REQUEST_COUNT));
+	if (LLCurl::sPipelining)
+	{
+		check_curl_multi_code(curl_multi_setopt(mCurlMultiHandle, CURLMOPT_PIPELINING, 1L));
+	}
 }
 
 LLCurl::Multi::~Multi()
@@ -730,7 +746,7 @@ S32 LLCurl::Multi::process()
 	return processed;
 }
 
-LLCurl::Easy* LLCurl::Multi::allocEasy()
+LLCurl::Easy* LLCurl::Multi::allocEasy(const std::string& host)
 {
 	Easy* easy = 0;
 
@@ -740,8 +756,21 @@ LLCurl::Easy* LLCurl::Multi::allocEasy()
 	}
 	else
 	{
-		easy = *(mEasyFreeList.begin());
-		mEasyFreeList.erase(easy);
+		easy_free_list_t::iterator iter = mEasyFreeList.begin();
+		if (!host.empty())
+		{
+			for (easy_free_list_t::iterator match = mEasyFreeList.begin();
+				 match != mEasyFreeList.end(); ++match)
+			{
+				if ((*match)->getHost() == host)
+				{
+					iter = match;
+					break;
+				}
+			}
+		}
+		easy = *iter;
+		mEasyFreeList.erase(iter);
 	}
 	if (easy)
 	{
@@ -842,17 +871,19 @@ void LLCurlRequest::addMulti()
 	mActiveRequestCount = 0;
 }
 
-LLCurl::Easy* LLCurlRequest::allocEasy()
+LLCurl::Easy* LLCurlRequest::allocEasy(const std::string& host)
 {
+	// Only move on to a new multi when this one is full or has
+	// failed, since its connections go with it.
 	if (!mActiveMulti ||
-		mActiveRequestCount	>= MAX_ACTIVE_REQUEST_COUNT ||
+		mActiveMulti->getActiveCount() >= MAX_ACTIVE_REQUEST_COUNT ||
 		mActiveMulti->mErrorCount > 0)
 	{
 		addMulti();
 	}
 	llassert_always(mActiveMulti);
 	++mActiveRequestCount;
-	LLCurl::Easy* easy = mActiveMulti->allocEasy();
+	LLCurl::Easy* easy = mActiveMulti->allocEasy(host);
 	return easy;
 }
 
@@ -878,7 +909,7 @@ bool LLCurlRequest::getByteRange(const std::string& url,
 								 S32 offset, S32 length,
 								 LLCurl::ResponderPtr responder)
 {
-	LLCurl::Easy* easy = allocEasy();
+	LLCurl::Easy* easy = allocEasy(LLURI(url).authority());
 	if (!easy)
 	{
 		return false;
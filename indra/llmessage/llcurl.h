@@ -164,6 +164,12 @@ public:
 	 */
 	static const std::string& getCAPath() { return sCAPath; }
 
+	/**
+	 * @ brief Ask multi handles created after this call to pipeline
+	 * requests to the same host over one connection.
+	 */
+	static void setPipelining(bool pipelining);
+
 	/**
 	 * @ brief Initialize LLCurl class
 	 */
@@ -189,6 +195,7 @@ public:
 private:
 	static std::string sCAPath;
 	static std::string sCAFile;
+	static bool sPipelining;
 	static const unsigned int MAX_REDIRECTS;
 };
 
@@ -225,6 +232,9 @@ public:
 	
 	const char* getErrorBuffer();
 
+	// Host and port of the last request made with this handle.
+	const std::string& getHost() const { return mHost; }
+
 	std::stringstream& getInput() { return mInput; }
 	std::stringstream& getHeaderOutput() { return mHeaderOutput; }
 	LLIOPipe::buffer_ptr_t& getOutput() { return mOutput; }
@@ -253,6 +263,7 @@ private:
 	std::vector<char*>	mStrings;
 	
 	ResponderPtr		mResponder;
+	std::string			mHost;
 
 	static std::set<CURL*> sFreeHandles;
 	static std::set<CURL*> sActiveHandles;
@@ -275,11 +286,15 @@ public:
 	Multi();
 	~Multi();
 
-	Easy* allocEasy();
+	// Prefers a free handle last used for host, since curl keeps
+	// that handle's connection open.
+	Easy* allocEasy(const std::string& host = std::string());
 	bool addEasy(Easy* easy);
 	
 	void removeEasy(Easy* easy);
 
+	S32 getActiveCount() const { return (S32)mEasyActiveList.size(); }
+
 	S32 process();
 	void perform();
 	void doPerform();
@@ -335,7 +350,7 @@ public:
 
 private:
 	void addMulti();
-	LLCurl::Easy* allocEasy();
+	LLCurl::Easy* allocEasy(const std::string& host = std::string());
 	bool addEasy(LLCurl::Easy* easy);
 	
 private:
@@ -551,6 +551,17 @@ BOOL LLDataPackerBinaryBuffer::unpackUUID(LLUUID &value, const char *name)
 	return success;
 }
 
+BOOL LLDataPackerBinaryBuffer::unpackUUIDFast(LLUUID &value)
+{
+	if (mCurBufferp - mBufferp > mBufferSize - UUID_BYTES)
+	{
+		return FALSE;
+	}
+	memcpy(value.mData, mCurBufferp, UUID_BYTES);		/* Flawfinder: ignore */
+	mCurBufferp += UUID_BYTES;
+	return TRUE;
+}
+
 const LLDataPackerBinaryBuffer&	LLDataPackerBinaryBuffer::operator=(const LLDataPackerBinaryBuffer &a)
 {
 	if (a.getBufferSize() > getBufferSize())
@@ -195,6 +195,13 @@ public:
 	/*virtual*/ BOOL		hasNext() const			{ return getCurrentSize() < getBufferSize(); }
 
 	/*virtual*/ void dumpBufferToLog();
+
+	// Non-virtual reads for hot paths that know they hold a binary buffer.
+	// These neither log nor advance past the end; they return FALSE instead.
+	inline BOOL			unpackU8Fast(U8 &value);
+	inline BOOL			unpackU32Fast(U32 &value);
+	BOOL				unpackUUIDFast(LLUUID &value);
+
 protected:
 	inline BOOL verifyLength(const S32 data_size, const char *name);
 
@@ -203,6 +210,29 @@ protected:
 	S32 mBufferSize;
 };
 
+inline BOOL LLDataPackerBinaryBuffer::unpackU8Fast(U8 &value)
+{
+	if (mCurBufferp - mBufferp > mBufferSize - 1)
+	{
+		return FALSE;
+	}
+	value = *mCurBufferp++;
+	return TRUE;
+}
+
+inline BOOL LLDataPackerBinaryBuffer::unpackU32Fast(U32 &value)
+{
+	if (mCurBufferp - mBufferp > mBufferSize - 4)
+	{
+		return FALSE;
+	}
+	// Wire order is little endian
+	value = (U32)mCurBufferp[0] | ((U32)mCurBufferp[1] << 8) |
+			((U32)mCurBufferp[2] << 16) | ((U32)mCurBufferp[3] << 24);
+	mCurBufferp += 4;
+	return TRUE;
+}
+
 inline BOOL LLDataPackerBinaryBuffer::verifyLength(const S32 data_size, const char *name)
 {
 	if (mWriteEnabled && (mCurBufferp - mBufferp) > mBufferSize - data_size)
@@ -0,0 +1,491 @@
+/** 
+ * @file llhttpscheduler.cpp
+ * @brief Shared priority scheduler for HTTP asset fetches.
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llhttpscheduler.h"
+
+#include <algorithm>
+
+#include "llbuffer.h"
+#include "lltimer.h"
+#include "lluri.h"
+
+// A client which has not called update() for this long no longer
+// holds slots for its queued requests.
+static const F64 CLIENT_IDLE_SECS = 1.0;
+
+// Bandwidth is measured over windows of this length.
+static const F64 BANDWIDTH_WINDOW_SECS = 1.0;
+
+// Do not have more than this many seconds of data at the bandwidth
+// limit outstanding at once.
+static const F32 ADMISSION_WINDOW_SECS = 1.0f;
+
+// Assumed size of a request for the rest of a resource.
+static const S32 UNKNOWN_LENGTH_BYTES = 16384;
+
+static S32 expected_bytes(S32 length)
+{
+	return (length > 0) ? length : UNKNOWN_LENGTH_BYTES;
+}
+
+/**
+ * @class LLHTTPScheduledResponder
+ * @brief Tells the scheduler when a request finishes, then passes the
+ * response on to the caller's responder.
+ */
+class LLHTTPScheduledResponder : public LLCurl::Responder
+{
+public:
+	LLHTTPScheduledResponder(
+		LLHTTPScheduler::handle_t handle,
+		LLCurl::ResponderPtr responder) :
+		mHandle(handle),
+		mResponder(responder)
+	{
+	}
+
+	virtual void completedRaw(
+		U32 status,
+		const std::string& reason,
+		const LLChannelDescriptors& channels,
+		const LLIOPipe::buffer_ptr_t& buffer)
+	{
+		S32 bytes = buffer ? buffer->countAfter(channels.in(), NULL) : 0;
+		LLHTTPScheduler::getInstance()->requestDone(mHandle, bytes);
+		if (mResponder)
+		{
+			mResponder->completedRaw(status, reason, channels, buffer);
+		}
+	}
+
+	virtual bool followRedir()
+	{
+		return mResponder ? mResponder->followRedir() : false;
+	}
+
+private:
+	LLHTTPScheduler::handle_t mHandle;
+	LLCurl::ResponderPtr mResponder;
+};
+
+LLHTTPScheduler::LLHTTPScheduler() :
+	mNextHandle(0),
+	mNextSequence(0),
+	mMaxRequests(32),
+	mMaxRequestsPerHost(0),
+	mMinRequests(2),
+	mMaxBandwidth(0.f),
+	mOutstandingBytes(0),
+	mWindowBytes(0),
+	mWindowStart(LLTimer::getTotalSeconds()),
+	mBandwidth(0.f)
+{
+}
+
+LLHTTPScheduler::~LLHTTPScheduler()
+{
+}
+
+void LLHTTPScheduler::setMaxRequests(U32 max_requests)
+{
+	LLMutexLock lock(&mMutex);
+	mMaxRequests = llmax(max_requests, 1U);
+}
+
+void LLHTTPScheduler::setMaxRequestsPerHost(U32 max_requests)
+{
+	LLMutexLock lock(&mMutex);
+	mMaxRequestsPerHost = max_requests;
+}
+
+void LLHTTPScheduler::setMinRequests(U32 min_requests)
+{
+	LLMutexLock lock(&mMutex);
+	mMinRequests = min_requests;
+}
+
+void LLHTTPScheduler::setMaxBandwidth(F32 kbps)
+{
+	LLMutexLock lock(&mMutex);
+	mMaxBandwidth = llmax(kbps, 0.f);
+}
+
+LLHTTPScheduler::handle_t LLHTTPScheduler::getByteRange(
+	LLCurlRequest* client,
+	const std::string& url,
+	const LLCurlRequest::headers_t& headers,
+	S32 offset,
+	S32 length,
+	F32 priority,
+	LLCurl::ResponderPtr responder)
+{
+	LLQueuedRequest request;
+	request.mClient = client;
+	request.mURL = url;
+	request.mHost = LLURI(url).authority();
+	request.mHeaders = headers;
+	request.mOffset = offset;
+	request.mLength = length;
+	request.mPriority = priority;
+	request.mResponder = responder;
+
+	LLMutexLock lock(&mMutex);
+	if (nullHandle() == ++mNextHandle)
+	{
+		++mNextHandle;
+	}
+	handle_t handle = mNextHandle;
+	request.mSequence = mNextSequence++;
+	mQueues[makeQueueID(request)].insert(makeKey(handle, request));
+	mQueued[handle] = request;
+	return handle;
+}
+
+bool LLHTTPScheduler::setPriority(handle_t handle, F32 priority)
+{
+	LLMutexLock lock(&mMutex);
+	queued_map_t::iterator iter = mQueued.find(handle);
+	if (iter == mQueued.end())
+	{
+		return false;
+	}
+	LLQueuedRequest& request = iter->second;
+	if (request.mPriority != priority)
+	{
+		queue_t& queue = mQueues[makeQueueID(request)];
+		queue.erase(makeKey(handle, request));
+		request.mPriority = priority;
+		queue.insert(makeKey(handle, request));
+	}
+	return true;
+}
+
+bool LLHTTPScheduler::cancel(handle_t handle)
+{
+	LLMutexLock lock(&mMutex);
+	queued_map_t::iterator iter = mQueued.find(handle);
+	if (iter == mQueued.end())
+	{
+		return false;
+	}
+	dequeue(handle, iter->second);
+	mQueued.erase(iter);
+	return true;
+}
+
+S32 LLHTTPScheduler::update(LLCurlRequest* client)
+{
+	typedef std::vector<std::pair<handle_t, LLQueuedRequest> > issue_list_t;
+	issue_list_t issue;
+	{
+		LLMutexLock lock(&mMutex);
+		F64 now = LLTimer::getTotalSeconds();
+		mClients[client] = now;
+		updateBandwidth(now);
+
+		// Walk the queues in priority order as if every client were
+		// issuing at once. Requests for other clients take up their
+		// slots, so lower priority requests here can not jump ahead.
+		// Queues of idle clients and of hosts at the limit drop out of
+		// the walk, so it only visits requests which take a slot.
+		const U32 max_per_host = getMaxRequestsPerHost();
+		U32 active = mActive.size();
+		S32 outstanding = mOutstandingBytes;
+		host_count_t host_counts(mActivePerHost);
+		std::vector<LLQueueHead> heads;
+		for (queue_map_t::iterator queue = mQueues.begin(); queue != mQueues.end(); ++queue)
+		{
+			if (queue->first.first != client)
+			{
+				client_map_t::iterator other = mClients.find(queue->first.first);
+				if (other == mClients.end()
+					|| (now - other->second) > CLIENT_IDLE_SECS)
+				{
+					continue;
+				}
+			}
+			host_count_t::iterator host = host_counts.find(queue->first.second);
+			if (host != host_counts.end() && host->second >= max_per_host)
+			{
+				continue;
+			}
+			LLQueueHead head;
+			head.mQueue = queue;
+			head.mIter = queue->second.begin();
+			heads.push_back(head);
+		}
+		std::make_heap(heads.begin(), heads.end());
+
+		while (!heads.empty() && active < mMaxRequests)
+		{
+			std::pop_heap(heads.begin(), heads.end());
+			LLQueueHead head = heads.back();
+			heads.pop_back();
+
+			U32& host_count = host_counts[head.mQueue->first.second];
+			if (host_count >= max_per_host)
+			{
+				// another queue filled the host since this one was added.
+				continue;
+			}
+
+			handle_t handle = head.mIter->mHandle;
+			queued_map_t::iterator found = mQueued.find(handle);
+			llassert(found != mQueued.end());
+			const LLQueuedRequest& request = found->second;
+			S32 expected = expected_bytes(request.mLength);
+			if (!admitBandwidth(active, outstanding, expected))
+			{
+				break;
+			}
+			++active;
+			outstanding += expected;
+			++host_count;
+
+			queue_t::iterator next = head.mIter;
+			++next;
+			if (request.mClient == client)
+			{
+				LLActiveRequest& active_request = mActive[handle];
+				active_request.mClient = client;
+				active_request.mHost = request.mHost;
+				active_request.mExpectedBytes = expected;
+				++mActivePerHost[request.mHost];
+				mOutstandingBytes += expected;
+
+				issue.push_back(std::make_pair(handle, request));
+				mQueued.erase(found);
+				head.mQueue->second.erase(head.mIter);
+			}
+
+			if (next != head.mQueue->second.end())
+			{
+				head.mIter = next;
+				heads.push_back(head);
+				std::push_heap(heads.begin(), heads.end());
+			}
+			else if (head.mQueue->second.empty())
+			{
+				mQueues.erase(head.mQueue);
+			}
+		}
+	}
+
+	// Issue outside of the lock. A failed request is reported to its
+	// responder the same way curl reports a request with no response.
+	for (issue_list_t::iterator iter = issue.begin(); iter != issue.end(); ++iter)
+	{
+		LLQueuedRequest& request = iter->second;
+		bool res = client->getByteRange(
+			request.mURL,
+			request.mHeaders,
+			request.mOffset,
+			request.mLength,
+			new LLHTTPScheduledResponder(iter->first, request.mResponder));
+		if (!res)
+		{
+			llwarns << "Unable to issue request for " << request.mURL << llendl;
+			requestDone(iter->first, 0);
+			if (request.mResponder)
+			{
+				LLIOPipe::buffer_ptr_t buffer(new LLBufferArray);
+				request.mResponder->completedRaw(
+					499,
+					"Unable to issue request",
+					buffer->nextChannel(),
+					buffer);
+			}
+		}
+	}
+	return (S32)issue.size();
+}
+
+void LLHTTPScheduler::removeClient(LLCurlRequest* client)
+{
+	LLMutexLock lock(&mMutex);
+	queued_map_t::iterator queued = mQueued.begin();
+	while (queued != mQueued.end())
+	{
+		if (queued->second.mClient == client)
+		{
+			mQueued.erase(queued++);
+		}
+		else
+		{
+			++queued;
+		}
+	}
+	queue_map_t::iterator queue = mQueues.begin();
+	while (queue != mQueues.end())
+	{
+		if (queue->first.first == client)
+		{
+			mQueues.erase(queue++);
+		}
+		else
+		{
+			++queue;
+		}
+	}
+
+	// The client's curl handles go with it, so these will never
+	// report back.
+	active_map_t::iterator active = mActive.begin();
+	while (active != mActive.end())
+	{
+		if (active->second.mClient == client)
+		{
+			--mActivePerHost[active->second.mHost];
+			mOutstandingBytes -= active->second.mExpectedBytes;
+			mActive.erase(active++);
+		}
+		else
+		{
+			++active;
+		}
+	}
+	mClients.erase(client);
+}
+
+void LLHTTPScheduler::requestDone(handle_t handle, S32 bytes_received)
+{
+	LLMutexLock lock(&mMutex);
+	active_map_t::iterator iter = mActive.find(handle);
+	if (iter == mActive.end())
+	{
+		// the client has been removed.
+		return;
+	}
+	host_count_t::iterator host = mActivePerHost.find(iter->second.mHost);
+	if (host != mActivePerHost.end() && (0 == --host->second))
+	{
+		mActivePerHost.erase(host);
+	}
+	mOutstandingBytes -= iter->second.mExpectedBytes;
+	mActive.erase(iter);
+	mWindowBytes += bytes_received;
+}
+
+U32 LLHTTPScheduler::getNumQueued() const
+{
+	LLMutexLock lock(&mMutex);
+	return mQueued.size();
+}
+
+U32 LLHTTPScheduler::getNumActive() const
+{
+	LLMutexLock lock(&mMutex);
+	return mActive.size();
+}
+
+U32 LLHTTPScheduler::getNumActive(const std::string& host) const
+{
+	LLMutexLock lock(&mMutex);
+	host_count_t::const_iterator iter = mActivePerHost.find(host);
+	return (iter == mActivePerHost.end()) ? 0 : iter->second;
+}
+
+F32 LLHTTPScheduler::getBandwidth() const
+{
+	LLMutexLock lock(&mMutex);
+	return mBandwidth;
+}
+
+void LLHTTPScheduler::dequeue(handle_t handle, const LLQueuedRequest& request)
+{
+	queue_map_t::iterator queue = mQueues.find(makeQueueID(request));
+	if (queue != mQueues.end())
+	{
+		queue->second.erase(makeKey(handle, request));
+		if (queue->second.empty())
+		{
+			mQueues.erase(queue);
+		}
+	}
+}
+
+U32 LLHTTPScheduler::getMaxRequestsPerHost() const
+{
+	if (0 == mMaxRequestsPerHost)
+	{
+		return mMaxRequests;
+	}
+	return llmin(mMaxRequestsPerHost, mMaxRequests);
+}
+
+bool LLHTTPScheduler::admitBandwidth(
+	U32 active,
+	S32 outstanding_bytes,
+	S32 expected_bytes) const
+{
+	if (mMaxBandwidth <= 0.f || active < mMinRequests)
+	{
+		return true;
+	}
+	if (mBandwidth > mMaxBandwidth)
+	{
+		return false;
+	}
+	F32 max_bytes = mMaxBandwidth * (1000.f / 8.f) * ADMISSION_WINDOW_SECS;
+	return (F32)(outstanding_bytes + expected_bytes) <= max_bytes;
+}
+
+void LLHTTPScheduler::updateBandwidth(F64 now)
+{
+	F64 elapsed = now - mWindowStart;
+	if (elapsed >= BANDWIDTH_WINDOW_SECS)
+	{
+		mBandwidth = (F32)(mWindowBytes * 8.0 / 1000.0 / elapsed);
+		mWindowBytes = 0;
+		mWindowStart = now;
+	}
+}
+
+// static
+LLHTTPScheduler::LLQueueKey LLHTTPScheduler::makeKey(
+	handle_t handle,
+	const LLQueuedRequest& request)
+{
+	LLQueueKey key;
+	key.mPriority = request.mPriority;
+	key.mSequence = request.mSequence;
+	key.mHandle = handle;
+	return key;
+}
+
+// static
+LLHTTPScheduler::queue_id_t LLHTTPScheduler::makeQueueID(
+	const LLQueuedRequest& request)
+{
+	return std::make_pair(request.mClient, request.mHost);
+}
@@ -0,0 +1,234 @@
+/** 
+ * @file llhttpscheduler.h
+ * @brief Shared priority scheduler for HTTP asset fetches.
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLHTTPSCHEDULER_H
+#define LL_LLHTTPSCHEDULER_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "llcurl.h"
+#include "llsingleton.h"
+#include "llthread.h"
+
+/**
+ * @class LLHTTPScheduler
+ * @brief Orders HTTP asset fetches from several threads by priority.
+ *
+ * Each fetching thread (the texture fetcher and the mesh repository)
+ * keeps its own LLCurlRequest, since curl handles belong to the thread
+ * which created them. Requests are queued here instead of being issued
+ * directly, and each thread calls <code>update()</code> with its
+ * LLCurlRequest to issue whatever the scheduler admits. Admission is in
+ * priority order across every client, capped per host so that curl can
+ * keep reusing the same connections, and held back while the measured
+ * bandwidth is over the limit.
+ *
+ * All methods are safe to call from any thread, except that requests
+ * for a client are only issued from within that client's
+ * <code>update()</code>.
+ */
+class LLHTTPScheduler : public LLSingleton<LLHTTPScheduler>
+{
+	LOG_CLASS(LLHTTPScheduler);
+public:
+	typedef U32 handle_t;
+	static const handle_t nullHandle() { return 0; }
+
+	LLHTTPScheduler();
+	~LLHTTPScheduler();
+
+	/** @name Configuration */
+	//@{
+	void setMaxRequests(U32 max_requests);
+
+	// 0 caps each host at the overall maximum only.
+	void setMaxRequestsPerHost(U32 max_requests);
+
+	// Requests always admitted regardless of bandwidth.
+	void setMinRequests(U32 min_requests);
+
+	// Bandwidth limit in kilobits per second, or 0 for none.
+	void setMaxBandwidth(F32 kbps);
+	//@}
+
+	/** 
+	 * @brief Queue a byte range fetch to be issued through client.
+	 *
+	 * @param client The LLCurlRequest which will issue the request.
+	 * @param priority Higher is sooner. Clients should keep to the
+	 * range 0 to 1 so that their requests interleave sensibly.
+	 * @return Returns the handle of the queued request.
+	 */
+	handle_t getByteRange(
+		LLCurlRequest* client,
+		const std::string& url,
+		const LLCurlRequest::headers_t& headers,
+		S32 offset,
+		S32 length,
+		F32 priority,
+		LLCurl::ResponderPtr responder);
+
+	/** 
+	 * @brief Change the priority of a request which has not been issued.
+	 *
+	 * @return Returns false if the request has already been issued.
+	 */
+	bool setPriority(handle_t handle, F32 priority);
+
+	/** 
+	 * @brief Drop a request which has not been issued.
+	 *
+	 * @return Returns false if the request has already been issued.
+	 */
+	bool cancel(handle_t handle);
+
+	/** 
+	 * @brief Issue the requests for client which are admitted.
+	 *
+	 * Call this from the thread which owns client, before processing
+	 * it, and not from within one of its responders.
+	 * @return Returns the number of requests issued.
+	 */
+	S32 update(LLCurlRequest* client);
+
+	/** 
+	 * @brief Forget every request for client. Call before deleting it.
+	 */
+	void removeClient(LLCurlRequest* client);
+
+	/** @name Statistics */
+	//@{
+	U32 getNumQueued() const;
+	U32 getNumActive() const;
+	U32 getNumActive(const std::string& host) const;
+	F32 getBandwidth() const;	// kbps, measured over the last second
+	//@}
+
+	// Called by the responder wrapper when a request finishes.
+	void requestDone(handle_t handle, S32 bytes_received);
+
+protected:
+	struct LLQueuedRequest
+	{
+		LLCurlRequest* mClient;
+		std::string mURL;
+		std::string mHost;
+		LLCurlRequest::headers_t mHeaders;
+		S32 mOffset;
+		S32 mLength;
+		F32 mPriority;
+		U32 mSequence;
+		LLCurl::ResponderPtr mResponder;
+	};
+
+	// Queue order: highest priority first, then first come first served.
+	struct LLQueueKey
+	{
+		F32 mPriority;
+		U32 mSequence;
+		handle_t mHandle;
+		bool operator<(const LLQueueKey& rhs) const
+		{
+			if (mPriority != rhs.mPriority)
+			{
+				return mPriority > rhs.mPriority;
+			}
+			return mSequence < rhs.mSequence;
+		}
+	};
+
+	struct LLActiveRequest
+	{
+		LLCurlRequest* mClient;
+		std::string mHost;
+		S32 mExpectedBytes;
+	};
+
+	// Requests are queued per client and host, so that a walk in
+	// priority order can drop a whole queue once its client is idle or
+	// its host is at the limit.
+	typedef std::pair<LLCurlRequest*, std::string> queue_id_t;
+	typedef std::set<LLQueueKey> queue_t;
+	typedef std::map<queue_id_t, queue_t> queue_map_t;
+
+	struct LLQueueHead
+	{
+		queue_map_t::iterator mQueue;
+		queue_t::iterator mIter;
+		// Heap order: the highest priority head on top.
+		bool operator<(const LLQueueHead& rhs) const
+		{
+			return *rhs.mIter < *mIter;
+		}
+	};
+
+	void dequeue(handle_t handle, const LLQueuedRequest& request);
+	U32 getMaxRequestsPerHost() const;
+	bool admitBandwidth(U32 active, S32 outstanding_bytes, S32 expected_bytes) const;
+	void updateBandwidth(F64 now);
+	static LLQueueKey makeKey(handle_t handle, const LLQueuedRequest& request);
+	static queue_id_t makeQueueID(const LLQueuedRequest& request);
+
+protected:
+	mutable LLMutex mMutex;
+
+	typedef std::map<handle_t, LLQueuedRequest> queued_map_t;
+	queued_map_t mQueued;
+	queue_map_t mQueues;
+	typedef std::map<handle_t, LLActiveRequest> active_map_t;
+	active_map_t mActive;
+	typedef std::map<std::string, U32> host_count_t;
+	host_count_t mActivePerHost;
+
+	// When each client last called update(). Requests of a client
+	// which has gone quiet do not hold slots for it.
+	typedef std::map<LLCurlRequest*, F64> client_map_t;
+	client_map_t mClients;
+
+	handle_t mNextHandle;
+	U32 mNextSequence;
+
+	U32 mMaxRequests;
+	U32 mMaxRequestsPerHost;
+	U32 mMinRequests;
+	F32 mMaxBandwidth;
+
+	S32 mOutstandingBytes;
+	S32 mWindowBytes;
+	F64 mWindowStart;
+	F32 mBandwidth;
+};
+
+#endif // LL_LLHTTPSCHEDULER_H
@@ -36,6 +36,8 @@
 #include "lliosocket.h"
 
 #include "llapr.h"
+#define APR_WANT_IOVEC
+#include "apr_want.h"
 
 #include "llbuffer.h"
 #include "llhost.h"
@@ -50,6 +52,7 @@
 static const S32 LL_DEFAULT_LISTEN_BACKLOG = 10;
 static const S32 LL_SEND_BUFFER_SIZE = 40000;
 static const S32 LL_RECV_BUFFER_SIZE = 40000;
+static const S32 LL_MAX_WRITE_SEGMENTS = 16;
 //static const U16 LL_PORT_DISCOVERY_RANGE_MIN = 13000;
 //static const U16 LL_PORT_DISCOVERY_RANGE_MAX = 13050;
 
@@ -424,88 +427,64 @@ LLIOPipe::EStatus LLIOSocketWriter::process_impl(
 	}
 
 	PUMP_DEBUG;
-	// *FIX: Some sort of writev implementation would be much more
-	// efficient - not only because writev() is better, but also
-	// because we won't have to do as much work to find the start
-	// address.
-	LLBufferArray::segment_iterator_t it;
-	LLBufferArray::segment_iterator_t end = buffer->endSegment();
-	LLSegment segment;
-	it = buffer->constructSegmentAfter(mLastWritten, segment);
-	/*
-	if(NULL == mLastWritten)
-	{
-		it = buffer->beginSegment();
-		segment = (*it);
-	}
-	else
-	{
-		it = buffer->getSegment(mLastWritten);
-		segment = (*it);
-		S32 size = segment.size();
-		U8* data = segment.data();
-		if((data + size) == mLastWritten)
-		{
-			++it;
-			segment = (*it);
-		}
-		else
-		{
-			// *FIX: check the math on this one
-			segment = LLSegment(
-				(*it).getChannelMask(),
-				mLastWritten + 1,
-				size - (mLastWritten - data));
-		}
-	}
-	*/
-
-	PUMP_DEBUG;
-	apr_size_t len;
+	// Hand the socket everything we have on the channel in one writev
+	// style call, LL_MAX_WRITE_SEGMENTS runs at a time.
+	LLSegment segments[LL_MAX_WRITE_SEGMENTS];
+	struct iovec vec[LL_MAX_WRITE_SEGMENTS];
 	bool done = false;
 	apr_status_t status = APR_SUCCESS;
-	while(it != end)
+	while(true)
 	{
-
 		PUMP_DEBUG;
-		if((*it).isOnChannel(channels.in()))
+		S32 count = buffer->gatherSegments(
+			channels.in(),
+			mLastWritten,
+			segments,
+			LL_MAX_WRITE_SEGMENTS);
+		if(!count)
 		{
-			PUMP_DEBUG;
-			len = (apr_size_t)segment.size();
-			status = apr_socket_send(
-				mDestination->getSocket(),
-				(const char*)segment.data(),
-				&len);
-			// We sometimes get a 'non-blocking socket operation could not be 
-			// completed immediately' error from apr_socket_send.  In this
-			// case we break and the data will be sent the next time the chain
-			// is pumped.
-			if(APR_STATUS_IS_EAGAIN(status))
-			{
-				ll_apr_warn_status(status);
-				break;
-			}
-
-			mLastWritten = segment.data() + len - 1;
+			done = true;
+			break;
+		}
 
-			PUMP_DEBUG;
-			if((S32)len < segment.size())
-			{
-				break;
-			}
-			
+		apr_size_t total = 0;
+		for(S32 i = 0; i < count; ++i)
+		{
+			vec[i].iov_base = (char*)segments[i].data();
+			vec[i].iov_len = (size_t)segments[i].size();
+			total += (apr_size_t)segments[i].size();
 		}
 
-		++it;
-		if(it != end)
+		apr_size_t len = 0;
+		status = apr_socket_sendv(
+			mDestination->getSocket(),
+			vec,
+			count,
+			&len);
+		// We sometimes get a 'non-blocking socket operation could not be 
+		// completed immediately' error from apr_socket_sendv.  In this
+		// case we break and the data will be sent the next time the chain
+		// is pumped.
+		if(APR_STATUS_IS_EAGAIN(status))
 		{
-			segment = (*it);
+			ll_apr_warn_status(status);
+			break;
 		}
-		else
+
+		// Find the last byte written, which may be in any of the runs.
+		apr_size_t left = len;
+		for(S32 i = 0; (i < count) && left; ++i)
 		{
-			done = true;
+			apr_size_t written = llmin(left, (apr_size_t)segments[i].size());
+			mLastWritten = segments[i].data() + written - 1;
+			left -= written;
 		}
 
+		PUMP_DEBUG;
+		if(len < total)
+		{
+			break;
+		}
 	}
 	PUMP_DEBUG;
 	if(done && eos)
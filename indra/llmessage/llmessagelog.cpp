@@ -1,5 +1,8 @@
 // <edit>
+#include "linden_common.h"
 #include "llmessagelog.h"
+#include "llmessagereplay.h"
+#include "lltimer.h"
 
 LLMessageLogEntry::LLMessageLogEntry(EType type, LLHost from_host, LLHost to_host, U8* data, S32 data_size)
 :	mType(type),
@@ -27,6 +30,8 @@ LLMessageLogEntry::~LLMessageLogEntry()
 U32 LLMessageLog::sMaxSize = 4096; // testzone fixme todo boom
 std::deque<LLMessageLogEntry> LLMessageLog::sDeque;
 void (*(LLMessageLog::sCallback))(LLMessageLogEntry);
+LLFILE* LLMessageLog::sCaptureFile = NULL;
+F64 LLMessageLog::sCaptureStart = 0.0;
 void LLMessageLog::setMaxSize(U32 size)
 {
 	sMaxSize = size;
@@ -51,4 +56,44 @@ std::deque<LLMessageLogEntry> LLMessageLog::getDeque()
 {
 	return sDeque;
 }
+bool LLMessageLog::startCapture(const std::string& filename)
+{
+	stopCapture();
+	sCaptureFile = LLFile::fopen(filename, "wb");
+	if(!sCaptureFile)
+	{
+		llwarns << "Unable to open message capture file " << filename << llendl;
+		return false;
+	}
+	LLMessageCaptureHeader header;
+	memcpy(header.mMagic, LL_MESSAGE_CAPTURE_MAGIC, sizeof(header.mMagic));
+	header.mVersion = LL_MESSAGE_CAPTURE_VERSION;
+	fwrite(&header, sizeof(header), 1, sCaptureFile);
+	sCaptureStart = LLTimer::getTotalSeconds();
+	llinfos << "Capturing inbound messages to " << filename << llendl;
+	return true;
+}
+void LLMessageLog::stopCapture()
+{
+	if(sCaptureFile)
+	{
+		fclose(sCaptureFile);
+		sCaptureFile = NULL;
+	}
+}
+void LLMessageLog::capture(const LLHost& from_host, const U8* data, S32 data_size)
+{
+	if(!sCaptureFile || data_size <= 0) return;
+	LLMessageCaptureRecord record;
+	record.mTime = LLTimer::getTotalSeconds() - sCaptureStart;
+	record.mAddress = from_host.getAddress();
+	record.mPort = from_host.getPort();
+	record.mSize = data_size;
+	if(fwrite(&record, sizeof(record), 1, sCaptureFile) != 1
+	   || fwrite(data, 1, data_size, sCaptureFile) != (size_t)data_size)
+	{
+		llwarns << "Message capture write failed, stopping capture" << llendl;
+		stopCapture();
+	}
+}
 // </edit>
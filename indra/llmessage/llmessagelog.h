@@ -3,6 +3,7 @@
 #define LL_LLMESSAGELOG_H
 #include "stdtypes.h"
 #include "llhost.h"
+#include "llfile.h"
 #include <queue>
 #include <string.h>
 
@@ -32,8 +33,18 @@ public:
 	static void setCallback(void (*callback)(LLMessageLogEntry));
 	static void log(LLHost from_host, LLHost to_host, U8* data, S32 data_size);
 	static std::deque<LLMessageLogEntry> getDeque();
+
+	// Raw inbound datagram capture for offline replay, see LLMessageReplay.
+	// Records are written as they arrive, before ack stripping and zero
+	// code expansion, so a replay sees exactly what the socket returned.
+	static bool startCapture(const std::string& filename);
+	static void stopCapture();
+	static bool isCapturing() { return sCaptureFile != NULL; }
+	static void capture(const LLHost& from_host, const U8* data, S32 data_size);
 private:
 	static U32 sMaxSize;
+	static LLFILE* sCaptureFile;
+	static F64 sCaptureStart;
 	static void (*sCallback)(LLMessageLogEntry);
 	static std::deque<LLMessageLogEntry> sDeque;
 };
@@ -0,0 +1,232 @@
+/** 
+ * @file llmessagereplay.cpp
+ * @brief Offline replay of captured inbound message traffic
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+
+#include "linden_common.h"
+
+#include "llmessagereplay.h"
+
+#include <algorithm>
+#include <set>
+
+#include "llfile.h"
+#include "lltimer.h"
+#include "message.h"
+
+LLMessageReplay::LLMessageReplay()
+:	mReplayTime(0.0),
+	mHandlerTime(0.f)
+{
+}
+
+bool LLMessageReplay::load(const std::string& filename)
+{
+	LLFILE* fp = LLFile::fopen(filename, "rb");
+	if (!fp)
+	{
+		llwarns << "Unable to open message capture " << filename << llendl;
+		return false;
+	}
+
+	LLMessageCaptureHeader header;
+	if (fread(&header, sizeof(header), 1, fp) != 1
+		|| memcmp(header.mMagic, LL_MESSAGE_CAPTURE_MAGIC, sizeof(header.mMagic))
+		|| header.mVersion != LL_MESSAGE_CAPTURE_VERSION)
+	{
+		llwarns << filename << " is not a message capture" << llendl;
+		fclose(fp);
+		return false;
+	}
+
+	LLMessageCaptureRecord record;
+	std::vector<U8> data;
+	while (fread(&record, sizeof(record), 1, fp) == 1)
+	{
+		if (!record.mSize || record.mSize > (U32)MAX_BUFFER_SIZE)
+		{
+			llwarns << "Bad packet size " << record.mSize << " in " << filename
+					<< ", stopping after " << mPackets.size() << " packets" << llendl;
+			break;
+		}
+		data.resize(record.mSize);
+		if (fread(&data[0], 1, record.mSize, fp) != record.mSize)
+		{
+			// capture was cut off mid write
+			break;
+		}
+		addPacket(record.mTime, LLHost(record.mAddress, record.mPort), &data[0], record.mSize);
+	}
+	fclose(fp);
+
+	llinfos << "Loaded " << mPackets.size() << " packets from " << filename << llendl;
+	return true;
+}
+
+void LLMessageReplay::addPacket(F64 time, const LLHost& host, const U8* data, S32 size)
+{
+	mPackets.push_back(Packet());
+	Packet& packet = mPackets.back();
+	packet.mTime = time;
+	packet.mHost = host;
+	packet.mData.assign(data, data + size);
+}
+
+// static
+void LLMessageReplay::timingCallback(const char* name, F32 time, void* data)
+{
+	((LLMessageReplay*)data)->mHandlerTime += time;
+}
+
+S32 LLMessageReplay::replay(LLMessageSystem* msg, const LLHost& host)
+{
+	if (!msg || mPackets.empty())
+	{
+		return 0;
+	}
+	if (msg == gMessageSystem)
+	{
+		llwarns << "Refusing to replay a message capture into the live message system" << llendl;
+		return 0;
+	}
+
+	// The template reader dispatches to gMessageSystem's handlers.
+	LLMessageSystem* live_msg = gMessageSystem;
+	gMessageSystem = msg;
+
+	LLMessageSystem::msg_timing_callback old_callback = msg->getTimingCallback();
+	void* old_callback_data = msg->getTimingCallbackData();
+	msg->setTimingFunc(timingCallback, this);
+
+	std::set<LLHost> opened_circuits;
+	U8 buffer[MAX_BUFFER_SIZE];
+	S32 valid_count = 0;
+	LLTimer replay_timer;
+	LLTimer timer;
+
+	for (std::vector<Packet>::const_iterator iter = mPackets.begin();
+		 iter != mPackets.end(); ++iter)
+	{
+		const Packet& packet = *iter;
+		LLHost sender = host.isOk() ? host : packet.mHost;
+		S32 size = (S32)packet.mData.size();
+		memcpy(buffer, &packet.mData[0], size);		/* Flawfinder: ignore */
+
+		// checkMessages() leaves appended acks alone for faked messages,
+		// strip them here so the template reader sees the bare message.
+		if (buffer[0] & LL_ACK_FLAG)
+		{
+			S32 acks = buffer[size - 1];
+			size -= 1 + acks * (S32)sizeof(TPACKETID);
+			if (size < (S32)LL_MINIMUM_VALID_PACKET_SIZE)
+			{
+				continue;
+			}
+			buffer[0] &= ~LL_ACK_FLAG;
+		}
+
+		if (!msg->mCircuitInfo.findCircuit(sender))
+		{
+			msg->enableCircuit(sender, TRUE);
+			opened_circuits.insert(sender);
+		}
+
+		mHandlerTime = 0.f;
+		timer.reset();
+		BOOL valid = msg->checkMessages(0, true, buffer, sender, size);
+		F32 elapsed = timer.getElapsedTimeF32();
+
+		Stats& stats = mStats[valid ? std::string(msg->getMessageName()) : std::string("(invalid)")];
+		stats.mCount++;
+		stats.mBytes += (U32)packet.mData.size();
+		stats.mHandlerTime += mHandlerTime;
+		stats.mDecodeTime += llmax(elapsed - mHandlerTime, 0.f);
+		stats.mMaxTime = llmax(stats.mMaxTime, elapsed);
+		if (valid)
+		{
+			valid_count++;
+		}
+	}
+	mReplayTime += replay_timer.getElapsedTimeF64();
+
+	msg->setTimingFunc(old_callback, old_callback_data);
+
+	for (std::set<LLHost>::iterator iter = opened_circuits.begin();
+		 iter != opened_circuits.end(); ++iter)
+	{
+		if (msg->mCircuitInfo.findCircuit(*iter))
+		{
+			msg->disableCircuit(*iter);
+		}
+	}
+
+	gMessageSystem = live_msg;
+	return valid_count;
+}
+
+void LLMessageReplay::resetStats()
+{
+	mStats.clear();
+	mReplayTime = 0.0;
+}
+
+static bool compare_total_time(const std::pair<std::string, LLMessageReplay::Stats>& a,
+							   const std::pair<std::string, LLMessageReplay::Stats>& b)
+{
+	return a.second.mDecodeTime + a.second.mHandlerTime > b.second.mDecodeTime + b.second.mHandlerTime;
+}
+
+void LLMessageReplay::dumpStats() const
+{
+	std::vector<std::pair<std::string, Stats> > sorted(mStats.begin(), mStats.end());
+	std::sort(sorted.begin(), sorted.end(), compare_total_time);
+
+	U32 total_count = 0;
+	for (S32 i = 0; i < (S32)sorted.size(); i++)
+	{
+		total_count += sorted[i].second.mCount;
+	}
+
+	llinfos << "Replayed " << total_count << " packets in " << mReplayTime << " seconds ("
+			<< (mReplayTime > 0.0 ? total_count / mReplayTime : 0.0) << " packets/sec)" << llendl;
+	llinfos << llformat("%-32s %8s %10s %12s %12s %10s", "Message", "Count", "Bytes", "Decode us", "Handler us", "Max us") << llendl;
+	for (S32 i = 0; i < (S32)sorted.size(); i++)
+	{
+		const Stats& stats = sorted[i].second;
+		llinfos << llformat("%-32s %8u %10u %12.1f %12.1f %10.1f",
+							sorted[i].first.c_str(),
+							stats.mCount,
+							stats.mBytes,
+							stats.mDecodeTime * 1000000.0 / stats.mCount,
+							stats.mHandlerTime * 1000000.0 / stats.mCount,
+							stats.mMaxTime * 1000000.f) << llendl;
+	}
+}
@@ -0,0 +1,123 @@
+/** 
+ * @file llmessagereplay.h
+ * @brief Offline replay of captured inbound message traffic
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+
+#ifndef LL_LLMESSAGEREPLAY_H
+#define LL_LLMESSAGEREPLAY_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "llhost.h"
+
+class LLMessageSystem;
+
+// Capture file layout, written by LLMessageLog::capture().  Fields are in
+// host byte order; captures are meant to be replayed on the same kind of
+// machine that recorded them.
+const char LL_MESSAGE_CAPTURE_MAGIC[8] = { 'L', 'L', 'M', 'S', 'G', 'C', 'A', 'P' };
+const U32 LL_MESSAGE_CAPTURE_VERSION = 1;
+
+struct LLMessageCaptureHeader
+{
+	char	mMagic[8];
+	U32		mVersion;
+};
+
+// One per datagram, followed by mSize bytes of packet data.
+struct LLMessageCaptureRecord
+{
+	F64		mTime;			// seconds since the capture started
+	U32		mAddress;		// sender, as LLHost stores it
+	U32		mPort;
+	U32		mSize;
+};
+
+// Feeds captured datagrams through LLMessageSystem::checkMessages() so the
+// registered handlers run exactly as they would for live traffic, and
+// accumulates decode and handler time per message type.  Packets are
+// replayed back to back in capture order, which keeps runs repeatable.
+class LLMessageReplay
+{
+public:
+	struct Packet
+	{
+		F64					mTime;
+		LLHost				mHost;
+		std::vector<U8>		mData;
+	};
+
+	struct Stats
+	{
+		Stats() : mCount(0), mBytes(0), mDecodeTime(0.0), mHandlerTime(0.0), mMaxTime(0.f) {}
+		U32		mCount;
+		U32		mBytes;
+		F64		mDecodeTime;	// checkMessages() time outside the handler
+		F64		mHandlerTime;
+		F32		mMaxTime;		// slowest single message, decode plus handler
+	};
+	typedef std::map<std::string, Stats> stats_map_t;
+
+	LLMessageReplay();
+
+	bool load(const std::string& filename);
+	void addPacket(F64 time, const LLHost& host, const U8* data, S32 size);
+	S32 getPacketCount() const				{ return (S32)mPackets.size(); }
+	const Packet& getPacket(S32 i) const	{ return mPackets[i]; }
+
+	// Replays every loaded packet into msg, which must be a message system
+	// of its own (e.g. built from a template file by a test harness or a
+	// headless tool), never the live gMessageSystem: the handlers would act
+	// on the session's state.  msg stands in as gMessageSystem while the
+	// packets are dispatched.  Packets appear to come from host if it is
+	// valid, otherwise from their captured sender.  Circuits are opened for
+	// senders that have none and closed again afterwards.  Replayed packets
+	// skip duplicate detection and are never acked.  Returns the number of
+	// packets the message system accepted as valid.
+	S32 replay(LLMessageSystem* msg, const LLHost& host = LLHost());
+
+	const stats_map_t& getStats() const		{ return mStats; }
+	F64 getReplayTime() const				{ return mReplayTime; }
+	void resetStats();
+	void dumpStats() const;
+
+private:
+	static void timingCallback(const char* name, F32 time, void* data);
+
+	std::vector<Packet>	mPackets;
+	stats_map_t			mStats;
+	F64					mReplayTime;
+	F32					mHandlerTime;
+};
+
+#endif // LL_LLMESSAGEREPLAY_H
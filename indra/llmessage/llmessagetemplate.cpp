@@ -36,6 +36,8 @@
 
 #include "message.h"
 
+U32 LLMessageTemplate::sSerialCounter = 0;
+
 void LLMsgVarData::addData(const void *data, S32 size, EMsgVariableType type, S32 data_size)
 {
 	mSize = size;
@@ -145,16 +145,17 @@ public:
 class LLMessageVariable
 {
 public:
-	LLMessageVariable() : mName(NULL), mType(MVT_NULL), mSize(-1)
+	LLMessageVariable() : mName(NULL), mType(MVT_NULL), mSize(-1), mIndex(0), mOffset(-1)
 	{
 	}
 
-	LLMessageVariable(char *name) : mType(MVT_NULL), mSize(-1)
+	LLMessageVariable(char *name) : mType(MVT_NULL), mSize(-1), mIndex(0), mOffset(-1)
 	{
 		mName = name;
 	}
 
-	LLMessageVariable(const char *name, const EMsgVariableType type, const S32 size) : mType(type), mSize(size) 
+	LLMessageVariable(const char *name, const EMsgVariableType type, const S32 size, S32 index = 0, S32 offset = -1)
+		: mType(type), mSize(size), mIndex(index), mOffset(offset)
 	{
 		mName = LLMessageStringTable::getInstance()->getString(name); 
 	}
@@ -166,10 +167,17 @@ public:
 	EMsgVariableType getType() const				{ return mType; }
 	S32	getSize() const								{ return mSize; }
 	char *getName() const							{ return mName; }
+
+	// Position in the block, and byte offset from the start of a block
+	// instance or -1 if a variable length field comes first.
+	S32 getIndex() const							{ return mIndex; }
+	S32 getOffset() const							{ return mOffset; }
 protected:
 	char				*mName;
 	EMsgVariableType	mType;
 	S32					mSize;
+	S32					mIndex;
+	S32					mOffset;
 };
 
 
@@ -185,7 +193,7 @@ typedef enum e_message_block_type
 class LLMessageBlock
 {
 public:
-	LLMessageBlock(const char *name, EMsgBlockType type, S32 number = 1) : mType(type), mNumber(number), mTotalSize(0) 
+	LLMessageBlock(const char *name, EMsgBlockType type, S32 number = 1) : mType(type), mNumber(number), mTotalSize(0), mIndex(-1)
 	{ 
 		mName = LLMessageStringTable::getInstance()->getString(name);
 	}
@@ -202,7 +210,7 @@ public:
 		{
 			llerrs << name << " has already been used as a variable name!" << llendl;
 		}
-		*varp = new LLMessageVariable(name, type, size);
+		*varp = new LLMessageVariable(name, type, size, (S32)mMemberVariables.size() - 1, mTotalSize);
 		if (((*varp)->getType() != MVT_VARIABLE)
 			&&(mTotalSize != -1))
 		{
@@ -237,7 +245,8 @@ public:
 	char									*mName;
 	EMsgBlockType							mType;
 	S32										mNumber;
-	S32										mTotalSize;
+	S32										mTotalSize;	// size of one instance, -1 if it has variable length fields
+	S32										mIndex;		// position in the message template
 };
 
 
@@ -295,6 +304,7 @@ public:
 		mUserData(NULL)
 	{ 
 		mName = LLMessageStringTable::getInstance()->getString(name);
+		mSerial = ++sSerialCounter;
 	}
 
 	~LLMessageTemplate()
@@ -311,6 +321,7 @@ public:
 				<< "has already been used as a block name!" << llendl;
 		}
 		*member_blockp = blockp;
+		blockp->mIndex = (S32)mMemberBlocks.size() - 1;
 		if (  (mTotalSize != -1)
 			&&(blockp->mTotalSize != -1)
 			&&(  (blockp->mType == MBT_SINGLE)
@@ -418,7 +429,13 @@ public:
 	bool									mBanFromTrusted;
 	bool									mBanFromUntrusted;
 
+	// Never reused, unlike the template's address once its message system
+	// is gone, so cached LLMessageFields can tell which template they are for.
+	U32										mSerial;
+
 private:
+	static U32								sSerialCounter;
+
 	// message handler function (this is set by each application)
 	void									(*mHandlerFunc)(LLMessageSystem *msgsystem, void **user_data);
 	void									**mUserData;
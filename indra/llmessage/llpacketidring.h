@@ -0,0 +1,232 @@
+/** 
+ * @file llpacketidring.h
+ * @brief Sliding window of per packet ID slots
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+
+#ifndef LL_LLPACKETIDRING_H
+#define LL_LLPACKETIDRING_H
+
+#include <deque>
+
+// Window of slots indexed by packet ID, for bookkeeping on IDs that are
+// mostly consecutive (our own outgoing IDs, or a peer's incoming ones).
+// Lookups are an index computation instead of a tree walk, nothing is
+// allocated per entry, and iteration is in send order even across the
+// wrap of the ID space, which a std::map keyed by ID could not give us.
+//
+// A default constructed T marks an empty slot, so T must not use that
+// value for real entries (NULL pointers, 0 flags).
+//
+// The window grows to cover every ID inserted.  If it would span more
+// than max_window slots the oldest slots are dropped, which is only
+// allowed for tables that can lose entries (duplicate suppression).
+// Tables owning their entries should pass a max_window they cannot reach.
+template <class T>
+class LLPacketIDRing
+{
+public:
+	LLPacketIDRing(TPACKETID id_space, S32 max_window)
+	:	mIDSpace(id_space),
+		mMaxWindow(max_window),
+		mBase(0),
+		mCount(0)
+	{
+	}
+
+	bool empty() const			{ return mCount == 0; }
+	S32 size() const			{ return mCount; }
+
+	T find(TPACKETID id) const
+	{
+		S32 offset = offsetOf(id);
+		if (offset < 0 || offset >= (S32)mSlots.size())
+		{
+			return T();
+		}
+		return mSlots[offset];
+	}
+
+	// Returns false if the ID is too far behind the window to be stored.
+	bool insert(TPACKETID id, const T& value)
+	{
+		if (mSlots.empty())
+		{
+			mBase = id;
+			mSlots.push_back(value);
+			mCount = 1;
+			return true;
+		}
+
+		S32 offset = offsetOf(id);
+		if (offset < 0)
+		{
+			if ((S32)mSlots.size() - offset > mMaxWindow)
+			{
+				return false;
+			}
+			mSlots.insert(mSlots.begin(), -offset, T());
+			mBase = id;
+			offset = 0;
+		}
+		else if (offset >= mMaxWindow)
+		{
+			// slide forward, forgetting the oldest IDs
+			dropFront(offset - mMaxWindow + 1);
+			if (mSlots.empty())
+			{
+				return insert(id, value);
+			}
+			offset = offsetOf(id);
+		}
+
+		if (offset >= (S32)mSlots.size())
+		{
+			mSlots.resize(offset + 1, T());
+		}
+		if (mSlots[offset] == T())
+		{
+			mCount++;
+		}
+		mSlots[offset] = value;
+		return true;
+	}
+
+	// Empties the slot for id and returns what was there.
+	T remove(TPACKETID id)
+	{
+		S32 offset = offsetOf(id);
+		if (offset < 0 || offset >= (S32)mSlots.size())
+		{
+			return T();
+		}
+		T value = mSlots[offset];
+		clearSlot(offset);
+		trim();
+		return value;
+	}
+
+	// Forget every ID older than id.
+	void removeBefore(TPACKETID id)
+	{
+		S32 offset = offsetOf(id);
+		if (offset > 0)
+		{
+			dropFront(offset);
+		}
+	}
+
+	// Oldest stored ID, the window must not be empty.
+	TPACKETID oldestID() const
+	{
+		return slotID(0);
+	}
+
+	// Returns true if a comes before b in the window's notion of time.
+	bool isOlder(TPACKETID a, TPACKETID b) const
+	{
+		return signedDelta(a, b) < 0;
+	}
+
+	void clear()
+	{
+		mSlots.clear();
+		mCount = 0;
+	}
+
+	// Index based access for in order iteration, slots may be empty.
+	// Clearing slots while iterating is fine, call trim() when done.
+	// Inserting past the end is fine as well, slotCount() just grows.
+	S32 slotCount() const			{ return (S32)mSlots.size(); }
+	const T& slot(S32 index) const	{ return mSlots[index]; }
+	TPACKETID slotID(S32 index) const { return (mBase + (TPACKETID)index) % mIDSpace; }
+
+	void clearSlot(S32 index)
+	{
+		if (mSlots[index] != T())
+		{
+			mSlots[index] = T();
+			mCount--;
+		}
+	}
+
+	// Drop empty slots at either end of the window.
+	void trim()
+	{
+		while (!mSlots.empty() && mSlots.front() == T())
+		{
+			mSlots.pop_front();
+			mBase = (mBase + 1) % mIDSpace;
+		}
+		while (!mSlots.empty() && mSlots.back() == T())
+		{
+			mSlots.pop_back();
+		}
+	}
+
+private:
+	// Distance from a to b, taking the shorter way around the ID space.
+	S32 signedDelta(TPACKETID a, TPACKETID b) const
+	{
+		S32 delta = (S32)((a + mIDSpace - b) % mIDSpace);
+		if (delta >= (S32)(mIDSpace / 2))
+		{
+			delta -= (S32)mIDSpace;
+		}
+		return delta;
+	}
+
+	S32 offsetOf(TPACKETID id) const
+	{
+		return signedDelta(id % mIDSpace, mBase);
+	}
+
+	void dropFront(S32 count)
+	{
+		while (count-- > 0 && !mSlots.empty())
+		{
+			if (mSlots.front() != T())
+			{
+				mCount--;
+			}
+			mSlots.pop_front();
+			mBase = (mBase + 1) % mIDSpace;
+		}
+		trim();
+	}
+
+	TPACKETID		mIDSpace;
+	S32				mMaxWindow;
+	TPACKETID		mBase;
+	S32				mCount;
+	std::deque<T>	mSlots;
+};
+
+#endif // LL_LLPACKETIDRING_H
@@ -0,0 +1,136 @@
+/** 
+ * @file llpatchworker.cpp
+ * @brief Decodes terrain patch layers off the main thread
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpatchworker.h"
+#include "bitpack.h"
+#include "patch_code.h"
+
+LLPatchDecodeThread::PatchRequest::PatchRequest(LLPatchDecodeThread* thread, handle_t handle,
+												U64 key, const U8* data, S32 size) :
+	QueuedRequest(handle, LLQueuedThread::PRIORITY_NORMAL, FLAG_AUTO_COMPLETE),
+	mThread(thread),
+	mKey(key),
+	mData(data, data + size)
+{
+}
+
+bool LLPatchDecodeThread::PatchRequest::processRequest()
+{
+	DecodedGroup group;
+	group.mKey = mKey;
+	{
+		LLMutexLock lock(mThread->getDecoderMutex());
+		decodeGroup(mData.empty() ? NULL : &mData[0], (S32)mData.size(), group);
+	}
+
+	LLMutexLock lock(&mThread->mDecodedMutex);
+	mThread->mDecoded.push_back(DecodedGroup());
+	DecodedGroup& decoded = mThread->mDecoded.back();
+	decoded.mKey = group.mKey;
+	decoded.mGroupHeader = group.mGroupHeader;
+	decoded.mHeaders.swap(group.mHeaders);
+	decoded.mHeights.swap(group.mHeights);
+	return true;
+}
+
+LLPatchDecodeThread::LLPatchDecodeThread(bool threaded) :
+	LLQueuedThread("Patch Decode", threaded)
+{
+}
+
+void LLPatchDecodeThread::decode(U64 key, const U8* data, S32 size)
+{
+	// Requests of equal priority run in the order they were queued, so
+	// later updates of a patch are applied after earlier ones.
+	if (!addRequest(new PatchRequest(this, generateHandle(), key, data, size)))
+	{
+		llwarns << "LLPatchDecodeThread::decode called after shutdown" << llendl;
+	}
+}
+
+void LLPatchDecodeThread::getDecoded(std::vector<DecodedGroup>& groups)
+{
+	groups.clear();
+	LLMutexLock lock(&mDecodedMutex);
+	groups.swap(mDecoded);
+}
+
+//static
+void LLPatchDecodeThread::decodeGroup(const U8* data, S32 size, DecodedGroup& group)
+{
+	group.mHeaders.clear();
+	group.mHeights.clear();
+	memset(&group.mGroupHeader, 0, sizeof(LLGroupHeader));
+	if (!data || size <= 0)
+	{
+		return;
+	}
+
+	LLBitPack bitpack((U8*)data, size);
+	decode_patch_group_header(bitpack, &group.mGroupHeader);
+	S32 patch_size = group.mGroupHeader.patch_size;
+	if (patch_size != NORMAL_PATCH_SIZE && patch_size != LARGE_PATCH_SIZE)
+	{
+		llwarns << "Received invalid terrain packet - patch size " << patch_size << llendl;
+		return;
+	}
+
+	// Decode each patch into its own rows rather than a region's grid.
+	LLGroupHeader gop = group.mGroupHeader;
+	gop.stride = patch_size;
+	init_patch_decompressor(patch_size);
+	set_group_of_patch_header(&gop);
+
+	// Patch ids are 5 bits each way, so a packet can't carry more than
+	// this many patches; stop there if the end marker never shows up.
+	const S32 MAX_PATCHES = 32 * 32;
+	S32 patch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+	LLPatchHeader ph;
+	while ((S32)group.mHeaders.size() < MAX_PATCHES)
+	{
+		decode_patch_header(bitpack, &ph);
+		if (ph.quant_wbits == END_OF_PATCHES)
+		{
+			break;
+		}
+		decode_patch(bitpack, patch);
+
+		size_t offset = group.mHeights.size();
+		group.mHeights.resize(offset + patch_size * patch_size);
+		decompress_patch(&group.mHeights[offset], patch, &ph);
+		group.mHeaders.push_back(ph);
+	}
+	// Nothing may use the group header after we return.
+	set_group_of_patch_header(NULL);
+}
@@ -0,0 +1,95 @@
+/** 
+ * @file llpatchworker.h
+ * @brief Decodes terrain patch layers off the main thread
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPATCHWORKER_H
+#define LL_LLPATCHWORKER_H
+
+#include <vector>
+#include "llqueuedthread.h"
+#include "patch_dct.h"
+
+// Decodes LayerData land packets off the main thread: the patch bitstream
+// and the inverse DCT of every patch in it. The decoder in patch_code.cpp
+// and patch_idct.cpp keeps its state in globals, so anything else decoding
+// patches while this thread runs has to hold getDecoderMutex().
+// Normals are still worked out on the main thread, in
+// LLSurface::idleUpdate(), since they need the neighbouring patches.
+class LLPatchDecodeThread : public LLQueuedThread
+{
+public:
+	// Every patch of one packet, in packet order.
+	struct DecodedGroup
+	{
+		U64 mKey;						// as passed to decode()
+		LLGroupHeader mGroupHeader;
+		std::vector<LLPatchHeader> mHeaders;
+		std::vector<F32> mHeights;		// patch_size * patch_size per header, row by row
+	};
+
+	class PatchRequest : public QueuedRequest
+	{
+	protected:
+		virtual ~PatchRequest() {} // use deleteRequest()
+
+	public:
+		PatchRequest(LLPatchDecodeThread* thread, handle_t handle, U64 key, const U8* data, S32 size);
+
+		/*virtual*/ bool processRequest();
+
+	private:
+		LLPatchDecodeThread* mThread;
+		U64 mKey;
+		std::vector<U8> mData;
+	};
+
+	LLPatchDecodeThread(bool threaded = true);
+	~LLPatchDecodeThread() { shutdown(); } // before our members go away
+
+	// Called from MAIN THREAD. Queues a copy of a land layer packet.
+	void decode(U64 key, const U8* data, S32 size);
+	// Called from MAIN THREAD. Hands over what has been decoded so far, in
+	// the order it was queued.
+	void getDecoded(std::vector<DecodedGroup>& groups);
+
+	LLMutex* getDecoderMutex() { return &mDecoderMutex; }
+
+	// Decodes one packet with the patch decoder. The caller holds
+	// getDecoderMutex() if the thread may be running.
+	static void decodeGroup(const U8* data, S32 size, DecodedGroup& group);
+
+private:
+	LLMutex mDecoderMutex;
+	LLMutex mDecodedMutex;
+	std::vector<DecodedGroup> mDecoded;
+};
+
+#endif // LL_LLPATCHWORKER_H
@@ -39,6 +39,13 @@
 #include <set>
 #include "apr_poll.h"
 
+#if LL_LINUX
+#include <errno.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include "apr_portable.h"
+#endif
+
 #include "llapr.h"
 #include "llmemtype.h"
 #include "llstl.h"
@@ -168,19 +175,83 @@ struct ll_delete_apr_pollset_fd_client_data
 	}
 };
 
+#if LL_LINUX
+static int epoll_descriptor(const apr_pollfd_t& poll)
+{
+	if(APR_POLL_SOCKET == poll.desc_type)
+	{
+		apr_os_sock_t os_sock;
+		if(APR_SUCCESS == apr_os_sock_get(&os_sock, poll.desc.s))
+		{
+			return os_sock;
+		}
+	}
+	else if(APR_POLL_FILE == poll.desc_type)
+	{
+		apr_os_file_t os_file;
+		if(APR_SUCCESS == apr_os_file_get(&os_file, poll.desc.f))
+		{
+			return os_file;
+		}
+	}
+	return -1;
+}
+
+static U32 apr_to_epoll_events(apr_int16_t events)
+{
+	U32 rv = 0;
+	if(events & APR_POLLIN) rv |= EPOLLIN;
+	if(events & APR_POLLPRI) rv |= EPOLLPRI;
+	if(events & APR_POLLOUT) rv |= EPOLLOUT;
+	return rv;
+}
+
+static apr_int16_t epoll_to_apr_events(U32 events)
+{
+	apr_int16_t rv = 0;
+	if(events & EPOLLIN) rv |= APR_POLLIN;
+	if(events & EPOLLPRI) rv |= APR_POLLPRI;
+	if(events & EPOLLOUT) rv |= APR_POLLOUT;
+	if(events & EPOLLERR) rv |= APR_POLLERR;
+	if(events & EPOLLHUP) rv |= APR_POLLHUP;
+	return rv;
+}
+#endif
+
 /**
  * LLPumpIO
  */
+bool LLPumpIO::sUseEpoll = false;
+
+// static
+void LLPumpIO::setUseEpoll(bool use_epoll)
+{
+	sUseEpoll = use_epoll;
+}
+
+LLPumpIO::LLPumpStats::LLPumpStats() :
+	mPumps(0),
+	mChainsProcessed(0),
+	mChainsWaiting(0),
+	mDescriptorsSignalled(0),
+	mTotalChainsProcessed(0),
+	mChainsExpired(0),
+	mPollsetRebuilds(0)
+{
+}
+
 LLPumpIO::LLPumpIO(void) :
 	mState(LLPumpIO::NORMAL),
 	mRebuildPollset(false),
 	mPollset(NULL),
 	mPollsetClientID(0),
+	mEpollFD(-1),
 	mNextLock(0),
 	mCurrentPoolReallocCount(0),
 	mChainsMutex(NULL),
 	mCallbackMutex(NULL),
-	mCurrentChain(mRunningChains.end())
+	mCurrentChain(mRunningChains.end()),
+	mNextChainID(0)
 {
 	mCurrentChain = mRunningChains.end();
 
@@ -203,6 +274,13 @@ LLPumpIO::~LLPumpIO()
 		apr_pollset_destroy(mPollset);
 		mPollset = NULL;
 	}
+#if LL_LINUX
+	if(mEpollFD >= 0)
+	{
+		close(mEpollFD);
+		mEpollFD = -1;
+	}
+#endif
 }
 
 bool LLPumpIO::addChain(const chain_t& chain, F32 timeout)
@@ -275,6 +353,7 @@ bool LLPumpIO::setTimeoutSeconds(F32 timeout)
 		return false;
 	}
 	(*mCurrentChain).setTimeoutSeconds(timeout);
+	scheduleTimeout(*mCurrentChain);
 	return true;
 }
 
@@ -284,6 +363,7 @@ void LLPumpIO::adjustTimeoutSeconds(F32 delta)
 	if(mRunningChains.end() != mCurrentChain)
 	{
 		(*mCurrentChain).adjustTimeoutSeconds(delta);
+		scheduleTimeout(*mCurrentChain);
 	}
 }
 
@@ -339,7 +419,7 @@ bool LLPumpIO::setConditional(LLIOPipe* pipe, const apr_pollfd_t* poll)
 		LLChainInfo::pipe_conditional_t& value = (*it);
 		if(pipe_ptr == value.first)
 		{
-			ll_delete_apr_pollset_fd_client_data()(value);
+			removeConditional(value);
 			it = (*mCurrentChain).mDescriptors.erase(it);
 			mRebuildPollset = true;
 		}
@@ -366,6 +446,10 @@ bool LLPumpIO::setConditional(LLIOPipe* pipe, const apr_pollfd_t* poll)
 	}
 	value.second.client_data = new S32(++mPollsetClientID);
 	(*mCurrentChain).mDescriptors.push_back(value);
+	if(usingEpoll())
+	{
+		addEpollClient(value.second);
+	}
 	mRebuildPollset = true;
 	return true;
 }
@@ -474,6 +558,7 @@ void LLPumpIO::pump(const S32& poll_timeout)
 		{
 			return;
 		}
+		++mStats.mPumps;
 
 		PUMP_DEBUG;
 		// Move the pending chains over to the running chaings
@@ -481,10 +566,21 @@ void LLPumpIO::pump(const S32& poll_timeout)
 		{
 			PUMP_DEBUG;
 			//lldebugs << "Pushing " << mPendingChains.size() << "." << llendl;
-			std::copy(
-				mPendingChains.begin(),
-				mPendingChains.end(),
-				std::back_insert_iterator<running_chains_t>(mRunningChains));
+			pending_chains_t::iterator it = mPendingChains.begin();
+			pending_chains_t::iterator end = mPendingChains.end();
+			for(; it != end; ++it)
+			{
+				running_chains_t::iterator chain = mRunningChains.insert(
+					mRunningChains.end(),
+					*it);
+				if(0 == ++mNextChainID)
+				{
+					mNextChainID = 1;
+				}
+				(*chain).mChainID = mNextChainID;
+				mChainIndex[mNextChainID] = chain;
+				scheduleTimeout(*chain);
+			}
 			mPendingChains.clear();
 			PUMP_DEBUG;
 		}
@@ -510,11 +606,16 @@ void LLPumpIO::pump(const S32& poll_timeout)
 	}
 
 	PUMP_DEBUG;
-	// rebuild the pollset if necessary
+	// rebuild the pollset if necessary. Epoll registrations are kept
+	// up to date by setConditional() instead.
 	if(mRebuildPollset)
 	{
 		PUMP_DEBUG;
-		rebuildPollset();
+		if(!usingEpoll())
+		{
+			rebuildPollset();
+			++mStats.mPollsetRebuilds;
+		}
 		mRebuildPollset = false;
 	}
 
@@ -522,10 +623,14 @@ void LLPumpIO::pump(const S32& poll_timeout)
 	// *TODO: may want to pass in a poll timeout so it works correctly
 	// in single and multi threaded processes.
 	PUMP_DEBUG;
-	typedef std::map<S32, S32> signal_client_t;
+	typedef std::map<S32, apr_int16_t> signal_client_t;
 	signal_client_t signalled_client;
 	const apr_pollfd_t* poll_fd = NULL;
-	if(mPollset)
+	if(usingEpoll())
+	{
+		pollEpoll(poll_timeout, signalled_client);
+	}
+	else if(mPollset)
 	{
 		PUMP_DEBUG;
 		//llinfos << "polling" << llendl;
@@ -540,10 +645,17 @@ void LLPumpIO::pump(const S32& poll_timeout)
 		{
 			ll_debug_poll_fd("Signalled pipe", &poll_fd[ii]);
 			client_id = *((S32*)poll_fd[ii].client_data);
-			signalled_client[client_id] = ii;
+			signalled_client[client_id] = poll_fd[ii].rtnevents;
 		}
 		PUMP_DEBUG;
 	}
+	mStats.mDescriptorsSignalled = signalled_client.size();
+	mStats.mChainsProcessed = 0;
+	mStats.mChainsWaiting = 0;
+
+	// Retire or give another chance to any chain which has timed out.
+	PUMP_DEBUG;
+	expireChains();
 
 	PUMP_DEBUG;
 	// set up for a check to see if each one was signalled
@@ -555,50 +667,10 @@ void LLPumpIO::pump(const S32& poll_timeout)
 	bool process_this_chain = false;
 	while( run_chain != mRunningChains.end() )
 	{
-		PUMP_DEBUG;
-		if((*run_chain).mInit
-		   && (*run_chain).mTimer.getStarted()
-		   && (*run_chain).mTimer.hasExpired())
-		{
-			PUMP_DEBUG;
-			if(handleChainError(*run_chain, LLIOPipe::STATUS_EXPIRED))
-			{
-				// the pipe probably handled the error. If the handler
-				// forgot to reset the expiration then we need to do
-				// that here.
-				if((*run_chain).mTimer.getStarted()
-				   && (*run_chain).mTimer.hasExpired())
-				{
-					PUMP_DEBUG;
-					llinfos << "Error handler forgot to reset timeout. "
-							<< "Resetting to " << DEFAULT_CHAIN_EXPIRY_SECS
-							<< " seconds." << llendl;
-					(*run_chain).setTimeoutSeconds(DEFAULT_CHAIN_EXPIRY_SECS);
-				}
-			}
-			else
-			{
-				PUMP_DEBUG;
-				// it timed out and no one handled it, so we need to
-				// retire the chain
-#if LL_DEBUG_PIPE_TYPE_IN_PUMP
-				lldebugs << "Removing chain "
-						<< (*run_chain).mChainLinks[0].mPipe
-						<< " '"
-						<< typeid(*((*run_chain).mChainLinks[0].mPipe)).name()
-						<< "' because it timed out." << llendl;
-#else
-//				lldebugs << "Removing chain "
-//						<< (*run_chain).mChainLinks[0].mPipe
-//						<< " because we reached the end." << llendl;
-#endif
-				run_chain = mRunningChains.erase(run_chain);
-				continue;
-			}
-		}
 		PUMP_DEBUG;
 		if((*run_chain).mLock)
 		{
+			++mStats.mChainsWaiting;
 			++run_chain;
 			continue;
 		}
@@ -636,8 +708,8 @@ void LLPumpIO::pump(const S32& poll_timeout)
 					if (signal == not_signalled) continue;
 					static const apr_int16_t POLL_CHAIN_ERROR =
 						APR_POLLHUP | APR_POLLNVAL | APR_POLLERR;
-					const apr_pollfd_t* poll = &(poll_fd[(*signal).second]);
-					if(poll->rtnevents & POLL_CHAIN_ERROR)
+					const apr_int16_t rtnevents = (*signal).second;
+					if(rtnevents & POLL_CHAIN_ERROR)
 					{
 						// Potential eror condition has been
 						// returned. If HUP was one of them, we pass
@@ -648,12 +720,12 @@ void LLPumpIO::pump(const S32& poll_timeout)
 						// the logic here gets no more strained than
 						// it already is.
 						LLIOPipe::EStatus error_status;
-						if(poll->rtnevents & APR_POLLHUP)
+						if(rtnevents & APR_POLLHUP)
 							error_status = LLIOPipe::STATUS_LOST_CONNECTION;
 						else
 							error_status = LLIOPipe::STATUS_ERROR;
 						if(handleChainError(*run_chain, error_status)) break;
-						ll_debug_poll_fd("Removing pipe", poll);
+						ll_debug_poll_fd("Removing pipe", &((*it).second));
 						llwarns << "Removing pipe "
 							<< (*run_chain).mChainLinks[0].mPipe
 							<< " '"
@@ -662,7 +734,7 @@ void LLPumpIO::pump(const S32& poll_timeout)
 								*((*run_chain).mChainLinks[0].mPipe)).name()
 #endif
 							<< "' because: "
-							<< events_2_string(poll->rtnevents)
+							<< events_2_string(rtnevents)
 							<< llendl;
 						(*run_chain).mHead = (*run_chain).mChainLinks.end();
 						break;
@@ -682,9 +754,17 @@ void LLPumpIO::pump(const S32& poll_timeout)
 			{
 				(*run_chain).mHead = (*run_chain).mChainLinks.begin();
 				(*run_chain).mInit = true;
+
+				// chains only expire once they have started.
+				scheduleTimeout(*run_chain);
 			}
 			PUMP_DEBUG;
 			processChain(*run_chain);
+			++mStats.mChainsProcessed;
+		}
+		else
+		{
+			++mStats.mChainsWaiting;
 		}
 
 		PUMP_DEBUG;
@@ -703,14 +783,7 @@ void LLPumpIO::pump(const S32& poll_timeout)
 			PUMP_DEBUG;
 			// This chain is done. Clean up any allocated memory and
 			// erase the chain info.
-			std::for_each(
-				(*run_chain).mDescriptors.begin(),
-				(*run_chain).mDescriptors.end(),
-				ll_delete_apr_pollset_fd_client_data());
-			run_chain = mRunningChains.erase(run_chain);
-
-			// *NOTE: may not always need to rebuild the pollset.
-			mRebuildPollset = true;
+			run_chain = removeChain(run_chain);
 		}
 		else
 		{
@@ -724,6 +797,7 @@ void LLPumpIO::pump(const S32& poll_timeout)
 	PUMP_DEBUG;
 	// null out the chain
 	mCurrentChain = mRunningChains.end();
+	mStats.mTotalChainsProcessed += mStats.mChainsProcessed;
 	END_PUMP_DEBUG;
 }
 
@@ -838,6 +912,307 @@ void LLPumpIO::initialize(void)
 	apr_thread_mutex_create(&mChainsMutex, APR_THREAD_MUTEX_UNNESTED, mPool());
 	apr_thread_mutex_create(&mCallbackMutex, APR_THREAD_MUTEX_UNNESTED, mPool());
 #endif
+#if LL_LINUX
+	if(sUseEpoll)
+	{
+		// the size is only a hint to the kernel.
+		mEpollFD = epoll_create(64);
+		if(mEpollFD < 0)
+		{
+			llwarns << "Unable to create epoll descriptor, errno " << errno
+					<< ". Falling back to apr pollset." << llendl;
+		}
+	}
+#endif
+}
+
+void LLPumpIO::scheduleTimeout(LLChainInfo& chain)
+{
+	if(!chain.mTimer.getStarted())
+	{
+		return;
+	}
+
+	// An earlier entry for this chain will reschedule it when it
+	// comes up, so only push when the chain now expires sooner.
+	F64 expiry = chain.mTimer.expiresAt();
+	if((chain.mScheduledExpiry > 0.0) && (chain.mScheduledExpiry <= expiry))
+	{
+		return;
+	}
+	LLChainTimeout timeout;
+	timeout.mExpiry = expiry;
+	timeout.mChainID = chain.mChainID;
+	mTimeouts.push(timeout);
+	chain.mScheduledExpiry = expiry;
+}
+
+void LLPumpIO::expireChains()
+{
+	if(mTimeouts.empty())
+	{
+		return;
+	}
+
+	// Pull everything due first, so that anything rescheduled below
+	// is not looked at again during this pump.
+	const F64 now = LLFrameTimer::getTotalSeconds();
+	std::vector<LLChainTimeout> due;
+	while(!mTimeouts.empty() && (mTimeouts.top().mExpiry <= now))
+	{
+		due.push_back(mTimeouts.top());
+		mTimeouts.pop();
+	}
+
+	std::vector<LLChainTimeout>::iterator it = due.begin();
+	std::vector<LLChainTimeout>::iterator end = due.end();
+	for(; it != end; ++it)
+	{
+		chain_index_t::iterator found = mChainIndex.find((*it).mChainID);
+		if(found == mChainIndex.end())
+		{
+			// the chain has already been removed.
+			continue;
+		}
+		running_chains_t::iterator run_chain = (*found).second;
+		LLChainInfo& chain = *run_chain;
+		if((*it).mExpiry == chain.mScheduledExpiry)
+		{
+			chain.mScheduledExpiry = 0.0;
+		}
+		if(!chain.mTimer.getStarted())
+		{
+			continue;
+		}
+		if(chain.mTimer.expiresAt() > now)
+		{
+			// the timeout was pushed back since this entry was made.
+			scheduleTimeout(chain);
+			continue;
+		}
+		if(!chain.mInit)
+		{
+			// rescheduled when the chain is first processed.
+			continue;
+		}
+
+		PUMP_DEBUG;
+		mCurrentChain = run_chain;
+		if(handleChainError(chain, LLIOPipe::STATUS_EXPIRED))
+		{
+			// the pipe probably handled the error. If the handler
+			// forgot to reset the expiration then we need to do
+			// that here.
+			if(chain.mTimer.getStarted() && chain.mTimer.hasExpired())
+			{
+				PUMP_DEBUG;
+				llinfos << "Error handler forgot to reset timeout. "
+						<< "Resetting to " << DEFAULT_CHAIN_EXPIRY_SECS
+						<< " seconds." << llendl;
+				chain.setTimeoutSeconds(DEFAULT_CHAIN_EXPIRY_SECS);
+			}
+			scheduleTimeout(chain);
+		}
+		else
+		{
+			PUMP_DEBUG;
+			// it timed out and no one handled it, so we need to
+			// retire the chain
+#if LL_DEBUG_PIPE_TYPE_IN_PUMP
+			lldebugs << "Removing chain "
+					<< chain.mChainLinks[0].mPipe
+					<< " '"
+					<< typeid(*(chain.mChainLinks[0].mPipe)).name()
+					<< "' because it timed out." << llendl;
+#endif
+			removeChain(run_chain);
+			++mStats.mChainsExpired;
+		}
+	}
+	mCurrentChain = mRunningChains.end();
+}
+
+void LLPumpIO::removeConditional(
+	const LLChainInfo::pipe_conditional_t& conditional)
+{
+	if(usingEpoll())
+	{
+		removeEpollClient(conditional.second);
+	}
+	ll_delete_apr_pollset_fd_client_data()(conditional);
+}
+
+LLPumpIO::running_chains_t::iterator LLPumpIO::removeChain(
+	running_chains_t::iterator chain)
+{
+	LLMemType m1(LLMemType::MTYPE_IO_PUMP);
+	if(!(*chain).mDescriptors.empty())
+	{
+		LLChainInfo::conditionals_t::iterator it;
+		it = (*chain).mDescriptors.begin();
+		LLChainInfo::conditionals_t::iterator end;
+		end = (*chain).mDescriptors.end();
+		for(; it != end; ++it)
+		{
+			removeConditional(*it);
+		}
+		mRebuildPollset = true;
+	}
+	mChainIndex.erase((*chain).mChainID);
+	return mRunningChains.erase(chain);
+}
+
+void LLPumpIO::addEpollClient(const apr_pollfd_t& poll)
+{
+#if LL_LINUX
+	int fd = epoll_descriptor(poll);
+	if(fd < 0)
+	{
+		llwarns << "Unable to find descriptor to poll." << llendl;
+		return;
+	}
+	std::vector<LLEpollClient>& clients = mEpollClients[fd];
+	LLEpollClient client;
+	client.mClientID = *((S32*)poll.client_data);
+	client.mReqEvents = poll.reqevents;
+	clients.push_back(client);
+
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.data.fd = fd;
+	std::vector<LLEpollClient>::const_iterator it = clients.begin();
+	std::vector<LLEpollClient>::const_iterator end = clients.end();
+	for(; it != end; ++it)
+	{
+		event.events |= apr_to_epoll_events((*it).mReqEvents);
+	}
+	int op = (1 == clients.size()) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+	int rv = epoll_ctl(mEpollFD, op, fd, &event);
+	if(rv < 0)
+	{
+		// The kernel drops a descriptor from the epoll set when it
+		// is closed, and the number may since have been reused.
+		if((EPOLL_CTL_MOD == op) && (ENOENT == errno))
+		{
+			rv = epoll_ctl(mEpollFD, EPOLL_CTL_ADD, fd, &event);
+		}
+		else if((EPOLL_CTL_ADD == op) && (EEXIST == errno))
+		{
+			rv = epoll_ctl(mEpollFD, EPOLL_CTL_MOD, fd, &event);
+		}
+	}
+	if(rv < 0)
+	{
+		llwarns << "Unable to add descriptor " << fd << " to epoll, errno "
+				<< errno << llendl;
+	}
+#endif
+}
+
+void LLPumpIO::removeEpollClient(const apr_pollfd_t& poll)
+{
+#if LL_LINUX
+	int fd = epoll_descriptor(poll);
+	epoll_clients_t::iterator found = mEpollClients.find(fd);
+	if(found == mEpollClients.end())
+	{
+		return;
+	}
+	S32 client_id = *((S32*)poll.client_data);
+	std::vector<LLEpollClient>& clients = (*found).second;
+	std::vector<LLEpollClient>::iterator it = clients.begin();
+	while(it != clients.end())
+	{
+		if((*it).mClientID == client_id)
+		{
+			it = clients.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	// Errors are ignored here since the descriptor may already have
+	// been closed.
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.data.fd = fd;
+	if(clients.empty())
+	{
+		mEpollClients.erase(found);
+		epoll_ctl(mEpollFD, EPOLL_CTL_DEL, fd, &event);
+	}
+	else
+	{
+		for(it = clients.begin(); it != clients.end(); ++it)
+		{
+			event.events |= apr_to_epoll_events((*it).mReqEvents);
+		}
+		epoll_ctl(mEpollFD, EPOLL_CTL_MOD, fd, &event);
+	}
+#endif
+}
+
+void LLPumpIO::pollEpoll(
+	S32 poll_timeout,
+	std::map<S32, apr_int16_t>& signalled)
+{
+#if LL_LINUX
+	// Just like an empty pollset, do not wait when there is nothing
+	// to wait for.
+	if(mEpollClients.empty())
+	{
+		return;
+	}
+
+	// poll_timeout is in microseconds, epoll takes milliseconds.
+	int timeout_ms = -1;
+	if(poll_timeout >= 0)
+	{
+		timeout_ms = (poll_timeout + 999) / 1000;
+	}
+
+	const S32 MAX_EPOLL_EVENTS = 256;
+	struct epoll_event events[MAX_EPOLL_EVENTS];
+	int count = 0;
+	{
+		LLPerfBlock polltime("pump_poll");
+		count = epoll_wait(mEpollFD, events, MAX_EPOLL_EVENTS, timeout_ms);
+	}
+	if(count < 0)
+	{
+		if(EINTR != errno)
+		{
+			llwarns << "epoll_wait failed, errno " << errno << llendl;
+		}
+		return;
+	}
+
+	static const apr_int16_t ALWAYS_SIGNALLED =
+		APR_POLLHUP | APR_POLLNVAL | APR_POLLERR;
+	for(S32 ii = 0; ii < count; ++ii)
+	{
+		epoll_clients_t::const_iterator found;
+		found = mEpollClients.find(events[ii].data.fd);
+		if(found == mEpollClients.end())
+		{
+			continue;
+		}
+		apr_int16_t rtnevents = epoll_to_apr_events(events[ii].events);
+		std::vector<LLEpollClient>::const_iterator it = (*found).second.begin();
+		std::vector<LLEpollClient>::const_iterator end = (*found).second.end();
+		for(; it != end; ++it)
+		{
+			apr_int16_t client_events =
+				rtnevents & ((*it).mReqEvents | ALWAYS_SIGNALLED);
+			if(client_events)
+			{
+				signalled[(*it).mClientID] |= client_events;
+			}
+		}
+	}
+#endif
 }
 
 void LLPumpIO::rebuildPollset()
@@ -1133,6 +1508,8 @@ bool LLPumpIO::handleChainError(
  */
 
 LLPumpIO::LLChainInfo::LLChainInfo() :
+	mChainID(0),
+	mScheduledExpiry(0.0),
 	mInit(false),
 	mLock(0),
 	mEOS(false),
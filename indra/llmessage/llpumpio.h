@@ -35,8 +35,11 @@
 #ifndef LL_LLPUMPIO_H
 #define LL_LLPUMPIO_H
 
+#include <map>
+#include <queue>
 #include <set>
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 #if LL_LINUX  // needed for PATH_MAX in APR.
 #include <sys/param.h>
 #endif
@@ -318,6 +321,43 @@ public:
 	 */
 	void control(EControl op);
 
+	/** 
+	 * @brief Use epoll instead of an APR pollset in pumps created
+	 * after this call.
+	 *
+	 * With epoll, descriptors are registered with the kernel once in
+	 * <code>setConditional()</code> instead of the whole pollset being
+	 * rebuilt whenever a chain with conditionals is added or removed.
+	 * This is only available on Linux and is ignored elsewhere.
+	 * @param use_epoll Pass true to use epoll.
+	 */
+	static void setUseEpoll(bool use_epoll);
+
+	/** 
+	 * @brief Return true if this pump polls with epoll.
+	 */
+	bool usingEpoll() const { return mEpollFD >= 0; }
+
+	/** 
+	 * @brief Counters kept by the pump.
+	 *
+	 * The per pump counts describe the last call to <code>pump()</code>.
+	 */
+	struct LLPumpStats
+	{
+		LLPumpStats();
+
+		U32 mPumps;
+		U32 mChainsProcessed;		// per pump
+		U32 mChainsWaiting;			// per pump, locked or not signalled
+		U32 mDescriptorsSignalled;	// per pump
+		U64 mTotalChainsProcessed;
+		U32 mChainsExpired;
+		U32 mPollsetRebuilds;
+	};
+
+	const LLPumpStats& getStats() const { return mStats; }
+
 protected:
 	/** 
 	 * @brief State of the pump
@@ -334,6 +374,9 @@ protected:
 	bool mRebuildPollset;
 	apr_pollset_t* mPollset;
 	S32 mPollsetClientID;
+	int mEpollFD;
+	LLPumpStats mStats;
+	static bool sUseEpoll;
 	S32 mNextLock;
 	std::set<S32> mClearLocks;
 
@@ -350,6 +393,8 @@ protected:
 		void adjustTimeoutSeconds(F32 delta);
 
 		// basic member data
+		U32 mChainID;
+		F64 mScheduledExpiry;	// earliest entry in mTimeouts, or 0
 		bool mInit;
 		S32 mLock;
 		LLFrameTimer mTimer;
@@ -375,6 +420,36 @@ protected:
 	typedef running_chains_t::iterator current_chain_t;
 	current_chain_t mCurrentChain;
 
+	// Running chains by id, so that timeouts can find their chain.
+	typedef boost::unordered_map<U32, running_chains_t::iterator> chain_index_t;
+	chain_index_t mChainIndex;
+	U32 mNextChainID;
+
+	// Chain expiry times, soonest first. Entries are left in place when
+	// a chain's timeout changes or the chain goes away, and are checked
+	// against the chain when they come up.
+	struct LLChainTimeout
+	{
+		F64 mExpiry;
+		U32 mChainID;
+		bool operator<(const LLChainTimeout& rhs) const
+		{
+			return mExpiry > rhs.mExpiry;
+		}
+	};
+	std::priority_queue<LLChainTimeout> mTimeouts;
+
+	// Every pipe polling a descriptor registered with epoll. A socket is
+	// often polled by both a reader and a writer, and epoll only takes
+	// one registration per descriptor.
+	struct LLEpollClient
+	{
+		S32 mClientID;
+		apr_int16_t mReqEvents;
+	};
+	typedef std::map<int, std::vector<LLEpollClient> > epoll_clients_t;
+	epoll_clients_t mEpollClients;
+
 	// structures necessary for doing callbacks
 	// since the callbacks only get one chance to run, we do not have
 	// to maintain a list.
@@ -424,6 +499,36 @@ protected:
 	 */
 	bool handleChainError(LLChainInfo& chain, LLIOPipe::EStatus error);
 
+	/** 
+	 * @brief Queue an expiry check for a chain whose timer changed.
+	 */
+	void scheduleTimeout(LLChainInfo& chain);
+
+	/** 
+	 * @brief Handle the running chains whose timers have expired.
+	 */
+	void expireChains();
+
+	/** 
+	 * @brief Forget a conditional, unregistering it from epoll.
+	 */
+	void removeConditional(const LLChainInfo::pipe_conditional_t& conditional);
+
+	/** 
+	 * @brief Remove a running chain along with its conditionals.
+	 *
+	 * @return Returns the chain after the one removed.
+	 */
+	running_chains_t::iterator removeChain(running_chains_t::iterator chain);
+
+	/* @name epoll support
+	 */
+	//@{
+	void addEpollClient(const apr_pollfd_t& poll);
+	void removeEpollClient(const apr_pollfd_t& poll);
+	void pollEpoll(S32 poll_timeout, std::map<S32, apr_int16_t>& signalled);
+	//@}
+
 public:
 	/** 
 	 * @brief Return number of running chains.
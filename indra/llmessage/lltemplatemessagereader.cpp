@@ -44,20 +44,41 @@
 #include "v3math.h"
 #include "v4math.h"
 
+LLMessageField::LLMessageField(const LLMessageTemplate* message_template,
+							   const char* block, const char* var) :
+	mTemplate(message_template),
+	mTemplateSerial(message_template ? message_template->mSerial : 0),
+	mBlock(NULL),
+	mVariable(NULL)
+{
+	if (!message_template)
+	{
+		return;
+	}
+	mBlock = message_template->getBlock((char*)block);
+	if (mBlock)
+	{
+		mVariable = mBlock->getVariable((char*)var);
+	}
+	if (!mVariable)
+	{
+		llwarns << "No variable " << block << "." << var << " in message "
+				<< message_template->mName << llendl;
+	}
+}
+
 LLTemplateMessageReader::LLTemplateMessageReader(message_template_number_map_t&
 												 number_template_map) :
 	mReceiveSize(0),
 	mCurrentRMessageTemplate(NULL),
-	mCurrentRMessageData(NULL),
-	mMessageNumbers(number_template_map)
+	mMessageNumbers(number_template_map),
+	mMessageDecoded(false)
 {
 }
 
 //virtual 
 LLTemplateMessageReader::~LLTemplateMessageReader()
 {
-	delete mCurrentRMessageData;
-	mCurrentRMessageData = NULL;
 }
 
 //virtual
@@ -65,8 +86,38 @@ void LLTemplateMessageReader::clearMessage()
 {
 	mReceiveSize = -1;
 	mCurrentRMessageTemplate = NULL;
-	delete mCurrentRMessageData;
-	mCurrentRMessageData = NULL;
+	mMessageDecoded = false;
+}
+
+bool LLTemplateMessageReader::findTemplateVariable(const char* blockname, const char* varname,
+												   const LLMessageBlock*& block,
+												   const LLMessageVariable*& var) const
+{
+	const LLMessageTemplate* message_template = mCurrentRMessageTemplate;
+	block = message_template->getBlock((char*)blockname);
+	var = block ? block->getVariable((char*)varname) : NULL;
+	return var != NULL;
+}
+
+const U8* LLTemplateMessageReader::findFieldData(const LLMessageBlock* block,
+												 const LLMessageVariable* var,
+												 S32 blocknum, S32& size) const
+{
+	if (blocknum < 0 || blocknum >= mBlockInstanceCount[block->mIndex])
+	{
+		return NULL;
+	}
+
+	const BlockInstance& instance = mBlockInstances[mBlockFirstInstance[block->mIndex] + blocknum];
+	if (instance.mFirstField < 0)
+	{
+		size = var->getSize();
+		return &mMessageBuffer[0] + instance.mOffset + var->getOffset();
+	}
+
+	const FieldPosition& position = mFieldPositions[instance.mFirstField + var->getIndex()];
+	size = position.mSize;
+	return &mMessageBuffer[0] + position.mOffset;
 }
 
 void LLTemplateMessageReader::getData(const char *blockname, const char *varname, void *datap, S32 size, S32 blocknum, S32 max_size)
@@ -78,77 +129,53 @@ void LLTemplateMessageReader::getData(const char *blockname, const char *varname
 		return;
 	}
 
-	if (!mCurrentRMessageData)
+	if (!mMessageDecoded)
 	{
-		llerrs << "Invalid mCurrentMessageData in getData!" << llendl;
+		llerrs << "No decoded message in getData!" << llendl;
 		return;
 	}
 
-	char *bnamep = (char *)blockname + blocknum; // this works because it's just a hash.  The bnamep is never derefference
-	char *vnamep = (char *)varname; 
-
-	LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-
-	if (iter == mCurrentRMessageData->mMemberBlocks.end())
+	const LLMessageBlock* block;
+	const LLMessageVariable* var;
+	if (!findTemplateVariable(blockname, varname, block, var))
 	{
-		llerrs << "Block " << blockname << " #" << blocknum
-			<< " not in message " << mCurrentRMessageData->mName << llendl;
+		llerrs << "Variable "<< varname << " not in message "
+			<< mCurrentRMessageTemplate->mName << " block " << blockname << llendl;
 		return;
 	}
 
-	LLMsgBlkData *msg_block_data = iter->second;
-	LLMsgVarData& vardata = msg_block_data->mMemberVarData[vnamep];
-
-	if (!vardata.getName())
+	S32 vardata_size = 0;
+	const U8* vardata = findFieldData(block, var, blocknum, vardata_size);
+	if (!vardata)
 	{
-		llerrs << "Variable "<< vnamep << " not in message "
-			<< mCurrentRMessageData->mName<< " block " << bnamep << llendl;
+		llerrs << "Block " << blockname << " #" << blocknum
+			<< " not in message " << mCurrentRMessageTemplate->mName << llendl;
 		return;
 	}
 
-	if (size && size != vardata.getSize())
+	if (size && size != vardata_size)
 	{
-		llerrs << "Msg " << mCurrentRMessageData->mName 
-			<< " variable " << vnamep
-			<< " is size " << vardata.getSize()
+		llerrs << "Msg " << mCurrentRMessageTemplate->mName 
+			<< " variable " << varname
+			<< " is size " << vardata_size
 			<< " but copying into buffer of size " << size
 			<< llendl;
 		return;
 	}
 
-
-	const S32 vardata_size = vardata.getSize();
 	if( max_size >= vardata_size )
 	{   
-		switch( vardata_size )
-		{ 
-		case 1:
-			*((U8*)datap) = *((U8*)vardata.getData());
-			break;
-		case 2:
-			*((U16*)datap) = *((U16*)vardata.getData());
-			break;
-		case 4:
-			*((U32*)datap) = *((U32*)vardata.getData());
-			break;
-		case 8:
-			((U32*)datap)[0] = ((U32*)vardata.getData())[0];
-			((U32*)datap)[1] = ((U32*)vardata.getData())[1];
-			break;
-		default:
-			memcpy(datap, vardata.getData(), vardata_size);
-			break;
-		}
+		htonmemcpy(datap, vardata, var->getType(), vardata_size);
 	}
 	else
 	{
-		llwarns << "Msg " << mCurrentRMessageData->mName 
-			<< " variable " << vnamep
-			<< " is size " << vardata.getSize()
+		llwarns << "Msg " << mCurrentRMessageTemplate->mName 
+			<< " variable " << varname
+			<< " is size " << vardata_size
 			<< " but truncated to max size of " << max_size
 			<< llendl;
 
-		memcpy(datap, vardata.getData(), max_size);
+		memcpy(datap, vardata, max_size);
 	}
 }
 
@@ -161,22 +188,20 @@ S32 LLTemplateMessageReader::getNumberOfBlocks(const char *blockname)
 		return -1;
 	}
 
-	if (!mCurrentRMessageData)
+	if (!mMessageDecoded)
 	{
-		llerrs << "Invalid mCurrentRMessageData in getData!" << llendl;
+		llerrs << "No decoded message in getNumberOfBlocks!" << llendl;
 		return -1;
 	}
 
-	char *bnamep = (char *)blockname; 
-
-	LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-	
-	if (iter == mCurrentRMessageData->mMemberBlocks.end())
+	const LLMessageTemplate* message_template = mCurrentRMessageTemplate;
+	const LLMessageBlock* block = message_template->getBlock((char*)blockname);
+	if (!block)
 	{
 		return 0;
 	}
 
-	return (iter->second)->mBlockNumber;
+	return mBlockInstanceCount[block->mIndex];
 }
 
 S32 LLTemplateMessageReader::getSize(const char *blockname, const char *varname)
@@ -188,43 +213,39 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, const char *varname)
 		return LL_MESSAGE_ERROR;
 	}
 
-	if (!mCurrentRMessageData)
+	if (!mMessageDecoded)
 	{	// This is a serious error - crash
-		llerrs << "Invalid mCurrentRMessageData in getData!" << llendl;
+		llerrs << "No decoded message in getSize!" << llendl;
 		return LL_MESSAGE_ERROR;
 	}
 
-	char *bnamep = (char *)blockname; 
-
-	LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-	
-	if (iter == mCurrentRMessageData->mMemberBlocks.end())
+	const LLMessageTemplate* message_template = mCurrentRMessageTemplate;
+	const LLMessageBlock* block = message_template->getBlock((char*)blockname);
+	if (!block || !mBlockInstanceCount[block->mIndex])
 	{	// don't crash
-		llinfos << "Block " << bnamep << " not in message "
-			<< mCurrentRMessageData->mName << llendl;
+		llinfos << "Block " << blockname << " not in message "
+			<< mCurrentRMessageTemplate->mName << llendl;
 		return LL_BLOCK_NOT_IN_MESSAGE;
 	}
 
-	char *vnamep = (char *)varname; 
-
-	LLMsgBlkData* msg_data = iter->second;
-	LLMsgVarData& vardata = msg_data->mMemberVarData[vnamep];
-	
-	if (!vardata.getName())
+	const LLMessageVariable* var = block->getVariable((char*)varname);
+	if (!var)
 	{	// don't crash
 		llinfos << "Variable " << varname << " not in message "
-			<< mCurrentRMessageData->mName << " block " << bnamep << llendl;
+			<< mCurrentRMessageTemplate->mName << " block " << blockname << llendl;
 		return LL_VARIABLE_NOT_IN_BLOCK;
 	}
 
-	if (mCurrentRMessageTemplate->mMemberBlocks[bnamep]->mType != MBT_SINGLE)
+	if (block->mType != MBT_SINGLE)
 	{	// This is a serious error - crash
-		llerrs << "Block " << bnamep << " isn't type MBT_SINGLE,"
+		llerrs << "Block " << blockname << " isn't type MBT_SINGLE,"
 			" use getSize with blocknum argument!" << llendl;
 		return LL_MESSAGE_ERROR;
 	}
 
-	return vardata.getSize();
+	S32 size = 0;
+	findFieldData(block, var, 0, size);
+	return size;
 }
 
 S32 LLTemplateMessageReader::getSize(const char *blockname, S32 blocknum, const char *varname)
@@ -236,35 +257,82 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, S32 blocknum, const
 		return LL_MESSAGE_ERROR;
 	}
 
-	if (!mCurrentRMessageData)
+	if (!mMessageDecoded)
 	{	// This is a serious error - crash
-		llerrs << "Invalid mCurrentRMessageData in getData!" << llendl;
+		llerrs << "No decoded message in getSize!" << llendl;
 		return LL_MESSAGE_ERROR;
 	}
 
-	char *bnamep = (char *)blockname + blocknum; 
-	char *vnamep = (char *)varname; 
-
-	LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-	
-	if (iter == mCurrentRMessageData->mMemberBlocks.end())
+	const LLMessageTemplate* message_template = mCurrentRMessageTemplate;
+	const LLMessageBlock* block = message_template->getBlock((char*)blockname);
+	if (!block || blocknum < 0 || blocknum >= mBlockInstanceCount[block->mIndex])
 	{	// don't crash
-		llinfos << "Block " << bnamep << " not in message " 
-			<< mCurrentRMessageData->mName << llendl;
+		llinfos << "Block " << blockname << " #" << blocknum << " not in message " 
+			<< mCurrentRMessageTemplate->mName << llendl;
 		return LL_BLOCK_NOT_IN_MESSAGE;
 	}
 
-	LLMsgBlkData* msg_data = iter->second;
-	LLMsgVarData& vardata = msg_data->mMemberVarData[vnamep];
-	
-	if (!vardata.getName())
+	const LLMessageVariable* var = block->getVariable((char*)varname);
+	if (!var)
 	{	// don't crash
-		llinfos << "Variable " << vnamep << " not in message "
-			<<  mCurrentRMessageData->mName << " block " << bnamep << llendl;
+		llinfos << "Variable " << varname << " not in message "
+			<<  mCurrentRMessageTemplate->mName << " block " << blockname << llendl;
 		return LL_VARIABLE_NOT_IN_BLOCK;
 	}
 
-	return vardata.getSize();
+	S32 size = 0;
+	findFieldData(block, var, blocknum, size);
+	return size;
+}
+
+// A field resolved against another message's template would index the
+// wrong block tables, so it is rejected rather than trusted.
+bool LLTemplateMessageReader::isFieldOfCurrentMessage(const LLMessageField& field) const
+{
+	return mCurrentRMessageTemplate
+		&& field.mTemplateSerial == mCurrentRMessageTemplate->mSerial;
+}
+
+bool LLTemplateMessageReader::isCurrentField(const LLMessageField& field) const
+{
+	if (!isFieldOfCurrentMessage(field))
+	{
+		// field.mTemplate may be gone, don't look at it
+		llwarns << "Field from another message template used on message "
+				<< (mCurrentRMessageTemplate ? mCurrentRMessageTemplate->mName : "(none)") << llendl;
+		return false;
+	}
+	return true;
+}
+
+S32 LLTemplateMessageReader::getNumberOfBlocks(const LLMessageField& field) const
+{
+	if (!mMessageDecoded || !field.mBlock || !isCurrentField(field))
+	{
+		return 0;
+	}
+	return mBlockInstanceCount[field.mBlock->mIndex];
+}
+
+const U8* LLTemplateMessageReader::getFieldData(const LLMessageField& field, S32 blocknum, S32& size) const
+{
+	if (!mMessageDecoded || !field.mVariable || !isCurrentField(field))
+	{
+		return NULL;
+	}
+	return findFieldData(field.mBlock, field.mVariable, blocknum, size);
+}
+
+bool LLTemplateMessageReader::getField(const LLMessageField& field, void* datap, S32 size, S32 blocknum) const
+{
+	S32 data_size = 0;
+	const U8* data = getFieldData(field, blocknum, data_size);
+	if (!data || data_size != size)
+	{
+		return false;
+	}
+	htonmemcpy(datap, data, field.mVariable->getType(), size);
+	return true;
 }
 
 void LLTemplateMessageReader::getBinaryData(const char *blockname, 
@@ -551,24 +619,32 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender,
 {
 	llassert( mReceiveSize >= 0 );
 	llassert( mCurrentRMessageTemplate);
-	llassert( !mCurrentRMessageData );
-	delete mCurrentRMessageData; // just to make sure
+	mMessageDecoded = false;
 
 	// The offset tells us how may bytes to skip after the end of the
 	// message name.
 	U8 offset = buffer[PHL_OFFSET];
 	S32 decode_pos = LL_PACKET_ID_SIZE + (S32)(mCurrentRMessageTemplate->mFrequency) + offset;
 
-	// create base working data set
-	mCurrentRMessageData = new LLMsgData(mCurrentRMessageTemplate->mName);
-	
-	// loop through the template building the data structure as we go
+	// Fixed size fields the sender left off the end read as zeros, so
+	// the copy of the packet is padded out to the last of them.
+	S32 decode_end = mReceiveSize;
+	bool ran_off_end = false;
+
+	const S32 num_blocks = (S32)mCurrentRMessageTemplate->mMemberBlocks.size();
+	mBlockFirstInstance.resize(num_blocks);
+	mBlockInstanceCount.resize(num_blocks);
+	mBlockInstances.clear();
+	mFieldPositions.clear();
+
+	// loop through the template recording where every block instance,
+	// and every field of blocks without a fixed layout, starts
 	LLMessageTemplate::message_block_map_t::const_iterator iter;
 	for(iter = mCurrentRMessageTemplate->mMemberBlocks.begin();
 		iter != mCurrentRMessageTemplate->mMemberBlocks.end();
 		++iter)
 	{
-		LLMessageBlock* mbci = *iter;
+		const LLMessageBlock* mbci = *iter;
 		U8	repeat_number;
 		S32	i;
 
@@ -612,36 +688,43 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender,
 			return FALSE;
 		}
 
-		LLMsgBlkData* cur_data_block = NULL;
+		mBlockFirstInstance[mbci->mIndex] = (S32)mBlockInstances.size();
+		mBlockInstanceCount[mbci->mIndex] = repeat_number;
 
 		// now loop through the block
 		for (i = 0; i < repeat_number; i++)
 		{
-			if (i)
-			{
-				// build new name to prevent collisions
-				// TODO: This should really change to a vector
-				cur_data_block = new LLMsgBlkData(mbci->mName, repeat_number);
-				cur_data_block->mName = mbci->mName + i;
-			}
-			else
+			BlockInstance instance;
+			instance.mOffset = decode_pos;
+
+			if (mbci->mTotalSize != -1)
 			{
-				cur_data_block = new LLMsgBlkData(mbci->mName, repeat_number);
+				// fixed layout, the template has every field's offset
+				instance.mFirstField = -1;
+				mBlockInstances.push_back(instance);
+				decode_pos += mbci->mTotalSize;
+				if (decode_pos > mReceiveSize)
+				{
+					// <edit>
+					if(!custom && !ran_off_end)
+					// </edit>
+					logRanOffEndOfPacket(sender, instance.mOffset, mbci->mTotalSize);
+					ran_off_end = true;
+					decode_end = llmax(decode_end, decode_pos);
+				}
+				continue;
 			}
 
-			// add the block to the message
-			mCurrentRMessageData->addBlock(cur_data_block);
+			instance.mFirstField = (S32)mFieldPositions.size();
+			mBlockInstances.push_back(instance);
 
-			// now read the variables
+			// now find the variables
 			for (LLMessageBlock::message_variable_map_t::const_iterator iter = 
 					 mbci->mMemberVariables.begin();
 				 iter != mbci->mMemberVariables.end(); iter++)
 			{
 				const LLMessageVariable& mvci = **iter;
-
-				// ok, build out the variables
-				// add variable block
-				cur_data_block->addVariable(mvci.getName(), mvci.getType());
+				FieldPosition position;
 
 				// what type of variable?
 				if (mvci.getType() == MVT_VARIABLE)
@@ -655,9 +738,10 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender,
 					if ((decode_pos + data_size) > mReceiveSize)
 					{
 						// <edit>
-						if(!custom)
+						if(!custom && !ran_off_end)
 						// </edit>
 						logRanOffEndOfPacket(sender, decode_pos, data_size);
+						ran_off_end = true;
 
 						// default to 0 length variable blocks
 						tsize = 0;
@@ -684,45 +768,50 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender,
 					}
 					decode_pos += data_size;
 
-					cur_data_block->addData(mvci.getName(), &buffer[decode_pos], tsize, mvci.getType());
-					decode_pos += tsize;
+					// never hand out bytes past the end of the packet, even
+					// if the length says there should be more
+					position.mOffset = llmin(decode_pos, mReceiveSize);
+					S32 available = mReceiveSize - position.mOffset;
+					position.mSize = tsize > (U32)available ? available : (S32)tsize;
+					decode_pos = position.mOffset + position.mSize;
 				}
 				else
 				{
 					// fixed!
-					// so, copy data pointer and set data size to fixed size
-					if ((decode_pos + mvci.getSize()) > mReceiveSize)
+					position.mOffset = decode_pos;
+					position.mSize = mvci.getSize();
+					decode_pos += mvci.getSize();
+					if (decode_pos > mReceiveSize)
 					{
 						// <edit>
-						if(!custom)
+						if(!custom && !ran_off_end)
 						// </edit>
-						logRanOffEndOfPacket(sender, decode_pos, mvci.getSize());
-
-						// default to 0s.
-						U32 size = mvci.getSize();
-						std::vector<U8> data(size, 0);
-						cur_data_block->addData(mvci.getName(), &(data[0]), 
-												size, mvci.getType());
-					}
-					else
-					{
-						cur_data_block->addData(mvci.getName(), 
-												&buffer[decode_pos], 
-												mvci.getSize(), 
-												mvci.getType());
+						logRanOffEndOfPacket(sender, position.mOffset, mvci.getSize());
+						ran_off_end = true;
+						decode_end = llmax(decode_end, decode_pos);
 					}
-					decode_pos += mvci.getSize();
 				}
+				mFieldPositions.push_back(position);
 			}
 		}
 	}
 
-	if (mCurrentRMessageData->mMemberBlocks.empty()
+	if (mBlockInstances.empty()
 		&& !mCurrentRMessageTemplate->mMemberBlocks.empty())
 	{
 		lldebugs << "Empty message '" << mCurrentRMessageTemplate->mName << "' (no blocks)" << llendl;
 		return FALSE;
 	}
+
+	// keep our own copy, handlers may read the message after the receive
+	// buffer has moved on
+	mMessageBuffer.resize(decode_end);
+	memcpy(&mMessageBuffer[0], buffer, mReceiveSize);		/* Flawfinder: ignore */
+	if (decode_end > mReceiveSize)
+	{
+		memset(&mMessageBuffer[mReceiveSize], 0, decode_end - mReceiveSize);
+	}
+	mMessageDecoded = true;
 	
 	// <edit>
 	if(!custom)
@@ -871,5 +960,46 @@ void LLTemplateMessageReader::copyToBuilder(LLMessageBuilder& builder) const
     {
         return;
     }
-	builder.copyFromMessageData(*mCurrentRMessageData);
+	if (!mMessageDecoded)
+	{
+		return;
+	}
+	LLMsgData* message_data = buildMessageData();
+	builder.copyFromMessageData(*message_data);
+	delete message_data;
+}
+
+// Rebuilds the name indexed form of the current message, for the rare
+// callers that need it.
+LLMsgData* LLTemplateMessageReader::buildMessageData() const
+{
+	LLMsgData* message_data = new LLMsgData(mCurrentRMessageTemplate->mName);
+
+	LLMessageTemplate::message_block_map_t::const_iterator iter;
+	for (iter = mCurrentRMessageTemplate->mMemberBlocks.begin();
+		 iter != mCurrentRMessageTemplate->mMemberBlocks.end();
+		 ++iter)
+	{
+		const LLMessageBlock* block = *iter;
+		S32 repeat_number = mBlockInstanceCount[block->mIndex];
+		for (S32 i = 0; i < repeat_number; i++)
+		{
+			// build new name to prevent collisions
+			LLMsgBlkData* block_data = new LLMsgBlkData(block->mName, repeat_number);
+			block_data->mName = block->mName + i;
+			message_data->addBlock(block_data);
+
+			for (LLMessageBlock::message_variable_map_t::const_iterator var_iter =
+					 block->mMemberVariables.begin();
+				 var_iter != block->mMemberVariables.end(); ++var_iter)
+			{
+				const LLMessageVariable* var = *var_iter;
+				S32 size = 0;
+				const U8* data = findFieldData(block, var, i, size);
+				block_data->addVariable(var->getName(), var->getType());
+				block_data->addData(var->getName(), data, size, var->getType());
+			}
+		}
+	}
+	return message_data;
 }
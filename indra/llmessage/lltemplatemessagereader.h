@@ -36,10 +36,31 @@
 #include "llmessagereader.h"
 
 #include <map>
+#include <vector>
 
+class LLMessageBlock;
 class LLMessageTemplate;
+class LLMessageVariable;
 class LLMsgData;
 
+// A template variable resolved ahead of time, so handlers reading the same
+// fields from every block of a busy message skip the block and variable
+// name lookups the getU32() style accessors do on each call.  Resolve once,
+// typically into a function static, with LLMessageSystem::getTemplateField().
+class LLMessageField
+{
+public:
+	LLMessageField() : mTemplate(NULL), mTemplateSerial(0), mBlock(NULL), mVariable(NULL) {}
+	LLMessageField(const LLMessageTemplate* message_template, const char* block, const char* var);
+
+	bool isValid() const { return mVariable != NULL; }
+
+	const LLMessageTemplate*	mTemplate;
+	U32							mTemplateSerial;	// see LLMessageTemplate::mSerial
+	const LLMessageBlock*		mBlock;
+	const LLMessageVariable*	mVariable;
+};
+
 class LLTemplateMessageReader : public LLMessageReader
 {
 public:
@@ -118,8 +139,56 @@ public:
 	bool isTrusted() const;
 	bool isBanned(bool trusted_source) const;
 	bool isUdpBanned() const;
-	
+
+	/** @name Compiled field access */
+	//@{
+	const LLMessageTemplate* getCurrentTemplate() const { return mCurrentRMessageTemplate; }
+
+	// True if field was resolved against the current message's template.
+	// Never dereferences the field, so it is safe on a field cached from a
+	// message system that has since been destroyed.
+	bool isFieldOfCurrentMessage(const LLMessageField& field) const;
+
+	// These all fail (0, NULL or false) for a field that does not come
+	// from the current message's template.
+	S32 getNumberOfBlocks(const LLMessageField& field) const;
+
+	// Returns the field's bytes in the current message, or NULL if the
+	// message has no such block.  size is set to the length of the data,
+	// not counting the length prefix of variable length fields.
+	const U8* getFieldData(const LLMessageField& field, S32 blocknum, S32& size) const;
+
+	// Copies a fixed size field into value, returns false (and leaves
+	// value alone) if the block is missing or the size does not match.
+	bool getField(const LLMessageField& field, void* datap, S32 size, S32 blocknum) const;
+
+	template <class T>
+	bool getField(const LLMessageField& field, T& value, S32 blocknum = 0) const
+	{
+		return getField(field, &value, (S32)sizeof(T), blocknum);
+	}
+	//@}
+
 private:
+	// Where one block instance, or one field of a block instance with
+	// variable length fields, starts in mMessageBuffer.
+	struct BlockInstance
+	{
+		S32 mOffset;
+		S32 mFirstField;	// into mFieldPositions, -1 for fixed size blocks
+	};
+	struct FieldPosition
+	{
+		S32 mOffset;
+		S32 mSize;
+	};
+
+	bool isCurrentField(const LLMessageField& field) const;
+	const U8* findFieldData(const LLMessageBlock* block, const LLMessageVariable* var,
+							S32 blocknum, S32& size) const;
+	bool findTemplateVariable(const char* blockname, const char* varname,
+							  const LLMessageBlock*& block, const LLMessageVariable*& var) const;
+	LLMsgData* buildMessageData() const;
 
 	void getData(const char *blockname, const char *varname, void *datap, 
 				 S32 size = 0, S32 blocknum = 0, S32 max_size = S32_MAX);
@@ -141,8 +210,18 @@ private:
 
 	S32	mReceiveSize;
 	LLMessageTemplate* mCurrentRMessageTemplate;
-	LLMsgData* mCurrentRMessageData;
 	message_template_number_map_t& mMessageNumbers;
+
+	// Decoded message: a copy of the packet plus the position of every
+	// block instance, indexed through the template instead of by name.
+	// Reused from message to message, so decoding does not allocate once
+	// the vectors have grown to the biggest message seen.
+	std::vector<U8>				mMessageBuffer;
+	std::vector<S32>			mBlockFirstInstance;	// per template block
+	std::vector<S32>			mBlockInstanceCount;
+	std::vector<BlockInstance>	mBlockInstances;
+	std::vector<FieldPosition>	mFieldPositions;
+	bool						mMessageDecoded;
 };
 
 #endif // LL_LLTEMPLATEMESSAGEREADER_H
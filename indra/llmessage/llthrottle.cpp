@@ -175,6 +175,24 @@ F32 gThrottleMinimumBPS[TC_EOF] =
 	10000.f,	// TC_ASSET
 };
 
+// Relative weight each channel gets when spare bandwidth is handed
+// out to channels with a backlog.  Resends and object updates unblock
+// everything else, so they go first.
+F32 gThrottleDefaultPriority[TC_EOF] =
+{
+	1.0f,	// TC_RESEND
+	0.6f,	// TC_LAND
+	0.2f,	// TC_WIND
+	0.2f,	// TC_CLOUD
+	1.0f,	// TC_TASK
+	0.8f,	// TC_TEXTURE
+	0.5f,	// TC_ASSET
+};
+
+const F32 DYNAMIC_ADJUST_TIME = 1.0f;		// seconds
+
+bool LLThrottleGroup::sAdaptive = false;
+
 const char* THROTTLE_NAMES[TC_EOF] =
 {
 	"Resend ",
@@ -193,8 +211,14 @@ LLThrottleGroup::LLThrottleGroup()
 	{
 		mThrottleTotal[i]	= gThrottleDefaultBPS[i];
 		mNominalBPS[i]		= gThrottleDefaultBPS[i];
+		mPriorityWeight[i]	= gThrottleDefaultPriority[i];
 	}
 
+	mLinkScale = 1.f;
+	mMinPingDelay = 0.f;
+	mLastPacketsOut = 0;
+	mLastPacketsResent = 0;
+
 	resetDynamicAdjust();
 }
 
@@ -237,10 +261,64 @@ void LLThrottleGroup::resetDynamicAdjust()
 		mLastSendTime[i] = mt_sec;
 		mBitsSentThisPeriod[i] = 0;
 		mBitsSentHistory[i] = 0;
+		mQueueDepthThisPeriod[i] = 0.f;
+		mQueueDepth[i] = 0.f;
+		mAchievedBPS[i] = 0.f;
 	}
 	mDynamicAdjustTime = mt_sec;
 }
 
+void LLThrottleGroup::setPriorityWeight(S32 throttle_cat, F32 weight)
+{
+	mPriorityWeight[throttle_cat] = llmax(weight, 0.f);
+}
+
+void LLThrottleGroup::noteQueueDepth(S32 throttle_cat, F32 bits)
+{
+	mQueueDepthThisPeriod[throttle_cat] = llmax(mQueueDepthThisPeriod[throttle_cat], bits);
+}
+
+void LLThrottleGroup::updateLinkStats(F32 ping_delay_ms, U32 packets_out, U32 packets_resent)
+{
+	const F32 LOSS_THRESHOLD = 0.02f;		// resend fraction that counts as congestion
+	const F32 PING_INFLATION = 2.f;		// ping this many times the baseline counts as congestion
+	const F32 PING_SLACK_MS = 50.f;		// ...plus this much, so LAN circuits don't flap
+	const F32 BASELINE_DRIFT = 0.01f;	// let the baseline creep up in case the route changed
+	const F32 BACKOFF = 0.85f;
+	const F32 RECOVER = 0.05f;
+	const F32 MIN_LINK_SCALE = 0.5f;
+
+	U32 sent = packets_out - mLastPacketsOut;
+	U32 resent = packets_resent - mLastPacketsResent;
+	mLastPacketsOut = packets_out;
+	mLastPacketsResent = packets_resent;
+
+	if (ping_delay_ms > 0.f)
+	{
+		if (mMinPingDelay <= 0.f || ping_delay_ms < mMinPingDelay)
+		{
+			mMinPingDelay = ping_delay_ms;
+		}
+		else
+		{
+			mMinPingDelay += (ping_delay_ms - mMinPingDelay) * BASELINE_DRIFT;
+		}
+	}
+
+	F32 loss = sent ? (F32)resent / (F32)sent : 0.f;
+	BOOL congested = (loss > LOSS_THRESHOLD)
+		|| (mMinPingDelay > 0.f && ping_delay_ms > mMinPingDelay * PING_INFLATION + PING_SLACK_MS);
+
+	if (congested)
+	{
+		mLinkScale = llmax(mLinkScale * BACKOFF, MIN_LINK_SCALE);
+	}
+	else
+	{
+		mLinkScale = llmin(mLinkScale + RECOVER, 1.f);
+	}
+}
+
 
 BOOL LLThrottleGroup::setNominalBPS(F32* throttle_vec)
 {
@@ -362,7 +440,6 @@ BOOL LLThrottleGroup::throttleOverflow(S32 throttle_cat, F32 bits)
 
 BOOL LLThrottleGroup::dynamicAdjust()
 {
-	const F32 DYNAMIC_ADJUST_TIME = 1.0f;		// seconds
 	const F32 CURRENT_PERIOD_WEIGHT = .25f;		// how much weight to give to last period while determining BPS utilization
 	const F32 BUSY_PERCENT = 0.75f;		// if use more than this fraction of BPS, you are busy
 	const F32 IDLE_PERCENT = 0.70f;		// if use less than this fraction, you are "idle"
@@ -374,7 +451,8 @@ BOOL LLThrottleGroup::dynamicAdjust()
 	F64 mt_sec = LLMessageSystem::getMessageTimeSeconds();
 
 	// Only dynamically adjust every few seconds
-	if ((mt_sec - mDynamicAdjustTime) < DYNAMIC_ADJUST_TIME)
+	F32 period = (F32)(mt_sec - mDynamicAdjustTime);
+	if (period < DYNAMIC_ADJUST_TIME)
 	{
 		return FALSE;
 	}
@@ -396,10 +474,20 @@ BOOL LLThrottleGroup::dynamicAdjust()
 				+ CURRENT_PERIOD_WEIGHT * mBitsSentThisPeriod[i];
 		}
 
+		mAchievedBPS[i] = 0.5f * mAchievedBPS[i] + 0.5f * (mBitsSentThisPeriod[i] / period);
+		mQueueDepth[i] = mQueueDepthThisPeriod[i];
+		mQueueDepthThisPeriod[i] = 0.f;
+
 		mBitsSentThisPeriod[i] = 0;
 		total += llround(mBitsSentHistory[i]);
 	}
 
+	if (sAdaptive)
+	{
+		adaptiveAdjust();
+		return TRUE;
+	}
+
 	// Look for busy channels
 	// TODO: Fold into loop above.
 	BOOL channels_busy = FALSE;
@@ -589,3 +677,134 @@ BOOL LLThrottleGroup::dynamicAdjust()
 	}
 	return TRUE;
 }
+
+// Shift the budget toward what each channel is sending plus enough to
+// drain its reported backlog.
+void LLThrottleGroup::adaptiveAdjust()
+{
+	const F32 BACKLOG_DRAIN_TIME = 2.f;		// seconds we'd like a backlog cleared in
+	const F32 SMOOTHING = 0.5f;				// how far to move toward the new allocation
+
+	S32 i;
+	F32 demand[TC_EOF];
+	F32 alloc[TC_EOF];
+	for (i = 0; i < TC_EOF; i++)
+	{
+		demand[i] = mAchievedBPS[i] + mQueueDepth[i] / BACKLOG_DRAIN_TIME;
+	}
+
+	allocateByDemand(mNominalBPS, demand, mPriorityWeight, mLinkScale, alloc);
+
+	for (i = 0; i < TC_EOF; i++)
+	{
+		mCurrentBPS[i] += (alloc[i] - mCurrentBPS[i]) * SMOOTHING;
+	}
+}
+
+// static
+F32 LLThrottleGroup::getDefaultPriorityWeight(S32 throttle_cat)
+{
+	return gThrottleDefaultPriority[throttle_cat];
+}
+
+// Hand the (link scaled) nominal budget out by demand.  Every channel
+// keeps its floor, then channels get what they ask for, first up to
+// their nominal share and then from the spare pool by priority.
+// Whatever nobody asked for goes back in nominal proportions so idle
+// channels still have room to burst.
+// static
+void LLThrottleGroup::allocateByDemand(const F32 nominal[TC_EOF], const F32 demand_in[TC_EOF],
+									   const F32 priority[TC_EOF], F32 link_scale, F32 alloc[TC_EOF])
+{
+	const F32 MAX_NOMINAL_MULTIPLE = 4.f;	// same ceiling as the heuristic adjuster
+
+	S32 i;
+	F32 budget = 0.f;
+	F32 demand[TC_EOF];
+	F32 cap[TC_EOF];
+
+	for (i = 0; i < TC_EOF; i++)
+	{
+		budget += nominal[i];
+	}
+	budget *= link_scale;
+
+	F32 remaining = budget;
+	for (i = 0; i < TC_EOF; i++)
+	{
+		cap[i] = llmax(MAX_NOMINAL_MULTIPLE * nominal[i], gThrottleMinimumBPS[i]);
+		alloc[i] = llmin(gThrottleMinimumBPS[i], nominal[i]);
+		remaining -= alloc[i];
+
+		demand[i] = llmin(demand_in[i], cap[i]);
+	}
+	remaining = llmax(remaining, 0.f);
+
+	// First pass: meet demand up to each channel's own (scaled) share.
+	F32 want[TC_EOF];
+	F32 want_sum = 0.f;
+	for (i = 0; i < TC_EOF; i++)
+	{
+		want[i] = llmax(llmin(demand[i], nominal[i] * link_scale) - alloc[i], 0.f);
+		want_sum += want[i];
+	}
+	if (want_sum > 0.f)
+	{
+		F32 frac = llmin(remaining / want_sum, 1.f);
+		for (i = 0; i < TC_EOF; i++)
+		{
+			alloc[i] += want[i] * frac;
+		}
+		remaining -= want_sum * frac;
+	}
+
+	// Second pass: water-fill unmet demand weighted by priority.  A
+	// channel that gets all it wants drops out, so a few rounds suffice.
+	for (S32 round = 0; round < TC_EOF && remaining > 1.f; round++)
+	{
+		F32 weight_sum = 0.f;
+		for (i = 0; i < TC_EOF; i++)
+		{
+			if (demand[i] > alloc[i])
+			{
+				weight_sum += priority[i] * (demand[i] - alloc[i]);
+			}
+		}
+		if (weight_sum <= 0.f)
+		{
+			break;
+		}
+
+		F32 pool = remaining;
+		for (i = 0; i < TC_EOF; i++)
+		{
+			if (demand[i] > alloc[i])
+			{
+				F32 unmet = demand[i] - alloc[i];
+				F32 grant = llmin(pool * priority[i] * unmet / weight_sum, unmet);
+				alloc[i] += grant;
+				remaining -= grant;
+			}
+		}
+	}
+
+	// Anything left over goes back in nominal proportions.
+	if (remaining > 0.f)
+	{
+		F32 nominal_sum = 0.f;
+		for (i = 0; i < TC_EOF; i++)
+		{
+			if (alloc[i] < cap[i])
+			{
+				nominal_sum += nominal[i];
+			}
+		}
+		for (i = 0; i < TC_EOF && nominal_sum > 0.f; i++)
+		{
+			if (alloc[i] < cap[i])
+			{
+				alloc[i] = llmin(alloc[i] + remaining * (nominal[i] / nominal_sum), cap[i]);
+			}
+		}
+	}
+}
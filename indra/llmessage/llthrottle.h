@@ -86,6 +86,41 @@ public:
 
 	S32		getAvailable(S32 throttle_cat);					// Return bits available in the channel
 
+	// Adaptive redistribution.  When enabled, dynamicAdjust() hands the
+	// budget to categories weighted by priority and reported backlog
+	// instead of the busy/idle heuristic, and scales the total budget
+	// down when the link shows loss or rising latency.  Like the rest of
+	// this class it only paces what this end sends on the circuit; what the
+	// other end sends us is governed by its own throttle (in the viewer,
+	// the AgentThrottle budget LLViewerThrottle sends to the sim, which
+	// uses allocateByDemand() for its split when adaptive).
+	static void	setAdaptive(bool adaptive)				{ sAdaptive = adaptive; }
+	static bool	getAdaptive()							{ return sAdaptive; }
+
+	// Splits the nominal total, scaled by link_scale, across the
+	// categories by demand and priority.  All rates in bits per second.
+	static void	allocateByDemand(const F32 nominal[TC_EOF], const F32 demand[TC_EOF],
+								 const F32 priority[TC_EOF], F32 link_scale, F32 alloc[TC_EOF]);
+	static F32	getDefaultPriorityWeight(S32 throttle_cat);
+
+	void	setPriorityWeight(S32 throttle_cat, F32 weight);
+	F32		getPriorityWeight(S32 throttle_cat) const		{ return mPriorityWeight[throttle_cat]; }
+
+	// Senders report how many bits are waiting behind the throttle.
+	// The largest report in each adjustment period is used as that
+	// category's queue depth.
+	void	noteQueueDepth(S32 throttle_cat, F32 bits);
+
+	// Feed circuit health in before dynamicAdjust().  Counters are
+	// cumulative; deltas are taken internally.
+	void	updateLinkStats(F32 ping_delay_ms, U32 packets_out, U32 packets_resent);
+
+	F32		getQueueDepth(S32 throttle_cat) const			{ return mQueueDepth[throttle_cat]; }	// bits
+	F32		getAchievedBPS(S32 throttle_cat) const			{ return mAchievedBPS[throttle_cat]; }
+	F32		getCurrentBPS(S32 throttle_cat) const			{ return mCurrentBPS[throttle_cat]; }
+	F32		getNominalBPS(S32 throttle_cat) const			{ return mNominalBPS[throttle_cat]; }
+	F32		getLinkScale() const							{ return mLinkScale; }
+
 	void packThrottle(LLDataPacker &dp) const;
 	void unpackThrottle(LLDataPacker &dp);
 public:
@@ -102,6 +137,19 @@ protected:
 	F64		mLastSendTime[TC_EOF];		// Time since last send on this channel
 	F64		mDynamicAdjustTime;	// Only dynamic adjust every 2 seconds or so.
 
+	F32		mPriorityWeight[TC_EOF];	// Relative importance when handing out spare bandwidth
+	F32		mQueueDepthThisPeriod[TC_EOF];	// Largest backlog reported in this period, bits
+	F32		mQueueDepth[TC_EOF];			// Backlog as of the last adjustment, bits
+	F32		mAchievedBPS[TC_EOF];			// Measured send rate, smoothed over adjustment periods
+
+	F32		mLinkScale;			// Fraction of the nominal total we currently allow, from loss and RTT
+	F32		mMinPingDelay;		// Best ping seen, used as the uncongested baseline
+	U32		mLastPacketsOut;
+	U32		mLastPacketsResent;
+
+	static bool sAdaptive;
+
+	void	adaptiveAdjust();
 };
 
 #endif
@@ -772,6 +772,18 @@ void LLTransferSourceChannel::updateTransfers()
 
 	LLThrottleGroup &tg = cdp->getThrottleGroup();
 
+	// Tell the throttle how much is waiting so it can shift bandwidth here.
+	// Sources that don't know their size yet count as one packet.
+	F32 backlog_bits = 0.f;
+	LLPriQueueMap<LLTransferSource *>::pqm_iter src_iter;
+	for (src_iter = mTransferSources.mMap.begin(); src_iter != mTransferSources.mMap.end(); ++src_iter)
+	{
+		LLTransferSource *tsp = src_iter->second;
+		S32 remaining = tsp->mSize - tsp->getNextPacketID() * DEFAULT_PACKET_SIZE;
+		backlog_bits += llmax(remaining, DEFAULT_PACKET_SIZE) * 8.f;
+	}
+	tg.noteQueueDepth(throttle_id, backlog_bits);
+
 	if (tg.checkOverflow(throttle_id, 0.f))
 	{
 		return;
@@ -41,6 +41,13 @@
 //number of bytes sent in each message
 const U32 LL_XFER_CHUNK_SIZE = 1000;
 
+// windowed xfer retransmit timing
+const F32 LL_XFER_INITIAL_RTO = 1.0f;		// seconds, before we have a round trip sample
+const F32 LL_XFER_MIN_RTO = 0.2f;
+const F32 LL_XFER_MAX_RTO = 3.0f;			// same as the stop-and-wait packet timeout
+const F32 LL_XFER_MAX_BACKOFF = 8.f;
+const S32 LL_XFER_WINDOW_RETRY_LIMIT = 10;
+
 const U32 LLXfer::XFER_FILE = 1;
 const U32 LLXfer::XFER_VFILE = 2;
 const U32 LLXfer::XFER_MEM = 3;
@@ -83,6 +90,10 @@ void LLXfer::init (S32 chunk_size)
 
 	mRetries = 0;
 
+	mWindowed = FALSE;
+	mSendWindow.init(1);
+	mReorderBuffer.clear();
+
 	if (chunk_size < 1)
 	{
 		chunk_size = LL_XFER_CHUNK_SIZE;
@@ -287,6 +298,70 @@ void LLXfer::resendLastPacket()
 
 ///////////////////////////////////////////////////////////
 
+void LLXfer::startWindowedSend(S32 max_window)
+{
+	mWindowed = TRUE;
+	mSendWindow.init(max_window);
+	sendWindow();
+}
+
+///////////////////////////////////////////////////////////
+
+void LLXfer::sendWindow()
+{
+	F64 now = LLTimer::getTotalSeconds();
+	while ((mStatus != e_LL_XFER_ABORTED) && mSendWindow.canSendNew())
+	{
+		mPacketNum = mSendWindow.sendNew(now);
+		sendPacket(mPacketNum);
+		if (mStatus == e_LL_XFER_COMPLETE)
+		{
+			mSendWindow.setLastPacket(mPacketNum);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+BOOL LLXfer::confirmWindowed(S32 packet_num)
+{
+	mSendWindow.ack(packet_num, LLTimer::getTotalSeconds());
+	if (mSendWindow.isDone())
+	{
+		return TRUE;
+	}
+	sendWindow();
+	return FALSE;
+}
+
+///////////////////////////////////////////////////////////
+
+BOOL LLXfer::retransmitWindowed()
+{
+	std::vector<S32> packets;
+	if (!mSendWindow.collectExpired(LLTimer::getTotalSeconds(), packets))
+	{
+		return FALSE;
+	}
+
+	// sendPacket() sets the status from the packet it sent, so put it
+	// back once a resend of an earlier packet is out.
+	ELLXferStatus status = mStatus;
+	for (std::vector<S32>::iterator it = packets.begin(); it != packets.end(); ++it)
+	{
+		mRetries++;
+		sendPacket(*it);
+		if (mStatus == e_LL_XFER_ABORTED)
+		{
+			return TRUE;
+		}
+	}
+	mStatus = status;
+	return TRUE;
+}
+
+///////////////////////////////////////////////////////////
+
 S32 LLXfer::processEOF()
 {
 	S32 retval = 0;
@@ -372,10 +447,161 @@ std::ostream& operator<< (std::ostream& os, LLXfer &hh)
 }
 
 
+///////////////////////////////////////////////////////////
+
+LLXferSendWindow::LLXferSendWindow()
+{
+	init(1);
+}
+
+void LLXferSendWindow::init(S32 max_window)
+{
+	mInFlight.clear();
+	mMaxWindow = llclamp(max_window, 1, LL_XFER_MAX_WINDOW);
+	// Start with a couple of packets and let confirmations open it up.
+	mWindow = (F32)llmin(2, mMaxWindow);
+	mSlowStartThreshold = (F32)mMaxWindow;
+	mNextPacket = 0;
+	mLastPacket = -1;
+	mSmoothedRTT = 0.f;
+	mRTTVariance = 0.f;
+	mBackoff = 1.f;
+	mLastBackoffTime = 0.0;
+	mRetransmits = 0;
+}
+
+BOOL LLXferSendWindow::canSendNew() const
+{
+	if ((mLastPacket >= 0) && (mNextPacket > mLastPacket))
+	{
+		return FALSE;
+	}
+	return (S32)mInFlight.size() < llmax(1, (S32)mWindow);
+}
+
+S32 LLXferSendWindow::sendNew(F64 now)
+{
+	LLPacketInfo& info = mInFlight[mNextPacket];
+	info.mSendTime = now;
+	info.mRetries = 0;
+	return mNextPacket++;
+}
+
+BOOL LLXferSendWindow::ack(S32 packet_num, F64 now)
+{
+	packet_map_t::iterator it = mInFlight.find(packet_num);
+	if (it == mInFlight.end())
+	{
+		// duplicate confirmation of a resend
+		return FALSE;
+	}
 
+	// Only time packets that went out once, otherwise we can't tell
+	// which copy is being confirmed.
+	if (!it->second.mRetries)
+	{
+		F32 sample = (F32)(now - it->second.mSendTime);
+		if (mSmoothedRTT <= 0.f)
+		{
+			mSmoothedRTT = sample;
+			mRTTVariance = sample * 0.5f;
+		}
+		else
+		{
+			mRTTVariance = 0.75f * mRTTVariance + 0.25f * fabsf(mSmoothedRTT - sample);
+			mSmoothedRTT = 0.875f * mSmoothedRTT + 0.125f * sample;
+		}
+		mBackoff = 1.f;
+	}
+	mInFlight.erase(it);
 
+	if (mWindow < mSlowStartThreshold)
+	{
+		mWindow += 1.f;
+	}
+	else
+	{
+		mWindow += 1.f / mWindow;
+	}
+	mWindow = llmin(mWindow, (F32)mMaxWindow);
+	return TRUE;
+}
 
+F32 LLXferSendWindow::getRetransmitTimeout() const
+{
+	F32 rto = LL_XFER_INITIAL_RTO;
+	if (mSmoothedRTT > 0.f)
+	{
+		rto = llclamp(mSmoothedRTT + 4.f * mRTTVariance, LL_XFER_MIN_RTO, LL_XFER_MAX_RTO);
+	}
+	return llmin(rto * mBackoff, LL_XFER_MAX_RTO * LL_XFER_MAX_BACKOFF);
+}
 
+BOOL LLXferSendWindow::collectExpired(F64 now, std::vector<S32>& packets)
+{
+	F32 rto = getRetransmitTimeout();
+	for (packet_map_t::iterator it = mInFlight.begin(); it != mInFlight.end(); ++it)
+	{
+		LLPacketInfo& info = it->second;
+		if ((now - info.mSendTime) <= rto)
+		{
+			continue;
+		}
+		if (info.mRetries >= LL_XFER_WINDOW_RETRY_LIMIT)
+		{
+			return FALSE;
+		}
+		info.mRetries++;
+		info.mSendTime = now;
+		packets.push_back(it->first);
+	}
+
+	if (!packets.empty())
+	{
+		mRetransmits += (U32)packets.size();
+
+		// Losses within one timeout of each other are one congestion
+		// event, so don't keep halving for every packet of a burst.
+		if ((now - mLastBackoffTime) > rto)
+		{
+			mSlowStartThreshold = llmax(mWindow * 0.5f, 1.f);
+			mWindow = mSlowStartThreshold;
+			mBackoff = llmin(mBackoff * 2.f, LL_XFER_MAX_BACKOFF);
+			mLastBackoffTime = now;
+		}
+	}
+	return TRUE;
+}
+
+BOOL LLXferSendWindow::isDone() const
+{
+	return (mLastPacket >= 0) && (mNextPacket > mLastPacket) && mInFlight.empty();
+}
+
+///////////////////////////////////////////////////////////
 
+BOOL LLXferReorderBuffer::store(S32 expected, S32 packet_num, BOOL is_eof, const char* datap, S32 data_size)
+{
+	if ((packet_num <= expected) || (packet_num - expected > LL_XFER_MAX_WINDOW))
+	{
+		return FALSE;
+	}
 
+	LLBufferedPacket& packet = mPackets[packet_num];
+	packet.mData.assign(datap, datap + data_size);
+	packet.mEOF = is_eof;
+	return TRUE;
+}
 
+BOOL LLXferReorderBuffer::take(S32 packet_num, std::vector<char>& data, BOOL& is_eof)
+{
+	std::map<S32, LLBufferedPacket>::iterator it = mPackets.find(packet_num);
+	if (it == mPackets.end())
+	{
+		return FALSE;
+	}
+	data.swap(it->second.mData);
+	is_eof = it->second.mEOF;
+	mPackets.erase(it);
+	return TRUE;
+}
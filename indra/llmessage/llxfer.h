@@ -36,7 +36,11 @@
 #include "message.h"
 #include "lltimer.h"
 
+#include <map>
+#include <vector>
+
 const S32 LL_XFER_LARGE_PAYLOAD = 7680;
+const S32 LL_XFER_MAX_WINDOW = 64;	// most packets a windowed xfer keeps in flight
 
 typedef enum ELLXferStatus {
 	e_LL_XFER_UNINITIALIZED,
@@ -48,6 +52,76 @@ typedef enum ELLXferStatus {
 	e_LL_XFER_NONE
 } ELLXferStatus;
 
+// Sender side bookkeeping for a windowed xfer.  Keeps up to a window of
+// packets in flight, retransmits only the ones whose confirmation is
+// overdue, and halves the window when that happens.  The window grows
+// back one packet per confirmation until it reaches the slow start
+// threshold, then one packet per round trip.  Pure logic on packet
+// numbers and times so it can be driven without a circuit.
+class LLXferSendWindow
+{
+public:
+	LLXferSendWindow();
+
+	void	init(S32 max_window);
+
+	BOOL	canSendNew() const;
+	S32		sendNew(F64 now);						// returns the packet number to send next
+	void	setLastPacket(S32 packet_num)			{ mLastPacket = packet_num; }
+	BOOL	ack(S32 packet_num, F64 now);			// TRUE if this confirmed something still in flight
+
+	// Fills packets with the ones whose confirmation is overdue and marks
+	// them resent.  Returns FALSE if one has hit the retry limit.
+	BOOL	collectExpired(F64 now, std::vector<S32>& packets);
+
+	BOOL	isDone() const;
+	S32		getInFlight() const						{ return (S32)mInFlight.size(); }
+	F32		getWindow() const						{ return mWindow; }
+	F32		getRetransmitTimeout() const;
+	U32		getRetransmits() const					{ return mRetransmits; }
+
+private:
+	struct LLPacketInfo
+	{
+		F64 mSendTime;
+		S32 mRetries;
+	};
+	typedef std::map<S32, LLPacketInfo> packet_map_t;
+	packet_map_t mInFlight;
+
+	S32		mMaxWindow;
+	F32		mWindow;
+	F32		mSlowStartThreshold;
+	S32		mNextPacket;
+	S32		mLastPacket;		// -1 until the EOF packet has been sent
+	F32		mSmoothedRTT;		// 0 until the first sample
+	F32		mRTTVariance;
+	F32		mBackoff;			// timeout multiplier, doubles on each loss
+	F64		mLastBackoffTime;
+	U32		mRetransmits;
+};
+
+// Receiver side holding area for packets that arrive ahead of the one
+// we're waiting for.  They have already been confirmed, so they must be
+// kept until the gap fills.
+class LLXferReorderBuffer
+{
+public:
+	BOOL	store(S32 expected, S32 packet_num, BOOL is_eof, const char* datap, S32 data_size);
+	BOOL	take(S32 packet_num, std::vector<char>& data, BOOL& is_eof);
+	BOOL	has(S32 packet_num) const				{ return mPackets.find(packet_num) != mPackets.end(); }
+	S32		size() const							{ return (S32)mPackets.size(); }
+	void	clear()									{ mPackets.clear(); }
+
+private:
+	struct LLBufferedPacket
+	{
+		std::vector<char> mData;
+		BOOL mEOF;
+	};
+	std::map<S32, LLBufferedPacket> mPackets;
+};
+
 class LLXfer
 {
  private:
@@ -78,6 +152,10 @@ class LLXfer
 	LLTimer ACKTimer;
 	S32 mRetries;
 
+	BOOL mWindowed;
+	LLXferSendWindow mSendWindow;
+	LLXferReorderBuffer mReorderBuffer;
+
 	static const U32 XFER_FILE;
 	static const U32 XFER_VFILE;
 	static const U32 XFER_MEM;
@@ -95,6 +173,13 @@ class LLXfer
 	virtual void sendPacket(S32 packet_num);
 	virtual void sendNextPacket();
 	virtual void resendLastPacket();
+
+	// Windowed sending, used instead of sendNextPacket()/resendLastPacket()
+	// when the manager has a window size above one.
+	virtual void startWindowedSend(S32 max_window);
+	virtual void sendWindow();
+	virtual BOOL confirmWindowed(S32 packet_num);	// TRUE once every packet is confirmed
+	virtual BOOL retransmitWindowed();				// FALSE if the retry limit was hit
 	virtual S32 processEOF();
 	virtual S32 startDownload();
 	virtual S32 receiveData (char *datap, S32 data_size);
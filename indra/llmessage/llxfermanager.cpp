@@ -49,6 +49,7 @@ const S32 LL_PACKET_RETRY_LIMIT = 10;            // packet retransmission limit
 
 const S32 LL_DEFAULT_MAX_SIMULTANEOUS_XFERS = 10;
 const S32 LL_DEFAULT_MAX_REQUEST_FIFO_XFERS = 1000;
+const S32 LL_DEFAULT_XFER_WINDOW_SIZE = 1;		// stop-and-wait unless asked otherwise
 
 #define LL_XFER_PROGRESS_MESSAGES 0
 #define LL_XFER_TEST_REXMIT       0
@@ -77,6 +78,7 @@ void LLXferManager::init (LLVFS *vfs)
 
 	setMaxOutgoingXfersPerCircuit(LL_DEFAULT_MAX_SIMULTANEOUS_XFERS);
 	setMaxIncomingXfers(LL_DEFAULT_MAX_REQUEST_FIFO_XFERS);
+	setXferWindowSize(LL_DEFAULT_XFER_WINDOW_SIZE);
 
 	mVFS = vfs;
 
@@ -128,6 +130,13 @@ void LLXferManager::setMaxOutgoingXfersPerCircuit(S32 max_num)
 	mMaxOutgoingXfersPerCircuit = max_num;
 }
 
+///////////////////////////////////////////////////////////
+
+void LLXferManager::setXferWindowSize(S32 window_size)
+{
+	mXferWindowSize = llclamp(window_size, 1, LL_XFER_MAX_WINDOW);
+}
+
 void LLXferManager::setUseAckThrottling(const BOOL use)
 {
 	mUseAckThrottling = use;
@@ -628,14 +637,21 @@ void LLXferManager::processReceiveData (LLMessageSystem *mesgsys, void ** /*user
 		return;
 	}
 
-	S32 xfer_size;
+	S32 packet_num = decodePacketNum(packetnum);
+	BOOL is_eof = isLastPacket(packetnum);
 
-	if (decodePacketNum(packetnum) != xferp->mPacketNum) // is the packet different from what we were expecting?
+	if (packet_num != xferp->mPacketNum) // is the packet different from what we were expecting?
 	{
-		// confirm it if it was a resend of the last one, since the confirmation might have gotten dropped
-		if (decodePacketNum(packetnum) == (xferp->mPacketNum - 1))
+		if (packet_num < xferp->mPacketNum)
 		{
-			llinfos << "Reconfirming xfer " << xferp->mRemoteHost << ":" << xferp->getFileName() << " packet " << packetnum << llendl; 			sendConfirmPacket(mesgsys, id, decodePacketNum(packetnum), mesgsys->getSender());
+			// confirm it if it was a resend, since the confirmation might have gotten dropped
+			llinfos << "Reconfirming xfer " << xferp->mRemoteHost << ":" << xferp->getFileName() << " packet " << packetnum << llendl;
+			sendConfirmPacket(mesgsys, id, packet_num, mesgsys->getSender());
+		}
+		else if (xferp->mReorderBuffer.store(xferp->mPacketNum, packet_num, is_eof, fdata_buf, fdata_size))
+		{
+			// A windowed sender got ahead of us.  Hold on to it until the gap fills.
+			confirmPacket(mesgsys, id, packet_num, mesgsys->getSender());
 		}
 		else
 		{
@@ -644,54 +660,85 @@ void LLXferManager::processReceiveData (LLMessageSystem *mesgsys, void ** /*user
 		return;		
 	}
 
+	S32 result = receivePacket(xferp, fdata_buf, fdata_size);
+	
+	if (result == LL_ERR_CANNOT_OPEN_FILE)
+	{
+			xferp->abort(LL_ERR_CANNOT_OPEN_FILE);
+			removeXfer(xferp,&mReceiveList);
+			startPendingDownloads();
+			return;		
+	}
+
+	confirmPacket(mesgsys, id, packet_num, mesgsys->getSender());
+
+	// Packets that arrived early may be next in line now.
+	std::vector<char> buffered;
+	while (!is_eof && xferp->mReorderBuffer.take(xferp->mPacketNum, buffered, is_eof))
+	{
+		char* datap = buffered.empty() ? fdata_buf : &buffered[0];
+		result = receivePacket(xferp, datap, (S32)buffered.size());
+		if (result == LL_ERR_CANNOT_OPEN_FILE)
+		{
+			xferp->abort(LL_ERR_CANNOT_OPEN_FILE);
+			removeXfer(xferp,&mReceiveList);
+			startPendingDownloads();
+			return;
+		}
+	}
+
+	if (is_eof)
+	{
+		xferp->processEOF();
+		removeXfer(xferp,&mReceiveList);
+		startPendingDownloads();
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+S32 LLXferManager::receivePacket(LLXfer* xferp, char* datap, S32 data_size)
+{
 	S32 result = 0;
 
 	if (xferp->mPacketNum == 0) // first packet has size encoded as additional S32 at beginning of data
 	{
-		ntohmemcpy(&xfer_size,fdata_buf,MVT_S32,sizeof(S32));
+		S32 xfer_size;
+		ntohmemcpy(&xfer_size,datap,MVT_S32,sizeof(S32));
 		
 // do any necessary things on first packet ie. allocate memory
 		xferp->setXferSize(xfer_size);
 
 		// adjust buffer start and size
-		result = xferp->receiveData(&(fdata_buf[sizeof(S32)]),fdata_size-(sizeof(S32)));
+		result = xferp->receiveData(&(datap[sizeof(S32)]),data_size-(sizeof(S32)));
 	}
 	else
 	{
-		result = xferp->receiveData(fdata_buf,fdata_size);
-	}
-	
-	if (result == LL_ERR_CANNOT_OPEN_FILE)
-	{
-			xferp->abort(LL_ERR_CANNOT_OPEN_FILE);
-			removeXfer(xferp,&mReceiveList);
-			startPendingDownloads();
-			return;		
+		result = xferp->receiveData(datap,data_size);
 	}
 
 	xferp->mPacketNum++;  // expect next packet
+	return result;
+}
 
+///////////////////////////////////////////////////////////
+
+void LLXferManager::confirmPacket(LLMessageSystem *mesgsys, U64 id, S32 packetnum, const LLHost &remote_host)
+{
 	if (!mUseAckThrottling)
 	{
 		// No throttling, confirm right away
-		sendConfirmPacket(mesgsys, id, decodePacketNum(packetnum), mesgsys->getSender());
+		sendConfirmPacket(mesgsys, id, packetnum, remote_host);
 	}
 	else
 	{
 		// Throttling, put on queue to be confirmed later.
 		LLXferAckInfo ack_info;
 		ack_info.mID = id;
-		ack_info.mPacketNum = decodePacketNum(packetnum);
-		ack_info.mRemoteHost = mesgsys->getSender();
+		ack_info.mPacketNum = packetnum;
+		ack_info.mRemoteHost = remote_host;
 		mXferAckQueue.push(ack_info);
 	}
-
-	if (isLastPacket(packetnum))
-	{
-		xferp->processEOF();
-		removeXfer(xferp,&mReceiveList);
-		startPendingDownloads();
-	}
 }
 
 ///////////////////////////////////////////////////////////
@@ -954,7 +1001,7 @@ void LLXferManager::processFileRequest (LLMessageSystem *mesgsys, void ** /*user
 	}
 	else if(xferp && (numActiveXfers(xferp->mRemoteHost) < mMaxOutgoingXfersPerCircuit))
 	{
-		xferp->sendNextPacket();
+		startSending(xferp);
 		changeNumActiveXfers(xferp->mRemoteHost,1);
 //		llinfos << "***STARTING XFER IMMEDIATELY***" << llendl;
 	}
@@ -988,7 +1035,14 @@ void LLXferManager::processConfirmation (LLMessageSystem *mesgsys, void ** /*use
 	{
 //		cout << "confirmed packet #" << packetNum << " ping: "<< xferp->ACKTimer.getElapsedTimeF32() <<  endl;
 		xferp->mWaitingForACK = FALSE;
-		if (xferp->mStatus == e_LL_XFER_IN_PROGRESS)
+		if (xferp->mWindowed)
+		{
+			if (xferp->confirmWindowed(packetNum))
+			{
+				removeXfer(xferp, &mSendList);
+			}
+		}
+		else if (xferp->mStatus == e_LL_XFER_IN_PROGRESS)
 		{
 			xferp->sendNextPacket();
 		}
@@ -1031,7 +1085,23 @@ void LLXferManager::retransmitUnackedPackets ()
 	F32 et;
 	while (xferp)
 	{
-		if (xferp->mWaitingForACK && ( (et = xferp->ACKTimer.getElapsedTimeF32()) > LL_PACKET_TIMEOUT))
+		if (xferp->mWindowed && (xferp->mStatus != e_LL_XFER_ABORTED))
+		{
+			// windowed xfers time each packet themselves and only resend the overdue ones
+			if (!xferp->retransmitWindowed())
+			{
+				llinfos << "dropping xfer " << xferp->mRemoteHost << ":" << xferp->getFileName() << " packet retransmit limit exceeded, xfer dropped" << llendl;
+				xferp->abort(LL_ERR_TCP_TIMEOUT);
+				delp = xferp;
+				xferp = xferp->mNext;
+				removeXfer(delp,&mSendList);
+			}
+			else
+			{
+				xferp = xferp->mNext;
+			}
+		}
+		else if (xferp->mWaitingForACK && ( (et = xferp->ACKTimer.getElapsedTimeF32()) > LL_PACKET_TIMEOUT))
 		{
 			if (xferp->mRetries > LL_PACKET_RETRY_LIMIT)
 			{
@@ -1069,7 +1139,7 @@ void LLXferManager::retransmitUnackedPackets ()
 			if (numActiveXfers(xferp->mRemoteHost) < mMaxOutgoingXfersPerCircuit)
 			{
 //			    llinfos << "bumping pending xfer to active" << llendl;
-				xferp->sendNextPacket();
+				startSending(xferp);
 				changeNumActiveXfers(xferp->mRemoteHost,1);
 			}			
 			xferp = xferp->mNext;
@@ -1124,6 +1194,20 @@ void LLXferManager::processAbort (LLMessageSystem *mesgsys, void ** /*user_data*
 
 ///////////////////////////////////////////////////////////
 
+void LLXferManager::startSending(LLXfer* xferp)
+{
+	if (mXferWindowSize > 1)
+	{
+		xferp->startWindowedSend(mXferWindowSize);
+	}
+	else
+	{
+		xferp->sendNextPacket();
+	}
+}
+
+///////////////////////////////////////////////////////////
+
 void LLXferManager::startPendingDownloads()
 {
 	// This method goes through the list, and starts pending
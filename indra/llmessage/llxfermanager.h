@@ -84,6 +84,7 @@ class LLXferManager
  protected:
 	S32    mMaxOutgoingXfersPerCircuit;
 	S32    mMaxIncomingXfers;
+	S32    mXferWindowSize;		// packets in flight per outgoing xfer, 1 is stop-and-wait
 
 	BOOL	mUseAckThrottling; // Use ack throttling to cap file xfer bandwidth
 	LLLinkedQueue<LLXferAckInfo> mXferAckQueue;
@@ -108,6 +109,9 @@ class LLXferManager
  protected:
 	// implementation methods
 	virtual void startPendingDownloads();
+	virtual void startSending(LLXfer* xferp);
+	virtual S32 receivePacket(LLXfer* xferp, char* datap, S32 data_size);
+	virtual void confirmPacket(LLMessageSystem *mesgsys, U64 id, S32 packetnum, const LLHost &remote_host);
 	virtual void addToList(LLXfer* xferp, LLXfer*& head, BOOL is_priority);
 	std::multiset<std::string> mExpectedTransfers; // files that are authorized to transfer out
 	std::multiset<std::string> mExpectedRequests;  // files that are authorized to be downloaded on top of
@@ -132,6 +136,8 @@ class LLXferManager
 
 	virtual void setMaxOutgoingXfersPerCircuit (S32 max_num);
 	virtual void setMaxIncomingXfers(S32 max_num);
+	virtual void setXferWindowSize(S32 window_size);
+	S32 getXferWindowSize() const { return mXferWindowSize; }
 	virtual void updateHostStatus();
 	virtual void printHostStatus();
 
@@ -564,6 +564,10 @@ BOOL LLMessageSystem::checkMessages( S64 frame_count, bool faked_message, U8 fak
 			receive_size = mTrueReceiveSize;
 			mLastSender = mPacketRing.getLastSender();
 			mLastReceivingIF = mPacketRing.getLastReceivingInterface();
+			if (receive_size > 0 && LLMessageLog::isCapturing())
+			{
+				LLMessageLog::capture(mLastSender, buffer, receive_size);
+			}
 		} else {
 			buffer = fake_buffer; //true my ass.
 			mTrueReceiveSize = fake_size;
@@ -655,7 +659,9 @@ BOOL LLMessageSystem::checkMessages( S64 frame_count, bool faked_message, U8 fak
 			if (buffer[0] & LL_RESENT_FLAG)
 			{
 				recv_resent = TRUE;
-				if (cdp && cdp->isDuplicateResend(mCurrentRecvPacketID))
+				// Faked (replayed) packets never went through the circuit's
+				// packet ID tracking, so don't judge them against it.
+				if (cdp && !faked_message && cdp->isDuplicateResend(mCurrentRecvPacketID))
 				{
 					// We need to ACK here to suppress
 					// further resends of packets we've
@@ -740,7 +746,8 @@ BOOL LLMessageSystem::checkMessages( S64 frame_count, bool faked_message, U8 fak
 
 			if( valid_packet )
 			{
-				logValidMsg(cdp, host, recv_reliable, recv_resent, (BOOL)(acks>0) );
+				// Faked packets stay out of the circuit's packet ID tracking.
+				logValidMsg(faked_message ? NULL : cdp, host, recv_reliable, recv_resent, (BOOL)(acks>0) );
 				valid_packet = mTemplateMessageReader->readMessage(buffer, host);
 			}
 
@@ -754,11 +761,12 @@ BOOL LLMessageSystem::checkMessages( S64 frame_count, bool faked_message, U8 fak
 				mBytesIn += mTrueReceiveSize;
 				
 				// ACK here for	valid packets that we've seen
-				// for the first time.
-				if (cdp && recv_reliable)
+				// for the first time.  Faked packets were never sent by
+				// the other end, so they are neither acked nor remembered.
+				if (cdp && recv_reliable && !faked_message)
 				{
 					// Add to the recently received list for duplicate suppression
-					cdp->mRecentlyReceivedReliablePackets[mCurrentRecvPacketID] = getMessageTimeUsecs();
+					cdp->mRecentlyReceivedReliablePackets.insert(mCurrentRecvPacketID, 1);
 
 					// Put it onto the list of packets to be acked
 					cdp->collectRAck(mCurrentRecvPacketID);
@@ -2718,6 +2726,7 @@ void end_messaging_system(bool print_summary)
 	if (gMessageSystem)
 	{
 		gMessageSystem->stopLogging();
+		LLMessageLog::stopCapture();
 
 		if (print_summary)
 		{
@@ -4001,6 +4010,18 @@ S32	LLMessageSystem::getNumberOfBlocks(const char *blockname) const
 {
 	return getNumberOfBlocksFast(LLMessageStringTable::getInstance()->getString(blockname));
 }
+
+LLMessageField LLMessageSystem::getTemplateField(const char *message, const char *blockname,
+												 const char *varname) const
+{
+	message_template_name_map_t::const_iterator iter = mMessageTemplates.find(message);
+	if (iter == mMessageTemplates.end())
+	{
+		LL_WARNS("Messaging") << "No template for message " << message << llendl;
+		return LLMessageField();
+	}
+	return LLMessageField(iter->second, blockname, varname);
+}
 	
 S32	LLMessageSystem::getSizeFast(const char *blockname, const char *varname) const
 {
@@ -64,6 +64,7 @@
 #include "llstl.h"
 #include "llmsgvariabletype.h"
 #include "llmessagesenderinterface.h"
+#include "lltemplatemessagereader.h"
 
 #include "llstoredmessage.h"
 #include "llsocks5.h"
@@ -652,6 +653,15 @@ public:
 						const char *varname) const; // size in bytes of data
 	S32		getSize(const char *blockname, S32 blocknum, const char *varname) const;
 
+	// Compiled field access for UDP template messages, see LLMessageField.
+	// getTemplateReader() is NULL while an LLSD message is being handled.
+	LLMessageField getTemplateField(const char *message, const char *blockname,
+									const char *varname) const;
+	LLTemplateMessageReader* getTemplateReader() const
+	{
+		return mMessageReader == mTemplateMessageReader ? mTemplateMessageReader : NULL;
+	}
+
 	void	resetReceiveCounts();				// resets receive counts for all message types to 0
 	void	dumpReceiveCounts();				// dumps receive count for each message type to llinfos
 	void	dumpCircuitInfo();					// Circuit information to llinfos
@@ -94,4 +94,7 @@ void init_patch_decompressor(S32 size);
 void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph);
 void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph);
 
+// Use the SSE inverse DCT (default). The scalar version is kept for reference.
+extern BOOL gPatchIDCTVectorized;
+
 #endif
@@ -37,6 +37,8 @@
 #include "v3math.h"
 #include "patch_dct.h"
 
+#include <xmmintrin.h>
+
 LLGroupHeader	*gGOPP;
 
 void set_group_of_patch_header(LLGroupHeader *gopp)
@@ -61,6 +63,12 @@ S32	gCurrentDeSize = 0;
 
 F32	gPatchICosines[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
 
+// Same as gPatchICosines, but with the DC row replaced by its OO_SQRT2
+// weight so the SSE kernels need no special case for u == 0.
+F32	gPatchIDCTCoefficients[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+
+BOOL gPatchIDCTVectorized = TRUE;
+
 void setup_patch_icosines(S32 size)
 {
 	S32 n, u;
@@ -71,6 +79,7 @@ void setup_patch_icosines(S32 size)
 		for (n = 0; n < size; n++)
 		{
 			gPatchICosines[u*size+n] = cosf((2.f*n+1.f)*u*oosob);
+			gPatchIDCTCoefficients[u*size+n] = u ? gPatchICosines[u*size+n] : OO_SQRT2;
 		}
 	}
 }
@@ -592,6 +601,70 @@ inline void idct_patch_large(F32 *block)
 	idct_line_large_slow(temp, block, 31);	
 }
 
+// SSE version of idct_patch()/idct_patch_large() for either patch size.
+// Each output lane accumulates its terms in the same order as the scalar
+// code above (DC term first, then u = 1..size-1, multiply then add). That
+// keeps the two paths close, but not bit-identical: release builds use
+// -ffast-math, which lets the compiler reorder or contract the scalar sums,
+// and the DC row is pre-weighted here. Expect differences in the last few
+// bits of the mantissa, i.e. far below the height quantization.
+static void idct_patch_simd(F32 *block, S32 size)
+{
+	F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+	__m128 total[LARGE_PATCH_SIZE/4];
+	const F32 *coef = gPatchIDCTCoefficients;
+	const S32 quads = size/4;
+	S32 n, u, i, q;
+
+	// columns: temp[n][c] = sum_u coef[u][n] * block[u][c], a whole row of c at a time
+	for (n = 0; n < size; n++)
+	{
+		__m128 weight = _mm_set1_ps(coef[n]);
+		for (q = 0; q < quads; q++)
+		{
+			total[q] = _mm_mul_ps(weight, _mm_loadu_ps(block + q*4));
+		}
+		for (u = 1; u < size; u++)
+		{
+			const F32 *in = block + u*size;
+			weight = _mm_set1_ps(coef[u*size + n]);
+			for (q = 0; q < quads; q++)
+			{
+				total[q] = _mm_add_ps(total[q], _mm_mul_ps(_mm_loadu_ps(in + q*4), weight));
+			}
+		}
+		for (q = 0; q < quads; q++)
+		{
+			_mm_storeu_ps(temp + n*size + q*4, total[q]);
+		}
+	}
+
+	// lines: block[l][n] = oosob * sum_u temp[l][u] * coef[u][n], a whole line of n at a time
+	__m128 oosob = _mm_set1_ps(2.f/size);
+	for (i = 0; i < size; i++)
+	{
+		const F32 *in = temp + i*size;
+		__m128 value = _mm_set1_ps(in[0]);
+		for (q = 0; q < quads; q++)
+		{
+			total[q] = _mm_mul_ps(value, _mm_loadu_ps(coef + q*4));
+		}
+		for (u = 1; u < size; u++)
+		{
+			const F32 *tcoef = coef + u*size;
+			value = _mm_set1_ps(in[u]);
+			for (q = 0; q < quads; q++)
+			{
+				total[q] = _mm_add_ps(total[q], _mm_mul_ps(value, _mm_loadu_ps(tcoef + q*4)));
+			}
+		}
+		for (q = 0; q < quads; q++)
+		{
+			_mm_storeu_ps(block + i*size + q*4, _mm_mul_ps(total[q], oosob));
+		}
+	}
+}
+
 S32	gDitherNoise = 128;
 
 void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph)
@@ -621,7 +694,11 @@ void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph)
 		*(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
 	}
 
-	if (size == 16)
+	if (gPatchIDCTVectorized)
+	{
+		idct_patch_simd(block, size);
+	}
+	else if (size == 16)
 	{
 		idct_patch(block);
 	}
@@ -672,7 +749,9 @@ void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph)
 		*(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
 	}
 
-	if (size == 16)
+	if (gPatchIDCTVectorized)
+		idct_patch_simd(block, size);
+	else if (size == 16)
 		idct_patch(block);
 	else
 		idct_patch_large(block);
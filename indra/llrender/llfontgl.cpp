@@ -41,6 +41,7 @@
 #include "llgl.h"
 #include "llrender.h"
 #include "v4color.h"
+#include "v4coloru.h"
 #include "llstl.h"
 #include "llfasttimer.h"
 
@@ -69,6 +70,17 @@ const F32 PIXEL_CORRECTION_DISTANCE = 0.01f;
 const F32 PAD_UVY = 0.5f; // half of vertical padding between glyphs in the glyph texture
 const F32 DROP_SHADOW_SOFT_STRENGTH = 0.3f;
 
+// Longest string whose layout is kept between calls.
+const S32 MAX_GLYPH_RUN_LENGTH = 256;
+
+// A soft drop shadow draws six quads per glyph.
+const S32 MAX_QUADS_PER_GLYPH = 6;
+const S32 GLYPH_BATCH_SIZE = 30 * MAX_QUADS_PER_GLYPH;
+
+S32 LLFontGL::sMaxGlyphRuns = 256;
+U32 LLFontGL::sGlyphRunHits = 0;
+U32 LLFontGL::sGlyphRunMisses = 0;
+
 F32 llfont_round_x(F32 x)
 {
 	//return llfloor((x-LLFontGL::sCurOrigin.mX)/LLFontGL::sScaleX+0.5f)*LLFontGL::sScaleX+LLFontGL::sCurOrigin.mX;
@@ -83,6 +95,28 @@ F32 llfont_round_y(F32 y)
 	return y;
 }
 
+// Same conversion gGL.color4fv() does.
+static LLColor4U glyph_color(const LLColor4& color)
+{
+	return LLColor4U((U8)(llclamp(color.mV[VRED], 0.f, 1.f) * 255),
+					 (U8)(llclamp(color.mV[VGREEN], 0.f, 1.f) * 255),
+					 (U8)(llclamp(color.mV[VBLUE], 0.f, 1.f) * 255),
+					 (U8)(llclamp(color.mV[VALPHA], 0.f, 1.f) * 255));
+}
+
+static void flush_glyph_batch(S32& quad_count, LLVector3* vertices, LLVector2* uvs, LLColor4U* colors)
+{
+	if (quad_count > 0)
+	{
+		gGL.begin(LLRender::QUADS);
+		{
+			gGL.vertexBatchPreTransformed(vertices, uvs, colors, quad_count * 4);
+		}
+		gGL.end();
+		quad_count = 0;
+	}
+}
+
 LLFontGL::LLFontGL()
 	: LLFont()
 {
@@ -99,6 +133,7 @@ void LLFontGL::reset()
 	if (!mIsFallback)
 	{
 		// This is the head of the list - need to rebuild ourself and all fallbacks.
+		clearGlyphRuns();
 		loadFace(mName,mPointSize,sVertDPI,sHorizDPI,mFontBitmapCachep->getNumComponents(),mIsFallback);
 		if (mFallbackFontp==NULL)
 		{
@@ -310,141 +345,213 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 	// Remember last-used texture to avoid unnecesssary bind calls.
 	LLImageGL *last_bound_texture = NULL;
 
-	for (i = begin_offset; i < begin_offset + length; i++)
-	{
-		llwchar wch = wstr[i];
+	LLVector3 vertices[GLYPH_BATCH_SIZE * 4];
+	LLVector2 uvs[GLYPH_BATCH_SIZE * 4];
+	LLColor4U colors[GLYPH_BATCH_SIZE * 4];
+	S32 quad_count = 0;
 
-		// Handle embedded characters first, if they're enabled.
-		// Embedded characters are a hack for notecards
-		const embedded_data_t* ext_data = use_embedded ? getEmbeddedCharData(wch) : NULL;
-		if (ext_data)
+	if (!use_embedded || mEmbeddedChars.empty())
+	{
+		// Lay out from the whole pixel the pen starts in; glyph positions
+		// are snapped relative to it, so a run starting on a pixel
+		// boundary can be reused wherever it is drawn.
+		F32 base_x = (F32)llfloor(cur_x);
+		glyph_run_t scratch;
+		const glyph_run_t* run = getGlyphRun(wstr, begin_offset, length, cur_x - base_x, scratch);
+		F32 base_y = cur_y;
+
+		S32 glyph_count = run->mGlyphs.size();
+		for (i = 0; i < glyph_count; i++)
 		{
-			LLImageGL* ext_image = ext_data->mImage;
-			const LLWString& label = ext_data->mLabel;
+			const run_glyph_t& glyph = run->mGlyphs[i];
+			cur_x = base_x + glyph.mPenX;
+			cur_y = base_y + glyph.mPenY;
 
-			F32 ext_height = (F32)ext_image->getHeight() * sScaleY;
-
-			F32 ext_width = (F32)ext_image->getWidth() * sScaleX;
-			F32 ext_advance = (EXT_X_BEARING * sScaleX) + ext_width;
-
-			if (!label.empty())
+			// Per-glyph bitmap texture.
+			LLImageGL *image_gl = mFontBitmapCachep->getImageGL(glyph.mBitmapNum);
+			if (last_bound_texture != image_gl)
 			{
-				ext_advance += (EXT_X_BEARING + getFontExtChar()->getWidthF32( label.c_str() )) * sScaleX;
+				flush_glyph_batch(quad_count, vertices, uvs, colors);
+				gGL.getTexUnit(0)->bind(image_gl);
+				last_bound_texture = image_gl;
 			}
 
-			if (start_x + scaled_max_pixels < cur_x + ext_advance)
+			if ((start_x + scaled_max_pixels) < (cur_x + glyph.mXBearing + glyph.mWidth))
 			{
 				// Not enough room for this character.
 				break;
 			}
 
-			if (last_bound_texture != ext_image)
-			{
-				gGL.getTexUnit(0)->bind(ext_image);
-				last_bound_texture = ext_image;
-			}
-
-			// snap origin to whole screen pixel
-			const F32 ext_x = (F32)llround(cur_render_x + (EXT_X_BEARING * sScaleX));
-			const F32 ext_y = (F32)llround(cur_render_y + (EXT_Y_BEARING * sScaleY + mAscender - mLineHeight));
-
-			LLRectf uv_rect(0.f, 1.f, 1.f, 0.f);
-			LLRectf screen_rect(ext_x, ext_y + ext_height, ext_x + ext_width, ext_y);
-			drawGlyph(screen_rect, uv_rect, LLColor4::white, style, shadow, drop_shadow_strength);
+			// snap glyph origin to whole screen pixel
+			LLRectf screen_rect(llround(cur_x + (F32)glyph.mXBearing),
+					    llround(cur_y + (F32)glyph.mYBearing),
+					    llround(cur_x + (F32)glyph.mXBearing) + (F32)glyph.mWidth,
+					    llround(cur_y + (F32)glyph.mYBearing) - (F32)glyph.mHeight);
 
-			if (!label.empty())
+			if (quad_count + MAX_QUADS_PER_GLYPH > GLYPH_BATCH_SIZE)
 			{
-				gGL.pushMatrix();
-				//gGL.loadIdentity();
-				//gGL.translatef(sCurOrigin.mX, sCurOrigin.mY, 0.0f);
-				//gGL.scalef(sScaleX, sScaleY, 1.f);
-				getFontExtChar()->render(label, 0,
-									 /*llfloor*/((ext_x + (F32)ext_image->getWidth() + EXT_X_BEARING) / sScaleX), 
-									 /*llfloor*/(cur_y / sScaleY),
-									 color,
-									 halign, BASELINE, NORMAL, NO_SHADOW, S32_MAX, S32_MAX, NULL,
-									 TRUE );
-				gGL.popMatrix();
+				flush_glyph_batch(quad_count, vertices, uvs, colors);
 			}
-
-			gGL.color4fv(color.mV);
+			drawGlyph(quad_count, vertices, uvs, colors, screen_rect, glyph.mUVRect, color, style, shadow, drop_shadow_strength);
 
 			chars_drawn++;
-			cur_x += ext_advance;
-			if (((i + 1) < length) && wstr[i+1])
-			{
-				cur_x += EXT_KERNING * sScaleX;
-			}
-			cur_render_x = cur_x;
 		}
-		else
+		if (i == glyph_count)
 		{
-			if (!hasGlyph(wch))
-			{
-				addChar(wch);
-			}
+			cur_x = base_x + run->mEndX;
+			cur_y = base_y + run->mEndY;
+		}
+	}
+	else
+	{
+		for (i = begin_offset; i < begin_offset + length; i++)
+		{
+			llwchar wch = wstr[i];
 
-			const LLFontGlyphInfo* fgi= getGlyphInfo(wch);
-			if (!fgi)
+			// Handle embedded characters first, if they're enabled.
+			// Embedded characters are a hack for notecards
+			const embedded_data_t* ext_data = getEmbeddedCharData(wch);
+			if (ext_data)
 			{
-				llerrs << "Missing Glyph Info" << llendl;
-				break;
+				LLImageGL* ext_image = ext_data->mImage;
+				const LLWString& label = ext_data->mLabel;
+
+				F32 ext_height = (F32)ext_image->getHeight() * sScaleY;
+
+				F32 ext_width = (F32)ext_image->getWidth() * sScaleX;
+				F32 ext_advance = (EXT_X_BEARING * sScaleX) + ext_width;
+
+				if (!label.empty())
+				{
+					ext_advance += (EXT_X_BEARING + getFontExtChar()->getWidthF32( label.c_str() )) * sScaleX;
+				}
+
+				if (start_x + scaled_max_pixels < cur_x + ext_advance)
+				{
+					// Not enough room for this character.
+					break;
+				}
+
+				flush_glyph_batch(quad_count, vertices, uvs, colors);
+				if (last_bound_texture != ext_image)
+				{
+					gGL.getTexUnit(0)->bind(ext_image);
+					last_bound_texture = ext_image;
+				}
+
+				// snap origin to whole screen pixel
+				const F32 ext_x = (F32)llround(cur_render_x + (EXT_X_BEARING * sScaleX));
+				const F32 ext_y = (F32)llround(cur_render_y + (EXT_Y_BEARING * sScaleY + mAscender - mLineHeight));
+
+				LLRectf uv_rect(0.f, 1.f, 1.f, 0.f);
+				LLRectf screen_rect(ext_x, ext_y + ext_height, ext_x + ext_width, ext_y);
+				drawGlyph(quad_count, vertices, uvs, colors, screen_rect, uv_rect, LLColor4::white, style, shadow, drop_shadow_strength);
+				flush_glyph_batch(quad_count, vertices, uvs, colors);
+
+				if (!label.empty())
+				{
+					gGL.pushMatrix();
+					//gGL.loadIdentity();
+					//gGL.translatef(sCurOrigin.mX, sCurOrigin.mY, 0.0f);
+					//gGL.scalef(sScaleX, sScaleY, 1.f);
+					getFontExtChar()->render(label, 0,
+										 /*llfloor*/((ext_x + (F32)ext_image->getWidth() + EXT_X_BEARING) / sScaleX), 
+										 /*llfloor*/(cur_y / sScaleY),
+										 color,
+										 halign, BASELINE, NORMAL, NO_SHADOW, S32_MAX, S32_MAX, NULL,
+										 TRUE );
+					gGL.popMatrix();
+					// The label may have bound the extended character font.
+					last_bound_texture = NULL;
+				}
+
+				gGL.color4fv(color.mV);
+
+				chars_drawn++;
+				cur_x += ext_advance;
+				if (((i + 1) < length) && wstr[i+1])
+				{
+					cur_x += EXT_KERNING * sScaleX;
+				}
+				cur_render_x = cur_x;
 			}
-			// Per-glyph bitmap texture.
-			LLImageGL *image_gl = mFontBitmapCachep->getImageGL(fgi->mBitmapNum);
-			if (last_bound_texture != image_gl)
+			else
 			{
-				gGL.getTexUnit(0)->bind(image_gl);
-				last_bound_texture = image_gl;
-			}
+				if (!hasGlyph(wch))
+				{
+					addChar(wch);
+				}
 
-			if ((start_x + scaled_max_pixels) < (cur_x + fgi->mXBearing + fgi->mWidth))
-			{
-				// Not enough room for this character.
-				break;
-			}
+				const LLFontGlyphInfo* fgi= getGlyphInfo(wch);
+				if (!fgi)
+				{
+					llerrs << "Missing Glyph Info" << llendl;
+					break;
+				}
+				// Per-glyph bitmap texture.
+				LLImageGL *image_gl = mFontBitmapCachep->getImageGL(fgi->mBitmapNum);
+				if (last_bound_texture != image_gl)
+				{
+					flush_glyph_batch(quad_count, vertices, uvs, colors);
+					gGL.getTexUnit(0)->bind(image_gl);
+					last_bound_texture = image_gl;
+				}
 
-			// Draw the text at the appropriate location
-			//Specify vertices and texture coordinates
-			LLRectf uv_rect((fgi->mXBitmapOffset) * inv_width,
-					(fgi->mYBitmapOffset + fgi->mHeight + PAD_UVY) * inv_height,
-					(fgi->mXBitmapOffset + fgi->mWidth) * inv_width,
-					(fgi->mYBitmapOffset - PAD_UVY) * inv_height);
-			// snap glyph origin to whole screen pixel
-			LLRectf screen_rect(llround(cur_render_x + (F32)fgi->mXBearing),
-					    llround(cur_render_y + (F32)fgi->mYBearing),
-					    llround(cur_render_x + (F32)fgi->mXBearing) + (F32)fgi->mWidth,
-					    llround(cur_render_y + (F32)fgi->mYBearing) - (F32)fgi->mHeight);
+				if ((start_x + scaled_max_pixels) < (cur_x + fgi->mXBearing + fgi->mWidth))
+				{
+					// Not enough room for this character.
+					break;
+				}
+
+				// Draw the text at the appropriate location
+				//Specify vertices and texture coordinates
+				LLRectf uv_rect((fgi->mXBitmapOffset) * inv_width,
+						(fgi->mYBitmapOffset + fgi->mHeight + PAD_UVY) * inv_height,
+						(fgi->mXBitmapOffset + fgi->mWidth) * inv_width,
+						(fgi->mYBitmapOffset - PAD_UVY) * inv_height);
+				// snap glyph origin to whole screen pixel
+				LLRectf screen_rect(llround(cur_render_x + (F32)fgi->mXBearing),
+						    llround(cur_render_y + (F32)fgi->mYBearing),
+						    llround(cur_render_x + (F32)fgi->mXBearing) + (F32)fgi->mWidth,
+						    llround(cur_render_y + (F32)fgi->mYBearing) - (F32)fgi->mHeight);
 			
-			drawGlyph(screen_rect, uv_rect, color, style, shadow, drop_shadow_strength);
+				if (quad_count + MAX_QUADS_PER_GLYPH > GLYPH_BATCH_SIZE)
+				{
+					flush_glyph_batch(quad_count, vertices, uvs, colors);
+				}
+				drawGlyph(quad_count, vertices, uvs, colors, screen_rect, uv_rect, color, style, shadow, drop_shadow_strength);
 
-			chars_drawn++;
-			cur_x += fgi->mXAdvance;
-			cur_y += fgi->mYAdvance;
+				chars_drawn++;
+				cur_x += fgi->mXAdvance;
+				cur_y += fgi->mYAdvance;
 
-			llwchar next_char = wstr[i+1];
-			if (next_char && (next_char < LAST_CHARACTER))
-			{
-				// Kern this puppy.
-				if (!hasGlyph(next_char))
+				llwchar next_char = wstr[i+1];
+				if (next_char && (next_char < LAST_CHARACTER))
 				{
-					addChar(next_char);
+					// Kern this puppy.
+					if (!hasGlyph(next_char))
+					{
+						addChar(next_char);
+					}
+					cur_x += getXKerning(wch, next_char);
 				}
-				cur_x += getXKerning(wch, next_char);
-			}
 
-			// Round after kerning.
-			// Must do this to cur_x, not just to cur_render_x, otherwise you
-			// will squish sub-pixel kerned characters too close together.
-			// For example, "CCCCC" looks bad.
-			cur_x = (F32)llfloor(cur_x + 0.5f);
-			//cur_y = (F32)llfloor(cur_y + 0.5f);
+				// Round after kerning.
+				// Must do this to cur_x, not just to cur_render_x, otherwise you
+				// will squish sub-pixel kerned characters too close together.
+				// For example, "CCCCC" looks bad.
+				cur_x = (F32)llfloor(cur_x + 0.5f);
+				//cur_y = (F32)llfloor(cur_y + 0.5f);
 
-			cur_render_x = cur_x;
-			cur_render_y = cur_y;
+				cur_render_x = cur_x;
+				cur_render_y = cur_y;
+			}
 		}
+
 	}
 
+	flush_glyph_batch(quad_count, vertices, uvs, colors);
+
 	if (right_x)
 	{
 		*right_x = cur_x / sScaleX;
@@ -550,6 +657,22 @@ F32 LLFontGL::getWidthF32(const llwchar* wchars, const S32 begin_offset, const S
 {
 	const S32 LAST_CHARACTER = LLFont::LAST_CHAR_FULL;
 
+	if (sMaxGlyphRuns > 0 && begin_offset == 0 && (!use_embedded || mEmbeddedChars.empty()))
+	{
+		// Measuring a whole short string: the cached layout has the answer.
+		S32 length = 0;
+		while (length <= MAX_GLYPH_RUN_LENGTH && length < max_chars && wchars[length])
+		{
+			length++;
+		}
+		if (length <= MAX_GLYPH_RUN_LENGTH && !wchars[length])
+		{
+			glyph_run_t scratch;
+			const glyph_run_t* run = getGlyphRun(LLWString(wchars, length), 0, length, 0.f, scratch);
+			return run->mEndX / sScaleX;
+		}
+	}
+
 	F32 cur_x = 0;
 	const S32 max_index = begin_offset + max_chars;
 	for (S32 i = begin_offset; i < max_index; i++)
@@ -909,6 +1032,121 @@ void LLFontGL::clearEmbeddedChars()
 	mEmbeddedChars.clear();
 }
 
+// Returns the layout of wstr from begin_offset for length characters, with
+// the pen starting origin_x into a pixel.  Whole short strings starting on
+// a pixel boundary come from (and go into) the run cache; anything else is
+// laid out into scratch.
+const LLFontGL::glyph_run_t* LLFontGL::getGlyphRun(const LLWString& wstr, S32 begin_offset, S32 length, F32 origin_x, glyph_run_t& scratch) const
+{
+	if (sMaxGlyphRuns <= 0
+		|| begin_offset != 0
+		|| length != (S32)wstr.length()
+		|| length > MAX_GLYPH_RUN_LENGTH
+		|| origin_x != 0.f)
+	{
+		layoutGlyphRun(wstr.c_str() + begin_offset, length, origin_x, scratch);
+		return &scratch;
+	}
+
+	glyph_run_map_t::iterator iter = mGlyphRunMap.find(wstr);
+	if (iter != mGlyphRunMap.end())
+	{
+		sGlyphRunHits++;
+		mGlyphRuns.splice(mGlyphRuns.begin(), mGlyphRuns, iter->second);
+		return &mGlyphRuns.front().second;
+	}
+
+	sGlyphRunMisses++;
+	mGlyphRuns.push_front(std::make_pair(wstr, glyph_run_t()));
+	mGlyphRunMap[wstr] = mGlyphRuns.begin();
+	layoutGlyphRun(wstr.c_str(), length, 0.f, mGlyphRuns.front().second);
+
+	while ((S32)mGlyphRunMap.size() > sMaxGlyphRuns)
+	{
+		mGlyphRunMap.erase(mGlyphRuns.back().first);
+		mGlyphRuns.pop_back();
+	}
+	return &mGlyphRuns.front().second;
+}
+
+// Same placement rules as the glyph loop in render(): kern against the
+// following character, even past length, and round the pen after kerning.
+void LLFontGL::layoutGlyphRun(const llwchar* wchars, S32 length, F32 origin_x, glyph_run_t& run) const
+{
+	const S32 LAST_CHARACTER = LLFont::LAST_CHAR_FULL;
+
+	F32 inv_width = 1.f / mFontBitmapCachep->getBitmapWidth();
+	F32 inv_height = 1.f / mFontBitmapCachep->getBitmapHeight();
+
+	run.mGlyphs.clear();
+	run.mGlyphs.reserve(length);
+
+	F32 cur_x = origin_x;
+	F32 cur_y = 0.f;
+	for (S32 i = 0; i < length; i++)
+	{
+		llwchar wch = wchars[i];
+		if (!hasGlyph(wch))
+		{
+			addChar(wch);
+		}
+
+		const LLFontGlyphInfo* fgi = getGlyphInfo(wch);
+		if (!fgi)
+		{
+			llerrs << "Missing Glyph Info" << llendl;
+			break;
+		}
+
+		run_glyph_t glyph;
+		glyph.mPenX = cur_x;
+		glyph.mPenY = cur_y;
+		glyph.mXBearing = fgi->mXBearing;
+		glyph.mYBearing = fgi->mYBearing;
+		glyph.mWidth = fgi->mWidth;
+		glyph.mHeight = fgi->mHeight;
+		glyph.mBitmapNum = fgi->mBitmapNum;
+		glyph.mUVRect = LLRectf((fgi->mXBitmapOffset) * inv_width,
+								(fgi->mYBitmapOffset + fgi->mHeight + PAD_UVY) * inv_height,
+								(fgi->mXBitmapOffset + fgi->mWidth) * inv_width,
+								(fgi->mYBitmapOffset - PAD_UVY) * inv_height);
+		run.mGlyphs.push_back(glyph);
+
+		cur_x += fgi->mXAdvance;
+		cur_y += fgi->mYAdvance;
+
+		llwchar next_char = wchars[i+1];
+		if (next_char && (next_char < LAST_CHARACTER))
+		{
+			// Kern this puppy.
+			if (!hasGlyph(next_char))
+			{
+				addChar(next_char);
+			}
+			cur_x += getXKerning(wch, next_char);
+		}
+
+		// Round after kerning.
+		cur_x = (F32)llfloor(cur_x + 0.5f);
+	}
+
+	run.mEndX = cur_x;
+	run.mEndY = cur_y;
+}
+
+void LLFontGL::clearGlyphRuns() const
+{
+	mGlyphRuns.clear();
+	mGlyphRunMap.clear();
+}
+
+// static
+void LLFontGL::setMaxGlyphRuns(S32 runs)
+{
+	// Caches over the new limit shrink as new strings are laid out.
+	sMaxGlyphRuns = runs;
+}
+
 void LLFontGL::addEmbeddedChar( llwchar wc, LLTexture* image, const std::string& label ) const
 {
 	LLWString wlabel = utf8str_to_wstring(label);
@@ -1226,95 +1464,97 @@ LLFontGL &LLFontGL::operator=(const LLFontGL &source)
 	return *this;
 }
 
-void LLFontGL::renderQuad(const LLRectf& screen_rect, const LLRectf& uv_rect, F32 slant_amt) const
+void LLFontGL::renderQuad(LLVector3* vertex_out, LLVector2* uv_out, LLColor4U* colors_out, const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4U& color, F32 slant_amt) const
 {
-	gGL.texCoord2f(uv_rect.mRight, uv_rect.mTop);
-	gGL.vertex2f(llfont_round_x(screen_rect.mRight), 
-				llfont_round_y(screen_rect.mTop));
-
-	gGL.texCoord2f(uv_rect.mLeft, uv_rect.mTop);
-	gGL.vertex2f(llfont_round_x(screen_rect.mLeft), 
-				llfont_round_y(screen_rect.mTop));
-
-	gGL.texCoord2f(uv_rect.mLeft, uv_rect.mBottom);
-	gGL.vertex2f(llfont_round_x(screen_rect.mLeft + slant_amt), 
-				llfont_round_y(screen_rect.mBottom));
-
-	gGL.texCoord2f(uv_rect.mRight, uv_rect.mBottom);
-	gGL.vertex2f(llfont_round_x(screen_rect.mRight + slant_amt), 
-				llfont_round_y(screen_rect.mBottom));
+	S32 index = 0;
+
+	vertex_out[index] = LLVector3(llfont_round_x(screen_rect.mRight), llfont_round_y(screen_rect.mTop), 0.f);
+	uv_out[index] = LLVector2(uv_rect.mRight, uv_rect.mTop);
+	colors_out[index] = color;
+	index++;
+
+	vertex_out[index] = LLVector3(llfont_round_x(screen_rect.mLeft), llfont_round_y(screen_rect.mTop), 0.f);
+	uv_out[index] = LLVector2(uv_rect.mLeft, uv_rect.mTop);
+	colors_out[index] = color;
+	index++;
+
+	vertex_out[index] = LLVector3(llfont_round_x(screen_rect.mLeft + slant_amt), llfont_round_y(screen_rect.mBottom), 0.f);
+	uv_out[index] = LLVector2(uv_rect.mLeft, uv_rect.mBottom);
+	colors_out[index] = color;
+	index++;
+
+	vertex_out[index] = LLVector3(llfont_round_x(screen_rect.mRight + slant_amt), llfont_round_y(screen_rect.mBottom), 0.f);
+	uv_out[index] = LLVector2(uv_rect.mRight, uv_rect.mBottom);
+	colors_out[index] = color;
 }
 
-void LLFontGL::drawGlyph(const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4& color, U8 style, ShadowType shadow, F32 drop_shadow_strength) const
+void LLFontGL::drawGlyph(S32& quad_count, LLVector3* vertex_out, LLVector2* uv_out, LLColor4U* colors_out, const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4& color, U8 style, ShadowType shadow, F32 drop_shadow_strength) const
 {
 	F32 slant_offset;
 	slant_offset = ((style & ITALIC) ? ( -mAscender * 0.2f) : 0.f);
 
-	gGL.begin(LLRender::QUADS);
+	//FIXME: bold and drop shadow are mutually exclusive only for convenience
+	//Allow both when we need them.
+	if (style & BOLD)
 	{
-		//FIXME: bold and drop shadow are mutually exclusive only for convenience
-		//Allow both when we need them.
-		if (style & BOLD)
+		LLColor4U text_color = glyph_color(color);
+		for (S32 pass = 0; pass < 2; pass++)
 		{
-			gGL.color4fv(color.mV);
-			for (S32 pass = 0; pass < 2; pass++)
-			{
-				LLRectf screen_rect_offset = screen_rect;
+			LLRectf screen_rect_offset = screen_rect;
 
-				screen_rect_offset.translate((F32)(pass * BOLD_OFFSET), 0.f);
-				renderQuad(screen_rect_offset, uv_rect, slant_offset);
-			}
+			screen_rect_offset.translate((F32)(pass * BOLD_OFFSET), 0.f);
+			renderQuad(&vertex_out[quad_count * 4], &uv_out[quad_count * 4], &colors_out[quad_count * 4], screen_rect_offset, uv_rect, text_color, slant_offset);
+			quad_count++;
 		}
-		else if (shadow == DROP_SHADOW_SOFT)
+	}
+	else if (shadow == DROP_SHADOW_SOFT)
+	{
+		LLColor4 shadow_color = LLFontGL::sShadowColor;
+		shadow_color.mV[VALPHA] = color.mV[VALPHA] * drop_shadow_strength * DROP_SHADOW_SOFT_STRENGTH;
+		LLColor4U shadow_color_u = glyph_color(shadow_color);
+		for (S32 pass = 0; pass < 5; pass++)
 		{
-			LLColor4 shadow_color = LLFontGL::sShadowColor;
-			shadow_color.mV[VALPHA] = color.mV[VALPHA] * drop_shadow_strength * DROP_SHADOW_SOFT_STRENGTH;
-			gGL.color4fv(shadow_color.mV);
-			for (S32 pass = 0; pass < 5; pass++)
-			{
-				LLRectf screen_rect_offset = screen_rect;
+			LLRectf screen_rect_offset = screen_rect;
 
-				switch(pass)
-				{
-				case 0:
-					screen_rect_offset.translate(-1.f, -1.f);
-					break;
-				case 1:
-					screen_rect_offset.translate(1.f, -1.f);
-					break;
-				case 2:
-					screen_rect_offset.translate(1.f, 1.f);
-					break;
-				case 3:
-					screen_rect_offset.translate(-1.f, 1.f);
-					break;
-				case 4:
-					screen_rect_offset.translate(0, -2.f);
-					break;
-				}
-			
-				renderQuad(screen_rect_offset, uv_rect, slant_offset);
+			switch(pass)
+			{
+			case 0:
+				screen_rect_offset.translate(-1.f, -1.f);
+				break;
+			case 1:
+				screen_rect_offset.translate(1.f, -1.f);
+				break;
+			case 2:
+				screen_rect_offset.translate(1.f, 1.f);
+				break;
+			case 3:
+				screen_rect_offset.translate(-1.f, 1.f);
+				break;
+			case 4:
+				screen_rect_offset.translate(0, -2.f);
+				break;
 			}
-			gGL.color4fv(color.mV);
-			renderQuad(screen_rect, uv_rect, slant_offset);
-		}
-		else if (shadow == DROP_SHADOW)
-		{
-			LLColor4 shadow_color = LLFontGL::sShadowColor;
-			shadow_color.mV[VALPHA] = color.mV[VALPHA] * drop_shadow_strength;
-			gGL.color4fv(shadow_color.mV);
-			LLRectf screen_rect_shadow = screen_rect;
-			screen_rect_shadow.translate(1.f, -1.f);
-			renderQuad(screen_rect_shadow, uv_rect, slant_offset);
-			gGL.color4fv(color.mV);
-			renderQuad(screen_rect, uv_rect, slant_offset);
+		
+			renderQuad(&vertex_out[quad_count * 4], &uv_out[quad_count * 4], &colors_out[quad_count * 4], screen_rect_offset, uv_rect, shadow_color_u, slant_offset);
+			quad_count++;
 		}
-		else // normal rendering
-		{
-			gGL.color4fv(color.mV);
-			renderQuad(screen_rect, uv_rect, slant_offset);
-		}
-
+		renderQuad(&vertex_out[quad_count * 4], &uv_out[quad_count * 4], &colors_out[quad_count * 4], screen_rect, uv_rect, glyph_color(color), slant_offset);
+		quad_count++;
 	}
-	gGL.end();
-}
\ No newline at end of file
+	else if (shadow == DROP_SHADOW)
+	{
+		LLColor4 shadow_color = LLFontGL::sShadowColor;
+		shadow_color.mV[VALPHA] = color.mV[VALPHA] * drop_shadow_strength;
+		LLRectf screen_rect_shadow = screen_rect;
+		screen_rect_shadow.translate(1.f, -1.f);
+		renderQuad(&vertex_out[quad_count * 4], &uv_out[quad_count * 4], &colors_out[quad_count * 4], screen_rect_shadow, uv_rect, glyph_color(shadow_color), slant_offset);
+		quad_count++;
+		renderQuad(&vertex_out[quad_count * 4], &uv_out[quad_count * 4], &colors_out[quad_count * 4], screen_rect, uv_rect, glyph_color(color), slant_offset);
+		quad_count++;
+	}
+	else // normal rendering
+	{
+		renderQuad(&vertex_out[quad_count * 4], &uv_out[quad_count * 4], &colors_out[quad_count * 4], screen_rect, uv_rect, glyph_color(color), slant_offset);
+		quad_count++;
+	}
+}
@@ -42,7 +42,13 @@
 
 #include "llfontregistry.h"
 
+#include <list>
+#include <boost/unordered_map.hpp>
+
 class LLColor4;
+class LLColor4U;
+class LLVector2;
+class LLVector3;
 
 // Key used to request a font.
 class LLFontDescriptor;
@@ -188,6 +194,13 @@ public:
 
 	static void setFontDisplay(BOOL flag) { sDisplayFont = flag ; }
 
+	// Whole strings of up to 256 characters keep their glyph layout between
+	// calls; each font remembers at most this many of them (0 disables).
+	static void setMaxGlyphRuns(S32 runs);
+	static S32	getMaxGlyphRuns()					{ return sMaxGlyphRuns; }
+	static void getGlyphRunStats(U32& hits, U32& misses)	{ hits = sGlyphRunHits; misses = sGlyphRunMisses; }
+	static void resetGlyphRunStats()				{ sGlyphRunHits = sGlyphRunMisses = 0; }
+
 protected:
 	struct embedded_data_t
 	{
@@ -198,6 +211,29 @@ protected:
 	const embedded_data_t* getEmbeddedCharData(const llwchar wch) const;
 	F32 getEmbeddedCharAdvance(const embedded_data_t* ext_data) const;
 	void clearEmbeddedChars();
+
+	// One laid out glyph.  Pen positions are in scaled pixels relative to
+	// the whole pixel the run starts in.
+	struct run_glyph_t
+	{
+		F32		mPenX;
+		F32		mPenY;
+		S32		mXBearing;
+		S32		mYBearing;
+		S32		mWidth;
+		S32		mHeight;
+		S32		mBitmapNum;
+		LLRectf	mUVRect;
+	};
+	struct glyph_run_t
+	{
+		std::vector<run_glyph_t> mGlyphs;
+		F32		mEndX;		// pen position after the last glyph
+		F32		mEndY;
+	};
+	const glyph_run_t* getGlyphRun(const LLWString& wstr, S32 begin_offset, S32 length, F32 origin_x, glyph_run_t& scratch) const;
+	void layoutGlyphRun(const llwchar* wchars, S32 length, F32 origin_x, glyph_run_t& run) const;
+	void clearGlyphRuns() const;
 public:
 		
 	static LLFontGL* getFontMonospace();
@@ -237,8 +273,19 @@ protected:
 	
 	LLFontDescriptor mFontDesc;
 
-	void renderQuad(const LLRectf& screen_rect, const LLRectf& uv_rect, F32 slant_amt) const;
-	void drawGlyph(const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4& color, U8 style, ShadowType shadow, F32 drop_shadow_fade) const;
+	typedef std::list<std::pair<LLWString, glyph_run_t> > glyph_run_list_t;
+	typedef boost::unordered_map<LLWString, glyph_run_list_t::iterator> glyph_run_map_t;
+	mutable glyph_run_list_t mGlyphRuns;	// most recently used first
+	mutable glyph_run_map_t mGlyphRunMap;
+
+	static S32 sMaxGlyphRuns;
+	static U32 sGlyphRunHits;
+	static U32 sGlyphRunMisses;
+
+	// Quads are written to vertex_out/uv_out/colors_out at quad_count and
+	// sent to gGL a batch at a time.
+	void renderQuad(LLVector3* vertex_out, LLVector2* uv_out, LLColor4U* colors_out, const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4U& color, F32 slant_amt) const;
+	void drawGlyph(S32& quad_count, LLVector3* vertex_out, LLVector2* uv_out, LLColor4U* colors_out, const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4& color, U8 style, ShadowType shadow, F32 drop_shadow_fade) const;
 
 	// Registry holds all instantiated fonts.
 	static LLFontRegistry* sFontRegistry;
@@ -59,7 +59,7 @@ inline BOOL LLKeywordToken::isHead(const llwchar* s) const
 	return res;
 }
 
-LLKeywords::LLKeywords() : mLoaded(FALSE)
+LLKeywords::LLKeywords() : mLoaded(FALSE), mLineStartsValid(FALSE)
 {
 }
 
@@ -199,6 +199,10 @@ void LLKeywords::addToken(LLKeywordToken::TOKEN_TYPE type,
 {
 	LLWString key = utf8str_to_wstring(key_in);
 	LLWString tool_tip = utf8str_to_wstring(tool_tip_in);
+
+	// Existing segments may now be wrong anywhere; make the next update a full one.
+	mLineStartsValid = FALSE;
+
 	switch(type)
 	{
 	case LLKeywordToken::WORD:
@@ -237,6 +241,8 @@ void LLKeywords::findSegments(std::vector<LLTextSegment *>* seg_list, const LLWS
 {
 	std::for_each(seg_list->begin(), seg_list->end(), DeletePointer());
 	seg_list->clear();
+	mLineStarts.clear();
+	mLineStartsValid = TRUE;
 
 	if( wtext.empty() )
 	{
@@ -247,13 +253,26 @@ void LLKeywords::findSegments(std::vector<LLTextSegment *>* seg_list, const LLWS
 
 	seg_list->push_back( new LLTextSegment( LLColor3(defaultColor), 0, text_len ) ); 
 
+	scanSegments(seg_list, wtext, defaultColor, 0, mLineStarts);
+}
+
+// Tokenize from start, which must be the beginning of a line outside any comment
+// or string, appending to seg_list and recording restartable line starts.  With
+// an edit_end, stops at the first such line past it that mLineStarts also had
+// (moved by delta): from there on the old segments still hold.  Returns where
+// tokenizing stopped.
+S32 LLKeywords::scanSegments(std::vector<LLTextSegment *>* seg_list, const LLWString& wtext, const LLColor4 &defaultColor,
+							 S32 start, std::vector<S32>& line_starts, S32 edit_end, S32 delta)
+{
+	S32 text_len = wtext.size();
 	const llwchar* base = wtext.c_str();
-	const llwchar* cur = base;
+	const llwchar* first = base + start;
+	const llwchar* cur = first;
 	const llwchar* line = NULL;
 
 	while( *cur )
 	{
-		if( *cur == '\n' || cur == base )
+		if( *cur == '\n' || cur == first )
 		{
 			if( *cur == '\n' )
 			{
@@ -266,6 +285,13 @@ void LLKeywords::findSegments(std::vector<LLTextSegment *>* seg_list, const LLWS
 
 			// Start of a new line
 			line = cur;
+			S32 line_pos = line - base;
+			if( edit_end >= 0 && line_pos > edit_end
+				&& std::binary_search(mLineStarts.begin(), mLineStarts.end(), line_pos - delta) )
+			{
+				return line_pos;
+			}
+			line_starts.push_back(line_pos);
 
 			// Skip white space
 			while( *cur && isspace(*cur) && (*cur != '\n')  )
@@ -456,6 +482,121 @@ void LLKeywords::findSegments(std::vector<LLTextSegment *>* seg_list, const LLWS
 			}
 		}
 	}
+
+	return text_len;
+}
+
+void LLKeywords::updateSegments(std::vector<LLTextSegment *>* seg_list, const LLWString& wtext, const LLColor4 &defaultColor,
+								S32 edit_start, S32 edit_end, S32 delta)
+{
+	S32 text_len = wtext.size();
+	if( !mLineStartsValid || seg_list->empty() || !text_len
+		|| (seg_list->size() == 1 && seg_list->front()->getIsDefault()) )
+	{
+		// Nothing of ours to reuse.
+		findSegments(seg_list, wtext, defaultColor);
+		return;
+	}
+
+	// Restart at the last line before the edit that began outside any
+	// comment or string; what came before it cannot have changed.
+	std::vector<S32>::iterator line_iter = std::upper_bound(mLineStarts.begin(), mLineStarts.end(), edit_start);
+	S32 restart = 0;
+	if( line_iter != mLineStarts.begin() )
+	{
+		--line_iter;
+		restart = *line_iter;
+	}
+
+	std::vector<LLTextSegment *> new_segs;
+	new_segs.push_back( new LLTextSegment( LLColor3(defaultColor), restart, text_len ) );
+	std::vector<S32> new_starts;
+	S32 stop = scanSegments(&new_segs, wtext, defaultColor, restart, new_starts, edit_end, delta);
+	BOOL resumed = (stop < text_len);
+	S32 old_stop = stop - delta;
+
+	// Keep old segments wholly before restart and, if tokenizing caught up
+	// with the old state, wholly after stop.  The plain text segments
+	// straddling either point are trimmed; neighbouring plain segments are
+	// merged below so the result matches a full rescan.
+	std::vector<LLTextSegment *> head;
+	std::vector<LLTextSegment *> tail;
+	for (std::vector<LLTextSegment *>::iterator iter = seg_list->begin(); iter != seg_list->end(); ++iter)
+	{
+		LLTextSegment* seg = *iter;
+		BOOL keep = FALSE;
+		if( resumed && seg->getEnd() > old_stop )
+		{
+			S32 seg_start = llmax(seg->getStart(), old_stop);
+			if( seg->getStart() < restart )
+			{
+				tail.push_back( new LLTextSegment( seg->getColor(), seg_start + delta, seg->getEnd() + delta ) );
+			}
+			else
+			{
+				seg->setStart( seg_start + delta );
+				seg->setEnd( seg->getEnd() + delta );
+				tail.push_back(seg);
+				keep = TRUE;
+			}
+		}
+		if( seg->getStart() < restart )
+		{
+			seg->setEnd( llmin(seg->getEnd(), restart) );
+			head.push_back(seg);
+			keep = TRUE;
+		}
+		if( !keep )
+		{
+			delete seg;
+		}
+	}
+
+	seg_list->clear();
+	seg_list->reserve(head.size() + new_segs.size() + tail.size());
+	appendSegments(seg_list, head, text_len);
+	appendSegments(seg_list, new_segs, resumed ? stop : text_len);
+	appendSegments(seg_list, tail, text_len);
+
+	// Same for the restartable line starts.
+	std::vector<S32> line_starts;
+	line_starts.reserve(mLineStarts.size() + new_starts.size());
+	line_starts.insert(line_starts.end(), mLineStarts.begin(), line_iter);
+	line_starts.insert(line_starts.end(), new_starts.begin(), new_starts.end());
+	if( resumed )
+	{
+		for (std::vector<S32>::iterator iter = std::lower_bound(mLineStarts.begin(), mLineStarts.end(), old_stop);
+			 iter != mLineStarts.end(); ++iter)
+		{
+			line_starts.push_back(*iter + delta);
+		}
+	}
+	mLineStarts.swap(line_starts);
+}
+
+// Append segs to seg_list, clipped to end, folding a plain text segment into a
+// plain one before it.
+void LLKeywords::appendSegments(std::vector<LLTextSegment *>* seg_list, std::vector<LLTextSegment *>& segs, S32 end)
+{
+	for (std::vector<LLTextSegment *>::iterator iter = segs.begin(); iter != segs.end(); ++iter)
+	{
+		LLTextSegment* seg = *iter;
+		seg->setEnd( llmin(seg->getEnd(), end) );
+		if( seg->getStart() >= seg->getEnd() )
+		{
+			delete seg;
+		}
+		else if( !seg_list->empty() && !seg->getToken() && !seg_list->back()->getToken()
+				 && seg_list->back()->getEnd() == seg->getStart() )
+		{
+			seg_list->back()->setEnd( seg->getEnd() );
+			delete seg;
+		}
+		else
+		{
+			seg_list->push_back(seg);
+		}
+	}
 }
 
 void LLKeywords::insertSegment(std::vector<LLTextSegment*>* seg_list, LLTextSegment* new_segment, S32 text_len, const LLColor4 &defaultColor )
@@ -39,6 +39,7 @@
 #include <map>
 #include <list>
 #include <deque>
+#include <vector>
 
 class LLTextSegment;
 
@@ -86,6 +87,12 @@ public:
 
 	void		findSegments(std::vector<LLTextSegment *> *seg_list, const LLWString& text, const LLColor4 &defaultColor );
 
+	// Bring seg_list up to date after text was edited.  Text before edit_start
+	// is unchanged, and text from edit_end on is unchanged but has moved by
+	// delta characters.  Only the lines between are re-tokenized.
+	void		updateSegments(std::vector<LLTextSegment *> *seg_list, const LLWString& text, const LLColor4 &defaultColor,
+							   S32 edit_start, S32 edit_end, S32 delta);
+
 	// Add the token as described
 	void addToken(LLKeywordToken::TOKEN_TYPE type,
 					const std::string& key,
@@ -104,12 +111,20 @@ public:
 private:
 	LLColor3	readColor(const std::string& s);
 	void		insertSegment(std::vector<LLTextSegment *> *seg_list, LLTextSegment* new_segment, S32 text_len, const LLColor4 &defaultColor);
+	S32			scanSegments(std::vector<LLTextSegment *> *seg_list, const LLWString& wtext, const LLColor4 &defaultColor,
+							 S32 start, std::vector<S32>& line_starts, S32 edit_end = -1, S32 delta = 0);
+	void		appendSegments(std::vector<LLTextSegment *> *seg_list, std::vector<LLTextSegment *>& segs, S32 end);
 
 	BOOL		mLoaded;
 	word_token_map_t mWordTokenMap;
 	typedef std::deque<LLKeywordToken*> token_list_t;
 	token_list_t mLineTokenList;
 	token_list_t mDelimiterTokenList;
+
+	// Starts of the lines in the last segmented text that begin outside
+	// any comment or string; tokenizing can restart at any of them.
+	std::vector<S32> mLineStarts;
+	BOOL		mLineStartsValid;
 };
 
 #endif  // LL_LLKEYWORDS_H
@@ -99,6 +99,86 @@ struct SortScrollListItem
 	const sort_order_t& mSortOrders;
 };
 
+// Sorting large lists through SortScrollListItem converts every cell value
+// to a string on each comparison, which dominates the sort. Instead extract
+// the keys once per row, sort on those and write the result back.
+struct LLScrollListSortEntry
+{
+	LLScrollListItem*			mItem;
+	std::vector<std::string>	mKeys;
+	std::vector<bool>			mHasKey;
+};
+
+struct SortScrollListEntry
+{
+	SortScrollListEntry(const SortScrollListItem::sort_order_t& sort_orders)
+	:	mSortOrders(sort_orders)
+	{}
+
+	bool operator()(const LLScrollListSortEntry* e1, const LLScrollListSortEntry* e2)
+	{
+		// keys are stored in mSortOrders order, compare from most significant (last) to first
+		S32 sort_result = 0;
+		for (S32 i = (S32)mSortOrders.size() - 1; i >= 0; --i)
+		{
+			if (e1->mHasKey[i] && e2->mHasKey[i])
+			{
+				S32 order = mSortOrders[i].second ? 1 : -1;
+				sort_result = order * LLStringUtil::compareDict(e1->mKeys[i], e2->mKeys[i]);
+				if (sort_result != 0)
+				{
+					break;
+				}
+			}
+		}
+		return sort_result < 0;
+	}
+
+	const SortScrollListItem::sort_order_t& mSortOrders;
+};
+
+static void sort_scroll_list_items(std::deque<LLScrollListItem*>& items, const SortScrollListItem::sort_order_t& sort_orders)
+{
+	if (items.size() < 2 || sort_orders.empty())
+	{
+		return;
+	}
+
+	std::vector<LLScrollListSortEntry> entries(items.size());
+	std::vector<LLScrollListSortEntry*> order;
+	order.reserve(items.size());
+	for (U32 i = 0; i < items.size(); ++i)
+	{
+		LLScrollListSortEntry& entry = entries[i];
+		entry.mItem = items[i];
+		entry.mKeys.resize(sort_orders.size());
+		entry.mHasKey.resize(sort_orders.size(), false);
+		for (U32 k = 0; k < sort_orders.size(); ++k)
+		{
+			const LLScrollListCell* cell = entry.mItem->getColumn(sort_orders[k].first);
+			if (cell)
+			{
+				entry.mKeys[k] = cell->getValue().asString();
+				entry.mHasKey[k] = true;
+			}
+		}
+		order.push_back(&entry);
+	}
+
+	// do stable sort to preserve any previous sorts
+	std::stable_sort(order.begin(), order.end(), SortScrollListEntry(sort_orders));
+
+	for (U32 i = 0; i < order.size(); ++i)
+	{
+		items[i] = order[i]->mItem;
+	}
+}
+
+
+//
+// LLScrollListCell
+//
+U32 LLScrollListCell::sEditCount = 0;
 
 //
 // LLScrollListIcon
@@ -118,7 +198,7 @@ LLScrollListIcon::LLScrollListIcon(const LLSD& value, S32 width)
 	: LLScrollListCell(width),
 	mColor(LLColor4::white)
 {
-	setValue(value);
+	setIcon(value);
 }
 
 
@@ -127,6 +207,12 @@ LLScrollListIcon::~LLScrollListIcon()
 }
 
 void LLScrollListIcon::setValue(const LLSD& value)
+{
+	setIcon(value);
+	sEditCount++;
+}
+
+void LLScrollListIcon::setIcon(const LLSD& value)
 {
 	if (value.isUUID())
 	{
@@ -139,7 +225,7 @@ void LLScrollListIcon::setValue(const LLSD& value)
 		std::string value_string = value.asString();
 		if (LLUUID::validate(value_string))
 		{
-			setValue(LLUUID(value_string));
+			setIcon(LLUUID(value_string));
 		}
 		else if (!value_string.empty())
 		{
@@ -225,6 +311,7 @@ BOOL LLScrollListCheck::handleClick()
 	if (mCheckBox->getEnabled())
 	{
 		mCheckBox->toggle();
+		sEditCount++;
 	}
 	// don't change selection when clicking on embedded checkbox
 	return TRUE; 
@@ -265,8 +352,10 @@ BOOL LLScrollListLineEditor::handleClick()
 { 
 	if (mLineEditor->getEnabled())
 	{
+		// the text can change from here on without going through setValue()
 		mLineEditor->setFocus(TRUE);
 		mLineEditor->selectAll();
+		sEditCount++;
 	}
 	// return value changes selection?
 	return FALSE; //TRUE; 
@@ -374,6 +463,7 @@ void LLScrollListText::setColor(const LLColor4& color)
 void LLScrollListText::setText(const LLStringExplicit& text)
 {
 	mText = text;
+	sEditCount++;
 }
 
 //virtual
@@ -495,6 +585,11 @@ void LLScrollListItem::setColumn( S32 column, LLScrollListCell *cell )
 {
 	if (column < (S32)mColumns.size())
 	{
+		if (mColumns[column])
+		{
+			// replacing a cell edits the item
+			LLScrollListCell::bumpEditCount();
+		}
 		delete mColumns[column];
 		mColumns[column] = cell;
 	}
@@ -671,6 +766,9 @@ LLScrollListCtrl::LLScrollListCtrl(const std::string& name, const LLRect& rect,
 	mTotalStaticColumnWidth(0),
 	mTotalColumnPadding(0),
 	mSorted(TRUE),
+	mSortedByFirstColumn(TRUE),
+	mSortedEditCount(LLScrollListCell::getEditCount()),
+	mColumnContentWidthsDirty(TRUE),
 	mDirty(FALSE),
 	mOriginalSelection(-1),
 	mDrewSelected(FALSE)
@@ -783,6 +881,8 @@ void LLScrollListCtrl::clearRows()
 
 	mScrollLines = 0;
 	mLastSelected = NULL;
+	mSortedByFirstColumn = TRUE;
+	mSortedEditCount = LLScrollListCell::getEditCount();
 	updateLayout();
 	mDirty = FALSE; 
 }
@@ -988,15 +1088,30 @@ BOOL LLScrollListCtrl::addItem( LLScrollListItem* item, EAddPosition pos, BOOL r
 				std::vector<sort_column_t> single_sort_column;
 				single_sort_column.push_back(std::make_pair(0, TRUE));
 
-				mItemList.push_back(item);
-				std::stable_sort(
-					mItemList.begin(), 
-					mItemList.end(), 
-					SortScrollListItem(single_sort_column));
+				// consecutive sorted adds just binary search for the insertion point,
+				// unless a cell was edited since, which could have broken the order.
+				// upper_bound keeps the new item after equal ones, as the stable sort did
+				SortScrollListItem compare(single_sort_column);
+				if (mSortedEditCount != LLScrollListCell::getEditCount())
+				{
+					mSortedByFirstColumn = FALSE;
+				}
+				if (mSortedByFirstColumn)
+				{
+					mItemList.insert(std::upper_bound(mItemList.begin(), mItemList.end(), item, compare), item);
+				}
+				else
+				{
+					mItemList.push_back(item);
+					sort_scroll_list_items(mItemList, single_sort_column);
+					mSortedByFirstColumn = TRUE;
+				}
+				mSortedEditCount = LLScrollListCell::getEditCount();
 				
 				// ADD_SORTED just sorts by first column...
 				// this might not match user sort criteria, so flag list as being in unsorted state
-				setSorted(FALSE);
+				// (without setSorted(), which would also forget the column 0 order)
+				mSorted = FALSE;
 				break;
 			}	
 		case ADD_BOTTOM:
@@ -1029,18 +1144,8 @@ BOOL LLScrollListCtrl::addItem( LLScrollListItem* item, EAddPosition pos, BOOL r
 	return not_too_big;
 }
 
-// NOTE: This is *very* expensive for large lists, especially when we are dirtying the list every frame
-//  while receiving a long list of names.
-// *TODO: Use bookkeeping to make this an incramental cost with item additions
 void LLScrollListCtrl::calcColumnWidths()
 {
-	const S32 HEADING_TEXT_PADDING = 25;
-	const S32 COLUMN_TEXT_PADDING = 10;
-
-	mMaxContentWidth = 0;
-
-	S32 max_item_width = 0;
-
 	ordered_columns_t::iterator column_itor;
 	for (column_itor = mColumnsIndexed.begin(); column_itor != mColumnsIndexed.end(); ++column_itor)
 	{
@@ -1059,16 +1164,43 @@ void LLScrollListCtrl::calcColumnWidths()
 		}
 
 		column->setWidth(new_width);
+	}
+
+	// content widths are only needed when snapping a column header, and measuring
+	// them means laying out the text of every row, which is *very* expensive for
+	// large lists that are dirtied every frame while a long list of names arrives.
+	mColumnContentWidthsDirty = TRUE;
+}
+
+void LLScrollListCtrl::updateColumnContentWidths()
+{
+	const S32 HEADING_TEXT_PADDING = 25;
+	const S32 COLUMN_TEXT_PADDING = 10;
+
+	if (!mColumnContentWidthsDirty)
+	{
+		return;
+	}
+	mColumnContentWidthsDirty = FALSE;
+
+	S32 max_item_width = 0;
+
+	const LLFontGL* font = LLFontGL::getFontSansSerifSmall();
+	ordered_columns_t::iterator column_itor;
+	for (column_itor = mColumnsIndexed.begin(); column_itor != mColumnsIndexed.end(); ++column_itor)
+	{
+		LLScrollListColumn* column = *column_itor;
+		if (!column) continue;
 
 		// update max content width for this column, by looking at all items
-		column->mMaxContentWidth = column->mHeader ? LLFontGL::getFontSansSerifSmall()->getWidth(column->mLabel) + mColumnPadding + HEADING_TEXT_PADDING : 0;
+		column->mMaxContentWidth = column->mHeader ? font->getWidth(column->mLabel) + mColumnPadding + HEADING_TEXT_PADDING : 0;
 		item_list::iterator iter;
 		for (iter = mItemList.begin(); iter != mItemList.end(); iter++)
 		{
 			LLScrollListCell* cellp = (*iter)->getColumn(column->mIndex);
 			if (!cellp) continue;
 
-			column->mMaxContentWidth = llmax(LLFontGL::getFontSansSerifSmall()->getWidth(cellp->getValue().asString()) + mColumnPadding + COLUMN_TEXT_PADDING, column->mMaxContentWidth);
+			column->mMaxContentWidth = llmax(font->getWidth(cellp->getValue().asString()) + mColumnPadding + COLUMN_TEXT_PADDING, column->mMaxContentWidth);
 		}
 
 		max_item_width += column->mMaxContentWidth;
@@ -1294,6 +1426,7 @@ void LLScrollListCtrl::swapWithNext(S32 index)
 	LLScrollListItem *cur_itemp = mItemList[index];
 	mItemList[index] = mItemList[index + 1];
 	mItemList[index + 1] = cur_itemp;
+	mSortedByFirstColumn = FALSE;
 }
 
 
@@ -1308,6 +1441,7 @@ void LLScrollListCtrl::swapWithPrevious(S32 index)
 	LLScrollListItem *cur_itemp = mItemList[index];
 	mItemList[index] = mItemList[index - 1];
 	mItemList[index - 1] = cur_itemp;
+	mSortedByFirstColumn = FALSE;
 }
 
 void LLScrollListCtrl::moveToFront(S32 index)
@@ -1321,6 +1455,7 @@ void LLScrollListCtrl::moveToFront(S32 index)
 	std::advance(it,index);
 	mItemList.push_front(*it);
 	mItemList.erase(it);
+	mSortedByFirstColumn = FALSE;
 }
 
 void LLScrollListCtrl::deleteSingleItem(S32 target_index)
@@ -1840,10 +1975,13 @@ void LLScrollListCtrl::drawItems()
 		F32 type_ahead_timeout = LLUI::sConfigGroup->getF32("TypeAheadTimeout");
 		highlight_color.mV[VALPHA] = clamp_rescale(mSearchTimer.getElapsedTimeF32(), type_ahead_timeout * 0.7f, type_ahead_timeout, 0.4f, 0.f);
 
-		item_list::iterator iter;
-		for (iter = mItemList.begin(); iter != mItemList.end(); iter++)
+		// only visit the rows that are actually on screen, long lists
+		// shouldn't cost anything per frame for rows scrolled out of view
+		S32 last_line = llmin((S32)mItemList.size(), mScrollLines + num_page_lines);
+		line = llmax(0, mScrollLines);
+		for (; line < last_line; line++)
 		{
-			LLScrollListItem* item = *iter;
+			LLScrollListItem* item = mItemList[line];
 			
 			item_rect.setOriginAndSize( 
 				x, 
@@ -1863,36 +2001,32 @@ void LLScrollListCtrl::drawItems()
 			LLColor4 fg_color;
 			LLColor4 bg_color(LLColor4::transparent);
 
-			if( mScrollLines <= line && line < mScrollLines + num_page_lines )
+			fg_color = (item->getEnabled() ? mFgUnselectedColor : mFgDisabledColor);
+			if( item->getSelected() && mCanSelect)
 			{
-				fg_color = (item->getEnabled() ? mFgUnselectedColor : mFgDisabledColor);
-				if( item->getSelected() && mCanSelect)
-				{
-					bg_color = mBgSelectedColor;
-					fg_color = (item->getEnabled() ? mFgSelectedColor : mFgDisabledColor);
-				}
-				else if (mHighlightedItem == line && mCanSelect)
-				{
-					bg_color = mHighlightedColor;
-				}
-				else 
+				bg_color = mBgSelectedColor;
+				fg_color = (item->getEnabled() ? mFgSelectedColor : mFgDisabledColor);
+			}
+			else if (mHighlightedItem == line && mCanSelect)
+			{
+				bg_color = mHighlightedColor;
+			}
+			else 
+			{
+				if (mDrawStripes && (line % 2 == 0) && (max_columns > 1))
 				{
-					if (mDrawStripes && (line % 2 == 0) && (max_columns > 1))
-					{
-						bg_color = mBgStripeColor;
-					}
+					bg_color = mBgStripeColor;
 				}
+			}
 
-				if (!item->getEnabled())
-				{
-					bg_color = mBgReadOnlyColor;
-				}
+			if (!item->getEnabled())
+			{
+				bg_color = mBgReadOnlyColor;
+			}
 
-				item->draw(item_rect, fg_color, bg_color, highlight_color, mColumnPadding);
+			item->draw(item_rect, fg_color, bg_color, highlight_color, mColumnPadding);
 
-				cur_y -= mLineHeight;
-			}
-			line++;
+			cur_y -= mLineHeight;
 		}
 	}
 }
@@ -2727,11 +2861,8 @@ void  LLScrollListCtrl::sortByColumnIndex(U32 column, BOOL ascending)
 
 void LLScrollListCtrl::sortItems()
 {
-	// do stable sort to preserve any previous sorts
-	std::stable_sort(
-		mItemList.begin(), 
-		mItemList.end(), 
-		SortScrollListItem(mSortColumns));
+	sort_scroll_list_items(mItemList, mSortColumns);
+	mSortedByFirstColumn = FALSE;
 
 	setSorted(TRUE);
 }
@@ -2742,11 +2873,8 @@ void LLScrollListCtrl::sortOnce(S32 column, BOOL ascending)
 	std::vector<std::pair<S32, BOOL> > sort_column;
 	sort_column.push_back(std::make_pair(column, ascending));
 
-	// do stable sort to preserve any previous sorts
-	std::stable_sort(
-		mItemList.begin(), 
-		mItemList.end(), 
-		SortScrollListItem(sort_column));
+	sort_scroll_list_items(mItemList, sort_column);
+	mSortedByFirstColumn = FALSE;
 }
 
 void LLScrollListCtrl::dirtyColumns() 
@@ -3833,6 +3961,7 @@ BOOL LLColumnHeader::handleDoubleClick(S32 x, S32 y, MASK mask)
 	{
 		// reshape column to max content width
 		LLRect column_rect = getRect();
+		mColumn->mParentCtrl->updateColumnContentWidths();
 		column_rect.mRight = column_rect.mLeft + mColumn->mMaxContentWidth;
 		setShape(column_rect,true);
 	}
@@ -4018,6 +4147,7 @@ LLView*	LLColumnHeader::findSnapEdge(S32& new_edge_val, const LLCoordGL& mouse_d
 
 	LLRect snap_rect = getSnapRect();
 
+	mColumn->mParentCtrl->updateColumnContentWidths();
 	S32 snap_delta = mColumn->mMaxContentWidth - snap_rect.getWidth();
 
 	// x coord growing means column growing, so same signs mean we're going in right direction
@@ -82,6 +82,14 @@ public:
 	virtual BOOL			handleClick() { return FALSE; }
 	virtual	void			setEnabled(BOOL enable) { }
 
+	// Bumped whenever a cell's value changes after it was built, so a list
+	// keeping its items in order knows it has to check that order again.
+	static U32				getEditCount() { return sEditCount; }
+	static void				bumpEditCount() { sEditCount++; }
+
+protected:
+	static U32 sEditCount;
+
 private:
 	S32 mWidth;
 };
@@ -172,6 +180,8 @@ public:
 	// </edit>
 
 private:
+	void			setIcon(const LLSD& value);
+
 	LLUIImagePtr mIcon;
 	LLColor4 mColor;
 	// <edit>
@@ -191,7 +201,7 @@ public:
 	virtual void	draw(const LLColor4& color, const LLColor4& highlight_color) const;
 	virtual S32		getHeight() const			{ return 0; } 
 	virtual const LLSD	getValue() const { return mCheckBox->getValue(); }
-	virtual void	setValue(const LLSD& value) { mCheckBox->setValue(value); }
+	virtual void	setValue(const LLSD& value) { mCheckBox->setValue(value); sEditCount++; }
 	virtual void	onCommit() { mCheckBox->onCommit(); }
 
 	virtual BOOL	handleClick();
@@ -213,7 +223,7 @@ public:
 	virtual void	draw(const LLColor4& color, const LLColor4& highlight_color) const;
 	virtual S32		getHeight() const			{ return 0; } 
 	virtual const LLSD	getValue() const { return mLineEditor->getValue(); }
-	virtual void	setValue(const LLSD& value) { mLineEditor->setValue(value); }
+	virtual void	setValue(const LLSD& value) { mLineEditor->setValue(value); sEditCount++; }
 	virtual void	onCommit() { mLineEditor->onCommit(); }
 	virtual BOOL	handleClick();
 	virtual BOOL	handleUnicodeChar(llwchar uni_char, BOOL called_from_parent);
@@ -585,7 +595,9 @@ public:
 
 	void updateColumns();
 	void calcColumnWidths();
-	S32 getMaxContentWidth() { return mMaxContentWidth; }
+	// measures the widest cell in each column; only done on demand since it touches every row
+	void updateColumnContentWidths();
+	S32 getMaxContentWidth() { updateColumnContentWidths(); return mMaxContentWidth; }
 
 	void setDisplayHeading(BOOL display);
 	void setHeadingHeight(S32 heading_height);
@@ -618,7 +630,7 @@ public:
 	void			sortOnce(S32 column, BOOL ascending);
 
 	// manually call this whenever editing list items in place to flag need for resorting
-	void			setSorted(BOOL sorted) { mSorted = sorted; }
+	void			setSorted(BOOL sorted) { mSorted = sorted; if (!sorted) mSortedByFirstColumn = FALSE; }
 	void			dirtyColumns(); // some operation has potentially affected column layout or ordering
 
 	void userSetShape(const LLRect& new_rect)
@@ -645,7 +657,8 @@ protected:
 	BOOL			addItem( LLScrollListItem* item, EAddPosition pos = ADD_BOTTOM, BOOL requires_column = TRUE );
 
 	typedef std::deque<LLScrollListItem *> item_list;
-	item_list&		getItemList() { return mItemList; }
+	// Callers may reorder or edit the items, so the list forgets its order.
+	item_list&		getItemList() { mSortedByFirstColumn = FALSE; return mItemList; }
 
 private:
 	void			selectPrevItem(BOOL extend_selection);
@@ -719,6 +732,10 @@ private:
 	S32				mTotalColumnPadding;
 
 	BOOL			mSorted;
+	// TRUE while mItemList is known to be in ADD_SORTED (column 0, ascending) order
+	BOOL			mSortedByFirstColumn;
+	U32				mSortedEditCount;	// LLScrollListCell::getEditCount() when that order was last known
+	BOOL			mColumnContentWidthsDirty;
 	
 	typedef std::map<std::string, LLScrollListColumn> column_map_t;
 	column_map_t mColumns;
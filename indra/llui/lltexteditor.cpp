@@ -293,6 +293,13 @@ LLTextEditor::LLTextEditor(
 	mLastSelectionY(-1),
 	mLastContextMenuX(-1),
 	mLastContextMenuY(-1),
+	mLayoutWidth(0),
+	mLayoutFont(NULL),
+	mLayoutWordWrap(FALSE),
+	mLayoutLineNumbers(FALSE),
+	mKeywordEditStart(0),
+	mKeywordEditEnd(S32_MAX),
+	mKeywordEditDelta(0),
 	mReflowNeeded(FALSE),
 	mScrollNeeded(FALSE),
 	mSpellCheckable(FALSE)
@@ -510,85 +517,92 @@ void LLTextEditor::setShadowColor( const LLColor4& color )
 
 void LLTextEditor::updateLineStartList(S32 startpos)
 {
-	updateSegments();
-	
-	bindEmbeddedChars(mGLFont);
+	// Explicit callers want everything from startpos on redone.
+	mLineLayout.invalidateFrom(startpos);
+	reflowLines();
+}
+
+void LLTextEditor::needsFullReflow()
+{
+	mLineLayout.invalidate();
+	mKeywordEditStart = 0;
+	mKeywordEditEnd = S32_MAX;
+	needsReflow();
+}
+
+void LLTextEditor::textChanged(S32 pos, S32 removed, S32 inserted)
+{
+	mLineLayout.textChanged(pos, removed, inserted);
+
+	// The keyword segments also need to know how far the text after the
+	// edits has moved.
+	S32 delta = inserted - removed;
+	if (mKeywordEditEnd != S32_MAX)
+	{
+		if (mKeywordEditStart == S32_MAX)
+		{
+			mKeywordEditStart = pos;
+			mKeywordEditEnd = pos + inserted;
+			mKeywordEditDelta = delta;
+		}
+		else
+		{
+			mKeywordEditStart = llmin(mKeywordEditStart, pos);
+			mKeywordEditEnd = llmax(mKeywordEditEnd, pos + removed) + delta;
+			mKeywordEditDelta += delta;
+		}
+	}
+}
 
-	S32 seg_num = mSegments.size();
-	S32 seg_idx = 0;
-	S32 seg_offset = 0;
+// Wraps lines with the editor's font and settings.  Each visual line is one
+// maxDrawableChars call over its whole paragraph.
+class LLTextEditorLineMeasure : public LLTextLineLayout::Measure
+{
+public:
+	LLTextEditorLineMeasure(const LLFontGL* font, F32 width, BOOL word_wrap, BOOL allow_embedded)
+	:	mFont(font),
+		mWidth(width),
+		mWordWrap(word_wrap),
+		mAllowEmbedded(allow_embedded)
+	{
+	}
 
-	if (!mLineStartList.empty())
+	/*virtual*/ S32 fitChars(const llwchar* str, S32 max_chars) const
 	{
-		getSegmentAndOffset(startpos, &seg_idx, &seg_offset);
-		line_info t(seg_idx, seg_offset);
-		line_list_t::iterator iter = std::upper_bound(mLineStartList.begin(), mLineStartList.end(), t, line_info_compare());
-		if (iter != mLineStartList.begin()) --iter;
-		seg_idx = iter->mSegment;
-		seg_offset = iter->mOffset;
-		mLineStartList.erase(iter, mLineStartList.end());
+		return mFont->maxDrawableChars(str, mWidth, max_chars,
+									   mWordWrap ? LLFontGL::WORD_BOUNDARY_IF_POSSIBLE : LLFontGL::ANYWHERE, mAllowEmbedded);
 	}
+
+private:
+	const LLFontGL* mFont;
+	F32 mWidth;
+	BOOL mWordWrap;
+	BOOL mAllowEmbedded;
+};
+
+void LLTextEditor::reflowLines()
+{
+	updateSegments();
 	
-	while( seg_idx < seg_num )
+	bindEmbeddedChars(mGLFont);
+
+	// Anything that changes how much fits on a line invalidates every line.
+	S32 wrap_width = abs(mTextRect.getWidth());
+	if (wrap_width != mLayoutWidth
+		|| mGLFont != mLayoutFont
+		|| mWordWrap != mLayoutWordWrap
+		|| mShowLineNumbers != mLayoutLineNumbers)
 	{
-		mLineStartList.push_back(line_info(seg_idx,seg_offset));
-		BOOL line_ended = FALSE;
-		S32 start_x = mShowLineNumbers ? UI_TEXTEDITOR_LINE_NUMBER_MARGIN : 0;
-		S32 line_width = start_x;
-		while(!line_ended && seg_idx < seg_num)
-		{
-			LLTextSegment* segment = mSegments[seg_idx];
-			S32 start_idx = segment->getStart() + seg_offset;
-			S32 end_idx = start_idx;
-			while (end_idx < segment->getEnd() && mWText[end_idx] != '\n')
-			{
-				end_idx++;
-			}
-			if (start_idx == end_idx)
-			{
-				if (end_idx >= segment->getEnd())
-				{
-					// empty segment
-					seg_idx++;
-					seg_offset = 0;
-				}
-				else
-				{
-					// empty line
-					line_ended = TRUE;
-					seg_offset++;
-				}
-			}
-			else
-			{ 
-				const llwchar* str = mWText.c_str() + start_idx;
-				S32 drawn = mGLFont->maxDrawableChars(str, (F32)abs(mTextRect.getWidth()) - line_width,
-													  end_idx - start_idx, mWordWrap ? LLFontGL::WORD_BOUNDARY_IF_POSSIBLE : LLFontGL::ANYWHERE, mAllowEmbeddedItems );
-				if( 0 == drawn && line_width == start_x)
-				{
-					// If at the beginning of a line, draw at least one character, even if it doesn't all fit.
-					drawn = 1;
-				}
-				seg_offset += drawn;
-				line_width += mGLFont->getWidth(str, 0, drawn, mAllowEmbeddedItems);
-				end_idx = segment->getStart() + seg_offset;
-				if (end_idx < segment->getEnd())
-				{
-					line_ended = TRUE;
-					if (mWText[end_idx] == '\n')
-					{
-						seg_offset++; // skip newline
-					}
-				}
-				else
-				{
-					// finished with segment
-					seg_idx++;
-					seg_offset = 0;
-				}
-			}
-		}
+		mLayoutWidth = wrap_width;
+		mLayoutFont = mGLFont;
+		mLayoutWordWrap = mWordWrap;
+		mLayoutLineNumbers = mShowLineNumbers;
+		mLineLayout.invalidate();
 	}
+
+	S32 start_x = mShowLineNumbers ? UI_TEXTEDITOR_LINE_NUMBER_MARGIN : 0;
+	LLTextEditorLineMeasure measure(mGLFont, (F32)(wrap_width - start_x), mWordWrap, mAllowEmbeddedItems);
+	mLineLayout.reflow(mWText, measure);
 	
 	unbindEmbeddedChars(mGLFont);
 
@@ -630,6 +644,7 @@ BOOL LLTextEditor::truncate()
 			mWText = utf8str_to_wstring( temp_utf8_text );
 			mTextIsUpToDate = FALSE;
 			did_truncate = TRUE;
+			needsFullReflow();
 		}
 	}
 
@@ -650,7 +665,7 @@ void LLTextEditor::setText(const LLStringExplicit &utf8str)
 	setCursorPos(0);
 	deselect();
 
-	needsReflow();
+	needsFullReflow();
 
 	resetDirty();
 }
@@ -667,7 +682,7 @@ void LLTextEditor::setWText(const LLWString &wtext)
 	setCursorPos(0);
 	deselect();
 
-	needsReflow();
+	needsFullReflow();
 
 	resetDirty();
 }
@@ -893,17 +908,13 @@ S32 LLTextEditor::getLineStart( S32 line ) const
     }
 
 	line = llclamp(line, 0, num_lines-1);
-	S32 segidx = mLineStartList[line].mSegment;
-	S32 segoffset = mLineStartList[line].mOffset;
-	LLTextSegment* seg = mSegments[segidx];
-	S32 res = seg->getStart() + segoffset;
-	if (res > seg->getEnd()) 
+	S32 res = mLineLayout.getLineStart(line);
+	if (res > getLength()) 
 	{
-		//llerrs << "wtf" << llendl;
 		// This happens when creating a new notecard using the AO on certain opensims.
 		// Play it safe instead of bringing down the viewer - MC
-		llwarns << "BAD JOOJOO! Text length (" << res << ") greater than text end (" << seg->getEnd() << "). Setting line start to " << seg->getEnd() << llendl;
-		res = seg->getEnd();
+		llwarns << "BAD JOOJOO! Text length (" << res << ") greater than text end (" << getLength() << "). Setting line start to " << getLength() << llendl;
+		res = getLength();
 	}
 	return res;
 }
@@ -911,23 +922,7 @@ S32 LLTextEditor::getLineStart( S32 line ) const
 // Given an offset into text (pos), find the corresponding line (from the start of the doc) and an offset into the line.
 void LLTextEditor::getLineAndOffset( S32 startpos, S32* linep, S32* offsetp ) const
 {
-	if (mLineStartList.empty())
-	{
-		*linep = 0;
-		*offsetp = startpos;
-	}
-	else
-	{
-		S32 seg_idx, seg_offset;
-		getSegmentAndOffset( startpos, &seg_idx, &seg_offset );
-
-		line_info tline(seg_idx, seg_offset);
-		line_list_t::const_iterator iter = std::upper_bound(mLineStartList.begin(), mLineStartList.end(), tline, line_info_compare());
-		if (iter != mLineStartList.begin()) --iter;
-		*linep = iter - mLineStartList.begin();
-		S32 line_start = mSegments[iter->mSegment]->getStart() + iter->mOffset;
-		*offsetp = startpos - line_start;
-	}
+	mLineLayout.getLineAndOffset(startpos, linep, offsetp);
 }
 
 void LLTextEditor::getSegmentAndOffset( S32 startpos, S32* segidxp, S32* offsetp ) const
@@ -3588,7 +3583,7 @@ void LLTextEditor::draw()
 	// do on-demand reflow 
 	if (mReflowNeeded)
 	{
-		updateLineStartList();
+		reflowLines();
 		mReflowNeeded = FALSE;
 	}
 
@@ -4215,8 +4210,7 @@ void LLTextEditor::removeTextFromEnd(S32 num_chars)
 
 	pruneSegments();
 	
-	// pruneSegments will invalidate mLineStartList.
-	updateLineStartList();
+	reflowLines();
 	needsScroll();
 }
 
@@ -4230,6 +4224,7 @@ S32 LLTextEditor::insertStringNoUndo(const S32 pos, const LLWString &wstr)
 
 	mWText.insert(pos, wstr);
 	mTextIsUpToDate = FALSE;
+	textChanged(pos, 0, insert_len);
 
 	if ( truncate() )
 	{
@@ -4245,6 +4240,7 @@ S32 LLTextEditor::removeStringNoUndo(S32 pos, S32 length)
 {
 	mWText.erase(pos, length);
 	mTextIsUpToDate = FALSE;
+	textChanged(pos, length, 0);
 	return -length;	// This will be wrong if someone calls removeStringNoUndo with an excessive length
 }
 
@@ -4256,6 +4252,7 @@ S32 LLTextEditor::overwriteCharNoUndo(S32 pos, llwchar wc)
 	}
 	mWText[pos] = wc;
 	mTextIsUpToDate = FALSE;
+	textChanged(pos, 1, 1);
 	return 1;
 }
 
@@ -4346,6 +4343,9 @@ void LLTextEditor::loadKeywords(const std::string& filename,
 		}
 
 		mKeywords.findSegments( &mSegments, mWText, mDefaultColor );
+		mKeywordEditStart = S32_MAX;
+		mKeywordEditEnd = -1;
+		mKeywordEditDelta = 0;
 
 		llassert( mSegments.front()->getStart() == 0 );
 		llassert( mSegments.back()->getEnd() == getLength() );
@@ -4357,7 +4357,17 @@ void LLTextEditor::updateSegments()
 	if (mKeywords.isLoaded())
 	{
 		// HACK:  No non-ascii keywords for now
-		mKeywords.findSegments(&mSegments, mWText, mDefaultColor);
+		if (mKeywordEditEnd == S32_MAX)
+		{
+			mKeywords.findSegments(&mSegments, mWText, mDefaultColor);
+		}
+		else if (mKeywordEditStart != S32_MAX)
+		{
+			mKeywords.updateSegments(&mSegments, mWText, mDefaultColor, mKeywordEditStart, mKeywordEditEnd, mKeywordEditDelta);
+		}
+		mKeywordEditStart = S32_MAX;
+		mKeywordEditEnd = -1;
+		mKeywordEditDelta = 0;
 	}
 	else if (mAllowEmbeddedItems)
 	{
@@ -4380,7 +4390,6 @@ void LLTextEditor::updateSegments()
 }
 
 // Only effective if text was removed from the end of the editor
-// *NOTE: Using this will invalidate references to mSegments from mLineStartList.
 void LLTextEditor::pruneSegments()
 {
 	S32 len = mWText.length();
@@ -37,6 +37,7 @@
 
 #include "llrect.h"
 #include "llkeywords.h"
+#include "lltextlinelayout.h"
 #include "lluictrl.h"
 #include "llframetimer.h"
 #include "lldarray.h"
@@ -307,6 +308,11 @@ protected:
 public:
 	void			updateLineStartList(S32 startpos = 0);
 protected:
+	// Every edit goes through textChanged(), so reflowLines() only has to
+	// re-wrap the lines around it.
+	void			reflowLines();
+	void			textChanged(S32 pos, S32 removed, S32 inserted);
+	void			needsFullReflow();
 	void			updateScrollFromCursor();
 	void			updateTextRect();
 	const LLRect&	getTextRect() const { return mTextRect; }
@@ -350,7 +356,7 @@ protected:
 	S32				nextWordPos(S32 cursorPos) const;
 	BOOL			getWordBoundriesAt(const S32 at, S32* word_begin, S32* word_length) const;
 
-	S32 			getLineCount() const { return mLineStartList.size(); }
+	S32 			getLineCount() const { return mLineLayout.getLineCount(); }
 	S32 			getLineStart( S32 line ) const;
 	void			getLineAndOffset(S32 pos, S32* linep, S32* offsetp) const;
 	S32				getPos(S32 line, S32 offset);
@@ -540,33 +546,19 @@ private:
 
 	S32				mDesiredXPixel;			// X pixel position where the user wants the cursor to be
 	LLRect			mTextRect;				// The rect in which text is drawn.  Excludes borders.
-	// List of offsets and segment index of the start of each line.  Always has at least one node (0).
-	struct line_info
-	{
-		line_info(S32 segment, S32 offset) : mSegment(segment), mOffset(offset) {}
-		S32 mSegment;
-		S32 mOffset;
-	};
-	struct line_info_compare
-	{
-		bool operator()(const line_info& a, const line_info& b) const
-		{
-			if (a.mSegment < b.mSegment)
-				return true;
-			else if (a.mSegment > b.mSegment)
-				return false;
-			else
-				return a.mOffset < b.mOffset;
-		}
-	};
-	typedef std::vector<line_info> line_list_t;
-
 	//to keep track of what we have to remove before showing menu
 	std::vector<SpellMenuBind* > suggestionMenuItems;
 	S32 mLastContextMenuX;
 	S32 mLastContextMenuY;
 
-	line_list_t mLineStartList;
+	LLTextLineLayout mLineLayout;			// where each line starts
+	S32				mLayoutWidth;			// what mLineLayout was wrapped for
+	const LLFontGL*	mLayoutFont;
+	BOOL			mLayoutWordWrap;
+	BOOL			mLayoutLineNumbers;
+	S32				mKeywordEditStart;		// text edited since keywords were last applied, S32_MAX if none
+	S32				mKeywordEditEnd;		// end of that text now, S32_MAX to re-tokenize everything
+	S32				mKeywordEditDelta;		// how far the text after it has moved
 	BOOL			mReflowNeeded;
 	BOOL			mScrollNeeded;
 
@@ -619,6 +611,7 @@ public:
 
 	S32					getStart() const					{ return mStart; }
 	S32					getEnd() const						{ return mEnd; }
+	void				setStart( S32 start )				{ mStart = start; }
 	void				setEnd( S32 end )					{ mEnd = end; }
 	const LLColor4&		getColor() const					{ return mStyle->getColor(); }
 	void 				setColor(const LLColor4 &color)		{ mStyle->setColor(color); }
@@ -0,0 +1,185 @@
+/** 
+ * @file lltextlinelayout.cpp
+ * @brief Incremental line wrapping for LLTextEditor
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lltextlinelayout.h"
+
+#include <algorithm>
+
+LLTextLineLayout::LLTextLineLayout()
+:	mReflowStart(0),
+	mReflowEnd(S32_MAX)
+{
+}
+
+// Starts inside removed text collapse onto pos; they are re-laid out
+// because they sit inside the dirty range.
+void LLTextLineLayout::textChanged(S32 pos, S32 removed, S32 inserted)
+{
+	S32 delta = inserted - removed;
+	if (delta)
+	{
+		std::vector<S32>::iterator iter = std::upper_bound(mLineStarts.begin(), mLineStarts.end(), pos);
+		for ( ; iter != mLineStarts.end(); ++iter)
+		{
+			*iter = llmax(pos, *iter + delta);
+		}
+	}
+
+	// mReflowEnd is S32_MAX while a full reflow is pending, -1 when clean.
+	if (mReflowEnd != S32_MAX)
+	{
+		if (mReflowEnd > pos)
+		{
+			mReflowEnd = llmax(pos, mReflowEnd + delta);
+		}
+		mReflowEnd = llmax(mReflowEnd, pos + inserted);
+	}
+	mReflowStart = llmin(mReflowStart, pos);
+}
+
+void LLTextLineLayout::invalidateFrom(S32 pos)
+{
+	mReflowStart = llmin(mReflowStart, llmax(pos, 0));
+	mReflowEnd = S32_MAX;
+}
+
+// Wrap the line starting at start.  para_end is the next newline (or the
+// end of the text).  Returns where the next line starts, or -1 if this is
+// the last line.
+// static
+S32 LLTextLineLayout::layoutLine(const LLWString& text, S32 start, S32 para_end, const Measure& measure)
+{
+	S32 len = text.length();
+	if (start == para_end)
+	{
+		// empty line
+		return (para_end < len) ? para_end + 1 : -1;
+	}
+
+	S32 drawn = measure.fitChars(text.c_str() + start, para_end - start);
+	if (0 == drawn)
+	{
+		// Draw at least one character, even if it doesn't all fit.
+		drawn = 1;
+	}
+
+	S32 end = start + drawn;
+	if (end < para_end)
+	{
+		return end;
+	}
+	return (para_end < len) ? para_end + 1 : -1;
+}
+
+void LLTextLineLayout::reflow(const LLWString& text, const Measure& measure)
+{
+	if (mLineStarts.empty())
+	{
+		mLineStarts.push_back(0);
+		invalidate();
+	}
+
+	S32 len = text.length();
+	if (mReflowStart != S32_MAX)
+	{
+		mReflowStart = llmin(mReflowStart, len);
+
+		// Back up past the line holding the edit: the edit may let its
+		// first word (or a shorter previous line) fit further up.  Starts
+		// collapsed onto the edit point compare equal, so take the first.
+		std::vector<S32>::iterator iter = std::lower_bound(mLineStarts.begin(), mLineStarts.end(), mReflowStart);
+		S32 first_line = llmax(0, (S32)(iter - mLineStarts.begin()) - 3);
+		S32 old_line = first_line + 1;
+		S32 num_old = mLineStarts.size();
+
+		std::vector<S32> new_lines;
+		S32 pos = llmin(mLineStarts[first_line], mReflowStart);
+		S32 para_end = pos;
+		while (TRUE)
+		{
+			new_lines.push_back(pos);
+			if (para_end < pos)
+			{
+				para_end = pos;
+			}
+			while (para_end < len && text[para_end] != '\n')
+			{
+				para_end++;
+			}
+
+			S32 next = layoutLine(text, pos, para_end, measure);
+			if (next < 0)
+			{
+				old_line = num_old;
+				break;
+			}
+			pos = next;
+
+			// Past the edit, once we land on a start we already had the
+			// rest of the old layout still holds.
+			if (pos > mReflowEnd)
+			{
+				while (old_line < num_old && mLineStarts[old_line] < pos)
+				{
+					old_line++;
+				}
+				if (old_line < num_old && mLineStarts[old_line] == pos)
+				{
+					break;
+				}
+			}
+		}
+
+		mLineStarts.erase(mLineStarts.begin() + first_line, mLineStarts.begin() + old_line);
+		mLineStarts.insert(mLineStarts.begin() + first_line, new_lines.begin(), new_lines.end());
+	}
+	mReflowStart = S32_MAX;
+	mReflowEnd = -1;
+}
+
+void LLTextLineLayout::getLineAndOffset(S32 pos, S32* linep, S32* offsetp) const
+{
+	if (mLineStarts.empty())
+	{
+		*linep = 0;
+		*offsetp = pos;
+	}
+	else
+	{
+		std::vector<S32>::const_iterator iter = std::upper_bound(mLineStarts.begin(), mLineStarts.end(), pos);
+		if (iter != mLineStarts.begin()) --iter;
+		*linep = iter - mLineStarts.begin();
+		*offsetp = pos - *iter;
+	}
+}
@@ -0,0 +1,81 @@
+/** 
+ * @file lltextlinelayout.h
+ * @brief Incremental line wrapping for LLTextEditor
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXTLINELAYOUT_H
+#define LL_LLTEXTLINELAYOUT_H
+
+#include "llstring.h"
+#include <vector>
+
+// Keeps the character position where each visual line of a text starts,
+// up to date incrementally.  Edits record the range they touched and shift
+// the line starts after it; the next reflow() re-wraps from just before
+// that range until the new line starts line up with old ones again.
+class LLTextLineLayout
+{
+public:
+	// Says how many characters of a run fit on one line.  Must only look
+	// at the max_chars it is given, or edits further on would change lines
+	// that are not re-wrapped.
+	class Measure
+	{
+	public:
+		virtual ~Measure() {}
+		virtual S32 fitChars(const llwchar* str, S32 max_chars) const = 0;
+	};
+
+	LLTextLineLayout();
+
+	// Text at pos had removed characters replaced by inserted ones.
+	void			textChanged(S32 pos, S32 removed, S32 inserted);
+	// Re-wrap everything from pos on at the next reflow.
+	void			invalidateFrom(S32 pos);
+	// Re-wrap everything, e.g. when the width or font changed.
+	void			invalidate()				{ invalidateFrom(0); }
+	BOOL			needsReflow() const			{ return mReflowStart != S32_MAX; }
+
+	void			reflow(const LLWString& text, const Measure& measure);
+
+	// Before the first reflow there are no lines at all.
+	S32				getLineCount() const		{ return mLineStarts.size(); }
+	S32				getLineStart(S32 line) const { return mLineStarts[line]; }
+	void			getLineAndOffset(S32 pos, S32* linep, S32* offsetp) const;
+
+private:
+	static S32		layoutLine(const LLWString& text, S32 start, S32 para_end, const Measure& measure);
+
+	std::vector<S32> mLineStarts;			// always starts with 0 once laid out
+	S32				mReflowStart;			// first character whose wrapping may have changed, S32_MAX if none
+	S32				mReflowEnd;				// end of the edited range; lines starting after it only moved
+};
+
+#endif // LL_LLTEXTLINELAYOUT_H
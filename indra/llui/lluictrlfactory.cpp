@@ -79,6 +79,7 @@ const S32 FLOATER_H_MARGIN = 15;
 const S32 MIN_WIDGET_HEIGHT = 10;
 
 std::vector<std::string> LLUICtrlFactory::sXUIPaths;
+LLUICtrlFactory::layout_cache_t LLUICtrlFactory::sLayoutCache;
 
 // UI Ctrl class for padding
 class LLUICtrlLocate : public LLUICtrl
@@ -133,6 +134,7 @@ void LLUICtrlFactory::setupPaths()
 	LLXMLNodePtr root;
 	BOOL success  = LLXMLNode::parseFile(filename, root, NULL);
 	sXUIPaths.clear();
+	clearLayoutCache();
 	
 	if (success)
 	{
@@ -165,11 +167,56 @@ const std::vector<std::string>& LLUICtrlFactory::getXUIPaths()
 	return sXUIPaths;
 }
 
+// static
+void LLUICtrlFactory::clearLayoutCache()
+{
+	sLayoutCache.clear();
+}
+
+static time_t get_layout_file_mtime(const std::string& filename)
+{
+	llstat stat_info;
+	if (LLFile::stat(filename, &stat_info) != 0)
+	{
+		return 0;
+	}
+	return stat_info.st_mtime;
+}
+
+// static
+bool LLUICtrlFactory::isLayoutCacheEntryValid(const LLLayoutCacheEntry& entry)
+{
+	for (std::vector<std::pair<std::string, time_t> >::const_iterator it = entry.mSources.begin();
+		 it != entry.mSources.end(); ++it)
+	{
+		if (get_layout_file_mtime(it->first) != it->second)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 //-----------------------------------------------------------------------------
 // getLayeredXMLNode()
 //-----------------------------------------------------------------------------
 bool LLUICtrlFactory::getLayeredXMLNode(const std::string &xui_filename, LLXMLNodePtr& root)
 {
+	layout_cache_t::iterator cached = sLayoutCache.find(xui_filename);
+	if (cached != sLayoutCache.end())
+	{
+		if (isLayoutCacheEntryValid(cached->second))
+		{
+			// callers are free to modify what they get, so hand out a copy
+			root = cached->second.mRoot->deepCopy();
+			return true;
+		}
+		// a source file was edited on disk, reparse it
+		sLayoutCache.erase(cached);
+	}
+
+	LLLayoutCacheEntry entry;
+
 	std::string full_filename = gDirUtilp->findSkinnedFilename(sXUIPaths.front(), xui_filename);
 	if (full_filename.empty())
 	{
@@ -190,6 +237,7 @@ bool LLUICtrlFactory::getLayeredXMLNode(const std::string &xui_filename, LLXMLNo
 		llwarns << "Problem reading UI description file: " << full_filename << llendl;
 		return false;
 	}
+	entry.mSources.push_back(std::make_pair(full_filename, get_layout_file_mtime(full_filename)));
 
 	LLXMLNodePtr updateRoot;
 
@@ -213,6 +261,8 @@ bool LLUICtrlFactory::getLayeredXMLNode(const std::string &xui_filename, LLXMLNo
 			return false;
 		}
 
+		entry.mSources.push_back(std::make_pair(layer_filename, get_layout_file_mtime(layer_filename)));
+
 		updateRoot->getAttributeString("name", updateName);
 		root->getAttributeString("name", nodeName);
 
@@ -222,6 +272,9 @@ bool LLUICtrlFactory::getLayeredXMLNode(const std::string &xui_filename, LLXMLNo
 		}
 	}
 
+	entry.mRoot = root->deepCopy();
+	sLayoutCache[xui_filename] = entry;
+
 	return true;
 }
 
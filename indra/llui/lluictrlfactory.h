@@ -85,6 +85,9 @@ public:
 
 	static const std::vector<std::string>& getXUIPaths();
 
+	// Drops all parsed layouts, e.g. when the skin or language changes.
+	static void clearLayoutCache();
+
 private:
 	bool getLayeredXMLNodeImpl(const std::string &filename, LLXMLNodePtr& root);
 
@@ -98,6 +101,18 @@ private:
 
 	static std::vector<std::string> sXUIPaths;
 
+	// Merged (base + localized layers) XUI trees by filename, so reopening a
+	// floater copies the tree instead of parsing and merging the XML again.
+	// Each entry remembers the files it was built from and their mtimes.
+	struct LLLayoutCacheEntry
+	{
+		LLXMLNodePtr mRoot;
+		std::vector<std::pair<std::string, time_t> > mSources;
+	};
+	typedef std::map<std::string, LLLayoutCacheEntry> layout_cache_t;
+	static layout_cache_t sLayoutCache;
+	static bool isLayoutCacheEntryValid(const LLLayoutCacheEntry& entry);
+
 	LLPanel* mDummyPanel;
 	
 	void buildFloaterInternal(LLFloater *floaterp, LLXMLNodePtr &root, const std::string &filename,
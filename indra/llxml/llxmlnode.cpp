@@ -144,10 +144,10 @@ LLXMLNodePtr LLXMLNode::deepCopy()
 	LLXMLNodePtr newnode = LLXMLNodePtr(new LLXMLNode(*this));
 	if (mChildren.notNull())
 	{
-		for (LLXMLChildList::iterator iter = mChildren->map.begin();
-			 iter != mChildren->map.end(); ++iter)
+		// walk the sibling list rather than the name map so the copy keeps document order
+		for (LLXMLNodePtr child = mChildren->head; child.notNull(); child = child->mNext)
 		{
-			newnode->addChild(iter->second->deepCopy());
+			newnode->addChild(child->deepCopy());
 		}
 	}
 	for (LLXMLAttribList::iterator iter = mAttributes.begin();
@@ -71,6 +71,7 @@ LLPrefsAscentSys::LLPrefsAscentSys()
     childSetCommitCallback("AscentCmdLineOfferTp", onCommitCmdLine, this);
     childSetCommitCallback("AscentCmdLineMapTo", onCommitCmdLine, this);
     childSetCommitCallback("AscentCmdLineTP2", onCommitCmdLine, this);
+    childSetCommitCallback("AscentCmdLineSearchLog", onCommitCmdLine, this);
 
     refreshValues();
     refresh();
@@ -153,6 +154,7 @@ void LLPrefsAscentSys::onCommitCmdLine(LLUICtrl* ctrl, void* user_data)
         self->childSetEnabled("cmd_line_text_11",          enabled);
         self->childSetEnabled("cmd_line_text_12",          enabled);
         self->childSetEnabled("cmd_line_text_13",          enabled);
+        self->childSetEnabled("cmd_line_text_14",          enabled);
         self->childSetEnabled("cmd_line_text_15",          enabled);
         self->childSetEnabled("AscentCmdLinePos",          enabled);
         self->childSetEnabled("AscentCmdLineGround",       enabled);
@@ -169,6 +171,7 @@ void LLPrefsAscentSys::onCommitCmdLine(LLUICtrl* ctrl, void* user_data)
         self->childSetEnabled("AscentCmdLineMapTo",        enabled);
         self->childSetEnabled("map_to_keep_pos",           enabled);
         self->childSetEnabled("AscentCmdLineTP2",          enabled);
+        self->childSetEnabled("AscentCmdLineSearchLog",    enabled);
     }
 
     gSavedSettings.setString("AscentCmdLinePos",          self->childGetValue("AscentCmdLinePos"));
@@ -184,6 +187,7 @@ void LLPrefsAscentSys::onCommitCmdLine(LLUICtrl* ctrl, void* user_data)
     gSavedSettings.setString("AscentCmdLineOfferTp",      self->childGetValue("AscentCmdLineOfferTp"));
     gSavedSettings.setString("AscentCmdLineMapTo",        self->childGetValue("AscentCmdLineMapTo"));
     gSavedSettings.setString("AscentCmdLineTP2",          self->childGetValue("AscentCmdLineTP2"));
+    gSavedSettings.setString("AscentCmdLineSearchLog",    self->childGetValue("AscentCmdLineSearchLog"));
 }
 
 void LLPrefsAscentSys::refreshValues()
@@ -225,6 +229,7 @@ void LLPrefsAscentSys::refreshValues()
     mCmdLineMapTo               = gSavedSettings.getString("AscentCmdLineMapTo");
     mCmdMapToKeepPos            = gSavedSettings.getBOOL("AscentMapToKeepPos");
     mCmdLineTP2                 = gSavedSettings.getString("AscentCmdLineTP2");
+    mCmdLineSearchLog           = gSavedSettings.getString("AscentCmdLineSearchLog");
 
     //Privacy -----------------------------------------------------------------------------
     mBroadcastViewerEffects		= gSavedSettings.getBOOL("BroadcastViewerEffects");
@@ -259,6 +264,7 @@ void LLPrefsAscentSys::refresh()
     childSetEnabled("cmd_line_text_11",           mCmdLine);
     childSetEnabled("cmd_line_text_12",           mCmdLine);
     childSetEnabled("cmd_line_text_13",           mCmdLine);
+    childSetEnabled("cmd_line_text_14",           mCmdLine);
     childSetEnabled("cmd_line_text_15",           mCmdLine);
     childSetEnabled("AscentCmdLinePos",           mCmdLine);
     childSetEnabled("AscentCmdLineGround",        mCmdLine);
@@ -275,6 +281,7 @@ void LLPrefsAscentSys::refresh()
     childSetEnabled("AscentCmdLineMapTo",         mCmdLine);
     childSetEnabled("map_to_keep_pos",            mCmdLine);
     childSetEnabled("AscentCmdLineTP2",           mCmdLine);
+    childSetEnabled("AscentCmdLineSearchLog",     mCmdLine);
 
     childSetValue("AscentCmdLinePos",           mCmdLinePos);
     childSetValue("AscentCmdLineGround",        mCmdLineGround);
@@ -289,6 +296,7 @@ void LLPrefsAscentSys::refresh()
     childSetValue("AscentCmdLineOfferTp",       mCmdLineOfferTp);
     childSetValue("AscentCmdLineMapTo",         mCmdLineMapTo);
     childSetValue("AscentCmdLineTP2",           mCmdLineTP2);
+    childSetValue("AscentCmdLineSearchLog",     mCmdLineSearchLog);
 }
 
 void LLPrefsAscentSys::cancel()
@@ -329,6 +337,7 @@ void LLPrefsAscentSys::cancel()
     gSavedSettings.setString("AscentCmdLineMapTo",			mCmdLineMapTo);
     gSavedSettings.setBOOL("AscentMapToKeepPos",            mCmdMapToKeepPos);
     gSavedSettings.setString("AscentCmdLineTP2",			mCmdLineTP2);
+    gSavedSettings.setString("AscentCmdLineSearchLog",		mCmdLineSearchLog);
 
     //Privacy -----------------------------------------------------------------------------
     gSavedSettings.setBOOL("BroadcastViewerEffects",        mBroadcastViewerEffects);
@@ -72,6 +72,7 @@
 void cmdline_printchat(std::string message);
 void cmdline_rezplat(bool use_saved_value = true, F32 visual_radius = 30.0);
 void cmdline_tp2name(std::string target);
+void cmdline_searchlog(const std::string& query);
 
 LLUUID cmdline_partial_name2key(std::string name);
 
@@ -398,6 +399,13 @@ bool cmd_line_chat(std::string revised_text, EChatType type)
 					cmdline_tp2name(name);
 				}
 				return false;
+			}else if(command == utf8str_tolower(gSavedSettings.getString("AscentCmdLineSearchLog")))
+			{
+				if (revised_text.length() > command.length() + 1)
+				{
+					cmdline_searchlog(revised_text.substr(command.length()+1));
+				}
+				return false;
 			}else if(command == "typingstop")
 			{
 				std::string text;
@@ -506,6 +514,29 @@ void cmdline_tp2name(std::string target)
 	}
 }
 
+// Shows the newest transcript lines containing every word of query in the
+// chat history. They are not logged, or each search would log its results.
+void cmdline_searchlog(const std::string& query)
+{
+	std::vector<LLLogChat::LLLogChatMatch> matches;
+	LLLogChat::searchHistory(query, matches, 20);
+
+	LLChat chat;
+	chat.mSourceType = CHAT_SOURCE_SYSTEM;
+	if (matches.empty())
+	{
+		chat.mText = "No chat history found for: " + query;
+		LLFloaterChat::addChatHistory(chat, false);
+		return;
+	}
+	// Oldest first, so the newest match ends up at the bottom.
+	for (std::vector<LLLogChat::LLLogChatMatch>::reverse_iterator iter = matches.rbegin(); iter != matches.rend(); ++iter)
+	{
+		chat.mText = gDirUtilp->getBaseFileName(iter->mFileName, true) + ": " + iter->mText;
+		LLFloaterChat::addChatHistory(chat, false);
+	}
+}
+
 void cmdline_rezplat(bool use_saved_value, F32 visual_radius) //cmdline_rezplat() will still work... just will use the saved value
 {
     LLVector3 agentPos = gAgent.getPositionAgent()+(gAgent.getVelocity()*(F32)0.333);
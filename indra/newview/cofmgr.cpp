@@ -263,9 +263,7 @@ void LLCOFMgr::addCOFItemLink(const LLInventoryItem* pItem, LLPointer<LLInventor
 
 bool LLCOFMgr::isLinkInCOF(const LLUUID& idItem) const
 {
-	 LLInventoryModel::cat_array_t folders; LLInventoryModel::item_array_t items;
-	 LLLinkedItemIDMatches f(gInventory.getLinkedItemID(idItem));
-	 gInventory.collectDescendentsIf(getCOF(), folders, items, LLInventoryModel::EXCLUDE_TRASH, f);
+	 LLInventoryModel::item_array_t items = gInventory.collectLinkedItems(gInventory.getLinkedItemID(idItem), getCOF());
 	 return (!items.empty());
 }
 
@@ -273,14 +271,10 @@ void LLCOFMgr::removeCOFItemLinks(const LLUUID& idItem)
 {
 	gInventory.addChangedMask(LLInventoryObserver::LABEL, idItem);
 
-	LLInventoryModel::cat_array_t folders; LLInventoryModel::item_array_t items;
-	gInventory.collectDescendents(getCOF(), folders, items, LLInventoryModel::EXCLUDE_TRASH);
-
+	LLInventoryModel::item_array_t items = gInventory.collectLinkedItems(idItem, getCOF());
 	for (S32 idxItem = 0; idxItem < items.count(); idxItem++)
 	{
-		const LLInventoryItem* pItem = items.get(idxItem).get();
-		if ( (pItem->getIsLinkType()) && (idItem == pItem->getLinkedUUID()) )
-			gInventory.purgeObject(pItem->getUUID());
+		gInventory.purgeObject(items.get(idxItem)->getUUID());
 	}
 }
 
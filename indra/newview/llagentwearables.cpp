@@ -2026,9 +2026,8 @@ void LLAgentWearables::userRemoveMultipleAttachments(llvo_vec_t& objects_to_remo
 				itObj = objects_to_remove.erase(itObj);
 
 				// Fall-back code: re-add the attachment if it got removed from COF somehow (compensates for possible bugs elsewhere)
-				LLInventoryModel::cat_array_t folders; LLInventoryModel::item_array_t items;
-				LLLinkedItemIDMatches f(pAttachObj->getAttachmentItemID());
-				gInventory.collectDescendentsIf(LLCOFMgr::instance().getCOF(), folders, items, LLInventoryModel::EXCLUDE_TRASH, f);
+				LLInventoryModel::item_array_t items =
+					gInventory.collectLinkedItems(pAttachObj->getAttachmentItemID(), LLCOFMgr::instance().getCOF());
 				RLV_ASSERT( 0 != items.count() );
 				if (0 == items.count())
 					LLCOFMgr::instance().addAttachment(pAttachObj->getAttachmentItemID());
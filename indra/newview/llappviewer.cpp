@@ -44,6 +44,7 @@
 #include "llalertdialog.h"
 #include "llerrorcontrol.h"
 #include "lleventtimer.h"
+#include "llstringtable.h"
 #include "llviewertexturelist.h"
 #include "llgroupmgr.h"
 #include "llagent.h"
@@ -62,6 +63,7 @@
 #include "llfloaterjoystick.h"
 #include "llares.h" 
 #include "llcurl.h"
+#include "llhttpscheduler.h"
 #include "llfloatersnapshot.h"
 #include "lltexturestats.h"
 #include "llviewerwindow.h"
@@ -108,7 +110,10 @@
 #include "llnotify.h"
 #include "llviewerkeyboard.h"
 #include "lllfsthread.h"
+#include "lllogchat.h"
 #include "llworkerthread.h"
+#include "llhitchmonitor.h"
+#include "lltexlayermaskcache.h"
 #include "lltexturecache.h"
 #include "lltexturefetch.h"
 #include "llimageworker.h"
@@ -164,6 +169,7 @@
 #include "llvotree.h"
 #include "llvoavatar.h"
 #include "llfolderview.h"
+#include "llinventoryfilterengine.h"
 #include "lltoolbar.h"
 #include "llframestats.h"
 #include "llagentpilot.h"
@@ -629,8 +635,13 @@ bool LLAppViewer::init()
     // *NOTE:Mani - LLCurl::initClass is not thread safe. 
     // Called before threads are created.
     LLCurl::initClass(gSavedSettings.getBOOL("CurlUseMultipleThreads"));
+	LLCurl::setPipelining(gSavedSettings.getBOOL("HTTPPipelining"));
 	LL_INFOS("InitInfo") << "LLCurl initialized." << LL_ENDL ;
 
+	// The HTTP scheduler is shared by the texture and mesh threads, so
+	// create it before they start.
+	LLHTTPScheduler::getInstance()->setMaxRequestsPerHost(gSavedSettings.getU32("HTTPMaxRequestsPerHost"));
+
     initThreads();
 	LL_INFOS("InitInfo") << "Threads initialized." << LL_ENDL ;
 
@@ -1014,6 +1025,7 @@ bool LLAppViewer::mainLoop()
 	//-------------------------------------------
 
 	// Create IO Pump to use for HTTP Requests.
+	LLPumpIO::setUseEpoll(gSavedSettings.getBOOL("PumpIOUseEpoll"));
 	gServicePump = new LLPumpIO;
 	LLHTTPClient::setPump(*gServicePump);
 	LLCurl::setCAFile(gDirUtilp->getCAFile());
@@ -1036,6 +1048,7 @@ bool LLAppViewer::mainLoop()
 	while (!LLApp::isExiting())
 	{
 		LLFastTimer::reset(); // Should be outside of any timer instances
+		LLHitchMonitor::update();
 
 		//clear call stack records
 		llclearcallstacks;
@@ -1519,6 +1532,7 @@ bool LLAppViewer::cleanup()
 	//LLVolumeMgr::cleanupClass();
 	LLPrimitive::cleanupVolumeManager();
 	LLWorldMapView::cleanupClass();
+	LLInventoryFilterEngine::cleanupClass();
 	LLFolderViewItem::cleanupClass();
 	LLUI::cleanupClass();
 	
@@ -1631,6 +1645,7 @@ bool LLAppViewer::cleanup()
 	}
 	
 	// Delete workers first
+	LLTexLayerMaskCache::cleanupClass();
 	// shotdown all worker threads before deleting them in case of co-dependencies
 	sTextureFetch->shutdown();
 	sTextureCache->shutdown();
@@ -1643,6 +1658,7 @@ bool LLAppViewer::cleanup()
     sTextureFetch = NULL;
 	delete sImageDecodeThread;
     sImageDecodeThread = NULL;
+	gVLManager.cleanupThread();
 
 
 	llinfos << "Cleaning up Media and Textures" << llendflush;
@@ -1660,6 +1676,7 @@ bool LLAppViewer::cleanup()
 	LLImage::cleanupClass();
 	LLVFSThread::cleanupClass();
 	LLLFSThread::cleanupClass();
+	LLLogChat::cleanupClass();
 
 	llinfos << "VFS Thread finished" << llendflush;
 
@@ -1765,12 +1782,22 @@ bool LLAppViewer::initThreads()
 	LLVFSThread::initClass(enable_threads && false);
 	LLLFSThread::initClass(enable_threads && false);
 
+	// Before the first worker thread starts recording.
+	LLFastTimerTrace::setThreadName("main");
+	LLFastTimerTrace::setEnabled(gSavedSettings.getBOOL("FastTimerTraceEnabled"));
+
 	// Image decoding
 	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true);
 	LLAppViewer::sTextureCache = new LLTextureCache(enable_threads && true);
 	LLAppViewer::sTextureFetch = new LLTextureFetch(LLAppViewer::getTextureCache(), sImageDecodeThread, enable_threads && true);
 	LLImage::initClass();
 
+	// Avatar bake alpha masks
+	LLTexLayerMaskCache::initClass(enable_threads ? gSavedSettings.getU32("AvatarBakeThreads") : 0);
+
+	// Terrain patch decoding
+	gVLManager.initThread(enable_threads);
+
 	// Mesh streaming and caching
 	gMeshRepo.init();
 	// *FIX: no error handling here!
@@ -3655,6 +3682,9 @@ void LLAppViewer::idle()
 	LLEventTimer::updateClass();
 	LLCriticalDamp::updateInterpolants();
 	LLMortician::updateClass();
+	// Only the main thread interns strings, so between frames no lookup can
+	// still be holding a retired entry.
+	gStringTable.freeRetiredEntries();
 	F32 dt_raw = idle_timer.getElapsedTimeAndResetF32();
 
 	// Cap out-of-control frame times
@@ -4209,6 +4239,7 @@ void LLAppViewer::idleNetwork()
 	pingMainloopTimeout("idleNetwork");
 
 	gObjectList.mNumNewObjects = 0;
+	gObjectList.mNumObjectUpdates = 0;
 	S32 total_decoded = 0;
 
 	if (!gSavedSettings.getBOOL("SpeedTest"))
@@ -4286,6 +4317,7 @@ void LLAppViewer::idleNetwork()
 	}
 	llpushcallstacks ;
 	LLViewerStats::getInstance()->mNumNewObjectsStat.addValue(gObjectList.mNumNewObjects);
+	LLViewerStats::getInstance()->mNumObjectUpdatesStat.addValue(gObjectList.mNumObjectUpdates);
 
 	// Retransmit unacknowledged packets.
 	gXferManager->retransmitUnackedPackets();
@@ -1799,6 +1799,21 @@ BOOL LLFace::getGeometryVolume(const LLVolume& volume,
 	return TRUE;
 }
 
+void LLFace::setVirtualSize(F32 size)
+{
+	// Changes the decode priority update would not ignore get the
+	// texture reprioritized now rather than on its round robin turn.
+	if ((size > mVSize * 1.25f || size < mVSize * .8f) && mTexture.notNull())
+	{
+		LLViewerFetchedTexture* tex = LLViewerTextureManager::staticCastToFetchedTexture(mTexture);
+		if (tex)
+		{
+			gTextureList.dirtyImagePriority(tex, llmax(size, mVSize));
+		}
+	}
+	mVSize = size;
+}
+
 const F32 LEAST_IMPORTANCE = 0.05f ;
 const F32 LEAST_IMPORTANCE_FOR_LARGE_IMAGE = 0.3f ;
 
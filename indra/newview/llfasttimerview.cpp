@@ -303,6 +303,7 @@ LLFastTimerView::LLFastTimerView(const std::string& name, const LLRect& rect)
 			llassert(level < FTV_DISPLAY_NUM);
 			ft_display_table[i].desc = text;
 			ft_display_table[i].level = level;
+			LLFastTimerTrace::setTimerName(ft_display_table[i].timer, text);
 			if (level > 0)
 			{
 				ft_display_table[i].parent = pidx[level-1];
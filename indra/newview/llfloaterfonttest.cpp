@@ -39,6 +39,8 @@
 #include "llviewerprecompiledheaders.h"
 
 #include "llfloaterfonttest.h"
+#include "llfontgl.h"
+#include "lltimer.h"
 #include "lluictrlfactory.h"
 
 
@@ -64,3 +66,84 @@ void LLFloaterFontTest::show(void *unused)
 	sInstance->open(); /*Flawfinder: ignore*/
 	sInstance->setFocus(TRUE);
 }
+
+// Lays out every line the way a chat history redraw does: the whole line,
+// then each word as the wrap code measures it.
+static F32 layout_chat_history(const LLFontGL* font, const std::vector<LLWString>& lines)
+{
+	F32 total = 0.f;
+	for (std::vector<LLWString>::const_iterator iter = lines.begin(); iter != lines.end(); ++iter)
+	{
+		const LLWString& line = *iter;
+		total += font->getWidthF32(line.c_str());
+		S32 word_start = 0;
+		for (S32 i = 0; i <= (S32)line.size(); i++)
+		{
+			if (i == (S32)line.size() || line[i] == ' ')
+			{
+				total += font->getWidthF32(line.substr(word_start, i - word_start).c_str());
+				word_start = i + 1;
+			}
+		}
+	}
+	return total;
+}
+
+// static
+void LLFloaterFontTest::benchmark(void *unused)
+{
+	const LLFontGL* font = LLFontGL::getFontSansSerif();
+	if (!font)
+	{
+		return;
+	}
+
+	const char* names[] = { "Governor Linden", "Torley Linden", "Phoenix Resident" };
+	const char* words[] = { "hello", "anyone", "know", "where", "the", "sandbox", "is?",
+							"lol", "brb", "rezzing", "a", "prim", "teleport", "me", "please", "thanks!" };
+	const S32 LINES = 300;
+	const S32 FRAMES = 20;
+	std::vector<LLWString> lines;
+	for (S32 i = 0; i < LINES; i++)
+	{
+		std::string line = llformat("[%02d:%02d] %s: ", (i / 60) % 24, i % 60, names[i % 3]);
+		for (S32 w = i; line.size() < 80; w += 7)
+		{
+			line += words[w % (sizeof(words) / sizeof(words[0]))];
+			line += " ";
+		}
+		lines.push_back(utf8str_to_wstring(line));
+	}
+
+	S32 max_runs = LLFontGL::getMaxGlyphRuns();
+	F32 uncached_width = 0.f;
+	F32 cached_width = 0.f;
+	LLTimer timer;
+
+	LLFontGL::setMaxGlyphRuns(0);
+	timer.reset();
+	for (S32 frame = 0; frame < FRAMES; frame++)
+	{
+		uncached_width = layout_chat_history(font, lines);
+	}
+	F64 uncached_time = timer.getElapsedTimeF64();
+
+	LLFontGL::setMaxGlyphRuns(llmax(max_runs, LINES * 4));
+	LLFontGL::resetGlyphRunStats();
+	timer.reset();
+	for (S32 frame = 0; frame < FRAMES; frame++)
+	{
+		cached_width = layout_chat_history(font, lines);
+	}
+	F64 cached_time = timer.getElapsedTimeF64();
+	LLFontGL::setMaxGlyphRuns(max_runs);
+
+	U32 hits = 0;
+	U32 misses = 0;
+	LLFontGL::getGlyphRunStats(hits, misses);
+	llinfos << "Font layout over " << LINES << " lines: "
+			<< (uncached_time * 1000.0 / FRAMES) << " ms/frame uncached, "
+			<< (cached_time * 1000.0 / FRAMES) << " ms/frame cached, "
+			<< hits << " run hits, " << misses << " run misses"
+			<< (uncached_width == cached_width ? "" : ", WIDTHS DIFFER") << llendl;
+}
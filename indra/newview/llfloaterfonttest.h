@@ -42,6 +42,10 @@ class LLFloaterFontTest:
 public:
 	static void show(void* unused);
 
+	// Times font layout of a chat history sized block of text with and
+	// without the glyph run cache, and logs the results.
+	static void benchmark(void* unused);
+
 private:
 	LLFloaterFontTest();
 	~LLFloaterFontTest();
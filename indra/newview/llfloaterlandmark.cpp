@@ -226,14 +226,8 @@ void LLFloaterLandmark::onClose(bool app_quitting)
 
 const LLUUID& LLFloaterLandmark::findItemID(const LLUUID& asset_id, BOOL copyable_only)
 {
-	LLViewerInventoryCategory::cat_array_t cats;
 	LLViewerInventoryItem::item_array_t items;
-	LLAssetIDMatches asset_id_matches(asset_id);
-	gInventory.collectDescendentsIf(LLUUID::null,
-							cats,
-							items,
-							LLInventoryModel::INCLUDE_TRASH,
-							asset_id_matches);
+	gInventory.findItemsByAssetID(asset_id, items);
 
 	if (items.count())
 	{
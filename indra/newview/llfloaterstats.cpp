@@ -48,6 +48,20 @@
 
 const S32 LL_SCROLL_BORDER = 1;
 
+// LLThrottleGroup categories of the region circuit, i.e. what this viewer
+// sends.  The inbound budget (LLViewerThrottle, sent to the sim in
+// AgentThrottle) is not measured per category on this end.
+static const char* const OUTGOING_THROTTLE_NAMES[TC_EOF] =
+{
+	"Resend Out",
+	"Land Out",
+	"Wind Out",
+	"Cloud Out",
+	"Task Out",
+	"Texture Out",
+	"Asset Out"
+};
+
 void LLFloaterStats::buildStats()
 {
 	LLRect rect;
@@ -140,6 +154,14 @@ void LLFloaterStats::buildStats()
 	stat_barp->mLabelSpacing = 500.f;
 	stat_barp->mPerSec = TRUE;
 
+	stat_barp = render_statviewp->addStat("Obj Updates", &(LLViewerStats::getInstance()->mNumObjectUpdatesStat), "DebugStatModeObjectUpdates");
+	stat_barp->setUnitLabel("/sec");
+	stat_barp->mMinBar = 0.f;
+	stat_barp->mMaxBar = 20000.f;
+	stat_barp->mTickSpacing = 2500.f;
+	stat_barp->mLabelSpacing = 10000.f;
+	stat_barp->mPerSec = TRUE;
+
 
 	// Texture statistics
 	LLStatView *texture_statviewp = render_statviewp->addStatView("texture stat view", "Texture", "OpenDebugStatTexture", rect);
@@ -239,6 +261,31 @@ void LLFloaterStats::buildStats()
 	stat_barp->setUnitLabel(" ");
 	stat_barp->mPerSec = FALSE;
 
+	// Outgoing throttle, per category: rate achieved and what is queued behind it
+	LLStatView *throttle_statviewp = net_statviewp->addStatView("throttle stat view", "Outgoing Throttles", "OpenDebugStatThrottle", rect);
+	for (S32 i = 0; i < TC_EOF; i++)
+	{
+		std::string name(OUTGOING_THROTTLE_NAMES[i]);
+		stat_barp = throttle_statviewp->addStat(name, &(LLViewerStats::getInstance()->mThrottleKBitStat[i]),
+												"", TRUE, FALSE);
+		stat_barp->setUnitLabel(" kbps");
+		stat_barp->mPerSec = FALSE;
+		stat_barp->mMinBar = 0.f;
+		stat_barp->mMaxBar = 512.f;
+		stat_barp->mTickSpacing = 128.f;
+		stat_barp->mLabelSpacing = 256.f;
+
+		stat_barp = throttle_statviewp->addStat(name + " Queued", &(LLViewerStats::getInstance()->mThrottleQueueKBitStat[i]),
+												"", TRUE, FALSE);
+		stat_barp->setUnitLabel(" kb");
+		stat_barp->mPerSec = FALSE;
+		stat_barp->mDisplayMean = FALSE;
+		stat_barp->mMinBar = 0.f;
+		stat_barp->mMaxBar = 1024.f;
+		stat_barp->mTickSpacing = 256.f;
+		stat_barp->mLabelSpacing = 512.f;
+	}
+
 
 	// Simulator stats
 	LLStatView *sim_statviewp = new LLStatView("sim stat view", "Simulator", "OpenDebugStatSim", rect);
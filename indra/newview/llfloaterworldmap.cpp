@@ -931,14 +931,20 @@ void LLFloaterWorldMap::buildLandmarkIDLists()
 	mLandmarkAssetIDList.put( sHomeID );
 	mLandmarkItemIDList.put( sHomeID );
 
-	LLInventoryModel::cat_array_t cats;
+	LLInventoryModel::item_array_t landmarks;
+	gInventory.findItemsByType(LLInventoryType::IT_LANDMARK, landmarks);
+	const LLUUID& root_id = gInventory.getRootFolderID();
+	const LLUUID trash_id = gInventory.findCategoryUUIDForType(LLFolderType::FT_TRASH, false);
 	LLInventoryModel::item_array_t items;
-	LLIsType is_landmark(LLAssetType::AT_LANDMARK);
-	gInventory.collectDescendentsIf(gInventory.getRootFolderID(),
-									cats,
-									items,
-									LLInventoryModel::EXCLUDE_TRASH,
-									is_landmark);
+	for (LLInventoryModel::item_array_t::iterator iter = landmarks.begin(); iter != landmarks.end(); ++iter)
+	{
+		const LLUUID& item_id = (*iter)->getUUID();
+		if (gInventory.isObjectDescendentOf(item_id, root_id) &&
+			(trash_id.isNull() || !gInventory.isObjectDescendentOf(item_id, trash_id)))
+		{
+			items.put(*iter);
+		}
+	}
 
 	std::sort(items.begin(), items.end(), LLViewerInventoryItem::comparePointers());
 	
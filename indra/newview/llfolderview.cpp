@@ -339,6 +339,10 @@ void LLFolderViewItem::refresh()
 	{
 		mSearchableLabel.assign(searchable_label);
 		dirtyFilter();
+		if (mRoot)
+		{
+			mRoot->dirtyFilterTable();
+		}
 		// some part of label has changed, so overall width has potentially changed
 		if (mParentFolder)
 		{
@@ -2619,7 +2623,8 @@ LLFolderView::LLFolderView( const std::string& name, LLUIImagePtr root_folder_ic
 	mSelectCallback(NULL),
 	mSignalSelectCallback(0),
 	mMinWidth(0),
-	mDragAndDropThisFrame(FALSE)
+	mDragAndDropThisFrame(FALSE),
+	mFilterTableDirty(TRUE)
 {
 	LLRect new_rect(rect.mLeft, rect.mBottom + getRect().getHeight(), rect.mLeft + getRect().getWidth(), rect.mBottom);
 	setRect( rect );
@@ -2697,6 +2702,11 @@ LLFolderView::~LLFolderView( void )
 	mFolders.clear();
 
 	mItemMap.clear();
+
+	if (mFilterJob.notNull())
+	{
+		mFilterJob->cancel();
+	}
 }
 
 BOOL LLFolderView::canFocusChildren() const
@@ -2779,6 +2789,7 @@ U32 LLFolderView::toggleSearchType(std::string toggle)
 	{
 		mSearchType = 1;
 	}
+	mFilterTableDirty = TRUE;
 
 	if (getFilterSubString().length())
 	{
@@ -2937,16 +2948,63 @@ const std::string LLFolderView::getFilterSubString(BOOL trim)
 void LLFolderView::filter( LLInventoryFilter& filter )
 {
 	LLFastTimer t2(LLFastTimer::FTM_FILTER);
-	filter.setFilterCount(llclamp(gSavedSettings.getS32("FilterItemsPerFrame"), 1, 5000));
+	S32 filter_count = llclamp(gSavedSettings.getS32("FilterItemsPerFrame"), 1, 5000);
+	filter.setFilterCount(filter_count);
 
 	if (getCompletedFilterGeneration() < filter.getCurrentGeneration())
 	{
+		static const LLCachedControl<bool> filter_in_background(gSavedSettings, "InventoryFilterInBackground", true);
+		if (filter_in_background && filter.canRunInBackground())
+		{
+			if (!pollBackgroundFilter(filter))
+			{
+				// keep showing the previous results until the worker is done
+				return;
+			}
+			if (filter.hasPrecomputedResults())
+			{
+				// each check is now a hash lookup, so walk more of the tree per frame
+				filter.setFilterCount(filter_count * 10);
+			}
+		}
 		mFiltered = FALSE;
 		mMinWidth = 0;
 		LLFolderViewFolder::filter(filter);
 	}
 }
 
+bool LLFolderView::pollBackgroundFilter(LLInventoryFilter& filter)
+{
+	S32 generation = filter.getCurrentGeneration();
+	if (mFilterJob.isNull() || mFilterJob->getGeneration() != generation)
+	{
+		if (mFilterJob.notNull())
+		{
+			mFilterJob->cancel();
+		}
+		if (mFilterTable.isNull() || mFilterTableDirty)
+		{
+			mFilterTable = new LLInventoryFilterTable();
+			mFilterTable->build(mItemMap);
+			mFilterTableDirty = FALSE;
+		}
+		mFilterJob = new LLInventoryFilterJob(mFilterTable, filter.getJobParams(), generation);
+		LLInventoryFilterEngine::getInstance()->post(mFilterJob);
+		filter.setPrecomputedResults(NULL);
+		return false;
+	}
+
+	if (!mFilterJob->isDone())
+	{
+		return false;
+	}
+
+	// Items added or relabeled since the snapshot was taken aren't in the
+	// results; fall back to checking everything directly in that case.
+	filter.setPrecomputedResults(mFilterTableDirty ? NULL : mFilterJob.get());
+	return true;
+}
+
 void LLFolderView::reshape(S32 width, S32 height, BOOL called_from_parent)
 {
 	S32 min_width = 0;
@@ -4354,11 +4412,13 @@ void LLFolderView::setShowSingleSelection(BOOL show)
 void LLFolderView::addItemID(const LLUUID& id, LLFolderViewItem* itemp)
 {
 	mItemMap[id] = itemp;
+	mFilterTableDirty = TRUE;
 }
 
 void LLFolderView::removeItemID(const LLUUID& id)
 {
 	mItemMap.erase(id);
+	mFilterTableDirty = TRUE;
 }
 
 LLFolderViewItem* LLFolderView::getItemByID(const LLUUID& id)
@@ -4667,17 +4727,8 @@ LLInventoryFilter::~LLInventoryFilter()
 {
 }
 
-BOOL LLInventoryFilter::check(LLFolderViewItem* item) 
+time_t LLInventoryFilter::getEarliestDate() const
 {
-	LLFolderViewEventListener* listener = item->getListener();
-	const LLUUID& item_id = listener->getUUID();
-	const LLInventoryObject *obj = gInventory.getObject(item_id);
-	if (isActive() && obj && obj->getIsLinkType())
-	{
-		// When filtering is active, omit links.
-		return FALSE;
-	}
-
 	time_t earliest;
 
 	earliest = time_corrected() - mFilterOps.mHoursAgo * 3600;
@@ -4689,6 +4740,42 @@ BOOL LLInventoryFilter::check(LLFolderViewItem* item)
 	{
 		earliest = 0;
 	}
+	return earliest;
+}
+
+LLInventoryFilterJob::Params LLInventoryFilter::getJobParams()
+{
+	LLInventoryFilterJob::Params params;
+	params.mSubString = mFilterSubString;
+	params.mFilterTypes = mFilterOps.mFilterTypes;
+	params.mPermissions = mFilterOps.mPermissions;
+	params.mEarliest = getEarliestDate();
+	params.mMaxDate = mFilterOps.mMaxDate;
+	params.mOmitLinks = isActive();
+	return params;
+}
+
+BOOL LLInventoryFilter::check(LLFolderViewItem* item) 
+{
+	LLFolderViewEventListener* listener = item->getListener();
+	const LLUUID& item_id = listener->getUUID();
+
+	if (hasPrecomputedResults())
+	{
+		const LLInventoryFilterJob::result_map_t& results = mPrecomputed->getResults();
+		LLInventoryFilterJob::result_map_t::const_iterator it = results.find(item_id);
+		mSubStringMatchOffset = (it != results.end()) ? it->second : std::string::npos;
+		return it != results.end();
+	}
+
+	const LLInventoryObject *obj = gInventory.getObject(item_id);
+	if (isActive() && obj && obj->getIsLinkType())
+	{
+		// When filtering is active, omit links.
+		return FALSE;
+	}
+
+	time_t earliest = getEarliestDate();
 	mSubStringMatchOffset = mFilterSubString.size() ? item->getSearchableLabel().find(mFilterSubString) : std::string::npos;
 	BOOL passed = (0x1 << listener->getInventoryType() & mFilterOps.mFilterTypes || listener->getInventoryType() == LLInventoryType::IT_NONE)
 					&& (mFilterSubString.size() == 0 || mSubStringMatchOffset != std::string::npos)
@@ -55,6 +55,7 @@
 #include "llviewertexture.h"
 #include "lldepthstack.h"
 #include "lltooldraganddrop.h"
+#include "llinventoryfilterengine.h"
 
 class LLMenuGL;
 
@@ -154,6 +155,14 @@ public:
 	U32 getSortOrder() { return mOrder; }
 
 	BOOL check(LLFolderViewItem* item);
+	// Results computed by LLInventoryFilterEngine for the current
+	// generation; check() uses them instead of matching strings itself.
+	void setPrecomputedResults(LLInventoryFilterJob* job) { mPrecomputed = job; }
+	bool hasPrecomputedResults() const { return !mFilterWorn && mPrecomputed.notNull() && mPrecomputed->getGeneration() == mFilterGeneration; }
+	// Only substring searches are worth handing off, and the worn test
+	// needs the agent, so it has to stay on the main thread.
+	bool canRunInBackground() const { return !mFilterWorn && !mFilterSubString.empty(); }
+	LLInventoryFilterJob::Params getJobParams();
 	std::string::size_type getStringMatchOffset() const;
 	BOOL isActive();
 	BOOL isNotDefault();
@@ -184,6 +193,8 @@ public:
 	void fromLLSD(LLSD& data);
 
 protected:
+	time_t getEarliestDate() const;
+
 	struct filter_ops
 	{
 		U32			mFilterTypes;
@@ -206,6 +217,7 @@ protected:
 	S32				mFilterCount;
 	S32				mNextFilterGeneration;
 	EFilterBehavior mFilterBehavior;
+	LLPointer<LLInventoryFilterJob> mPrecomputed;
 
 private:
 	U32 mLastLogoff;
@@ -825,6 +837,10 @@ public:
 	void removeItemID(const LLUUID& id);
 	LLFolderViewItem* getItemByID(const LLUUID& id);
 
+	// Called when an item's searchable text changes, so the next
+	// background filter pass takes a fresh snapshot.
+	void dirtyFilterTable() { mFilterTableDirty = TRUE; }
+
 	void	doIdle();						// Real idle routine
 	static void idle(void* user_data);		// static glue to doIdle()
 
@@ -846,6 +862,10 @@ protected:
 	void finishRenamingItem( void );
 	void closeRenamer( void );
 
+	// Returns true when filtering can go ahead this frame, false while
+	// the background job for the current generation is still running.
+	bool pollBackgroundFilter(LLInventoryFilter& filter);
+
 protected:
 	LLHandle<LLView>					mPopupMenuHandle;
 	
@@ -888,6 +908,10 @@ protected:
 	std::map<LLUUID, LLFolderViewItem*> mItemMap;
 	BOOL							mDragAndDropThisFrame;
 
+	LLPointer<LLInventoryFilterTable>	mFilterTable;
+	LLPointer<LLInventoryFilterJob>		mFilterJob;
+	BOOL							mFilterTableDirty;
+
 };
 
 bool sort_item_name(LLFolderViewItem* a, LLFolderViewItem* b);
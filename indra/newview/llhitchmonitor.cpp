@@ -0,0 +1,214 @@
+/**
+ * @file llhitchmonitor.cpp
+ * @brief Writes a report when a frame takes too long
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ *
+ * Copyright (c) 2011, Linden Research, Inc.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llhitchmonitor.h"
+
+#include "llappviewer.h"
+#include "lldir.h"
+#include "llimagegl.h"
+#include "llimageworker.h"
+#include "lllfsthread.h"
+#include "llmeshrepository.h"
+#include "llstartup.h"
+#include "lltexturecache.h"
+#include "lltexturefetch.h"
+#include "lltexturememorymanager.h"
+#include "llviewercontrol.h"
+#include "llvfsthread.h"
+
+// Frames of fast timer history summarized before the hitch.
+const S32 HISTORY_FRAMES = 10;
+// Timers listed for the hitch frame.
+const S32 MAX_TIMERS = 25;
+// Reports written per session, so a bad session doesn't fill the disk.
+const U32 MAX_REPORTS = 20;
+
+LLTimer LLHitchMonitor::sFrameTimer;
+LLTimer LLHitchMonitor::sLastReportTimer;
+U32 LLHitchMonitor::sHitchCount = 0;
+U32 LLHitchMonitor::sReportCount = 0;
+
+//static
+void LLHitchMonitor::update()
+{
+	F32 frame_time = sFrameTimer.getElapsedTimeAndResetF32();
+
+	static const LLCachedControl<F32> threshold("HitchReportThreshold", 0.2f);
+	if (threshold <= 0.f || frame_time < threshold)
+	{
+		return;
+	}
+	// Login, teleports and region crossings before that are expected to be slow.
+	if (LLStartUp::getStartupState() < STATE_STARTED)
+	{
+		return;
+	}
+
+	sHitchCount++;
+
+	static const LLCachedControl<F32> min_interval("HitchReportMinInterval", 60.f);
+	if (sReportCount >= MAX_REPORTS ||
+		(sReportCount && sLastReportTimer.getElapsedTimeF32() < min_interval))
+	{
+		llinfos << "Frame " << gFrameCount << " took " << (S32)(frame_time * 1000.f) << " ms, not reported" << llendl;
+		return;
+	}
+
+	writeReport(frame_time);
+	sLastReportTimer.reset();
+	sReportCount++;
+	// Don't count writing the report against the next frame.
+	sFrameTimer.reset();
+}
+
+//static
+void LLHitchMonitor::writeReport(F32 frame_time)
+{
+	std::string stamp = LLDate::now().toHTTPDateString("%Y%m%d_%H%M%S");
+	std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "hitch_" + stamp + ".txt");
+	llofstream out(filename);
+	if (!out.is_open())
+	{
+		llwarns << "Unable to write hitch report " << filename << llendl;
+		return;
+	}
+
+	out << "Frame " << gFrameCount << " took " << (S32)(frame_time * 1000.f) << " ms at " << LLDate::now().asString()
+		<< ", hitch " << sHitchCount << "\n\n";
+
+	// Fast timers.  Counts are exclusive of child timers.
+	if (LLFastTimer::sPauseHistory || LLFastTimer::sLastFrameIndex < 0)
+	{
+		out << "Fast timer history is paused\n";
+	}
+	else
+	{
+		const F64 ms_per_count = 1000.0 / (F64)LLFastTimer::countsPerSecond();
+		const S32 last = LLFastTimer::sLastFrameIndex;
+
+		out << "Preceding frames (ms):";
+		for (S32 frame = llmax(0, last - HISTORY_FRAMES + 1); frame <= last; frame++)
+		{
+			U64 total = 0;
+			for (S32 i = 0; i < LLFastTimer::FTM_NUM_TYPES; i++)
+			{
+				total += LLFastTimer::sCountHistory[frame % LLFastTimer::FTM_HISTORY_NUM][i];
+			}
+			out << llformat(" %.1f", (F64)total * ms_per_count);
+		}
+		out << "\n\n";
+
+		const S32 hidx = last % LLFastTimer::FTM_HISTORY_NUM;
+		std::vector<std::pair<U64, S32> > timers;
+		for (S32 i = 0; i < LLFastTimer::FTM_NUM_TYPES; i++)
+		{
+			if (LLFastTimer::sCountHistory[hidx][i])
+			{
+				timers.push_back(std::make_pair(LLFastTimer::sCountHistory[hidx][i], i));
+			}
+		}
+		std::sort(timers.begin(), timers.end(), std::greater<std::pair<U64, S32> >());
+		if ((S32)timers.size() > MAX_TIMERS)
+		{
+			timers.resize(MAX_TIMERS);
+		}
+
+		out << llformat("%-32s %10s %10s %8s %8s\n", "Timer", "ms", "avg ms", "calls", "avg");
+		for (size_t i = 0; i < timers.size(); i++)
+		{
+			S32 type = timers[i].second;
+			out << llformat("%-32s %10.2f %10.2f %8u %8u\n",
+							LLFastTimerTrace::getTimerName(type).c_str(),
+							(F64)timers[i].first * ms_per_count,
+							(F64)LLFastTimer::sCountAverage[type] * ms_per_count,
+							(U32)LLFastTimer::sCallHistory[hidx][type],
+							(U32)LLFastTimer::sCallAverage[type]);
+		}
+	}
+
+	// Worker queues
+	out << "\nQueues:\n";
+	LLTextureFetch* fetch = LLAppViewer::getTextureFetch();
+	if (fetch)
+	{
+		out << "  Texture fetch: " << fetch->getPending() << " pending, " << fetch->getNumRequests() << " requests, "
+			<< fetch->getNumHTTPRequests() << " HTTP\n";
+	}
+	if (LLAppViewer::getTextureCache())
+	{
+		out << "  Texture cache: " << LLAppViewer::getTextureCache()->getPending() << " pending\n";
+	}
+	if (LLAppViewer::getImageDecodeThread())
+	{
+		out << "  Image decode: " << LLAppViewer::getImageDecodeThread()->getPending() << " pending\n";
+	}
+	if (LLVFSThread::sLocal)
+	{
+		out << "  VFS: " << LLVFSThread::sLocal->getPending() << " pending\n";
+	}
+	if (LLLFSThread::sLocal)
+	{
+		out << "  LFS: " << LLLFSThread::sLocal->getPending() << " pending\n";
+	}
+
+	// Mesh
+	U32 loading_meshes = 0;
+	for (S32 i = 0; i < 4; i++)
+	{
+		loading_meshes += gMeshRepo.mLoadingMeshes[i].size();
+	}
+	out << "  Mesh: " << LLMeshRepoThread::sActiveHeaderRequests << " header and " << LLMeshRepoThread::sActiveLODRequests
+		<< " LOD HTTP requests, " << gMeshRepo.mPendingRequests.size() << " queued, " << loading_meshes << " loading\n";
+
+	// Memory
+	S32 raw_memory = *AIAccess<S32>(LLImageRaw::sGlobalRawMemory);
+	out << "\nMemory:\n"
+		<< "  Resident: " << (LLMemory::getCurrentRSS() >> 20) << " MB\n"
+		<< "  Textures: " << BYTES_TO_MEGA_BYTES(LLImageGL::sGlobalTextureMemoryInBytes) << " MB GL, "
+		<< BYTES_TO_MEGA_BYTES(LLImageGL::sBoundTextureMemoryInBytes) << " MB bound, "
+		<< BYTES_TO_MEGA_BYTES(raw_memory) << " MB raw\n"
+		<< "  Texture evictions: " << LLTextureMemoryManager::getEvictionCount() << "\n";
+
+	if (LLFastTimerTrace::isEnabled())
+	{
+		std::string trace_filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "hitch_" + stamp + ".json");
+		if (LLFastTimerTrace::dump(trace_filename, frame_time + 1.f))
+		{
+			out << "\nFast timer trace: " << trace_filename << "\n";
+		}
+	}
+
+	out.close();
+	llwarns << "Frame " << gFrameCount << " took " << (S32)(frame_time * 1000.f) << " ms, wrote " << filename << llendl;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file llhitchmonitor.h
+ * @brief Writes a report when a frame takes too long
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ *
+ * Copyright (c) 2011, Linden Research, Inc.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLHITCHMONITOR_H
+#define LL_LLHITCHMONITOR_H
+
+#include "lltimer.h"
+
+// Watches the frame time in LLAppViewer::mainLoop().  When a frame takes
+// longer than HitchReportThreshold it writes a report to the logs directory:
+// the fast timers of that frame against their averages, the worker queue
+// depths, pending mesh and HTTP requests and memory use.  If the fast timer
+// trace is recording, the trace leading up to the hitch is dumped too.
+//
+// Costs one timer read per frame when there is no hitch.
+class LLHitchMonitor
+{
+public:
+	// Call right after LLFastTimer::reset(), so the frame that just ended
+	// is in the fast timer history.
+	static void update();
+
+	static U32 getHitchCount()	{ return sHitchCount; }
+
+private:
+	static void writeReport(F32 frame_time);
+
+	static LLTimer sFrameTimer;
+	static LLTimer sLastReportTimer;
+	static U32 sHitchCount;
+	static U32 sReportCount;
+};
+
+#endif // LL_LLHITCHMONITOR_H
@@ -0,0 +1,210 @@
+/** 
+ * @file llinventoryfilterengine.cpp
+ * @brief Background evaluation of inventory filters against a flat item table.
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventoryfilterengine.h"
+
+#include "llfolderview.h"
+#include "llfoldervieweventlistener.h"
+#include "llinventorymodel.h"
+
+///----------------------------------------------------------------------------
+/// Class LLInventoryFilterTable
+///----------------------------------------------------------------------------
+
+void LLInventoryFilterTable::build(const std::map<LLUUID, LLFolderViewItem*>& items)
+{
+	mRows.clear();
+	mRows.reserve(items.size());
+	for (std::map<LLUUID, LLFolderViewItem*>::const_iterator it = items.begin(); it != items.end(); ++it)
+	{
+		LLFolderViewItem* item = it->second;
+		LLFolderViewEventListener* listener = item ? item->getListener() : NULL;
+		if (!listener)
+		{
+			continue;
+		}
+		LLInventoryFilterRow row;
+		row.mID = it->first;
+		row.mSearchableLabel = item->getSearchableLabel();
+		row.mInventoryType = listener->getInventoryType();
+		row.mPermissions = listener->getPermissionMask();
+		row.mCreationDate = listener->getCreationDate();
+		const LLInventoryObject* obj = gInventory.getObject(it->first);
+		row.mIsLink = obj && obj->getIsLinkType();
+		mRows.push_back(row);
+	}
+}
+
+///----------------------------------------------------------------------------
+/// Class LLInventoryFilterJob
+///----------------------------------------------------------------------------
+
+LLInventoryFilterJob::LLInventoryFilterJob(LLInventoryFilterTable* table, const Params& params, S32 generation)
+:	mTable(table),
+	mParams(params),
+	mGeneration(generation),
+	mCancelled(0),
+	mDone(0)
+{
+}
+
+// Mirrors LLInventoryFilter::check(), minus the worn test which needs
+// the agent and is left to the main thread.
+void LLInventoryFilterJob::run()
+{
+	const LLInventoryFilterTable::rows_t& rows = mTable->getRows();
+	const bool match_string = !mParams.mSubString.empty();
+	S32 count = 0;
+	for (LLInventoryFilterTable::rows_t::const_iterator it = rows.begin(); it != rows.end(); ++it)
+	{
+		if ((++count % LLInventoryFilterEngine::ROWS_PER_CANCEL_CHECK) == 0 && isCancelled())
+		{
+			return;
+		}
+
+		const LLInventoryFilterRow& row = *it;
+		if (mParams.mOmitLinks && row.mIsLink)
+		{
+			continue;
+		}
+		if (!((0x1 << row.mInventoryType) & mParams.mFilterTypes) && row.mInventoryType != LLInventoryType::IT_NONE)
+		{
+			continue;
+		}
+		if ((row.mPermissions & mParams.mPermissions) != mParams.mPermissions)
+		{
+			continue;
+		}
+		if (row.mCreationDate < mParams.mEarliest || row.mCreationDate > mParams.mMaxDate)
+		{
+			continue;
+		}
+		std::string::size_type offset = std::string::npos;
+		if (match_string)
+		{
+			offset = row.mSearchableLabel.find(mParams.mSubString);
+			if (offset == std::string::npos)
+			{
+				continue;
+			}
+		}
+		mResults[row.mID] = offset;
+	}
+	mTable = NULL;
+	mDone = 1;
+}
+
+///----------------------------------------------------------------------------
+/// Class LLInventoryFilterEngine
+///----------------------------------------------------------------------------
+
+LLInventoryFilterEngine* LLInventoryFilterEngine::sInstance = NULL;
+
+// static
+LLInventoryFilterEngine* LLInventoryFilterEngine::getInstance()
+{
+	if (!sInstance)
+	{
+		sInstance = new LLInventoryFilterEngine();
+		sInstance->start();
+	}
+	return sInstance;
+}
+
+// static
+void LLInventoryFilterEngine::cleanupClass()
+{
+	if (sInstance)
+	{
+		sInstance->shutdown();
+		delete sInstance;
+		sInstance = NULL;
+	}
+}
+
+LLInventoryFilterEngine::LLInventoryFilterEngine()
+:	LLThread("Inventory Filter")
+{
+}
+
+LLInventoryFilterEngine::~LLInventoryFilterEngine()
+{
+	mQueue.clear();
+}
+
+void LLInventoryFilterEngine::post(LLInventoryFilterJob* job)
+{
+	lockData();
+	for (job_queue_t::iterator it = mQueue.begin(); it != mQueue.end(); ++it)
+	{
+		(*it)->cancel();
+	}
+	mQueue.clear();
+	mQueue.push_back(job);
+	unlockData();
+	wake();
+}
+
+bool LLInventoryFilterEngine::runCondition()
+{
+	// mRunCondition must be locked here
+	return !mQueue.empty();
+}
+
+void LLInventoryFilterEngine::run()
+{
+	while (1)
+	{
+		checkPause();
+		if (isQuitting())
+		{
+			break;
+		}
+
+		LLPointer<LLInventoryFilterJob> job;
+		lockData();
+		if (!mQueue.empty())
+		{
+			job = mQueue.front();
+			mQueue.pop_front();
+		}
+		unlockData();
+
+		if (job.notNull() && !job->isCancelled())
+		{
+			job->run();
+		}
+	}
+	llinfos << "LLInventoryFilterEngine EXITING." << llendl;
+}
@@ -0,0 +1,144 @@
+/** 
+ * @file llinventoryfilterengine.h
+ * @brief Background evaluation of inventory filters against a flat item table.
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYFILTERENGINE_H
+#define LL_LLINVENTORYFILTERENGINE_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+#include "llapr.h"
+#include "llpermissionsflags.h"
+#include "llpointer.h"
+#include "llthread.h"
+#include "lluuid.h"
+
+class LLFolderViewItem;
+
+// One row per folder view entry. Everything the filter needs is copied
+// out on the main thread so the worker never touches views or the
+// inventory model.
+struct LLInventoryFilterRow
+{
+	LLUUID			mID;
+	std::string		mSearchableLabel;	// already upper case
+	S32				mInventoryType;
+	PermissionMask	mPermissions;
+	time_t			mCreationDate;
+	bool			mIsLink;
+};
+
+class LLInventoryFilterTable : public LLThreadSafeRefCount
+{
+public:
+	typedef std::vector<LLInventoryFilterRow> rows_t;
+
+	// Snapshot every item and folder currently in the folder view.
+	void build(const std::map<LLUUID, LLFolderViewItem*>& items);
+
+	const rows_t& getRows() const { return mRows; }
+
+private:
+	rows_t mRows;
+};
+
+// A single filter evaluation. Created on the main thread, run on the
+// worker, polled from the main thread. Superseded jobs are cancelled so
+// typing only ever pays for the latest keystroke.
+class LLInventoryFilterJob : public LLThreadSafeRefCount
+{
+public:
+	typedef boost::unordered_map<LLUUID, std::string::size_type> result_map_t;
+
+	struct Params
+	{
+		std::string		mSubString;
+		U32				mFilterTypes;
+		PermissionMask	mPermissions;
+		time_t			mEarliest;
+		time_t			mMaxDate;
+		bool			mOmitLinks;
+	};
+
+	LLInventoryFilterJob(LLInventoryFilterTable* table, const Params& params, S32 generation);
+
+	S32 getGeneration() const { return mGeneration; }
+	void cancel() { mCancelled = 1; }
+	bool isCancelled() { return mCancelled != 0; }
+	bool isDone() { return mDone != 0; }
+
+	// Passing ids mapped to their substring match offset. Only valid
+	// once isDone() returns true.
+	const result_map_t& getResults() const { return mResults; }
+
+	// Worker thread.
+	void run();
+
+private:
+	LLPointer<LLInventoryFilterTable> mTable;
+	Params			mParams;
+	S32				mGeneration;
+	LLAtomicU32		mCancelled;
+	LLAtomicU32		mDone;
+	result_map_t	mResults;
+};
+
+class LLInventoryFilterEngine : public LLThread
+{
+public:
+	static LLInventoryFilterEngine* getInstance();
+	static void cleanupClass();
+
+	// Queue a job, cancelling everything queued before it.
+	void post(LLInventoryFilterJob* job);
+
+	// Number of rows checked between cancellation polls.
+	static const S32 ROWS_PER_CANCEL_CHECK = 256;
+
+protected:
+	LLInventoryFilterEngine();
+	/*virtual*/ ~LLInventoryFilterEngine();
+
+	/*virtual*/ void run();
+	/*virtual*/ bool runCondition();
+
+private:
+	typedef std::deque<LLPointer<LLInventoryFilterJob> > job_queue_t;
+	job_queue_t mQueue;
+
+	static LLInventoryFilterEngine* sInstance;
+};
+
+#endif // LL_LLINVENTORYFILTERENGINE_H
@@ -158,6 +158,7 @@ LLInventoryModel gInventory;
 LLInventoryModel::LLInventoryModel()
 :	mModifyMask(LLInventoryObserver::ALL),
 	mChangedItemIDs(),
+	mReindexItemIDs(),
 	mCategoryMap(),
 	mItemMap(),
 	mCategoryLock(),
@@ -433,16 +434,15 @@ LLUUID LLInventoryModel::findCategoryByName(std::string name)
 	LLUUID root_id = gInventory.getRootFolderID();
 	if(root_id.notNull())
 	{
-		cat_array_t* cats = NULL;
-		cats = get_ptr_in_map(mParentChildCategoryTree, root_id);
-		if(cats)
+		const LLInventoryIndex::id_set_t* ids = mIndex.getCategoriesByName(name);
+		if(ids)
 		{
-			S32 count = cats->count();
-			for(S32 i = 0; i < count; ++i)
+			for(LLInventoryIndex::id_set_t::const_iterator it = ids->begin(); it != ids->end(); ++it)
 			{
-				if(cats->get(i)->getName() == name)
+				LLViewerInventoryCategory* cat = getCategory(*it);
+				if(cat && (cat->getParentUUID() == root_id) && (cat->getName() == name))
 				{
-					return cats->get(i)->getUUID();
+					return cat->getUUID();
 				}
 			}
 		}
@@ -450,6 +450,34 @@ LLUUID LLInventoryModel::findCategoryByName(std::string name)
 	return LLUUID::null;
 }
 
+void LLInventoryModel::appendIndexedItems(const LLInventoryIndex::id_set_t* ids, item_array_t& items) const
+{
+	if (!ids) return;
+	for (LLInventoryIndex::id_set_t::const_iterator it = ids->begin(); it != ids->end(); ++it)
+	{
+		item_map_t::const_iterator iter = mItemMap.find(*it);
+		if (iter != mItemMap.end())
+		{
+			items.put(iter->second);
+		}
+	}
+}
+
+void LLInventoryModel::findItemsByAssetID(const LLUUID& asset_id, item_array_t& items) const
+{
+	appendIndexedItems(mIndex.getItemsByAsset(asset_id), items);
+}
+
+void LLInventoryModel::findItemsByType(LLInventoryType::EType inv_type, item_array_t& items) const
+{
+	appendIndexedItems(mIndex.getItemsByType(inv_type), items);
+}
+
+void LLInventoryModel::findLinksTo(const LLUUID& target_id, item_array_t& items) const
+{
+	appendIndexedItems(mIndex.getLinksTo(target_id), items);
+}
+
 class LLCreateInventoryCategoryResponder : public LLHTTPClient::Responder
 {
 public:
@@ -705,33 +733,21 @@ void LLInventoryModel::addChangedMaskForLinks(const LLUUID& object_id, U32 mask)
 	if (!obj || obj->getIsLinkType())
 		return;
 
-	LLInventoryModel::cat_array_t cat_array;
-	LLInventoryModel::item_array_t item_array;
-	LLLinkedItemIDMatches is_linked_item_match(object_id);
-	collectDescendentsIf(gInventory.getRootFolderID(),
-						 cat_array,
-						 item_array,
-						 LLInventoryModel::INCLUDE_TRASH,
-						 is_linked_item_match);
-	if (cat_array.empty() && item_array.empty())
+	// Only links can point at an object, so the link target index gives
+	// us everything LLLinkedItemIDMatches would have found.
+	const LLInventoryIndex::id_set_t* link_ids = mIndex.getLinksTo(object_id);
+	if (!link_ids || link_ids->empty())
 	{
 		return;
 	}
-	for (LLInventoryModel::cat_array_t::iterator cat_iter = cat_array.begin();
-		 cat_iter != cat_array.end();
-		 cat_iter++)
-	{
-		LLViewerInventoryCategory *linked_cat = (*cat_iter);
-		addChangedMask(mask, linked_cat->getUUID());
-	};
-
-	for (LLInventoryModel::item_array_t::iterator iter = item_array.begin();
-		 iter != item_array.end();
-		 iter++)
+	// Copy first; addChangedMask() may reindex and invalidate the set.
+	uuid_vec_t linked_ids(link_ids->begin(), link_ids->end());
+	for (uuid_vec_t::const_iterator iter = linked_ids.begin();
+		 iter != linked_ids.end();
+		 ++iter)
 	{
-		LLViewerInventoryItem *linked_item = (*iter);
-		addChangedMask(mask, linked_item->getUUID());
-	};
+		addChangedMask(mask, *iter);
+	}
 }
 
 const LLUUID& LLInventoryModel::getLinkedItemID(const LLUUID& object_id) const
@@ -756,13 +772,16 @@ LLInventoryModel::item_array_t LLInventoryModel::collectLinkedItems(const LLUUID
 																	const LLUUID& start_folder_id)
 {
 	item_array_t items;
-	LLInventoryModel::cat_array_t cat_array;
-	LLLinkedItemIDMatches is_linked_item_match(id);
-	collectDescendentsIf((start_folder_id == LLUUID::null ? gInventory.getRootFolderID() : start_folder_id),
-						 cat_array,
-						 items,
-						 LLInventoryModel::INCLUDE_TRASH,
-						 is_linked_item_match);
+	item_array_t links;
+	findLinksTo(id, links);
+	const LLUUID& folder_id = (start_folder_id == LLUUID::null ? gInventory.getRootFolderID() : start_folder_id);
+	for (item_array_t::iterator iter = links.begin(); iter != links.end(); ++iter)
+	{
+		if (isObjectDescendentOf((*iter)->getUUID(), folder_id))
+		{
+			items.put(*iter);
+		}
+	}
 	return items;
 }
 
@@ -930,6 +949,10 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item)
 		mask |= LLInventoryObserver::GESTURE;
 	}
 	addChangedMask(mask, new_item->getUUID());
+	if (old_item)
+	{
+		reindexObject(new_item->getUUID());
+	}
 	return mask;
 }
 
@@ -997,6 +1020,7 @@ void LLInventoryModel::updateCategory(const LLViewerInventoryCategory* cat)
 		}
 		old_cat->copyViewerCategory(cat);
 		addChangedMask(mask, cat->getUUID());
+		reindexObject(cat->getUUID());
 	}
 	else
 	{
@@ -1081,6 +1105,7 @@ void LLInventoryModel::deleteObject(const LLUUID& id)
 	LLUUID parent_id = obj->getParentUUID();
 	mCategoryMap.erase(id);
 	mItemMap.erase(id);
+	mIndex.removeObject(id);
 	//mInventory.erase(id);
 	item_array_t* item_list = getUnlockedItemArray(parent_id);
 	if(item_list)
@@ -1224,6 +1249,17 @@ void LLInventoryModel::notifyObservers()
 		return;
 	}
 
+	// Some callers post the change before modifying the object (see
+	// LLAgentWearables::addWearabletoAgentInventoryDone()), so index the final state.
+	changed_items_t reindex_ids;
+	reindex_ids.swap(mReindexItemIDs);
+	for (changed_items_t::const_iterator iter = reindex_ids.begin();
+		 iter != reindex_ids.end();
+		 ++iter)
+	{
+		reindexObject(*iter);
+	}
+
 	mIsNotifyObservers = TRUE;
 	for (observer_list_t::iterator iter = mObservers.begin();
 		 iter != mObservers.end(); )
@@ -1241,6 +1277,22 @@ void LLInventoryModel::notifyObservers()
 	mIsNotifyObservers = FALSE;
 }
 
+void LLInventoryModel::reindexObject(const LLUUID& id)
+{
+	mReindexItemIDs.erase(id);
+	item_map_t::const_iterator item_it = mItemMap.find(id);
+	if (item_it != mItemMap.end())
+	{
+		mIndex.addItem(item_it->second);
+		return;
+	}
+	cat_map_t::const_iterator cat_it = mCategoryMap.find(id);
+	if (cat_it != mCategoryMap.end())
+	{
+		mIndex.addCategory(cat_it->second);
+	}
+}
+
 // store flag for change
 // and id of object change applies to
 void LLInventoryModel::addChangedMask(U32 mask, const LLUUID& referent) 
@@ -1258,6 +1310,14 @@ void LLInventoryModel::addChangedMask(U32 mask, const LLUUID& referent)
 	{
 		mChangedItemIDs.insert(referent);
 	}
+
+	// Objects are renamed (e.g. calling cards) or get a new asset id
+	// (e.g. saved wearables) in place. New objects were indexed when
+	// they were added.
+	if ((mask & (LLInventoryObserver::LABEL | LLInventoryObserver::INTERNAL)) && referent.notNull())
+	{
+		mReindexItemIDs.insert(referent);
+	}
 	
 	// Update all linked items.  Starting with just LABEL because I'm
 	// not sure what else might need to be accounted for this.
@@ -1420,6 +1480,7 @@ void LLInventoryModel::addCategory(LLViewerInventoryCategory* category)
 		}
 		// Insert category uniquely into the map
 		mCategoryMap[category->getUUID()] = category; // LLPointer will deref and delete the old one
+		mIndex.addCategory(category);
 		//mInventory[category->getUUID()] = category;
 	}
 }
@@ -1447,6 +1508,7 @@ void LLInventoryModel::addItem(LLViewerInventoryItem* item)
 		}
 
 		mItemMap[item->getUUID()] = item;
+		mIndex.addItem(item);
 	}
 }
 
@@ -1466,6 +1528,7 @@ void LLInventoryModel::empty()
 	mParentChildItemTree.clear();
 	mCategoryMap.clear(); // remove all references (should delete entries)
 	mItemMap.clear(); // remove all references (should delete entries)
+	mIndex.clear();
 	mLastItem = NULL;
 	//mInventory.clear();
 }
@@ -37,6 +37,7 @@
 #include "llfoldertype.h"
 #include "lldarray.h"
 #include "llhttpclient.h"
+#include "llinventoryindex.h"
 #include "lluuid.h"
 #include "llpermissionsflags.h"
 #include "llstring.h"
@@ -164,6 +165,11 @@ private:
 	typedef std::map<LLUUID, item_array_t*> parent_item_map_t;
 	parent_cat_map_t mParentChildCategoryTree;
 	parent_item_map_t mParentChildItemTree;
+	// Secondary indexes (asset id, type, link target, category name) kept
+	// in sync by addItem/addCategory/updateItem/updateCategory/deleteObject.
+	// Objects changed in place by anyone else are reindexed once, at the
+	// next notifyObservers().
+	LLInventoryIndex mIndex;
 
 	//--------------------------------------------------------------------
 	// Login
@@ -268,7 +274,19 @@ public:
 	LLViewerInventoryItem* getLinkedItem(const LLUUID& object_id) const;
 	
 	LLUUID findCategoryByName(std::string name);
+
+	// Indexed lookups over the whole model (including the library). These
+	// don't walk the category tree. Links are only returned by
+	// findLinksTo(). Results are appended to the array provided.
+	void findItemsByAssetID(const LLUUID& asset_id, item_array_t& items) const;
+	void findItemsByType(LLInventoryType::EType inv_type, item_array_t& items) const;
+	void findLinksTo(const LLUUID& target_id, item_array_t& items) const;
 private:
+	void appendIndexedItems(const LLInventoryIndex::id_set_t* ids, item_array_t& items) const;
+	// Re-reads the indexed fields of an item or category after an in place
+	// change, and drops it from mReindexItemIDs.
+	void reindexObject(const LLUUID& id);
+
 	mutable LLPointer<LLViewerInventoryItem> mLastItem; // cache recent lookups	
 
 	//--------------------------------------------------------------------
@@ -463,6 +481,7 @@ private:
 	// Variables used to track what has changed since the last notify.
 	U32 mModifyMask;
 	changed_items_t mChangedItemIDs;
+	changed_items_t mReindexItemIDs; // changed in place, reindexed at the next notify
 	
 	//--------------------------------------------------------------------
 	// Observers
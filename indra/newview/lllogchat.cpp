@@ -38,7 +38,30 @@
 #include "llfloaterchat.h"
 #include "llviewercontrol.h"
 
-const S32 LOG_RECALL_SIZE = 2048;
+const S32 LOG_RECALL_LINES = 30;
+
+static LLLogChatIndexer* sIndexer = NULL;
+
+// Starts the indexing thread on first use, and has it catch up on every
+// transcript of the account once.
+static LLLogChatIndexer* get_indexer()
+{
+	const std::string& dir = gDirUtilp->getPerAccountChatLogsDir();
+	if (dir.empty())
+	{
+		return NULL;
+	}
+	if (!sIndexer)
+	{
+		sIndexer = new LLLogChatIndexer;
+	}
+	if (sIndexer->mScannedDir != dir)
+	{
+		sIndexer->mScannedDir = dir;
+		sIndexer->index(dir, LLStringUtil::null, 0);
+	}
+	return sIndexer;
+}
 
 //static
 std::string LLLogChat::makeLogFileName(std::string filename)
@@ -98,6 +121,25 @@ std::string LLLogChat::timestamp(bool withdate)
 }
 
 
+//static
+void LLLogChat::cleanupClass()
+{
+	// Queued requests are dropped; the indexes catch up from the
+	// transcripts next session.
+	delete sIndexer;
+	sIndexer = NULL;
+}
+
+//static
+void LLLogChat::queueIndexing(const std::string& log_name)
+{
+	LLLogChatIndexer* indexer = get_indexer();
+	if (indexer)
+	{
+		indexer->index(gDirUtilp->getPerAccountChatLogsDir(), gDirUtilp->getBaseFileName(log_name), (U32)time(NULL));
+	}
+}
+
 //static
 void LLLogChat::saveHistory(std::string filename, std::string line)
 {
@@ -107,17 +149,17 @@ void LLLogChat::saveHistory(std::string filename, std::string line)
 		return;
 	}
 
-	LLFILE* fp = LLFile::fopen(LLLogChat::makeLogFileName(filename), "a"); 		/*Flawfinder: ignore*/
+	std::string log_name = LLLogChat::makeLogFileName(filename);
+	LLFILE* fp = LLFile::fopen(log_name, "a"); 		/*Flawfinder: ignore*/
 	if (!fp)
 	{
 		llinfos << "Couldn't open chat history log!" << llendl;
+		return;
 	}
-	else
-	{
-		fprintf(fp, "%s\n", line.c_str());
-		
-		fclose (fp);
-	}
+	fprintf(fp, "%s\n", line.c_str());
+	fclose (fp);
+
+	queueIndexing(log_name);
 }
 
 void LLLogChat::loadHistory(std::string filename , void (*callback)(ELogLineType,std::string,void*), void* userdata)
@@ -128,47 +170,28 @@ void LLLogChat::loadHistory(std::string filename , void (*callback)(ELogLineType
 		return ;
 	}
 
-	LLFILE* fptr = LLFile::fopen(makeLogFileName(filename), "r");		/*Flawfinder: ignore*/
-	if (!fptr)
+	std::deque<std::string> lines;
+	if (!LLLogChatIndexer::readRecentLines(makeLogFileName(filename), LOG_RECALL_LINES, lines))
 	{
 		//LLUIString message = LLFloaterChat::getInstance()->getString("IM_logging_string");
 		//callback(LOG_EMPTY,"IM_logging_string",userdata);
 		callback(LOG_EMPTY,LLStringUtil::null,userdata);
 		return;			//No previous conversation with this name.
 	}
-	else
+	for (std::deque<std::string>::const_iterator iter = lines.begin(); iter != lines.end(); ++iter)
+	{
+		callback(LOG_LINE,*iter,userdata);
+	}
+	callback(LOG_END,LLStringUtil::null,userdata);
+}
+
+//static
+void LLLogChat::searchHistory(const std::string& query, std::vector<LLLogChatMatch>& matches, S32 max_matches)
+{
+	matches.clear();
+	LLLogChatIndexer* indexer = get_indexer();
+	if (indexer)
 	{
-		char buffer[LOG_RECALL_SIZE];		/*Flawfinder: ignore*/
-		char *bptr;
-		S32 len;
-		bool firstline=TRUE;
-
-		if ( fseek(fptr, (LOG_RECALL_SIZE - 1) * -1  , SEEK_END) )		
-		{	//File is smaller than recall size.  Get it all.
-			firstline = FALSE;
-			if ( fseek(fptr, 0, SEEK_SET) )
-			{
-				fclose(fptr);
-				return;
-			}
-		}
-
-		while ( fgets(buffer, LOG_RECALL_SIZE, fptr)  && !feof(fptr) ) 
-		{
-			len = strlen(buffer) - 1;		/*Flawfinder: ignore*/
-			for ( bptr = (buffer + len); (*bptr == '\n' || *bptr == '\r') && bptr>buffer; bptr--)	*bptr='\0';
-			
-			if (!firstline)
-			{
-				callback(LOG_LINE,std::string(buffer),userdata);
-			}
-			else
-			{
-				firstline = FALSE;
-			}
-		}
-		callback(LOG_END,LLStringUtil::null,userdata);
-		
-		fclose(fptr);
+		indexer->search(gDirUtilp->getPerAccountChatLogsDir(), query, matches, max_matches);
 	}
 }
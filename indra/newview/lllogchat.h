@@ -34,6 +34,8 @@
 #ifndef LL_LLLOGCHAT_H
 #define LL_LLLOGCHAT_H
 
+#include "lllogchatindex.h"
+
 class LLLogChat
 {
 public:
@@ -43,14 +45,27 @@ public:
 		LOG_LINE,
 		LOG_END
 	};
+
+	// One line of a transcript found by searchHistory().
+	typedef LLLogChatIndexer::Match LLLogChatMatch;
+
 	static std::string timestamp(bool withdate = false);
 	static std::string makeLogFileName(std::string(filename));
 	static void saveHistory(std::string filename, std::string line);
 	static void loadHistory(std::string filename, 
 		                    void (*callback)(ELogLineType,std::string,void*), 
 							void* userdata);
+	// Finds the most recent transcript lines, across all conversations,
+	// containing every word of query. Lines the indexing thread hasn't
+	// reached yet are not found.
+	static void searchHistory(const std::string& query, std::vector<LLLogChatMatch>& matches, S32 max_matches = 100);
+	// Stops the indexing thread. Whatever it didn't get to is picked up
+	// next session.
+	static void cleanupClass();
+
 private:
 	static std::string cleanFileName(std::string filename);
+	static void queueIndexing(const std::string& log_name);
 };
 
 #endif
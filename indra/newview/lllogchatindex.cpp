@@ -0,0 +1,729 @@
+/** 
+ * @file lllogchatindex.cpp
+ * @brief Line and word indexes of the chat and IM transcripts
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include "lllogchatindex.h"
+#include "lldir.h"
+#include "lldiriterator.h"
+
+const S32 LOG_RECALL_SIZE = 2048;
+// readRecentLines() only reads on past the line index this far; further
+// behind, it reads the tail of the transcript instead.
+const long MAX_UNINDEXED_RECALL_SIZE = 64 * 1024;
+const std::string WORD_INDEX_FILE_NAME("chat_words.idx");
+const std::string WORD_JOURNAL_FILE_NAME("chat_words.new");
+const std::string WORD_INDEX_TEMP_FILE_NAME("chat_words.tmp");
+const std::string::size_type MIN_WORD_LENGTH = 2;
+const std::string::size_type MAX_WORD_LENGTH = 32;
+// Lines indexed between writes to the index files.
+const U32 INDEX_BATCH_LINES = 256;
+// The journal is merged into the word index once it reaches this size, or
+// a sixteenth of the word index if that is larger.
+const long MIN_JOURNAL_MERGE_SIZE = 256 * 1024;
+
+// Each transcript "name.txt" has a sidecar "name.idx" holding one of these
+// per physical line, so the tail of a transcript or any numbered line can
+// be found with a single seek. A message with embedded newlines takes
+// several lines, just as LLLogChat::loadHistory() shows it.
+struct line_record_t
+{
+	U32 mOffset;
+	U32 mTime;
+};
+
+// Words are indexed in two per-account files of "word<tab>file<tab>line"
+// postings. chat_words.idx is kept sorted and free of duplicates, so the
+// postings of a word are found by binary search without loading the file.
+// New postings are appended to the chat_words.new journal, which the
+// indexing thread merges into chat_words.idx when it has nothing else to do.
+
+// Reads one whole line of any length, without its line ending. terminated,
+// if given, is set to whether the line was ended by a newline rather than
+// by the end of the file.
+static bool read_log_line(LLFILE* fp, std::string& line, bool* terminated = NULL)
+{
+	char buffer[LOG_RECALL_SIZE];		/*Flawfinder: ignore*/
+	line.clear();
+	while (fgets(buffer, LOG_RECALL_SIZE, fp))
+	{
+		line += buffer;
+		if (line[line.size() - 1] == '\n')
+		{
+			break;
+		}
+	}
+	if (line.empty())
+	{
+		return false;
+	}
+	if (terminated)
+	{
+		*terminated = line[line.size() - 1] == '\n';
+	}
+	while (!line.empty() && (line[line.size() - 1] == '\n' || line[line.size() - 1] == '\r'))
+	{
+		line.erase(line.size() - 1);
+	}
+	return true;
+}
+
+static bool read_line_record(LLFILE* index_fp, S32 line, line_record_t& record)
+{
+	return !fseek(index_fp, line * (long)sizeof(line_record_t), SEEK_SET)
+		&& fread(&record, sizeof(line_record_t), 1, index_fp) == 1;
+}
+
+static bool is_line_start(LLFILE* fp, U32 offset)
+{
+	return !offset || (!fseek(fp, offset - 1, SEEK_SET) && fgetc(fp) == '\n');
+}
+
+static std::string make_index_file_name(const std::string& log_name)
+{
+	return log_name.substr(0, log_name.size() - 4) + ".idx";
+}
+
+// Returns the number of lines of the transcript covered by its sidecar
+// index, or 0 if there is no index or it doesn't fit the transcript. end is
+// set to the offset just past the last covered line.
+static S32 check_line_index(LLFILE* log_fp, const std::string& index_name, long& end)
+{
+	end = 0;
+	llstat index_stat;
+	if (LLFile::stat(index_name, &index_stat)
+		|| index_stat.st_size == 0
+		|| index_stat.st_size % sizeof(line_record_t))
+	{
+		return 0;
+	}
+
+	S32 line_count = index_stat.st_size / sizeof(line_record_t);
+	line_record_t record;
+	LLFILE* index_fp = LLFile::fopen(index_name, "rb");		/*Flawfinder: ignore*/
+	bool valid = index_fp && read_line_record(index_fp, line_count - 1, record);
+	if (index_fp)
+	{
+		fclose(index_fp);
+	}
+
+	std::string line;
+	bool terminated = false;
+	if (!valid
+		|| !is_line_start(log_fp, record.mOffset)
+		|| fseek(log_fp, record.mOffset, SEEK_SET)
+		|| !read_log_line(log_fp, line, &terminated)
+		|| !terminated)
+	{
+		return 0;
+	}
+	end = ftell(log_fp);
+	return line_count;
+}
+
+static bool newer_match(const LLLogChatIndexer::Match& a, const LLLogChatIndexer::Match& b)
+{
+	if (a.mTime != b.mTime)
+	{
+		return a.mTime > b.mTime;
+	}
+	return a.mLine > b.mLine;
+}
+
+// Lower-cased words of text worth indexing. Bytes above 0x7f count as word
+// characters so UTF-8 names and words stay whole.
+static void split_words(const std::string& text, std::set<std::string>& words)
+{
+	std::string word;
+	bool has_letter = false;
+	for (std::string::size_type i = 0; i <= text.size(); i++)
+	{
+		unsigned char c = i < text.size() ? (unsigned char)text[i] : 0;
+		if (c >= 0x80 || isalnum(c))
+		{
+			has_letter = has_letter || !isdigit(c);
+			word += (char)tolower(c);
+			continue;
+		}
+		// Skip bare numbers such as timestamps.
+		if (has_letter && word.size() >= MIN_WORD_LENGTH && word.size() <= MAX_WORD_LENGTH)
+		{
+			words.insert(word);
+		}
+		word.clear();
+		has_letter = false;
+	}
+}
+
+static bool parse_posting(const std::string& posting, std::string& file_name, S32& line)
+{
+	std::string::size_type word_end = posting.find('\t');
+	std::string::size_type file_end = posting.rfind('\t');
+	if (word_end == std::string::npos || file_end == word_end)
+	{
+		return false;
+	}
+	file_name = posting.substr(word_end + 1, file_end - word_end - 1);
+	line = atoi(posting.c_str() + file_end + 1);
+	return true;
+}
+
+// Returns the offset of the first line of the sorted file fp that is not
+// less than key. Bisects on byte offsets, resyncing to the next line start.
+static long find_first_line(LLFILE* fp, long size, const std::string& key)
+{
+	long lo = 0;	// always a line start
+	long hi = size;
+	std::string line;
+	while (lo < hi)
+	{
+		long mid = lo + (hi - lo) / 2;
+		long start = mid;
+		if (mid > lo)
+		{
+			fseek(fp, mid - 1, SEEK_SET);
+			read_log_line(fp, line);
+			start = ftell(fp);
+		}
+		if (start >= hi)
+		{
+			// No line starts in [mid, hi), step past lo instead.
+			start = lo;
+		}
+		fseek(fp, start, SEEK_SET);
+		if (read_log_line(fp, line) && line < key)
+		{
+			lo = ftell(fp);
+		}
+		else
+		{
+			hi = start;
+		}
+	}
+	return lo;
+}
+
+//----------------------------------------------------------------------------
+
+LLLogChatIndexer::LLLogChatIndexer(bool threaded) :
+	LLQueuedThread("Chat Log Indexer", threaded),
+	mMinJournalMergeSize(MIN_JOURNAL_MERGE_SIZE)
+{
+}
+
+void LLLogChatIndexer::index(const std::string& dir, const std::string& file_name, U32 time)
+{
+	// Newly saved lines go ahead of the catch up on old transcripts, so
+	// they are indexed with their time.
+	U32 priority = file_name.empty() ? PRIORITY_LOW : PRIORITY_NORMAL;
+	if (!addRequest(new Request(this, generateHandle(), priority, dir, file_name, time)))
+	{
+		llwarns << "LLLogChatIndexer::index called after LLLogChat::cleanupClass()" << llendl;
+	}
+}
+
+bool LLLogChatIndexer::Request::processRequest()
+{
+	if (mFileName.empty())
+	{
+		mIndexer->catchUpAll(mDir);
+	}
+	else
+	{
+		mIndexer->catchUp(mDir, mFileName, mTime);
+	}
+	// Merging waits for the queue to drain, so catching up on many
+	// transcripts merges once.
+	if (!mIndexer->getPending() && !mIndexer->isQuitting())
+	{
+		mIndexer->mergeJournal(mDir);
+	}
+	return true;
+}
+
+// Indexes the lines of a transcript past what its sidecar index covers,
+// rebuilding the index if it doesn't fit the transcript. Returns the number
+// of lines indexed.
+S32 LLLogChatIndexer::catchUp(const std::string& dir, const std::string& file_name, U32 time)
+{
+	std::string log_name = dir + gDirUtilp->getDirDelimiter() + file_name;
+	std::string index_name = make_index_file_name(log_name);
+	llstat log_stat;
+	if (LLFile::stat(log_name, &log_stat) || log_stat.st_size == 0)
+	{
+		mFiles.erase(file_name);
+		if (LLFile::isfile(index_name))
+		{
+			LLFile::remove(index_name);
+		}
+		return 0;
+	}
+
+	// Trust what we know about the transcript only while it and its sidecar
+	// index haven't changed behind our back.
+	std::map<std::string, file_state_t>::iterator state_iter = mFiles.find(file_name);
+	llstat index_stat;
+	bool known = state_iter != mFiles.end()
+		&& state_iter->second.mEnd <= (long)log_stat.st_size
+		&& !LLFile::stat(index_name, &index_stat)
+		&& (long)index_stat.st_size == state_iter->second.mLines * (long)sizeof(line_record_t);
+	if (known && state_iter->second.mEnd == (long)log_stat.st_size)
+	{
+		return 0;
+	}
+
+	LLFILE* log_fp = LLFile::fopen(log_name, "rb");		/*Flawfinder: ignore*/
+	if (!log_fp)
+	{
+		return 0;
+	}
+	if (!known)
+	{
+		// First look at this transcript, or it was replaced: go by what
+		// the sidecar index still covers.
+		file_state_t state;
+		state.mLines = check_line_index(log_fp, index_name, state.mEnd);
+		state_iter = mFiles.insert(std::make_pair(file_name, state)).first;
+		state_iter->second = state;
+	}
+	file_state_t& state = state_iter->second;
+
+	LLFILE* index_fp = LLFile::fopen(index_name, state.mLines ? "ab" : "wb");		/*Flawfinder: ignore*/
+	if (!index_fp)
+	{
+		llwarns << "Couldn't write chat history index " << index_name << llendl;
+		fclose(log_fp);
+		mFiles.erase(state_iter);
+		return 0;
+	}
+	if (!state.mLines)
+	{
+		// Rebuilding; when the old lines were logged is unknown.
+		time = 0;
+	}
+
+	// Postings go out before the line records, so an interrupted batch is
+	// indexed again rather than lost. Merging drops the duplicates.
+	S32 indexed = 0;
+	std::vector<line_record_t> records;
+	std::string postings;
+	std::string line;
+	bool terminated = false;
+	bool done = fseek(log_fp, state.mEnd, SEEK_SET) != 0;
+	long line_start = state.mEnd;
+	line_record_t record;
+	record.mTime = time;
+	while (!done)
+	{
+		if (line_start < 0 || (unsigned long)line_start > U32_MAX)
+		{
+			// Line records hold 32 bit offsets. Lines past 4GB stay out of
+			// the indexes; readRecentLines() reads the tail without them.
+			LL_WARNS_ONCE("ChatLog") << "Chat history " << log_name << " is too large to index past line "
+									 << state.mLines + (S32)records.size() << LL_ENDL;
+			done = true;
+		}
+		// A line without its newline is still being written.
+		done = done || isQuitting() || !read_log_line(log_fp, line, &terminated) || !terminated;
+		if (!done)
+		{
+			std::set<std::string> words;
+			split_words(line, words);
+			std::string posting_end = llformat("\t%s\t%d\n", file_name.c_str(), state.mLines + (S32)records.size());
+			for (std::set<std::string>::const_iterator iter = words.begin(); iter != words.end(); ++iter)
+			{
+				postings += *iter + posting_end;
+			}
+			record.mOffset = (U32)line_start;
+			records.push_back(record);
+			line_start = ftell(log_fp);
+		}
+		if (!records.empty() && (done || records.size() == INDEX_BATCH_LINES))
+		{
+			appendPostings(dir, postings);
+			if (fwrite(&records[0], sizeof(line_record_t), records.size(), index_fp) != records.size())
+			{
+				llwarns << "Couldn't write chat history index " << index_name << llendl;
+				mFiles.erase(state_iter);
+				break;
+			}
+			state.mLines += records.size();
+			state.mEnd = line_start;
+			indexed += records.size();
+			records.clear();
+			postings.clear();
+		}
+	}
+
+	fclose(index_fp);
+	fclose(log_fp);
+	return indexed;
+}
+
+void LLLogChatIndexer::catchUpAll(const std::string& dir)
+{
+	S32 indexed = 0;
+	LLDirIterator iter(dir, "*.txt");
+	std::string name;
+	while (!isQuitting() && iter.next(name))
+	{
+		indexed += catchUp(dir, name, 0);
+	}
+	if (indexed)
+	{
+		llinfos << "Indexed " << indexed << " lines of chat history" << llendl;
+	}
+}
+
+void LLLogChatIndexer::appendPostings(const std::string& dir, const std::string& postings)
+{
+	if (postings.empty())
+	{
+		return;
+	}
+	LLMutexLock lock(&mWordIndexMutex);
+	LLFILE* journal_fp = LLFile::fopen(dir + gDirUtilp->getDirDelimiter() + WORD_JOURNAL_FILE_NAME, "ab");		/*Flawfinder: ignore*/
+	if (journal_fp)
+	{
+		fwrite(postings.data(), 1, postings.size(), journal_fp);
+		fclose(journal_fp);
+	}
+}
+
+// Whether a posting still names a line of an existing transcript.
+bool LLLogChatIndexer::isPostingLive(const std::string& dir, const std::string& posting, std::map<std::string, S32>& line_counts)
+{
+	std::string file_name;
+	S32 line;
+	if (!parse_posting(posting, file_name, line))
+	{
+		return false;
+	}
+	std::map<std::string, S32>::iterator iter = line_counts.find(file_name);
+	if (iter == line_counts.end())
+	{
+		std::string log_name = dir + gDirUtilp->getDirDelimiter() + file_name;
+		llstat index_stat;
+		S32 line_count = 0;
+		if (LLFile::isfile(log_name))
+		{
+			// Keep everything if the sidecar index is still to be rebuilt.
+			line_count = LLFile::stat(make_index_file_name(log_name), &index_stat)
+				? S32_MAX : index_stat.st_size / sizeof(line_record_t);
+		}
+		iter = line_counts.insert(std::make_pair(file_name, line_count)).first;
+	}
+	return line >= 0 && line < iter->second;
+}
+
+// Merges the journal into the word index once it has grown enough. Both
+// are sorted, so the merge streams the index and holds only the journal in
+// memory. Duplicate postings and postings of lines that are gone are
+// dropped on the way.
+void LLLogChatIndexer::mergeJournal(const std::string& dir)
+{
+	std::string prefix = dir + gDirUtilp->getDirDelimiter();
+	std::string index_name = prefix + WORD_INDEX_FILE_NAME;
+	std::string journal_name = prefix + WORD_JOURNAL_FILE_NAME;
+	std::string temp_name = prefix + WORD_INDEX_TEMP_FILE_NAME;
+	llstat journal_stat;
+	llstat index_stat;
+	if (LLFile::stat(journal_name, &journal_stat))
+	{
+		return;
+	}
+	long index_size = LLFile::stat(index_name, &index_stat) ? 0 : (long)index_stat.st_size;
+	if ((long)journal_stat.st_size < llmax(mMinJournalMergeSize, index_size / 16))
+	{
+		return;
+	}
+
+	// Only this thread writes the journal, so it can be read unlocked.
+	std::vector<std::string> journal;
+	std::string posting;
+	LLFILE* journal_fp = LLFile::fopen(journal_name, "rb");		/*Flawfinder: ignore*/
+	if (!journal_fp)
+	{
+		return;
+	}
+	while (read_log_line(journal_fp, posting))
+	{
+		journal.push_back(posting);
+	}
+	fclose(journal_fp);
+	std::sort(journal.begin(), journal.end());
+
+	LLFILE* temp_fp = LLFile::fopen(temp_name, "wb");		/*Flawfinder: ignore*/
+	if (!temp_fp)
+	{
+		llwarns << "Couldn't write chat history word index " << temp_name << llendl;
+		return;
+	}
+	LLFILE* index_fp = LLFile::fopen(index_name, "rb");		/*Flawfinder: ignore*/
+
+	std::map<std::string, S32> line_counts;
+	std::vector<std::string>::const_iterator next = journal.begin();
+	std::string indexed;
+	std::string last;
+	bool have_indexed = index_fp && read_log_line(index_fp, indexed);
+	bool ok = true;
+	while (ok && (have_indexed || next != journal.end()))
+	{
+		if (have_indexed && (next == journal.end() || indexed < *next))
+		{
+			posting.swap(indexed);
+			have_indexed = read_log_line(index_fp, indexed);
+		}
+		else
+		{
+			posting = *next++;
+		}
+		if (posting != last && isPostingLive(dir, posting, line_counts))
+		{
+			ok = fprintf(temp_fp, "%s\n", posting.c_str()) >= 0 && !isQuitting();
+			last = posting;
+		}
+	}
+
+	if (index_fp)
+	{
+		fclose(index_fp);
+	}
+	if (fclose(temp_fp) || !ok)
+	{
+		if (!isQuitting())
+		{
+			llwarns << "Couldn't write chat history word index " << temp_name << llendl;
+		}
+		LLFile::remove(temp_name);
+		return;
+	}
+
+	LLMutexLock lock(&mWordIndexMutex);
+	LLFile::remove(index_name);
+	if (LLFile::rename(temp_name, index_name))
+	{
+		llwarns << "Couldn't replace chat history word index " << index_name << llendl;
+		return;
+	}
+	LLFile::remove(journal_name);
+}
+
+//static
+bool LLLogChatIndexer::readRecentLines(const std::string& log_name, S32 max_lines, std::deque<std::string>& lines)
+{
+	lines.clear();
+	LLFILE* log_fp = LLFile::fopen(log_name, "rb");		/*Flawfinder: ignore*/
+	if (!log_fp)
+	{
+		return false;
+	}
+
+	// Seek straight to the first recalled line if the index covers the
+	// transcript but for the few lines saved since it last caught up.
+	bool skip_partial_line = false;
+	long end = 0;
+	line_record_t record;
+	std::string index_name = make_index_file_name(log_name);
+	S32 line_count = check_line_index(log_fp, index_name, end);
+	LLFILE* index_fp = NULL;
+	if (line_count && !fseek(log_fp, 0, SEEK_END) && ftell(log_fp) - end <= MAX_UNINDEXED_RECALL_SIZE)
+	{
+		index_fp = LLFile::fopen(index_name, "rb");		/*Flawfinder: ignore*/
+	}
+	if (index_fp && read_line_record(index_fp, llmax(0, line_count - max_lines), record))
+	{
+		fseek(log_fp, record.mOffset, SEEK_SET);
+	}
+	else if (!fseek(log_fp, (LOG_RECALL_SIZE - 1) * -1, SEEK_END))
+	{
+		// No usable index, fall back to the tail of the file.
+		skip_partial_line = true;
+	}
+	else
+	{
+		fseek(log_fp, 0, SEEK_SET);
+	}
+	if (index_fp)
+	{
+		fclose(index_fp);
+	}
+
+	std::string line;
+	while (read_log_line(log_fp, line))
+	{
+		if (skip_partial_line)
+		{
+			skip_partial_line = false;
+			continue;
+		}
+		lines.push_back(line);
+		if ((S32)lines.size() > max_lines)
+		{
+			lines.pop_front();
+		}
+	}
+	fclose(log_fp);
+	return true;
+}
+
+// Collects the postings of word from the word index and the journal.
+void LLLogChatIndexer::findPostings(const std::string& dir, const std::string& word, std::vector<posting_t>& postings)
+{
+	std::string prefix = dir + gDirUtilp->getDirDelimiter();
+	std::string key = word + '\t';
+	std::string line;
+	posting_t posting;
+	LLMutexLock lock(&mWordIndexMutex);
+
+	LLFILE* index_fp = LLFile::fopen(prefix + WORD_INDEX_FILE_NAME, "rb");		/*Flawfinder: ignore*/
+	if (index_fp)
+	{
+		fseek(index_fp, 0, SEEK_END);
+		fseek(index_fp, find_first_line(index_fp, ftell(index_fp), key), SEEK_SET);
+		while (read_log_line(index_fp, line) && !line.compare(0, key.size(), key))
+		{
+			if (parse_posting(line, posting.first, posting.second))
+			{
+				postings.push_back(posting);
+			}
+		}
+		fclose(index_fp);
+	}
+
+	LLFILE* journal_fp = LLFile::fopen(prefix + WORD_JOURNAL_FILE_NAME, "rb");		/*Flawfinder: ignore*/
+	if (journal_fp)
+	{
+		while (read_log_line(journal_fp, line))
+		{
+			if (!line.compare(0, key.size(), key) && parse_posting(line, posting.first, posting.second))
+			{
+				postings.push_back(posting);
+			}
+		}
+		fclose(journal_fp);
+	}
+}
+
+void LLLogChatIndexer::search(const std::string& dir, const std::string& query, std::vector<Match>& matches, S32 max_matches)
+{
+	matches.clear();
+	std::set<std::string> words;
+	split_words(query, words);
+	if (words.empty() || max_matches <= 0)
+	{
+		return;
+	}
+
+	// Intersect the sorted posting lists of every query word.
+	std::vector<posting_t> hits;
+	for (std::set<std::string>::const_iterator iter = words.begin(); iter != words.end(); ++iter)
+	{
+		std::vector<posting_t> postings;
+		findPostings(dir, *iter, postings);
+		std::sort(postings.begin(), postings.end());
+		postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+		if (iter == words.begin())
+		{
+			hits.swap(postings);
+		}
+		else
+		{
+			std::vector<posting_t> both;
+			std::set_intersection(hits.begin(), hits.end(), postings.begin(), postings.end(), std::back_inserter(both));
+			hits.swap(both);
+		}
+		if (hits.empty())
+		{
+			return;
+		}
+	}
+
+	// Read back the newest hits of each transcript.
+	std::vector<posting_t>::const_iterator file_end = hits.end();
+	while (file_end != hits.begin())
+	{
+		const std::string& file_name = (file_end - 1)->first;
+		std::vector<posting_t>::const_iterator file_begin = file_end;
+		while (file_begin != hits.begin() && (file_begin - 1)->first == file_name)
+		{
+			--file_begin;
+		}
+
+		std::string log_name = dir + gDirUtilp->getDirDelimiter() + file_name;
+		LLFILE* log_fp = LLFile::fopen(log_name, "rb");		/*Flawfinder: ignore*/
+		LLFILE* index_fp = LLFile::fopen(make_index_file_name(log_name), "rb");		/*Flawfinder: ignore*/
+		S32 found = 0;
+		for (std::vector<posting_t>::const_iterator hit = file_end; log_fp && index_fp && hit != file_begin && found < max_matches; )
+		{
+			--hit;
+			Match match;
+			line_record_t record;
+			if (!read_line_record(index_fp, hit->second, record)
+				|| fseek(log_fp, record.mOffset, SEEK_SET)
+				|| !read_log_line(log_fp, match.mText))
+			{
+				continue;
+			}
+			// Postings can outlive a rewritten transcript; check the words are still there.
+			std::set<std::string> line_words;
+			split_words(match.mText, line_words);
+			if (!std::includes(line_words.begin(), line_words.end(), words.begin(), words.end()))
+			{
+				continue;
+			}
+			match.mFileName = file_name;
+			match.mLine = hit->second;
+			match.mTime = record.mTime;
+			matches.push_back(match);
+			found++;
+		}
+		if (log_fp)
+		{
+			fclose(log_fp);
+		}
+		if (index_fp)
+		{
+			fclose(index_fp);
+		}
+		file_end = file_begin;
+	}
+
+	std::sort(matches.begin(), matches.end(), newer_match);
+	if ((S32)matches.size() > max_matches)
+	{
+		matches.resize(max_matches);
+	}
+}
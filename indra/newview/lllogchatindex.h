@@ -0,0 +1,126 @@
+/** 
+ * @file lllogchatindex.h
+ * @brief Line and word indexes of the chat and IM transcripts
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLLOGCHATINDEX_H
+#define LL_LLLOGCHATINDEX_H
+
+#include <deque>
+#include <map>
+#include <vector>
+#include "llqueuedthread.h"
+
+// Keeps the line and word indexes of one account's transcripts in step
+// with them, off the main thread. Each request catches up on one
+// transcript, or on every transcript in the directory if it names none.
+// Indexing only ever reads the transcripts, so anything left undone is
+// redone from them later.
+class LLLogChatIndexer : public LLQueuedThread
+{
+public:
+	// One line of a transcript found by search().
+	struct Match
+	{
+		std::string mFileName;	// transcript file name, without directory
+		S32 mLine;				// line number within the transcript
+		U32 mTime;				// when the line was logged, 0 if unknown
+		std::string mText;
+	};
+
+	class Request : public QueuedRequest
+	{
+	protected:
+		virtual ~Request() {} // use deleteRequest()
+
+	public:
+		Request(LLLogChatIndexer* indexer, handle_t handle, U32 priority,
+				const std::string& dir, const std::string& file_name, U32 time) :
+			QueuedRequest(handle, priority, FLAG_AUTO_COMPLETE),
+			mIndexer(indexer),
+			mDir(dir),
+			mFileName(file_name),
+			mTime(time)
+		{
+		}
+
+		/*virtual*/ bool processRequest();
+
+	private:
+		LLLogChatIndexer* mIndexer;
+		std::string mDir;
+		std::string mFileName;
+		U32 mTime;	// logging time of lines not yet indexed, 0 if unknown
+	};
+
+	LLLogChatIndexer(bool threaded = true);
+	~LLLogChatIndexer() { shutdown(); } // before our members go away
+
+	// Called from MAIN THREAD.
+	void index(const std::string& dir, const std::string& file_name, U32 time);
+
+	// Finds the most recent lines of the transcripts in dir containing every
+	// word of query. Lines not indexed yet are not found.
+	void search(const std::string& dir, const std::string& query, std::vector<Match>& matches, S32 max_matches);
+
+	// Reads the last max_lines lines of a transcript, seeking to them with
+	// its line index and reading on past whatever the index doesn't cover
+	// yet. Returns false if there is no such transcript.
+	static bool readRecentLines(const std::string& log_name, S32 max_lines, std::deque<std::string>& lines);
+
+	// The journal is merged into the word index once it reaches this size.
+	void setMinJournalMergeSize(long size) { mMinJournalMergeSize = size; }
+
+	std::string mScannedDir; // MAIN THREAD only
+
+private:
+	typedef std::pair<std::string, S32> posting_t; // transcript file name, line number
+
+	struct file_state_t
+	{
+		S32 mLines;	// lines covered by the sidecar index
+		long mEnd;	// offset just past the last covered line
+	};
+
+	S32 catchUp(const std::string& dir, const std::string& file_name, U32 time);
+	void catchUpAll(const std::string& dir);
+	void appendPostings(const std::string& dir, const std::string& postings);
+	void mergeJournal(const std::string& dir);
+	bool isPostingLive(const std::string& dir, const std::string& posting, std::map<std::string, S32>& line_counts);
+	void findPostings(const std::string& dir, const std::string& word, std::vector<posting_t>& postings);
+
+	// By transcript file name; the directory only changes between sessions.
+	std::map<std::string, file_state_t> mFiles;
+	// Guards the word index and journal files against searches.
+	LLMutex mWordIndexMutex;
+	long mMinJournalMergeSize;
+};
+
+#endif
@@ -37,6 +37,7 @@
 #include "llcurl.h"
 #include "lldatapacker.h"
 #include "llfasttimer.h"
+#include "llhttpscheduler.h"
 #if MESH_IMPORT
 #include "llfloatermodelpreview.h"
 #endif //MESH_IMPORT
@@ -80,6 +81,13 @@ LLMeshRepository gMeshRepo;
 
 const U32 MAX_MESH_REQUESTS_PER_SECOND = 100;
 
+// Priorities of mesh fetches in the HTTP scheduler, where textures run
+// from 0 to 1 by decode priority. Headers come first since nothing else
+// about a mesh can be fetched without one.
+const F32 MESH_HEADER_HTTP_PRIORITY = 0.9f;
+const F32 MESH_LOD_HTTP_PRIORITY = 0.8f;
+const F32 MESH_INFO_HTTP_PRIORITY = 0.7f;
+
 // Maximum mesh version to support.  Three least significant digits are reserved for the minor version, 
 // with major version changes indicating a format change that is not backwards compatible and should not
 // be parsed by viewers that don't specifically support that version. For example, if the integer "1" is 
@@ -566,6 +574,7 @@ void LLMeshRepoThread::run()
 				mPhysicsShapeRequests = incomplete;
 			}
 
+			LLHTTPScheduler::getInstance()->update(mCurlRequest);
 			mCurlRequest->process();
 		}
 	}
@@ -583,6 +592,7 @@ void LLMeshRepoThread::run()
 	}
 #endif //MESH_IMPORT
 
+	LLHTTPScheduler::getInstance()->removeClient(mCurlRequest);
 	delete mCurlRequest;
 	mCurlRequest = NULL;
 }
@@ -717,8 +727,8 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id)
 			{
 				++sActiveLODRequests;
 				LLMeshRepository::sHTTPRequestCount++;
-				mCurlRequest->getByteRange(constructUrl(mesh_id), headers, offset, size,
-										   new LLMeshSkinInfoResponder(mesh_id, offset, size));
+				LLHTTPScheduler::getInstance()->getByteRange(mCurlRequest, constructUrl(mesh_id), headers, offset, size,
+										   MESH_INFO_HTTP_PRIORITY, new LLMeshSkinInfoResponder(mesh_id, offset, size));
 			}
 		}
 	}
@@ -790,8 +800,8 @@ bool LLMeshRepoThread::fetchMeshDecomposition(const LLUUID& mesh_id)
 			{
 				++sActiveLODRequests;
 				LLMeshRepository::sHTTPRequestCount++;
-				mCurlRequest->getByteRange(http_url, headers, offset, size,
-										   new LLMeshDecompositionResponder(mesh_id, offset, size));
+				LLHTTPScheduler::getInstance()->getByteRange(mCurlRequest, http_url, headers, offset, size,
+										   MESH_INFO_HTTP_PRIORITY, new LLMeshDecompositionResponder(mesh_id, offset, size));
 			}
 		}
 	}
@@ -863,8 +873,8 @@ bool LLMeshRepoThread::fetchMeshPhysicsShape(const LLUUID& mesh_id)
 			{
 				++sActiveLODRequests;
 				LLMeshRepository::sHTTPRequestCount++;
-				mCurlRequest->getByteRange(http_url, headers, offset, size,
-										   new LLMeshPhysicsShapeResponder(mesh_id, offset, size));
+				LLHTTPScheduler::getInstance()->getByteRange(mCurlRequest, http_url, headers, offset, size,
+										   MESH_INFO_HTTP_PRIORITY, new LLMeshPhysicsShapeResponder(mesh_id, offset, size));
 			}
 		}
 		else
@@ -917,7 +927,8 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params)
 		//grab first 4KB if we're going to bother with a fetch.  Cache will prevent future fetches if a full mesh fits
 		//within the first 4KB
 		LLMeshRepository::sHTTPRequestCount++;
-		mCurlRequest->getByteRange(http_url, headers, 0, 4096, new LLMeshHeaderResponder(mesh_params));
+		LLHTTPScheduler::getInstance()->getByteRange(mCurlRequest, http_url, headers, 0, 4096,
+			MESH_HEADER_HTTP_PRIORITY, new LLMeshHeaderResponder(mesh_params));
 	}
 
 	return retval;
@@ -981,8 +992,8 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
 				++sActiveLODRequests;
 				retval = true;
 				LLMeshRepository::sHTTPRequestCount++;
-				mCurlRequest->getByteRange(constructUrl(mesh_id), headers, offset, size,
-										   new LLMeshLODResponder(mesh_params, lod, offset, size));
+				LLHTTPScheduler::getInstance()->getByteRange(mCurlRequest, constructUrl(mesh_id), headers, offset, size,
+										   MESH_LOD_HTTP_PRIORITY, new LLMeshLODResponder(mesh_params, lod, offset, size));
 			}
 			else
 			{
@@ -1756,12 +1767,12 @@ void LLMeshLODResponder::completedRaw(U32 status, const std::string& reason,
 
 	LLMeshRepository::sBytesReceived += mRequestedBytes;
 
+	std::vector<U8> scratch;
 	U8* data = NULL;
 
 	if (data_size > 0)
 	{
-		data = new U8[data_size];
-		buffer->readAfter(channels.in(), NULL, data, data_size);
+		data = buffer->readContiguous(channels.in(), data_size, scratch);
 	}
 
 	if (gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size))
@@ -1779,8 +1790,6 @@ void LLMeshLODResponder::completedRaw(U32 status, const std::string& reason,
 			LLMeshRepository::sCacheBytesWritten += size;
 		}
 	}
-
-	delete [] data;
 }
 
 void LLMeshSkinInfoResponder::completedRaw(U32 status, const std::string& reason,
@@ -1810,12 +1819,12 @@ void LLMeshSkinInfoResponder::completedRaw(U32 status, const std::string& reason
 
 	LLMeshRepository::sBytesReceived += mRequestedBytes;
 
+	std::vector<U8> scratch;
 	U8* data = NULL;
 
 	if (data_size > 0)
 	{
-		data = new U8[data_size];
-		buffer->readAfter(channels.in(), NULL, data, data_size);
+		data = buffer->readContiguous(channels.in(), data_size, scratch);
 	}
 
 	if (gMeshRepo.mThread->skinInfoReceived(mMeshID, data, data_size))
@@ -1833,8 +1842,6 @@ void LLMeshSkinInfoResponder::completedRaw(U32 status, const std::string& reason
 			file.write(data, size);
 		}
 	}
-
-	delete [] data;
 }
 
 void LLMeshDecompositionResponder::completedRaw(U32 status, const std::string& reason,
@@ -1864,12 +1871,12 @@ void LLMeshDecompositionResponder::completedRaw(U32 status, const std::string& r
 
 	LLMeshRepository::sBytesReceived += mRequestedBytes;
 
+	std::vector<U8> scratch;
 	U8* data = NULL;
 
 	if (data_size > 0)
 	{
-		data = new U8[data_size];
-		buffer->readAfter(channels.in(), NULL, data, data_size);
+		data = buffer->readContiguous(channels.in(), data_size, scratch);
 	}
 
 	if (gMeshRepo.mThread->decompositionReceived(mMeshID, data, data_size))
@@ -1887,8 +1894,6 @@ void LLMeshDecompositionResponder::completedRaw(U32 status, const std::string& r
 			file.write(data, size);
 		}
 	}
-
-	delete [] data;
 }
 
 void LLMeshPhysicsShapeResponder::completedRaw(U32 status, const std::string& reason,
@@ -1918,12 +1923,12 @@ void LLMeshPhysicsShapeResponder::completedRaw(U32 status, const std::string& re
 
 	LLMeshRepository::sBytesReceived += mRequestedBytes;
 
+	std::vector<U8> scratch;
 	U8* data = NULL;
 
 	if (data_size > 0)
 	{
-		data = new U8[data_size];
-		buffer->readAfter(channels.in(), NULL, data, data_size);
+		data = buffer->readContiguous(channels.in(), data_size, scratch);
 	}
 
 	if (gMeshRepo.mThread->physicsShapeReceived(mMeshID, data, data_size))
@@ -1941,8 +1946,6 @@ void LLMeshPhysicsShapeResponder::completedRaw(U32 status, const std::string& re
 			file.write(data, size);
 		}
 	}
-
-	delete [] data;
 }
 
 void LLMeshHeaderResponder::completedRaw(U32 status, const std::string& reason,
@@ -1975,12 +1978,12 @@ void LLMeshHeaderResponder::completedRaw(U32 status, const std::string& reason,
 
 	S32 data_size = buffer->countAfter(channels.in(), NULL);
 
+	std::vector<U8> scratch;
 	U8* data = NULL;
 
 	if (data_size > 0)
 	{
-		data = new U8[data_size];
-		buffer->readAfter(channels.in(), NULL, data, data_size);
+		data = buffer->readContiguous(channels.in(), data_size, scratch);
 	}
 
 	LLMeshRepository::sBytesReceived += llmin(data_size, 4096);
@@ -2048,8 +2051,6 @@ void LLMeshHeaderResponder::completedRaw(U32 status, const std::string& reason,
 			}
 		}
 	}
-
-	delete [] data;
 }
 
 
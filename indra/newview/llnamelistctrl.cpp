@@ -252,6 +252,7 @@ void LLNameListCtrl::refresh(const LLUUID& agent_id, const std::string& full_nam
 			if (cell)
 			{
 				((LLScrollListText*)cell)->setText( full_name );
+				setSorted(FALSE);
 			}
 		}
 	}
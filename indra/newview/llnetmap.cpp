@@ -226,10 +226,6 @@ void LLNetMap::translatePan( F32 delta_x, F32 delta_y )
 
 
 ///////////////////////////////////////////////////////////////////////////////////
-std::size_t hash_value(const LLUUID& uuid)
-{
-    return (std::size_t)uuid.getCRC32();
-}
 boost::unordered_map<const LLUUID, LLColor4> mm_MarkerColors;
 
 void LLNetMap::mm_setcolor(LLUUID key,LLColor4 col)
@@ -406,14 +406,8 @@ LLPanelObject::~LLPanelObject()
 
 const LLUUID& LLPanelObject::findItemID(const LLUUID& asset_id)
 {
-	LLViewerInventoryCategory::cat_array_t cats;
 	LLViewerInventoryItem::item_array_t items;
-	LLAssetIDMatches asset_id_matches(asset_id);
-	gInventory.collectDescendentsIf(LLUUID::null,
-							cats,
-							items,
-							LLInventoryModel::INCLUDE_TRASH,
-							asset_id_matches);
+	gInventory.findItemsByAssetID(asset_id, items);
 
 	if (items.count())
 	{
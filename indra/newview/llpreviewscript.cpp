@@ -90,6 +90,7 @@
 #include "llviewercontrol.h"
 #include "llappviewer.h"
 #include "llpanelinventory.h"
+#include "llrand.h"
 
 #include "jclslpreproc.h"
 #include "lleventtimer.h"
@@ -1327,6 +1328,117 @@ void LLScriptEdCore::onSearchMenu(void* userdata)
 	}
 }
 
+static BOOL segments_match(const std::vector<LLTextSegment*>& a, const std::vector<LLTextSegment*>& b)
+{
+	if (a.size() != b.size())
+	{
+		return FALSE;
+	}
+	for (U32 i = 0; i < a.size(); i++)
+	{
+		if (a[i]->getStart() != b[i]->getStart()
+			|| a[i]->getEnd() != b[i]->getEnd()
+			|| a[i]->getColor() != b[i]->getColor())
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+// static
+// Types into and deletes from a script about the size limit, timing a full
+// re-tokenize against updating only the edited lines after every keystroke.
+void LLScriptEdCore::benchmarkHighlighting(void*)
+{
+	std::string keyword_path = gDirUtilp->getExpandedFilename(LL_PATH_APP_SETTINGS, "keywords.ini");
+	LLKeywords full_keywords;
+	LLKeywords incremental_keywords;
+	if (!full_keywords.loadFromFile(keyword_path) || !incremental_keywords.loadFromFile(keyword_path))
+	{
+		llwarns << "Unable to load " << keyword_path << llendl;
+		return;
+	}
+	LLColor3 color(gSavedSettings.getColor3("PhoenixColorllFunction"));
+	for (std::vector<LLScriptLibraryFunction>::const_iterator i = gScriptLibrary.mFunctions.begin(); i != gScriptLibrary.mFunctions.end(); ++i)
+	{
+		full_keywords.addToken(LLKeywordToken::WORD, i->mName, color);
+		incremental_keywords.addToken(LLKeywordToken::WORD, i->mName, color);
+	}
+
+	const std::string block =
+		"// Status display\n"
+		"default\n"
+		"{\n"
+		"    state_entry()\n"
+		"    {\n"
+		"        llSetText(\"Ready \\\"now\\\"\", <1.0, 1.0, 1.0>, 1.0);\n"
+		"        /* reset the counter\n"
+		"           on every restart */ integer count = 0;\n"
+		"    }\n"
+		"\n"
+		"    touch_start(integer total_number)\n"
+		"    {\n"
+		"        llSay(0, \"Touched by \" + (string)llDetectedKey(0));\n"
+		"    }\n"
+		"}\n";
+	std::string script;
+	while (script.size() + block.size() < 65536)
+	{
+		script += block;
+	}
+	LLWString text = utf8str_to_wstring(script);
+
+	std::vector<LLTextSegment*> full_segs;
+	std::vector<LLTextSegment*> incremental_segs;
+	full_keywords.findSegments(&full_segs, text, LLColor4::black);
+	incremental_keywords.findSegments(&incremental_segs, text, LLColor4::black);
+
+	const S32 EDITS = 200;
+	const llwchar typed[] = { 'a', ' ', '\n', '1', '_', '(' };
+	F64 full_time = 0.0;
+	F64 incremental_time = 0.0;
+	S32 mismatches = 0;
+	LLTimer timer;
+	for (S32 i = 0; i < EDITS; i++)
+	{
+		// Alternate typing a character and deleting one.
+		S32 pos = ll_rand((S32)text.size());
+		S32 removed = 0;
+		S32 inserted = 0;
+		if (i % 2)
+		{
+			text.erase(pos, 1);
+			removed = 1;
+		}
+		else
+		{
+			text.insert(pos, 1, typed[(i / 2) % (sizeof(typed) / sizeof(typed[0]))]);
+			inserted = 1;
+		}
+
+		timer.reset();
+		full_keywords.findSegments(&full_segs, text, LLColor4::black);
+		full_time += timer.getElapsedTimeF64();
+
+		timer.reset();
+		incremental_keywords.updateSegments(&incremental_segs, text, LLColor4::black, pos, pos + inserted, inserted - removed);
+		incremental_time += timer.getElapsedTimeF64();
+
+		if (!segments_match(full_segs, incremental_segs))
+		{
+			mismatches++;
+		}
+	}
+
+	llinfos << "Highlighting " << text.size() << " characters, " << full_segs.size() << " segments: full "
+			<< full_time * 1000.0 / EDITS << " ms/edit, incremental " << incremental_time * 1000.0 / EDITS
+			<< " ms/edit, " << mismatches << " mismatches in " << EDITS << " edits" << llendl;
+
+	std::for_each(full_segs.begin(), full_segs.end(), DeletePointer());
+	std::for_each(incremental_segs.begin(), incremental_segs.end(), DeletePointer());
+}
+
 // static 
 void LLScriptEdCore::onUndoMenu(void* userdata)
 {
@@ -128,6 +128,9 @@ public:
 
 	static BOOL		hasChanged(void* userdata);
 
+	// Log how long keyword highlighting of a large script takes per edit.
+	static void		benchmarkHighlighting(void*);
+
 	void selectFirstError();
 	
 	void autoSave();
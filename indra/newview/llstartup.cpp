@@ -75,6 +75,8 @@
 #include "llmd5.h"
 #include "llmemorystream.h"
 #include "llmessageconfig.h"
+#include "llmessagelog.h"
+#include "llmessagereplay.h"
 #include "llmoveview.h"
 #include "llnotifications.h"
 #include "llnotificationsutil.h"
@@ -282,6 +284,7 @@ bool update_dialog_callback(const LLSD& notification, const LLSD& response);
 void login_packet_failed(void**, S32 result);
 void use_circuit_callback(void**, S32 result);
 void register_viewer_callbacks(LLMessageSystem* msg);
+void replay_message_capture(const std::string& template_path, const std::string& capture_file);
 void init_stat_view();
 void asset_callback_nothing(LLVFS*, const LLUUID&, LLAssetType::EType, void*, S32);
 bool callback_choose_gender(const LLSD& notification, const LLSD& response);
@@ -480,6 +483,7 @@ bool idle_startup()
 
 		// Load the throttle settings
 		gViewerThrottle.load();
+		LLThrottleGroup::setAdaptive(gSavedSettings.getBOOL("ThrottleAdaptiveAdjust"));
 
 		if (ll_init_ares() == NULL || !gAres->isInitialized())
 		{
@@ -599,11 +603,24 @@ bool idle_startup()
 				msg->startLogging();
 			}
 
+			std::string capture_file = gSavedSettings.getString("MessageCaptureFile");
+			if (!capture_file.empty())
+			{
+				LLMessageLog::startCapture(gDirUtilp->getExpandedFilename(LL_PATH_LOGS, capture_file));
+			}
+
+			std::string replay_file = gSavedSettings.getString("MessageReplayFile");
+			if (!replay_file.empty())
+			{
+				replay_message_capture(message_template_path, replay_file);
+			}
+
 			// start the xfer system. by default, choke the downloads
 			// a lot...
 			const S32 VIEWER_MAX_XFER = 3;
 			start_xfer_manager(gVFS);
 			gXferManager->setMaxIncomingXfers(VIEWER_MAX_XFER);
+			gXferManager->setXferWindowSize(gSavedSettings.getS32("XferWindowSize"));
 			F32 xfer_throttle_bps = gSavedSettings.getF32("XferThrottle");
 			if (xfer_throttle_bps > 1.f)
 			{
@@ -3632,6 +3649,33 @@ void register_viewer_callbacks(LLMessageSystem* msg)
 	msg->setHandlerFuncFast(_PREHASH_FeatureDisabled, process_feature_disabled_message);
 }
 
+// Feeds a message capture through a message system of its own, with the
+// viewer's handlers registered, and logs the per-message timings.  This runs
+// before login, so the handlers find no region or agent state to act on and
+// the timings cover decoding plus handler entry.
+void replay_message_capture(const std::string& template_path, const std::string& capture_file)
+{
+	LLMessageReplay replay;
+	if (!replay.load(gDirUtilp->getExpandedFilename(LL_PATH_LOGS, capture_file)))
+	{
+		return;
+	}
+
+	LLMessageSystem msg(template_path, NET_USE_OS_ASSIGNED_PORT,
+						LL_VERSION_MAJOR, LL_VERSION_MINOR, LL_VERSION_PATCH,
+						false, 5.f, 100.f);
+	if (!msg.isOK())
+	{
+		llwarns << "Unable to start a message system to replay " << capture_file << llendl;
+		return;
+	}
+	register_viewer_callbacks(&msg);
+
+	S32 valid = replay.replay(&msg);
+	llinfos << valid << " valid messages replayed from " << capture_file << llendl;
+	replay.dumpStats();
+}
+
 
 void init_stat_view()
 {
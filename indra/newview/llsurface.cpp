@@ -677,26 +677,17 @@ BOOL LLSurface::idleUpdate(F32 max_update_time)
 	return did_update;
 }
 
-void LLSurface::decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL b_large_patch) 
+void LLSurface::applyDecodedPatches(const LLPatchDecodeThread::DecodedGroup& group)
 {
-
-	LLPatchHeader  ph;
 	S32 j, i;
-	S32 patch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
 	LLSurfacePatch *patchp;
+	S32 patch_size = group.mGroupHeader.patch_size;
+	const F32* heights = group.mHeights.empty() ? NULL : &group.mHeights[0];
 
-	init_patch_decompressor(gopp->patch_size);
-	gopp->stride = mGridsPerEdge;
-	set_group_of_patch_header(gopp);
-
-	while (1)
+	for (std::vector<LLPatchHeader>::const_iterator iter = group.mHeaders.begin();
+		 iter != group.mHeaders.end(); ++iter, heights += patch_size * patch_size)
 	{
-		decode_patch_header(bitpack, &ph);
-		if (ph.quant_wbits == END_OF_PATCHES)
-		{
-			break;
-		}
-
+		const LLPatchHeader& ph = *iter;
 		i = ph.patchids >> 5;
 		j = ph.patchids & 0x1F;
 
@@ -717,9 +708,11 @@ void LLSurface::decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL
 
 		patchp = &mPatchList[j*mPatchesPerEdge + i];
 
-
-		decode_patch(bitpack, patch);
-		decompress_patch(patchp->getDataZ(), patch, &ph);
+		F32* dataz = patchp->getDataZ();
+		for (S32 row = 0; row < patch_size; row++)
+		{
+			memcpy(dataz + row * mGridsPerEdge, heights + row * patch_size, patch_size * sizeof(F32));		/* Flawfinder: ignore */
+		}
 
 		// Update edges for neighbors.  Need to guarantee that this gets done before we generate vertical stats.
 		patchp->updateNorthEdge();
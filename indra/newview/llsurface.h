@@ -47,6 +47,7 @@
 #include "llvowater.h"
 #include "llpatchvertexarray.h"
 #include "llviewertexture.h"
+#include "llpatchworker.h"
 
 class LLTimer;
 class LLUUID;
@@ -91,7 +92,8 @@ public:
 	void disconnectNeighbor(LLSurface *neighborp);
 	void disconnectAllNeighbors();
 
-	virtual void decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL b_large_patch);
+	// Copies patches decoded by the patch decode thread into the surface.
+	void applyDecodedPatches(const LLPatchDecodeThread::DecodedGroup& group);
 	virtual void updatePatchVisibilities(LLAgent &agent);
 
 	inline F32 getZ(const U32 k) const				{ return mSurfaceZ[k]; }
@@ -45,6 +45,7 @@
 #include "llpolymorph.h"
 #include "llquantize.h"
 #include "lltexlayer.h"
+#include "lltexlayermaskcache.h"
 #include "llui.h"
 #include "llvfile.h"
 #include "llviewertexturelist.h"
@@ -887,6 +888,16 @@ void LLTexLayerSet::requestUpdate()
 	{
 		createComposite();
 		mComposite->requestUpdate(); 
+
+		// Get the alpha gradients going on the worker threads while we wait for the render.
+		for( layer_list_t::iterator iter = mLayerList.begin(); iter != mLayerList.end(); iter++ )
+		{
+			(*iter)->prefetchAlphaMasks();
+		}
+		for( layer_list_t::iterator iter = mMaskLayerList.begin(); iter != mMaskLayerList.end(); iter++ )
+		{
+			(*iter)->prefetchAlphaMasks();
+		}
 	}
 }
 
@@ -1827,6 +1838,14 @@ BOOL LLTexLayer::renderAlphaMasks( S32 x, S32 y, S32 width, S32 height, LLColor4
 	return success;
 }
 
+void LLTexLayer::prefetchAlphaMasks()
+{
+	for( alpha_list_t::iterator iter = mParamAlphaList.begin(); iter != mParamAlphaList.end(); iter++ )
+	{
+		(*iter)->prefetchProcessedImage();
+	}
+}
+
 void LLTexLayer::applyMorphMask(U8* tex_data, S32 width, S32 height, S32 num_components)
 {
 	for( morph_list_t::iterator iter = mMaskedMorphs.begin();
@@ -2041,6 +2060,7 @@ LLTexLayerParamAlpha::LLTexLayerParamAlpha( LLTexLayer* layer )
 LLTexLayerParamAlpha::~LLTexLayerParamAlpha()
 {
 	deleteCaches();
+	LLTexLayerMaskCache::forget( this );
 	sInstances.remove( this );
 }
 
@@ -2142,11 +2162,54 @@ BOOL LLTexLayerParamAlpha::getSkip()
 }
 
 
+F32 LLTexLayerParamAlpha::getEffectiveWeight()
+{
+	return ( mTexLayer->getTexLayerSet()->getAvatar()->getSex() & getSex() ) ? mCurWeight : getDefaultWeight();
+}
+
+// Don't load the image file until we actually need it the first time.
+BOOL LLTexLayerParamAlpha::loadStaticImageTGA()
+{
+	if( mStaticImageTGA.isNull() && !mStaticImageInvalid )
+	{
+		mStaticImageTGA = gTexStaticImageList.getImageTGA( getInfo()->mStaticImageFileName );  
+		// We now have something in one of our caches
+		LLTexLayerSet::sHasCaches |= mStaticImageTGA.notNull() ? TRUE : FALSE;
+
+		if( mStaticImageTGA.isNull() )
+		{
+			llwarns << "Unable to load static file: " << getInfo()->mStaticImageFileName << llendl;
+			mStaticImageInvalid = TRUE; // don't try again.
+		}
+	}
+	return mStaticImageTGA.notNull();
+}
+
+// Queues the processing of our alpha gradient at the current weight, if render() is going to need it.
+void LLTexLayerParamAlpha::prefetchProcessedImage()
+{
+	if( getInfo()->mStaticImageFileName.empty() || mStaticImageInvalid || getSkip() )
+	{
+		return;
+	}
+
+	F32 effective_weight = getEffectiveWeight();
+	if( mCachedProcessedTexture && (effective_weight == mCachedEffectiveWeight) )
+	{
+		return;
+	}
+
+	if( loadStaticImageTGA() )
+	{
+		LLTexLayerMaskCache::prefetch( this, getInfo()->mStaticImageFileName, mStaticImageTGA, getInfo()->mDomain, effective_weight );
+	}
+}
+
 BOOL LLTexLayerParamAlpha::render( S32 x, S32 y, S32 width, S32 height )
 {
 	BOOL success = TRUE;
 
-	F32 effective_weight = ( mTexLayer->getTexLayerSet()->getAvatar()->getSex() & getSex() ) ? mCurWeight : getDefaultWeight();
+	F32 effective_weight = getEffectiveWeight();
 	BOOL weight_changed = effective_weight != mCachedEffectiveWeight;
 	if( getSkip() )
 	{
@@ -2165,19 +2228,9 @@ BOOL LLTexLayerParamAlpha::render( S32 x, S32 y, S32 width, S32 height )
 
 	if( !getInfo()->mStaticImageFileName.empty() && !mStaticImageInvalid)
 	{
-		if( mStaticImageTGA.isNull() )
+		if( !loadStaticImageTGA() )
 		{
-			// Don't load the image file until we actually need it the first time.  Like now.
-			mStaticImageTGA = gTexStaticImageList.getImageTGA( getInfo()->mStaticImageFileName );  
-			// We now have something in one of our caches
-			LLTexLayerSet::sHasCaches |= mStaticImageTGA.notNull() ? TRUE : FALSE;
-
-			if( mStaticImageTGA.isNull() )
-			{
-				llwarns << "Unable to load static file: " << getInfo()->mStaticImageFileName << llendl;
-				mStaticImageInvalid = TRUE; // don't try again.
-				return FALSE;
-			}
+			return FALSE;
 		}
 
 		const S32 image_tga_width = mStaticImageTGA->getWidth();
@@ -2200,10 +2253,15 @@ BOOL LLTexLayerParamAlpha::render( S32 x, S32 y, S32 width, S32 height )
 				mCachedProcessedTexture->setExplicitFormat( GL_ALPHA8, GL_ALPHA );
 			}
 
-			// Applies domain and effective weight to data as it is decoded. Also resizes the raw image if needed.
-			mStaticImageRaw = NULL;
-			mStaticImageRaw = new LLImageRaw;
-			mStaticImageTGA->decodeAndProcess( mStaticImageRaw, getInfo()->mDomain, effective_weight );
+			// Applies domain and effective weight to data as it is decoded. Usually already
+			// done on a worker thread, see prefetchProcessedImage().  Shared, don't modify.
+			mStaticImageRaw = LLTexLayerMaskCache::getProcessedImage( getInfo()->mStaticImageFileName, mStaticImageTGA, getInfo()->mDomain, effective_weight );
+			if( mStaticImageRaw.isNull() )
+			{
+				llwarns << "Unable to process static file: " << getInfo()->mStaticImageFileName << llendl;
+				mStaticImageInvalid = TRUE; // don't try again.
+				return FALSE;
+			}
 			mNeedsCreateTexture = TRUE;
 		}
 
@@ -2590,6 +2648,7 @@ void LLTexStaticImageList::dumpByteCount() const
 	llinfos << "Avatar Static Textures " <<
 		"KB GL:" << (mGLBytes / 1024) <<
 		"KB TGA:" << (mTGABytes / 1024) << "KB" << llendl;
+	LLTexLayerMaskCache::dumpStats();
 }
 
 void LLTexStaticImageList::deleteCachedImages()
@@ -2604,6 +2663,7 @@ void LLTexStaticImageList::deleteCachedImages()
 		
 		mStaticImageListTGA.clear();
 		mStaticImageList.clear();
+		LLTexLayerMaskCache::clear();
 		
 		mGLBytes = 0;
 		mTGABytes = 0;
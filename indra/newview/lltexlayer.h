@@ -344,6 +344,7 @@ public:
 	BOOL					renderAlphaMasks(  S32 x, S32 y, S32 width, S32 height, LLColor4* colorp );
 	BOOL					hasAlphaParams() { return (!mParamAlphaList.empty());}
 	BOOL					blendAlphaTexture(S32 x, S32 y, S32 width, S32 height);
+	void					prefetchAlphaMasks();
 	BOOL					isVisibilityMask() const;
 	BOOL					isInvisibleAlphaMask();
 
@@ -404,9 +405,14 @@ public:
 	BOOL					render( S32 x, S32 y, S32 width, S32 height );
 	BOOL					getSkip();
 	void					deleteCaches();
+	void					prefetchProcessedImage();
 	LLTexLayer*				getTexLayer()		{ return mTexLayer; }
 	BOOL					getMultiplyBlend()	{ return getInfo()->mMultiplyBlend; }
 
+protected:
+	BOOL					loadStaticImageTGA();
+	F32						getEffectiveWeight();
+
 protected:
 	LLPointer<LLViewerTexture>	mCachedProcessedTexture;
 	LLTexLayer*				mTexLayer;
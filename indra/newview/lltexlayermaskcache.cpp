@@ -0,0 +1,398 @@
+/**
+ * @file lltexlayermaskcache.cpp
+ * @brief Background processing and caching of avatar bake alpha masks
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ *
+ * Copyright (c) 2011, Linden Research, Inc.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lltexlayermaskcache.h"
+
+#include "llimagetga.h"
+#include "llqueuedthread.h"
+
+// Processed masks are 1 byte per pixel, typically 256x256 or 512x512.
+const S32 MAX_CACHED_BYTES = 16 * 1024 * 1024;
+
+// Guards the state of every job, and is signalled when a job finishes.
+static LLCondition* sJobCondition = NULL;
+
+//-----------------------------------------------------------------------------
+// LLTexLayerMaskJob
+// One alpha gradient to process.  Run by whichever of a worker thread and
+// the main thread gets to it first.
+//-----------------------------------------------------------------------------
+class LLTexLayerMaskJob : public LLThreadSafeRefCount
+{
+public:
+	enum EState
+	{
+		STATE_QUEUED,
+		STATE_RUNNING,
+		STATE_DONE,
+		STATE_CANCELLED
+	};
+
+	LLTexLayerMaskJob(LLImageTGA* image_tga, F32 domain, F32 weight)
+		: mImageTGA(image_tga), mDomain(domain), mWeight(weight), mState(STATE_QUEUED)
+	{
+	}
+
+	// Processes the mask if nobody has started on it yet.  With wait, also
+	// waits for another thread that is processing it.  Returns the state the
+	// job was in on entry, so STATE_QUEUED means this call did the work.
+	EState process(bool wait)
+	{
+		sJobCondition->lock();
+		EState state = mState;
+		if (state == STATE_QUEUED)
+		{
+			mState = STATE_RUNNING;
+			sJobCondition->unlock();
+
+			// Applies domain and weight to the data as it is decoded.
+			LLPointer<LLImageRaw> image = new LLImageRaw;
+			bool success = mImageTGA->decodeAndProcess(image, mDomain, mWeight) && image->getDataSize() > 0;
+
+			sJobCondition->lock();
+			if (success)
+			{
+				mImage = image;
+			}
+			mImageTGA = NULL;
+			mState = STATE_DONE;
+			sJobCondition->broadcast();
+		}
+		else if (wait)
+		{
+			while (mState == STATE_RUNNING)
+			{
+				sJobCondition->wait();
+			}
+		}
+		sJobCondition->unlock();
+		return state;
+	}
+
+	// Returns true if the job had not started and now never will.
+	bool cancel()
+	{
+		LLMutexLock lock(sJobCondition);
+		if (mState != STATE_QUEUED)
+		{
+			return false;
+		}
+		mState = STATE_CANCELLED;
+		mImageTGA = NULL;
+		return true;
+	}
+
+	EState getState()
+	{
+		LLMutexLock lock(sJobCondition);
+		return mState;
+	}
+
+	// Only valid once the job is done.
+	LLImageRaw* getImage() const	{ return mImage; }
+	S32 getDataSize() const			{ return mImage.notNull() ? mImage->getDataSize() : 0; }
+
+protected:
+	/*virtual*/ ~LLTexLayerMaskJob() {}
+
+private:
+	LLPointer<LLImageTGA> mImageTGA;
+	const F32 mDomain;
+	const F32 mWeight;
+	LLPointer<LLImageRaw> mImage;
+	EState mState;
+};
+
+//-----------------------------------------------------------------------------
+// LLTexLayerMaskThread
+//-----------------------------------------------------------------------------
+class LLTexLayerMaskThread : public LLQueuedThread
+{
+	class MaskRequest : public LLQueuedThread::QueuedRequest
+	{
+	protected:
+		virtual ~MaskRequest() {} // use deleteRequest()
+
+	public:
+		MaskRequest(handle_t handle, LLTexLayerMaskJob* job)
+			: LLQueuedThread::QueuedRequest(handle, PRIORITY_NORMAL, FLAG_AUTO_COMPLETE),
+			  mJob(job)
+		{
+		}
+
+		/*virtual*/ bool processRequest()
+		{
+			mJob->process(false);
+			return true;
+		}
+
+	private:
+		LLPointer<LLTexLayerMaskJob> mJob;
+	};
+
+public:
+	LLTexLayerMaskThread(U32 index)
+		: LLQueuedThread(llformat("texlayermask%d", index))
+	{
+	}
+
+	// MAIN THREAD
+	void queue(LLTexLayerMaskJob* job)
+	{
+		if (!addRequest(new MaskRequest(generateHandle(), job)))
+		{
+			llerrs << "request added after LLTexLayerMaskCache::cleanupClass()" << llendl;
+		}
+	}
+};
+
+//-----------------------------------------------------------------------------
+// LLTexLayerMaskCache
+//-----------------------------------------------------------------------------
+
+std::vector<LLTexLayerMaskThread*> LLTexLayerMaskCache::sThreads;
+LLTexLayerMaskCache::entry_map_t LLTexLayerMaskCache::sEntries;
+LLTexLayerMaskCache::owner_map_t LLTexLayerMaskCache::sPrefetches;
+U32 LLTexLayerMaskCache::sUseCounter = 0;
+S32 LLTexLayerMaskCache::sCachedBytes = 0;
+U32 LLTexLayerMaskCache::sHits = 0;
+U32 LLTexLayerMaskCache::sWaits = 0;
+U32 LLTexLayerMaskCache::sMisses = 0;
+U32 LLTexLayerMaskCache::sCancelled = 0;
+
+LLTexLayerMaskCache::Entry::Entry()
+	: mLastUsed(0), mBytes(-1)
+{
+}
+
+LLTexLayerMaskCache::Entry::~Entry()
+{
+}
+
+bool LLTexLayerMaskCache::Key::operator<(const Key& rhs) const
+{
+	if (mDomain != rhs.mDomain)
+	{
+		return mDomain < rhs.mDomain;
+	}
+	if (mWeight != rhs.mWeight)
+	{
+		return mWeight < rhs.mWeight;
+	}
+	return mFileName < rhs.mFileName;
+}
+
+//static
+void LLTexLayerMaskCache::initClass(U32 num_threads)
+{
+	llassert(sThreads.empty());
+	sJobCondition = new LLCondition;
+	for (U32 i = 0; i < num_threads; i++)
+	{
+		sThreads.push_back(new LLTexLayerMaskThread(i));
+	}
+	llinfos << "Processing avatar bake masks on " << num_threads << " threads" << llendl;
+}
+
+//static
+void LLTexLayerMaskCache::cleanupClass()
+{
+	for (std::vector<LLTexLayerMaskThread*>::iterator iter = sThreads.begin();
+		 iter != sThreads.end(); ++iter)
+	{
+		(*iter)->shutdown();
+		delete *iter;
+	}
+	sThreads.clear();
+	sEntries.clear();
+	sPrefetches.clear();
+	sCachedBytes = 0;
+	delete sJobCondition;
+	sJobCondition = NULL;
+}
+
+//static
+LLTexLayerMaskCache::Entry& LLTexLayerMaskCache::findOrQueue(const Key& key, LLImageTGA* image_tga, bool queue)
+{
+	entry_map_t::iterator iter = sEntries.find(key);
+	if (iter != sEntries.end())
+	{
+		return iter->second;
+	}
+
+	Entry& entry = sEntries[key];
+	entry.mJob = new LLTexLayerMaskJob(image_tga, key.mDomain, key.mWeight);
+	entry.mLastUsed = ++sUseCounter;
+	if (queue && !sThreads.empty())
+	{
+		// Spread the work over the least busy thread.
+		LLTexLayerMaskThread* thread = sThreads[0];
+		for (U32 i = 1; i < sThreads.size(); i++)
+		{
+			if (sThreads[i]->getPending() < thread->getPending())
+			{
+				thread = sThreads[i];
+			}
+		}
+		thread->queue(entry.mJob);
+	}
+	return entry;
+}
+
+//static
+void LLTexLayerMaskCache::prefetch(const void* owner, const std::string& file_name, LLImageTGA* image_tga,
+								   F32 domain, F32 weight)
+{
+	if (sThreads.empty() || !image_tga)
+	{
+		return;
+	}
+
+	Key key(file_name, domain, weight);
+	owner_map_t::iterator owner_iter = sPrefetches.find(owner);
+	if (owner_iter != sPrefetches.end())
+	{
+		if (!(owner_iter->second < key) && !(key < owner_iter->second))
+		{
+			return; // already asked for this one
+		}
+		// Superseded.  Nobody else will want a mask that never got started.
+		entry_map_t::iterator iter = sEntries.find(owner_iter->second);
+		if (iter != sEntries.end() && iter->second.mJob->cancel())
+		{
+			sEntries.erase(iter);
+			sCancelled++;
+		}
+		owner_iter->second = key;
+	}
+	else
+	{
+		sPrefetches.insert(std::make_pair(owner, key));
+	}
+
+	findOrQueue(key, image_tga, true);
+}
+
+//static
+void LLTexLayerMaskCache::forget(const void* owner)
+{
+	sPrefetches.erase(owner);
+}
+
+//static
+LLImageRaw* LLTexLayerMaskCache::getProcessedImage(const std::string& file_name, LLImageTGA* image_tga,
+												   F32 domain, F32 weight)
+{
+	if (!sJobCondition || !image_tga)
+	{
+		return NULL;
+	}
+
+	Entry& entry = findOrQueue(Key(file_name, domain, weight), image_tga, false);
+	entry.mLastUsed = ++sUseCounter;
+
+	// Keep the job alive across evict().
+	LLPointer<LLTexLayerMaskJob> job = entry.mJob;
+	switch (job->process(true))
+	{
+	  case LLTexLayerMaskJob::STATE_QUEUED:
+		sMisses++;
+		break;
+	  case LLTexLayerMaskJob::STATE_RUNNING:
+		sWaits++;
+		break;
+	  default:
+		sHits++;
+		break;
+	}
+
+	evict();
+
+	return job->getImage();
+}
+
+// Drops the least recently used masks that are done until the cache is within budget.
+//static
+void LLTexLayerMaskCache::evict()
+{
+	// Count the masks finished since the last call, by any thread.
+	for (entry_map_t::iterator iter = sEntries.begin(); iter != sEntries.end(); ++iter)
+	{
+		Entry& entry = iter->second;
+		if (entry.mBytes < 0 && entry.mJob->getState() == LLTexLayerMaskJob::STATE_DONE)
+		{
+			entry.mBytes = entry.mJob->getDataSize();
+			sCachedBytes += entry.mBytes;
+		}
+	}
+
+	while (sCachedBytes > MAX_CACHED_BYTES)
+	{
+		entry_map_t::iterator oldest = sEntries.end();
+		for (entry_map_t::iterator iter = sEntries.begin(); iter != sEntries.end(); ++iter)
+		{
+			if (iter->second.mBytes >= 0 &&
+				(oldest == sEntries.end() || iter->second.mLastUsed < oldest->second.mLastUsed))
+			{
+				oldest = iter;
+			}
+		}
+		if (oldest == sEntries.end())
+		{
+			break;
+		}
+		sCachedBytes -= oldest->second.mBytes;
+		sEntries.erase(oldest);
+	}
+}
+
+//static
+void LLTexLayerMaskCache::clear()
+{
+	for (entry_map_t::iterator iter = sEntries.begin(); iter != sEntries.end(); ++iter)
+	{
+		iter->second.mJob->cancel();
+	}
+	sEntries.clear();
+	sPrefetches.clear();
+	sCachedBytes = 0;
+}
+
+//static
+void LLTexLayerMaskCache::dumpStats()
+{
+	llinfos << "Avatar bake masks: " << sEntries.size() << " cached, " << (sCachedBytes / 1024) << "KB, "
+			<< sThreads.size() << " threads; hits " << sHits << " waits " << sWaits
+			<< " main thread " << sMisses << " cancelled " << sCancelled << llendl;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file lltexlayermaskcache.h
+ * @brief Background processing and caching of avatar bake alpha masks
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ *
+ * Copyright (c) 2011, Linden Research, Inc.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXLAYERMASKCACHE_H
+#define LL_LLTEXLAYERMASKCACHE_H
+
+#include "llimage.h"
+#include "llpointer.h"
+
+class LLImageTGA;
+class LLTexLayerMaskJob;
+class LLTexLayerMaskThread;
+
+// The alpha gradient of an LLTexLayerParamAlpha is its static TGA run
+// through LLImageTGA::decodeAndProcess() with the param's domain and
+// weight.  That is pure CPU work, so it is queued on a small pool of worker
+// threads as soon as a layer set is invalidated, and is usually done by the
+// time the bake is rendered.  Results are shared by every param and avatar
+// using the same image, domain and weight, and kept in an LRU cache.
+//
+// Main thread only, except for the jobs themselves.
+class LLTexLayerMaskCache
+{
+public:
+	// num_threads == 0 processes every mask on the main thread when it is needed.
+	static void initClass(U32 num_threads);
+	static void cleanupClass();
+
+	// Queues processing of the mask unless it is cached or already queued.
+	// A still queued mask previously prefetched by the same owner is cancelled,
+	// so dragging an appearance slider doesn't pile up stale work.
+	static void prefetch(const void* owner, const std::string& file_name, LLImageTGA* image_tga,
+						 F32 domain, F32 weight);
+	// Forgets owner's outstanding prefetch.  Call when the owner goes away.
+	static void forget(const void* owner);
+
+	// Returns the processed mask, waiting for or doing the work as needed.
+	// Returns NULL if the image could not be processed.
+	static LLImageRaw* getProcessedImage(const std::string& file_name, LLImageTGA* image_tga,
+										 F32 domain, F32 weight);
+
+	// Drops all cached masks.  Queued jobs still run but their results are discarded.
+	static void clear();
+
+	static void dumpStats();
+
+private:
+	struct Key
+	{
+		Key(const std::string& file_name, F32 domain, F32 weight)
+			: mFileName(file_name), mDomain(domain), mWeight(weight) {}
+		bool operator<(const Key& rhs) const;
+
+		std::string mFileName;
+		F32 mDomain;
+		F32 mWeight;
+	};
+
+	struct Entry
+	{
+		Entry();
+		~Entry();
+
+		LLPointer<LLTexLayerMaskJob> mJob;
+		U32 mLastUsed;
+		S32 mBytes;			// -1 until the job is done and its size is counted in sCachedBytes
+	};
+
+	typedef std::map<Key, Entry> entry_map_t;
+	typedef std::map<const void*, Key> owner_map_t;
+
+	static Entry& findOrQueue(const Key& key, LLImageTGA* image_tga, bool queue);
+	static void evict();
+
+	static std::vector<LLTexLayerMaskThread*> sThreads;
+	static entry_map_t sEntries;
+	static owner_map_t sPrefetches;
+	static U32 sUseCounter;
+	static S32 sCachedBytes;
+
+	// Stats
+	static U32 sHits;			// mask was ready when needed
+	static U32 sWaits;			// a worker was still processing it
+	static U32 sMisses;			// processed on the main thread
+	static U32 sCancelled;		// stale prefetches dropped before they ran
+};
+
+#endif // LL_LLTEXLAYERMASKCACHE_H
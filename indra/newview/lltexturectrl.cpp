@@ -689,14 +689,8 @@ void LLFloaterTexturePicker::onSaveAnotherCopyDialog( S32 option, void* userdata
 
 const LLUUID& LLFloaterTexturePicker::findItemID(const LLUUID& asset_id, BOOL copyable_only)
 {
-	LLViewerInventoryCategory::cat_array_t cats;
 	LLViewerInventoryItem::item_array_t items;
-	LLAssetIDMatches asset_id_matches(asset_id);
-	gInventory.collectDescendentsIf(LLUUID::null,
-							cats,
-							items,
-							LLInventoryModel::INCLUDE_TRASH,
-							asset_id_matches);
+	gInventory.findItemsByAssetID(asset_id, items);
 
 	if (items.count())
 	{
@@ -42,6 +42,7 @@
 #include "llcurl.h"
 #include "lldir.h"
 #include "llhttpclient.h"
+#include "llhttpscheduler.h"
 #include "llhttpstatuscodes.h"
 #include "llimage.h"
 #include "llimagej2c.h"
@@ -183,6 +184,7 @@ private:
 	void resetFormattedData();
 	
 	void setImagePriority(F32 priority);
+	F32 getHTTPPriority() const;
 	void setDesiredDiscard(S32 discard, S32 size);
 	bool insertPacket(S32 index, U8* data, S32 size);
 	void clearPackets();
@@ -269,6 +271,7 @@ private:
 	S32 mActiveCount;
 	U32 mGetStatus;
 	std::string mGetReason;
+	LLHTTPScheduler::handle_t mHTTPHandle;
 	
 	// Work Data
 	LLMutex mWorkMutex;
@@ -771,6 +774,7 @@ LLTextureFetchWorker::LLTextureFetchWorker(LLTextureFetch* fetcher,
 	  mRetryAttempt(0),
 	  mActiveCount(0),
 	  mGetStatus(0),
+	  mHTTPHandle(LLHTTPScheduler::nullHandle()),
 	  mFirstPacket(0),
 	  mLastPacket(-1),
 	  mTotalPackets(0),
@@ -810,6 +814,11 @@ LLTextureFetchWorker::~LLTextureFetchWorker()
 	}
 	mFormattedImage = NULL;
 	clearPackets();
+	if (mHTTPHandle != LLHTTPScheduler::nullHandle())
+	{
+		LLHTTPScheduler::getInstance()->cancel(mHTTPHandle);
+		mHTTPHandle = LLHTTPScheduler::nullHandle();
+	}
 	unlockWorkMutex();
 	mFetcher->removeFromHTTPQueue(mID);
 }
@@ -909,9 +918,20 @@ void LLTextureFetchWorker::setImagePriority(F32 priority)
 		calcWorkPriority();
 		U32 work_priority = mWorkPriority | (getPriority() & LLWorkerThread::PRIORITY_HIGHBITS);
 		setPriority(work_priority);
+		if (mHTTPHandle != LLHTTPScheduler::nullHandle())
+		{
+			LLHTTPScheduler::getInstance()->setPriority(mHTTPHandle, getHTTPPriority());
+		}
 	}
 }
 
+// Texture priorities scaled to the 0 to 1 range the HTTP scheduler
+// shares with mesh requests.
+F32 LLTextureFetchWorker::getHTTPPriority() const
+{
+	return llclamp(mImagePriority / LLViewerFetchedTexture::maxDecodePriority(), 0.f, 1.f);
+}
+
 void LLTextureFetchWorker::resetFormattedData()
 {
 	FREE_MEM(LLImageBase::getPrivatePool(), mBuffer);
@@ -1250,16 +1270,11 @@ bool LLTextureFetchWorker::doWork(S32 param)
 		if(mCanUseHTTP)
 		{
 			//NOTE:
-			//control the number of the http requests issued for:
-			//1, not openning too many file descriptors at the same time;
-			//2, control the traffic of http so udp gets bandwidth.
+			//the number of http requests in flight and the http
+			//bandwidth are controlled by LLHTTPScheduler, which queues
+			//the request below until it can be issued.
 			//
-			static const LLCachedControl<U32> max_http_requests("HTTPMaxRequests", 32);
-			static const LLCachedControl<U32> min_http_requests("HTTPMinRequests", 2);
-			if(((U32)mFetcher->getNumHTTPRequests() > max_http_requests) ||
-			   ((mFetcher->getTextureBandwidth() > mFetcher->mMaxBandwidth) &&
-				((U32)mFetcher->getNumHTTPRequests() > min_http_requests)) ||
-			    !sgConnectionThrottle())
+			if(!sgConnectionThrottle())
 			{
 				return false ; //wait.
 			}
@@ -1318,8 +1333,10 @@ bool LLTextureFetchWorker::doWork(S32 param)
 				// Will call callbackHttpGet when curl request completes
 				std::vector<std::string> headers;
 				headers.push_back("Accept: image/x-j2c");
-				res = mFetcher->mCurlGetRequest->getByteRange(mUrl, headers, offset, mRequestedSize,
-															  new HTTPGetResponder(mFetcher, mID, LLTimer::getTotalTime(), mRequestedSize, offset, true));
+				mHTTPHandle = LLHTTPScheduler::getInstance()->getByteRange(
+					mFetcher->mCurlGetRequest, mUrl, headers, offset, mRequestedSize, getHTTPPriority(),
+					new HTTPGetResponder(mFetcher, mID, LLTimer::getTotalTime(), mRequestedSize, offset, true));
+				res = true;
 			}
 			if (!res)
 			{
@@ -1793,6 +1810,7 @@ S32 LLTextureFetchWorker::callbackHttpGet(const LLChannelDescriptors& channels,
 	S32 data_size = 0 ;
 
 	LLMutexLock lock(&mWorkMutex);
+	mHTTPHandle = LLHTTPScheduler::nullHandle();
 
 	if (mState != WAIT_HTTP_REQ)
 	{
@@ -2349,6 +2367,7 @@ void LLTextureFetch::commonUpdate()
 
 	// Update Curl on same thread as mCurlGetRequest was constructed
 	llassert_always(mCurlGetRequest);
+	LLHTTPScheduler::getInstance()->update(mCurlGetRequest);
 	S32 processed = mCurlGetRequest->process();
 	if (processed > 0)
 	{
@@ -2361,6 +2380,17 @@ void LLTextureFetch::commonUpdate()
 S32 LLTextureFetch::update(U32 max_time_ms)
 {
 	static LLCachedControl<F32> band_width(gSavedSettings,"ThrottleBandwidthKBPS");
+	static LLCachedControl<U32> max_http_requests(gSavedSettings, "HTTPMaxRequests");
+	static LLCachedControl<U32> min_http_requests(gSavedSettings, "HTTPMinRequests");
+	static LLCachedControl<U32> max_host_requests(gSavedSettings, "HTTPMaxRequestsPerHost");
+
+	// The scheduler is shared with mesh fetches, so these limits cover
+	// both.
+	LLHTTPScheduler* scheduler = LLHTTPScheduler::getInstance();
+	scheduler->setMaxBandwidth(band_width);
+	scheduler->setMaxRequests(max_http_requests);
+	scheduler->setMinRequests(min_http_requests);
+	scheduler->setMaxRequestsPerHost(max_host_requests);
 
 	{
 		mNetworkQueueMutex.lock() ;
@@ -2418,6 +2448,7 @@ void LLTextureFetch::startThread()
 void LLTextureFetch::endThread()
 {
 	// Destroy mCurlGetRequest from Worker Thread
+	LLHTTPScheduler::getInstance()->removeClient(mCurlGetRequest);
 	delete mCurlGetRequest;
 	mCurlGetRequest = NULL;
 }
@@ -0,0 +1,201 @@
+/** 
+ * @file lltexturememorymanager.cpp
+ * @brief Global GL texture memory accounting and eviction
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lltexturememorymanager.h"
+
+#include "llappviewer.h"
+#include "llimagegl.h"
+#include "llviewercamera.h"
+#include "llviewertexture.h"
+#include "llviewertexturelist.h"
+
+// tuning params
+const F32 EVICTION_INTERVAL = 0.5f;		// seconds between eviction passes
+const F32 PREDICTION_TIME = 2.f;		// how far ahead camera motion is extrapolated
+const F32 REFETCH_WINDOW = 60.f;		// a texture fetched back within this long of eviction counts as a refetch
+const F32 MAX_CAMERA_SPEED = 500.f;		// faster than this is a teleport, not motion
+const S32 MAX_EVICTIONS_PER_PASS = 64;
+
+// defined in llviewertexture.cpp
+extern F32 texmem_lower_bound_scale;
+extern F32 texmem_middle_bound_scale;
+
+S32 LLTextureMemoryManager::sResidentBytes[MAX_DISCARD_LEVEL + 1];
+U32 LLTextureMemoryManager::sEvictionCount = 0;
+S32 LLTextureMemoryManager::sEvictedKB = 0;
+U32 LLTextureMemoryManager::sRefetchCount = 0;
+LLVector3 LLTextureMemoryManager::sCameraVelocity;
+LLVector3 LLTextureMemoryManager::sLastCameraOrigin;
+LLFrameTimer LLTextureMemoryManager::sEvictionTimer;
+
+//static
+void LLTextureMemoryManager::update()
+{
+	// Smoothed camera velocity drives the need prediction.
+	LLVector3 origin = LLViewerCamera::getInstance()->getOrigin();
+	if (gFrameIntervalSeconds > 0.f)
+	{
+		LLVector3 velocity = (origin - sLastCameraOrigin) / gFrameIntervalSeconds;
+		if (velocity.magVec() > MAX_CAMERA_SPEED)
+		{
+			sCameraVelocity.clearVec();
+		}
+		else
+		{
+			sCameraVelocity = lerp(sCameraVelocity, velocity, 0.2f);
+		}
+	}
+	sLastCameraOrigin = origin;
+
+	if (sEvictionTimer.getElapsedTimeF32() < EVICTION_INTERVAL)
+	{
+		return;
+	}
+	sEvictionTimer.reset();
+
+	// Evict down to the lower bound once past the middle one, so that we
+	// are not back over the limit as soon as a few textures sharpen.
+	S32 max_total = MEGA_BYTES_TO_BYTES(gTextureList.getMaxTotalTextureMem());
+	S32 max_bound = MEGA_BYTES_TO_BYTES(gTextureList.getMaxResidentTexMem());
+	S32 total = LLImageGL::sGlobalTextureMemoryInBytes;
+	S32 bound = LLImageGL::sBoundTextureMemoryInBytes;
+	if (total > max_total * texmem_middle_bound_scale || bound > max_bound * texmem_middle_bound_scale)
+	{
+		evict(llmax(total - (S32)(max_total * texmem_lower_bound_scale),
+					bound - (S32)(max_bound * texmem_lower_bound_scale)));
+	}
+}
+
+struct eviction_candidate_t
+{
+	F32 mScore;
+	S32 mBytes;
+	LLViewerLODTexture* mTexture;
+
+	bool operator<(const eviction_candidate_t& rhs) const { return mScore < rhs.mScore; }
+};
+
+//static
+void LLTextureMemoryManager::evict(S32 bytes_needed)
+{
+	LLVector3 camera_now = LLViewerCamera::getInstance()->getOrigin();
+	LLVector3 camera_future = camera_now + sCameraVelocity * PREDICTION_TIME;
+
+	// Need per byte freed, discounted by how long since the texture was
+	// last drawn; the lowest scores are evicted first.
+	std::vector<eviction_candidate_t> candidates;
+	for (LLViewerTextureList::image_priority_list_t::iterator iter = gTextureList.mImageList.begin();
+		 iter != gTextureList.mImageList.end(); ++iter)
+	{
+		LLViewerFetchedTexture* imagep = *iter;
+		if (imagep->getType() != LLViewerTexture::LOD_TEXTURE)
+		{
+			continue;
+		}
+		S32 bytes = imagep->getEvictableBytes();
+		if (bytes <= 0)
+		{
+			continue;
+		}
+		F32 need = imagep->getPredictedVirtualSize(camera_now, camera_future) * (1.f + imagep->getBoostLevel());
+		F32 idle = llmax(imagep->getTimePassedSinceLastBound(), 0.f);
+
+		eviction_candidate_t candidate;
+		candidate.mScore = need / ((1.f + idle) * bytes);
+		candidate.mBytes = bytes;
+		candidate.mTexture = (LLViewerLODTexture*)imagep;
+		candidates.push_back(candidate);
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	S32 evicted = 0;
+	for (std::vector<eviction_candidate_t>::iterator iter = candidates.begin();
+		 iter != candidates.end() && bytes_needed > 0 && evicted < MAX_EVICTIONS_PER_PASS; ++iter)
+	{
+		if (iter->mTexture->evict())
+		{
+			bytes_needed -= iter->mBytes;
+			sEvictedKB += iter->mBytes / 1024;
+			sEvictionCount++;
+			evicted++;
+		}
+	}
+}
+
+//static
+void LLTextureMemoryManager::updateResidency(LLViewerFetchedTexture* tex, bool released)
+{
+	S32 bytes = 0;
+	S32 discard = -1;
+	if (!released && tex->hasGLTexture() && tex->mGLTexturep->mTextureMemory > 0)
+	{
+		bytes = tex->mGLTexturep->mTextureMemory;
+		discard = llclamp(tex->getDiscardLevel(), 0, MAX_DISCARD_LEVEL);
+	}
+	if (discard == tex->mResidentDiscardLevel && bytes == tex->mResidentBytes)
+	{
+		return;
+	}
+
+	if (tex->mResidentDiscardLevel >= 0)
+	{
+		sResidentBytes[tex->mResidentDiscardLevel] -= tex->mResidentBytes;
+	}
+	if (discard >= 0)
+	{
+		sResidentBytes[discard] += bytes;
+	}
+	tex->mResidentDiscardLevel = discard;
+	tex->mResidentBytes = bytes;
+
+	if (tex->mEvictedDiscardLevel >= 0 && discard >= 0 && discard < tex->mEvictedDiscardLevel)
+	{
+		if (LLViewerTexture::sCurrentTime - tex->mEvictedTime < REFETCH_WINDOW)
+		{
+			sRefetchCount++;
+		}
+		tex->mEvictedDiscardLevel = -1;
+	}
+}
+
+//static
+void LLTextureMemoryManager::dumpStats()
+{
+	llinfos << "Texture memory: " << sEvictionCount << " evictions freeing " << sEvictedKB / 1024
+			<< " MB, " << sRefetchCount << " refetches" << llendl;
+	for (S32 i = 0; i <= MAX_DISCARD_LEVEL; i++)
+	{
+		llinfos << "  discard " << i << ": " << BYTES_TO_MEGA_BYTES(sResidentBytes[i]) << " MB resident" << llendl;
+	}
+}
@@ -0,0 +1,75 @@
+/** 
+ * @file lltexturememorymanager.h
+ * @brief Global GL texture memory accounting and eviction
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXTUREMEMORYMANAGER_H
+#define LL_LLTEXTUREMEMORYMANAGER_H
+
+#include "llimage.h"
+#include "llframetimer.h"
+#include "v3math.h"
+
+class LLViewerFetchedTexture;
+
+// Keeps the GL memory of fetched textures within the limits set by
+// LLViewerTextureList. When over budget it evicts (drops to the cached
+// lower resolution) the textures with the least predicted need per byte
+// freed, rather than whichever texture happens to be processed next.
+class LLTextureMemoryManager
+{
+public:
+	// Called once per frame from LLViewerTexture::updateClass().
+	static void update();
+
+	// Re-accounts the GL memory of tex after its GL texture was created or
+	// destroyed. Pass released when tex is going away.
+	static void updateResidency(LLViewerFetchedTexture* tex, bool released = false);
+
+	static void dumpStats();
+
+	static S32 getResidentBytes(S32 discard_level)	{ return sResidentBytes[discard_level]; }
+	static U32 getEvictionCount()					{ return sEvictionCount; }
+	static S32 getEvictedKB()						{ return sEvictedKB; }
+	static U32 getRefetchCount()					{ return sRefetchCount; }
+
+private:
+	static void evict(S32 bytes_needed);
+
+	static S32 sResidentBytes[MAX_DISCARD_LEVEL + 1];
+	static U32 sEvictionCount;
+	static S32 sEvictedKB;
+	static U32 sRefetchCount;		// evicted textures fetched back at higher resolution soon after
+	static LLVector3 sCameraVelocity;
+	static LLVector3 sLastCameraOrigin;
+	static LLFrameTimer sEvictionTimer;
+};
+
+#endif // LL_LLTEXTUREMEMORYMANAGER_H
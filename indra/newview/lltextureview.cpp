@@ -49,6 +49,7 @@
 #include "lltexlayer.h"
 #include "lltexturecache.h"
 #include "lltexturefetch.h"
+#include "lltexturememorymanager.h"
 #include "llviewercontrol.h"
 #include "llviewerobject.h"
 #include "llviewertexturelist.h"
@@ -523,6 +524,13 @@ void LLGLTexMemBar::draw()
 	text = llformat("BW:%.0f/%.0f",bandwidth, max_bandwidth);
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, left, line_height*2,
 											 color, LLFontGL::LEFT, LLFontGL::TOP);
+	left += LLFontGL::getFontMonospace()->getWidth(text);
+	text = llformat(" PRI:%d(%d/%d) EVICT:%d(%dMB) REFETCH:%d", gTextureList.mPriorityUpdateCount,
+					gTextureList.mPriorityDirtyCount, gTextureList.mPriorityChangeCount,
+					LLTextureMemoryManager::getEvictionCount(), LLTextureMemoryManager::getEvictedKB() / 1024,
+					LLTextureMemoryManager::getRefetchCount());
+	LLFontGL::getFontMonospace()->renderUTF8(text, 0, left, line_height*2,
+											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
 	
 	S32 dx1 = 0;
 	if (LLAppViewer::getTextureFetch()->mDebugPause)
@@ -619,6 +619,12 @@ static bool handleAllowLargeSounds(const LLSD& newvalue)
 		gAudiop->setAllowLargeSounds(newvalue.asBoolean());
 	return true;
 }
+
+static bool handleFastTimerTraceChanged(const LLSD& newvalue)
+{
+	LLFastTimerTrace::setEnabled(newvalue.asBoolean());
+	return true;
+}
 ////////////////////////////////////////////////////////////////////////////
 void settings_setup_listeners()
 {
@@ -798,6 +804,7 @@ void settings_setup_listeners()
     // [/Ansariel: Display name support]
 
 	gSavedSettings.getControl("AllowLargeSounds")->getSignal()->connect(boost::bind(&handleAllowLargeSounds, _2));
+	gSavedSettings.getControl("FastTimerTraceEnabled")->getSignal()->connect(boost::bind(&handleFastTimerTraceChanged, _2));
 }
 
 void onCommitControlSetting_gSavedSettings(LLUICtrl* ctrl, void* name)
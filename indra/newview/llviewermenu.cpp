@@ -168,6 +168,7 @@
 #include "llimage.h"
 #include "llimagebmp.h"
 #include "llimagej2c.h"
+#include "llimagesimd.h"
 #include "llimagetga.h"
 #include "llinventorydefines.h"
 #include "llinventoryfunctions.h"
@@ -187,6 +188,7 @@
 
 #include "llpolymesh.h"
 #include "llprimitive.h"
+#include "llpreviewscript.h"
 #include "llresmgr.h"
 #include "llselectmgr.h"
 #include "llsky.h"
@@ -351,6 +353,7 @@ void handle_dump_capabilities_info(void *);
 void handle_dump_focus(void*);
 
 // Advanced->Consoles menu
+void handle_dump_fast_timer_trace(void*);
 void handle_show_notifications_console(void*);
 void handle_region_dump_settings(void*);
 void handle_region_dump_temp_asset_data(void*);
@@ -947,6 +950,8 @@ void init_client_menu(LLMenuGL* menu)
 										&get_visibility,
 										(void*)gDebugView->mFastTimerView,
 										  '9', MASK_CONTROL|MASK_SHIFT ) );
+		sub->append(new LLMenuItemCheckGL("Record Fast Timer Trace", menu_toggle_control, NULL, menu_check_control, (void*)"FastTimerTraceEnabled"));
+		sub->append(new LLMenuItemCallGL("Dump Fast Timer Trace", &handle_dump_fast_timer_trace));
 #if MEM_TRACK_MEM
 		sub->append(new LLMenuItemCheckGL("Memory", 
 										&toggle_visibility,
@@ -1242,6 +1247,23 @@ void init_debug_world_menu(LLMenuGL* menu)
 	menu->createJumpKeys();
 }
 
+void handle_benchmark_image_kernels(void*)
+{
+	LLImageSIMD::benchmark();
+}
+
+void handle_dump_fast_timer_trace(void*)
+{
+	if (!LLFastTimerTrace::isEnabled())
+	{
+		llwarns << "Fast timer trace is not recording, enable FastTimerTraceEnabled first" << llendl;
+		return;
+	}
+	std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS,
+		"fast_timer_trace_" + LLDate::now().toHTTPDateString("%Y%m%d_%H%M%S") + ".json");
+	LLFastTimerTrace::dump(filename, gSavedSettings.getF32("FastTimerTraceSeconds"));
+}
+
 static void handle_export_menus_to_xml_continued(AIFilePicker* filepicker);
 void handle_export_menus_to_xml(void*)
 {
@@ -1308,6 +1330,9 @@ void init_debug_xui_menu(LLMenuGL* menu)
 {
 	menu->append(new LLMenuItemCallGL("Floater Test...", LLFloaterTest::show));
 	menu->append(new LLMenuItemCallGL("Font Test...", LLFloaterFontTest::show));
+	menu->append(new LLMenuItemCallGL("Benchmark Script Highlighting", &LLScriptEdCore::benchmarkHighlighting));
+	menu->append(new LLMenuItemCallGL("Benchmark Font Layout", &LLFloaterFontTest::benchmark));
+	menu->append(new LLMenuItemCallGL("Benchmark Image Kernels", handle_benchmark_image_kernels));
 	menu->append(new LLMenuItemCallGL("Export Menus to XML...", handle_export_menus_to_xml));
 	menu->append(new LLMenuItemCallGL("Edit UI...", LLFloaterEditUI::show));	
 	menu->append(new LLMenuItemCallGL("Load from XML...", handle_load_from_xml));
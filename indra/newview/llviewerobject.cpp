@@ -120,6 +120,54 @@ S32			LLViewerObject::sAxisArrowLength(50);
 BOOL		LLViewerObject::sPulseEnabled(FALSE);
 BOOL		LLViewerObject::sUseSharedDrawables(FALSE); // TRUE
 
+// ObjectUpdate fields read for every object in a full update, resolved
+// against the message template once instead of looked up by name per call.
+// Resolved again whenever the update comes from a different template, e.g.
+// the isolated message system a capture replay runs through.
+struct LLObjectUpdateFields
+{
+	void resolve(const LLMessageSystem* msgsys)
+	{
+		mCRC = field(msgsys, _PREHASH_CRC);
+		mParentID = field(msgsys, _PREHASH_ParentID);
+		mSound = field(msgsys, _PREHASH_Sound);
+		mOwnerID = field(msgsys, _PREHASH_OwnerID);
+		mGain = field(msgsys, _PREHASH_Gain);
+		mFlags = field(msgsys, _PREHASH_Flags);
+		mMaterial = field(msgsys, _PREHASH_Material);
+		mClickAction = field(msgsys, _PREHASH_ClickAction);
+		mScale = field(msgsys, _PREHASH_Scale);
+		mObjectData = field(msgsys, _PREHASH_ObjectData);
+	}
+
+	static LLMessageField field(const LLMessageSystem* msgsys, const char* varname)
+	{
+		return msgsys->getTemplateField(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, varname);
+	}
+
+	// A field the update doesn't carry reads as zero, as it did through
+	// the name based getters, rather than throwing the update away.
+	static void read(const LLTemplateMessageReader* reader, const LLMessageField& field,
+					 void* datap, S32 size, S32 block_num)
+	{
+		if (!reader->getField(field, datap, size, block_num))
+		{
+			memset(datap, 0, size);
+		}
+	}
+
+	LLMessageField mCRC;
+	LLMessageField mParentID;
+	LLMessageField mSound;
+	LLMessageField mOwnerID;
+	LLMessageField mGain;
+	LLMessageField mFlags;
+	LLMessageField mMaterial;
+	LLMessageField mClickAction;
+	LLMessageField mScale;
+	LLMessageField mObjectData;
+};
+
 // sMaxUpdateInterpolationTime must be greater than sPhaseOutUpdateInterpolationTime
 F64			LLViewerObject::sMaxUpdateInterpolationTime = 3.0;		// For motion interpolation: after X seconds with no updates, don't predict object motion
 F64			LLViewerObject::sPhaseOutUpdateInterpolationTime = 2.0;	// For motion interpolation: after Y seconds with no updates, taper off motion prediction
@@ -865,6 +913,48 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 #ifdef DEBUG_UPDATE_TYPE
 				llinfos << "Full:" << getID() << llendl;
 #endif
+				LLUUID audio_uuid;
+				LLUUID owner_id;	// only valid if audio_uuid or particle system is not null
+				F32    gain = 0.f;
+				U8     sound_flags = 0;
+
+				LLTemplateMessageReader* reader = mesgsys->getTemplateReader();
+				if (!reader)
+				{
+					llwarns << "Full update for object " << getID() << " is not a template message, ignoring it" << llendl;
+					return retval;
+				}
+				static LLObjectUpdateFields fields;
+				if (!reader->isFieldOfCurrentMessage(fields.mCRC))
+				{
+					fields.resolve(mesgsys);
+				}
+				LLObjectUpdateFields::read(reader, fields.mCRC, &crc, sizeof(crc), block_num);
+				LLObjectUpdateFields::read(reader, fields.mParentID, &parent_id, sizeof(parent_id), block_num);
+				LLObjectUpdateFields::read(reader, fields.mSound, audio_uuid.mData, UUID_BYTES, block_num);
+				// HACK: Owner id only valid if non-null sound id or particle system
+				LLObjectUpdateFields::read(reader, fields.mOwnerID, owner_id.mData, UUID_BYTES, block_num);
+				LLObjectUpdateFields::read(reader, fields.mGain, &gain, sizeof(gain), block_num);
+				LLObjectUpdateFields::read(reader, fields.mFlags, &sound_flags, sizeof(sound_flags), block_num);
+				LLObjectUpdateFields::read(reader, fields.mMaterial, &material, sizeof(material), block_num);
+				LLObjectUpdateFields::read(reader, fields.mClickAction, &click_action, sizeof(click_action), block_num);
+				LLObjectUpdateFields::read(reader, fields.mScale, new_scale.mV, sizeof(new_scale.mV), block_num);
+				if (!llfinite(gain))
+				{
+					gain = 0.f;
+				}
+				if (!new_scale.isFinite())
+				{
+					new_scale.zeroVec();
+				}
+				length = 0;
+				const U8* object_data = reader->getFieldData(fields.mObjectData, block_num, length);
+				length = llclamp(length, 0, (S32)sizeof(data));
+				if (object_data)
+				{
+					memcpy(data, object_data, length);		/* Flawfinder: ignore */
+				}
+
 				//clear cost and linkset cost
 				mCostStale = true;
 				if (isSelected())
@@ -872,24 +962,6 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 					gFloaterTools->dirty();
 				}
 
-				LLUUID audio_uuid;
-				LLUUID owner_id;	// only valid if audio_uuid or particle system is not null
-				F32    gain;
-				U8     sound_flags;
-
-				mesgsys->getU32Fast( _PREHASH_ObjectData, _PREHASH_CRC, crc, block_num);
-				mesgsys->getU32Fast( _PREHASH_ObjectData, _PREHASH_ParentID, parent_id, block_num);
-				mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_Sound, audio_uuid, block_num );
-				// HACK: Owner id only valid if non-null sound id or particle system
-				mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_OwnerID, owner_id, block_num );
-				mesgsys->getF32Fast( _PREHASH_ObjectData, _PREHASH_Gain, gain, block_num );
-				mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_Flags, sound_flags, block_num );
-				mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_Material, material, block_num );
-				mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_ClickAction, click_action, block_num); 
-				mesgsys->getVector3Fast(_PREHASH_ObjectData, _PREHASH_Scale, new_scale, block_num );
-				length = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_ObjectData);
-				mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_ObjectData, data, length, block_num);
-
 				mTotalCRC = crc;
 
 				// Owner ID used for sound muting or particle system muting
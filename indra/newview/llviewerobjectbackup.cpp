@@ -437,14 +437,8 @@ LLUUID LLObjectBackup::validateTextureID(LLUUID asset_id)
 		// Allow to export a few default SL textures.
 		return asset_id;
 	}
-	LLViewerInventoryCategory::cat_array_t cats;
 	LLViewerInventoryItem::item_array_t items;
-	LLAssetIDMatches asset_id_matches(asset_id);
-	gInventory.collectDescendentsIf(LLUUID::null,
-							cats,
-							items,
-							LLInventoryModel::INCLUDE_TRASH,
-							asset_id_matches);
+	gInventory.findItemsByAssetID(asset_id, items);
 
 	if (items.count())
 	{
@@ -99,8 +99,8 @@ extern LLPipeline	gPipeline;
 
 // Statics for object lookup tables.
 U32						LLViewerObjectList::sSimulatorMachineIndex = 1; // Not zero deliberately, to speed up index check.
-std::map<U64, U32>			LLViewerObjectList::sIPAndPortToIndex;
-std::map<U64, LLUUID>	LLViewerObjectList::sIndexAndLocalIDToUUID;
+boost::unordered_map<U64, U32>		LLViewerObjectList::sIPAndPortToIndex;
+boost::unordered_map<U64, LLUUID>	LLViewerObjectList::sIndexAndLocalIDToUUID;
 
 LLViewerObjectList::LLViewerObjectList()
 {
@@ -112,6 +112,7 @@ LLViewerObjectList::LLViewerObjectList()
 	mMinNumDeadObjects = 20;
 	mNumOrphans = 0;
 	mNumNewObjects = 0;
+	mNumObjectUpdates = 0;
 	mWasPaused = FALSE;
 	mNumDeadObjectUpdates = 0;
 	mNumUnknownKills = 0;
@@ -140,20 +141,38 @@ void LLViewerObjectList::getUUIDFromLocal(LLUUID &id,
 										  const U32 local_id,
 										  const U32 ip,
 										  const U32 port)
+{
+	getUUIDFromLocal(id, local_id, getSimulatorIndex(ip, port));
+}
+
+U32 LLViewerObjectList::getSimulatorIndex(const U32 ip, const U32 port)
 {
 	U64 ipport = (((U64)ip) << 32) | (U64)port;
 
-	U32 index = sIPAndPortToIndex[ipport];
+	U32& index = sIPAndPortToIndex[ipport];
 
 	if (!index)
 	{
 		index = sSimulatorMachineIndex++;
-		sIPAndPortToIndex[ipport] = index;
 	}
+	return index;
+}
 
-	U64	indexid = (((U64)index) << 32) | (U64)local_id;
+void LLViewerObjectList::getUUIDFromLocal(LLUUID &id,
+										  const U32 local_id,
+										  const U32 sim_index)
+{
+	U64	indexid = (((U64)sim_index) << 32) | (U64)local_id;
 
-	id = get_if_there(sIndexAndLocalIDToUUID, indexid, LLUUID::null);
+	boost::unordered_map<U64, LLUUID>::const_iterator iter = sIndexAndLocalIDToUUID.find(indexid);
+	if (iter != sIndexAndLocalIDToUUID.end())
+	{
+		id = iter->second;
+	}
+	else
+	{
+		id.setNull();
+	}
 }
 
 U64 LLViewerObjectList::getIndex(const U32 local_id,
@@ -186,7 +205,7 @@ BOOL LLViewerObjectList::removeFromLocalIDTable(const LLViewerObject* objectp)
 		
 		U64	indexid = (((U64)index) << 32) | (U64)local_id;
 		
-		std::map<U64, LLUUID>::iterator iter = sIndexAndLocalIDToUUID.find(indexid);
+		boost::unordered_map<U64, LLUUID>::iterator iter = sIndexAndLocalIDToUUID.find(indexid);
 		if (iter == sIndexAndLocalIDToUUID.end())
 		{
 			return FALSE;
@@ -211,17 +230,7 @@ void LLViewerObjectList::setUUIDAndLocal(const LLUUID &id,
 										  const U32 ip,
 										  const U32 port)
 {
-	U64 ipport = (((U64)ip) << 32) | (U64)port;
-
-	U32 index = sIPAndPortToIndex[ipport];
-
-	if (!index)
-	{
-		index = sSimulatorMachineIndex++;
-		sIPAndPortToIndex[ipport] = index;
-	}
-
-	U64	indexid = (((U64)index) << 32) | (U64)local_id;
+	U64	indexid = (((U64)getSimulatorIndex(ip, port)) << 32) | (U64)local_id;
 
 	sIndexAndLocalIDToUUID[indexid] = id;
 	
@@ -291,6 +300,78 @@ void LLViewerObjectList::processUpdateCore(LLViewerObject* objectp,
 	}
 }
 
+// Largest ObjectData payload we will unpack, compressed or not
+const S32 MAX_OBJECT_UPDATE_SIZE = 2048;
+
+// One ObjectData block of an object update message, read in a single pass
+// over the message before any object is touched.
+struct LLObjectUpdateBlock
+{
+	LLUUID	mFullID;
+	U32		mLocalID;
+	U32		mCRC;			// cached updates
+	LLPCode	mPCode;
+	S32		mDataOffset;	// into sUpdateData, compressed updates
+	S32		mDataSize;		// -1 if the payload could not be unpacked
+};
+
+// Kept between messages so that decoding a message does not allocate once
+// these have grown to the largest update seen.
+static std::vector<LLObjectUpdateBlock> sUpdateBlocks;
+static std::vector<U8> sUpdateData;
+
+static void get_update_u32(LLMessageSystem* mesgsys, LLTemplateMessageReader* reader,
+						   const LLMessageField& field, const char* var, U32& value, S32 block)
+{
+	if (reader && field.isValid())
+	{
+		reader->getField(field, value, block);
+	}
+	else
+	{
+		mesgsys->getU32Fast(_PREHASH_ObjectData, var, value, block);
+	}
+}
+
+// Copies (and inflates, if flagged) the Data field of one block into data,
+// which has room for MAX_OBJECT_UPDATE_SIZE bytes. Returns the unpacked
+// size or -1.
+static S32 get_update_data(LLMessageSystem* mesgsys, LLTemplateMessageReader* reader,
+						   const LLMessageField& field, S32 block, bool zlib, U8* data)
+{
+	U8 copy[MAX_OBJECT_UPDATE_SIZE];
+	const U8* src = NULL;
+	S32 size = 0;
+	if (reader && field.isValid())
+	{
+		src = reader->getFieldData(field, block, size);
+	}
+	else
+	{
+		size = llmin(mesgsys->getSizeFast(_PREHASH_ObjectData, block, _PREHASH_Data), MAX_OBJECT_UPDATE_SIZE);
+		mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, copy, size, block, MAX_OBJECT_UPDATE_SIZE);
+		src = copy;
+	}
+	if (!src || size <= 0)
+	{
+		return -1;
+	}
+
+	if (zlib)
+	{
+		uLongf uncompressed_length = MAX_OBJECT_UPDATE_SIZE;
+		if (uncompress(data, &uncompressed_length, src, size) != Z_OK)
+		{
+			return -1;
+		}
+		return (S32)uncompressed_length;
+	}
+
+	size = llmin(size, MAX_OBJECT_UPDATE_SIZE);
+	memcpy(data, src, size);		/* Flawfinder: ignore */
+	return size;
+}
+
 void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 											 void **user_data,
 											 const EObjectUpdateType update_type,
@@ -311,34 +392,14 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 	// Until we get region-locality working on viewer we
 	// have to transform to absolute coordinates.
 	num_objects = mesgsys->getNumberOfBlocksFast(_PREHASH_ObjectData);
+	mNumObjectUpdates += num_objects;
 
 	if (!cached && !compressed && update_type != OUT_FULL)
 	{
 		gTerseObjectUpdates += num_objects;
-		S32 size;
-		if (mesgsys->getReceiveCompressedSize())
-		{
-			size = mesgsys->getReceiveCompressedSize();
-		}
-		else
-		{
-			size = mesgsys->getReceiveSize();
-		}
-		// llinfos << "Received terse " << num_objects << " in " << size << " byte (" << size/num_objects << ")" << llendl;
 	}
 	else
 	{
-		S32 size;
-		if (mesgsys->getReceiveCompressedSize())
-		{
-			size = mesgsys->getReceiveCompressedSize();
-		}
-		else
-		{
-			size = mesgsys->getReceiveSize();
-		}
-
-		// llinfos << "Received " << num_objects << " in " << size << " byte (" << size/num_objects << ")" << llendl;
 		gFullObjectUpdates += num_objects;
 	}
 
@@ -352,38 +413,130 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		return;
 	}
 
-	U8 compressed_dpbuffer[2048];
-	LLDataPackerBinaryBuffer compressed_dp(compressed_dpbuffer, 2048);
-	LLDataPacker *cached_dpp = NULL;
+	// Field handles for this message, so the per block reads below skip
+	// the name lookups. Without a template reader we fall back to names.
+	LLTemplateMessageReader* reader = mesgsys->getTemplateReader();
+	const LLMessageTemplate* message_template = reader ? reader->getCurrentTemplate() : NULL;
+	LLMessageField id_field, crc_field, flags_field, data_field, full_id_field, pcode_field;
+	if (message_template)
+	{
+		if (cached)
+		{
+			id_field = LLMessageField(message_template, _PREHASH_ObjectData, _PREHASH_ID);
+			crc_field = LLMessageField(message_template, _PREHASH_ObjectData, _PREHASH_CRC);
+		}
+		else if (compressed)
+		{
+			if (update_type != OUT_TERSE_IMPROVED)
+			{
+				flags_field = LLMessageField(message_template, _PREHASH_ObjectData, _PREHASH_UpdateFlags);
+			}
+			data_field = LLMessageField(message_template, _PREHASH_ObjectData, _PREHASH_Data);
+		}
+		else
+		{
+			id_field = LLMessageField(message_template, _PREHASH_ObjectData, _PREHASH_ID);
+			if (update_type == OUT_FULL)
+			{
+				full_id_field = LLMessageField(message_template, _PREHASH_ObjectData, _PREHASH_FullID);
+				pcode_field = LLMessageField(message_template, _PREHASH_ObjectData, _PREHASH_PCode);
+			}
+		}
+	}
+
+	// First pass: pull everything we need out of the message for all the
+	// blocks at once.
+	if ((S32)sUpdateBlocks.size() < num_objects)
+	{
+		sUpdateBlocks.resize(num_objects);
+	}
+	if (compressed && (S32)sUpdateData.size() < num_objects * MAX_OBJECT_UPDATE_SIZE)
+	{
+		sUpdateData.resize(num_objects * MAX_OBJECT_UPDATE_SIZE);
+	}
+	S32 data_offset = 0;
+	for (i = 0; i < num_objects; i++)
+	{
+		LLObjectUpdateBlock& block = sUpdateBlocks[i];
+		block.mLocalID = 0;
+		block.mCRC = 0;
+		block.mPCode = 0;
+		block.mDataSize = 0;
+
+		if (cached)
+		{
+			get_update_u32(mesgsys, reader, id_field, _PREHASH_ID, block.mLocalID, i);
+			get_update_u32(mesgsys, reader, crc_field, _PREHASH_CRC, block.mCRC, i);
+		}
+		else if (compressed)
+		{
+			U32 flags = 0;
+			if (update_type != OUT_TERSE_IMPROVED)
+			{
+				get_update_u32(mesgsys, reader, flags_field, _PREHASH_UpdateFlags, flags, i);
+			}
+			block.mDataOffset = data_offset;
+			block.mDataSize = get_update_data(mesgsys, reader, data_field, i,
+											  (flags & FLAGS_ZLIB_COMPRESSED) != 0,
+											  &sUpdateData[data_offset]);
+			if (block.mDataSize > 0)
+			{
+				data_offset += block.mDataSize;
+			}
+		}
+		else if (update_type != OUT_FULL)
+		{
+			get_update_u32(mesgsys, reader, id_field, _PREHASH_ID, block.mLocalID, i);
+		}
+		else if (reader && full_id_field.isValid())
+		{
+			reader->getField(full_id_field, block.mFullID, i);
+			reader->getField(id_field, block.mLocalID, i);
+			reader->getField(pcode_field, block.mPCode, i);
+		}
+		else
+		{
+			mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_FullID, block.mFullID, i);
+			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, block.mLocalID, i);
+			mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_PCode, block.mPCode, i);
+		}
+	}
+
+	const U32 sender_ip = mesgsys->getSenderIP();
+	const U32 sender_port = mesgsys->getSenderPort();
+	const U32 sim_index = getSimulatorIndex(sender_ip, sender_port);
+
+	LLDataPackerBinaryBuffer compressed_dp;
+	LLDataPackerBinaryBuffer *cached_dpp = NULL;
 	
+	// Second pass: resolve and update the objects in message order.
 	for (i = 0; i < num_objects; i++)
 	{
-		LLTimer update_timer;
+		const LLObjectUpdateBlock& block = sUpdateBlocks[i];
 		BOOL justCreated = FALSE;
 
 		if (cached)
 		{
-			U32 id;
-			U32 crc;
-			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, id, i);
-			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_CRC, crc, i);
-		
 			// Lookup data packer and add this id to cache miss lists if necessary.
 			U8 cache_miss_type = LLViewerRegion::CACHE_MISS_TYPE_NONE;
-			cached_dpp = regionp->getDP(id, crc, cache_miss_type);
+			cached_dpp = regionp->getDP(block.mLocalID, block.mCRC, cache_miss_type);
 			if (cached_dpp)
 			{
 				// Cache Hit.
 				cached_dpp->reset();
-				cached_dpp->unpackUUID(fullid, "ID");
-				cached_dpp->unpackU32(local_id, "LocalID");
-				cached_dpp->unpackU8(pcode, "PCode");
+				if (!cached_dpp->unpackUUIDFast(fullid) ||
+					!cached_dpp->unpackU32Fast(local_id) ||
+					!cached_dpp->unpackU8Fast(pcode))
+				{
+					llwarns << "Truncated cache entry for local id " << block.mLocalID << llendl;
+					continue;
+				}
 			}
 			else
 			{
 				// Cache Miss.
 				#if LL_RECORD_VIEWER_STATS
-				LLViewerStatsRecorder::instance()->recordCacheMissEvent(id, update_type, cache_miss_type);
+				LLViewerStatsRecorder::instance()->recordCacheMissEvent(block.mLocalID, update_type, cache_miss_type);
 				#endif
 
 				continue; // no data packer, skip this object
@@ -391,47 +544,30 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		}
 		else if (compressed)
 		{
-			U8							compbuffer[2048];
-			S32							uncompressed_length = 2048;
-			S32							compressed_length;
-			compressed_dp.reset();
-
-			U32 flags = 0;
-			if (update_type != OUT_TERSE_IMPROVED)
-			{
-				mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i);
-			}
-			
-			if (flags & FLAGS_ZLIB_COMPRESSED)
+			if (block.mDataSize <= 0)
 			{
-				compressed_length = mesgsys->getSizeFast(_PREHASH_ObjectData, i, _PREHASH_Data);
-				mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, compbuffer, 0, i);
-				uncompressed_length = 2048;
-				uncompress(compressed_dpbuffer, (unsigned long *)&uncompressed_length,
-						   compbuffer, compressed_length);
-				compressed_dp.assignBuffer(compressed_dpbuffer, uncompressed_length);
-			}
-			else
-			{
-				uncompressed_length = mesgsys->getSizeFast(_PREHASH_ObjectData, i, _PREHASH_Data);
-				mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, compressed_dpbuffer, 0, i);
-				compressed_dp.assignBuffer(compressed_dpbuffer, uncompressed_length);
+				llwarns << "Could not unpack object update " << i << " from " << mesgsys->getSender() << llendl;
+				continue;
 			}
-
+			compressed_dp.assignBuffer(&sUpdateData[block.mDataOffset], block.mDataSize);
 
 			if (update_type != OUT_TERSE_IMPROVED)
 			{
-				compressed_dp.unpackUUID(fullid, "ID");
-				compressed_dp.unpackU32(local_id, "LocalID");
-				compressed_dp.unpackU8(pcode, "PCode");
+				if (!compressed_dp.unpackUUIDFast(fullid) ||
+					!compressed_dp.unpackU32Fast(local_id) ||
+					!compressed_dp.unpackU8Fast(pcode))
+				{
+					llwarns << "Truncated object update " << i << " from " << mesgsys->getSender() << llendl;
+					continue;
+				}
 			}
 			else
 			{
-				compressed_dp.unpackU32(local_id, "LocalID");
-				getUUIDFromLocal(fullid,
-								 local_id,
-								 gMessageSystem->getSenderIP(),
-								 gMessageSystem->getSenderPort());
+				if (!compressed_dp.unpackU32Fast(local_id))
+				{
+					continue;
+				}
+				getUUIDFromLocal(fullid, local_id, sim_index);
 				if (fullid.isNull())
 				{
 					// llwarns << "update for unknown localid " << local_id << " host " << gMessageSystem->getSender() << ":" << gMessageSystem->getSenderPort() << llendl;
@@ -441,11 +577,8 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		}
 		else if (update_type != OUT_FULL)
 		{
-			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
-			getUUIDFromLocal(fullid,
-							local_id,
-							gMessageSystem->getSenderIP(),
-							gMessageSystem->getSenderPort());
+			local_id = block.mLocalID;
+			getUUIDFromLocal(fullid, local_id, sim_index);
 			if (fullid.isNull())
 			{
 				// llwarns << "update for unknown localid " << local_id << " host " << gMessageSystem->getSender() << llendl;
@@ -454,8 +587,8 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		}
 		else
 		{
-			mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_FullID, fullid, i);
-			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
+			fullid = block.mFullID;
+			local_id = block.mLocalID;
 			// llinfos << "Full Update, obj " << local_id << ", global ID" << fullid << "from " << mesgsys->getSender() << llendl;
 		}
 		objectp = findObject(fullid);
@@ -480,8 +613,8 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 			removeFromLocalIDTable(objectp);
 			setUUIDAndLocal(fullid,
 							local_id,
-							gMessageSystem->getSenderIP(),
-							gMessageSystem->getSenderPort());
+							sender_ip,
+							sender_port);
 			
 			if (objectp->mLocalID != local_id)
 			{    // Update local ID in object with the one sent from the region
@@ -515,7 +648,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 					continue;
 				}
 
-				mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_PCode, pcode, i);
+				pcode = block.mPCode;
 			}
 #ifdef IGNORE_DEAD
 			if (mDeadObjects.find(fullid) != mDeadObjects.end())
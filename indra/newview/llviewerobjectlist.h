@@ -35,6 +35,7 @@
 
 #include <map>
 #include <set>
+#include <boost/unordered_map.hpp>
 
 // common includes
 #include "llstat.h"
@@ -172,6 +173,7 @@ public:
 	U32	mCurBin; // Current bin we're working on...
 
 	S32 mNumNewObjects;
+	S32 mNumObjectUpdates;	// ObjectData blocks handled this frame
 
 	S32 mNumSizeCulled;
 	S32 mNumVisCulled;
@@ -189,6 +191,11 @@ public:
 								const U32 ip,
 								const U32 port); // Requires knowledge of message system info!
 
+	// Same lookup with the simulator index already resolved, for callers
+	// handling many objects from one sender.
+	static U32 getSimulatorIndex(const U32 ip, const U32 port);
+	static void getUUIDFromLocal(LLUUID &id, const U32 local_id, const U32 sim_index);
+
 	static BOOL removeFromLocalIDTable(const LLViewerObject* objectp);
 	// Used ONLY by the orphaned object code.
 	static U64 getIndex(const U32 local_id, const U32 ip, const U32 port);
@@ -212,7 +219,8 @@ public:
 
 	std::set<LLUUID> mDeadObjects;	
 
-	std::map<LLUUID, LLPointer<LLViewerObject> > mUUIDObjectMap;
+	typedef boost::unordered_map<LLUUID, LLPointer<LLViewerObject> > uuid_object_map_t;
+	uuid_object_map_t mUUIDObjectMap;
 	std::map<LLUUID, LLPointer<LLVOAvatar> > mUUIDAvatarMap;
 
 	//set of objects that need to update their cost
@@ -228,9 +236,9 @@ public:
 	S32 mCurLazyUpdateIndex;
 
 	static U32 sSimulatorMachineIndex;
-	static std::map<U64, U32> sIPAndPortToIndex;
+	static boost::unordered_map<U64, U32> sIPAndPortToIndex;
 
-	static std::map<U64, LLUUID> sIndexAndLocalIDToUUID;
+	static boost::unordered_map<U64, LLUUID> sIndexAndLocalIDToUUID;
 
 	std::set<LLViewerObject *> mSelectPickList;
 
@@ -265,7 +273,7 @@ extern LLViewerObjectList gObjectList;
 // Inlines
 inline LLViewerObject *LLViewerObjectList::findObject(const LLUUID &id) const
 {
-	std::map<LLUUID, LLPointer<LLViewerObject> >::const_iterator iter = mUUIDObjectMap.find(id);
+	uuid_object_map_t::const_iterator iter = mUUIDObjectMap.find(id);
 	if(iter != mUUIDObjectMap.end())
 	{
 		return iter->second;
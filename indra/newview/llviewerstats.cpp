@@ -270,6 +270,7 @@ LLViewerStats::LLViewerStats() :
 	mNumObjectsStat("numobjectsstat"),
 	mNumActiveObjectsStat("numactiveobjectsstat"),
 	mNumNewObjectsStat("numnewobjectsstat"),
+	mNumObjectUpdatesStat("numobjectupdatesstat"),
 	mNumSizeCulledStat("numsizeculledstat"),
 	mNumVisCulledStat("numvisculledstat"),
 	mLastTimeDiff(0.0)
@@ -631,6 +632,13 @@ void update_statistics(U32 frame_count)
 		LLViewerStats::getInstance()->mSimPingStat.addValue(cdp->getPingDelay());
 		gAvgSimPing = ((gAvgSimPing * (F32)gSimPingCount) + (F32)(cdp->getPingDelay())) / ((F32)gSimPingCount + 1);
 		gSimPingCount++;
+
+		LLThrottleGroup& tg = cdp->getThrottleGroup();
+		for (S32 i = 0; i < TC_EOF; i++)
+		{
+			LLViewerStats::getInstance()->mThrottleKBitStat[i].addValue(tg.getAchievedBPS(i) / 1024.f);
+			LLViewerStats::getInstance()->mThrottleQueueKBitStat[i].addValue(tg.getQueueDepth(i) / 1024.f);
+		}
 	}
 	else
 	{
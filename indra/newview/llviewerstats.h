@@ -35,6 +35,7 @@
 
 #include "llstat.h"
 #include "lltextureinfo.h"
+#include "llthrottle.h"
 
 class LLViewerStats : public LLSingleton<LLViewerStats>
 {
@@ -45,6 +46,8 @@ public:
 	LLStat mAssetKBitStat;
 	LLStat mTextureKBitStat;
 	LLStat mVFSPendingOperations;
+	LLStat mThrottleKBitStat[TC_EOF];		// achieved outgoing rate per throttle category
+	LLStat mThrottleQueueKBitStat[TC_EOF];	// outgoing backlog per throttle category
 	LLStat mObjectsDrawnStat;
 	LLStat mObjectsCulledStat;
 	LLStat mObjectsTestedStat;
@@ -113,6 +116,7 @@ public:
 	LLStat mNumObjectsStat;
 	LLStat mNumActiveObjectsStat;
 	LLStat mNumNewObjectsStat;
+	LLStat mNumObjectUpdatesStat;
 	LLStat mNumSizeCulledStat;
 	LLStat mNumVisCulledStat;
 
@@ -58,6 +58,7 @@
 #include "lldrawpool.h"
 #include "lltexturefetch.h"
 #include "llviewertexturelist.h"
+#include "lltexturememorymanager.h"
 #include "llviewercontrol.h"
 #include "pipeline.h"
 #include "llappviewer.h"
@@ -435,6 +436,7 @@ S32 LLViewerTexture::getCategoryFromIndex(S32 index)
 // tuning params
 const F32 discard_bias_delta = .25f;
 const F32 discard_delta_time = 0.5f;
+const F32 EVICTION_HOLD_TIME = 10.f; // seconds an evicted texture stays at the lower resolution
 const S32 min_non_tex_system_mem = (128<<20); // 128 MB
 // non-const (used externally
 F32 texmem_lower_bound_scale = 0.85f;
@@ -544,6 +546,8 @@ void LLViewerTexture::updateClass(const F32 velocity, const F32 angular_velocity
 
 	LLViewerTexture::sFreezeImageScalingDown = (BYTES_TO_MEGA_BYTES(sBoundTextureMemoryInBytes) < 0.75f * sMaxBoundTextureMemInMegaBytes * texmem_middle_bound_scale) &&
 				(BYTES_TO_MEGA_BYTES(sTotalTextureMemoryInBytes) < 0.75f * sMaxTotalTextureMemInMegaBytes * texmem_middle_bound_scale) ;
+
+	LLTextureMemoryManager::update();
 }
 
 //end of static functions
@@ -1223,6 +1227,12 @@ void LLViewerFetchedTexture::init(bool firstinit)
 	{
 		mDecodePriority = 0.f;
 		mInImageList = 0;
+		mPriorityDirty = FALSE;
+		mResidentDiscardLevel = -1;
+		mResidentBytes = 0;
+		mEvictedDiscardLevel = -1;
+		mEvictedTime = 0.f;
+		mEvictedVirtualSize = 0.f;
 	}
 
 	// Only set mIsMissingAsset true when we know for certain that the database
@@ -1273,6 +1283,7 @@ LLViewerFetchedTexture::~LLViewerFetchedTexture()
 	{
 		LLAppViewer::getTextureFetch()->deleteRequest(getID(), true);
 	}
+	LLTextureMemoryManager::updateResidency(this, true);
 	cleanup();	
 }
 
@@ -1315,6 +1326,7 @@ void LLViewerFetchedTexture::setForSculpt()
 	if(isForSculptOnly() && !getBoundRecently())
 	{
 		destroyGLTexture() ; //sculpt image does not need gl texture.
+		LLTextureMemoryManager::updateResidency(this);
 	}
 	checkCachedRawSculptImage() ;
 	setMaxVirtualSizeResetInterval(MAX_INTERVAL) ;
@@ -1405,6 +1417,7 @@ void LLViewerFetchedTexture::destroyTexture()
 	}
 	
 	destroyGLTexture() ;
+	LLTextureMemoryManager::updateResidency(this);
 	mFullyLoaded = FALSE ;
 }
 
@@ -1572,6 +1585,7 @@ BOOL LLViewerFetchedTexture::createTexture(S32 usename/*= 0*/)
 			res = mGLTexturep->createGLTexture(mRawDiscardLevel, mRawImage, usename, TRUE, mBoostLevel);
 			//resetFaceAtlas() ;
 		//}
+		LLTextureMemoryManager::updateResidency(this);
 		setActive() ;
 	}
 
@@ -1881,6 +1895,35 @@ void LLViewerFetchedTexture::updateVirtualSize()
 	reorganizeVolumeList();
 }
 
+S32 LLViewerFetchedTexture::getEvictableBytes() const
+{
+	if (mResidentBytes <= 0 || mBoostLevel >= LLViewerTexture::BOOST_SCULPTED ||
+		mForceToSaveRawImage || mNeedsCreateTexture || isJustBound() ||
+		mCachedRawImage.isNull() || mCachedRawDiscardLevel <= mResidentDiscardLevel)
+	{
+		return 0;
+	}
+	// Each discard level holds a quarter of the texels of the one before.
+	S32 levels = llmin(mCachedRawDiscardLevel - mResidentDiscardLevel, 8);
+	return mResidentBytes - (mResidentBytes >> (2 * levels));
+}
+
+F32 LLViewerFetchedTexture::getPredictedVirtualSize(const LLVector3& camera_now, const LLVector3& camera_future) const
+{
+	// Pixel area goes with the inverse square of distance, so scale the
+	// current need by how much closer the nearest face is getting.
+	const U32 MAX_FACES = 16;
+	F32 ratio = 1.f;
+	for (U32 i = 0; i < llmin(mNumFaces, MAX_FACES); i++)
+	{
+		LLVector3 position = mFaceList[i]->getPositionAgent();
+		F32 dist_now = llmax(dist_vec_squared(position, camera_now), 1.f);
+		F32 dist_future = llmax(dist_vec_squared(position, camera_future), 1.f);
+		ratio = llmax(ratio, dist_now / dist_future);
+	}
+	return mMaxVirtualSize * llmin(ratio, 16.f);
+}
+
 S32 LLViewerFetchedTexture::getCurrentDiscardLevelForFetching()
 {
 	S32 current_discard = getDiscardLevel() ;
@@ -3198,6 +3241,15 @@ void LLViewerLODTexture::processTextureStats()
 		// Clamp to min desired discard
 		mDesiredDiscardLevel = llmin(mMinDesiredDiscardLevel, mDesiredDiscardLevel);
 
+		// Don't fetch straight back what was just evicted unless the need
+		// for it has grown a lot since.
+		if (mEvictedDiscardLevel >= 0 &&
+			sCurrentTime - mEvictedTime < EVICTION_HOLD_TIME &&
+			mMaxVirtualSize < mEvictedVirtualSize * 4.f)
+		{
+			mDesiredDiscardLevel = llmax(mDesiredDiscardLevel, mEvictedDiscardLevel);
+		}
+
 		//
 		// At this point we've calculated the quality level that we want,
 		// if possible.  Now we check to see if we have it, and take the
@@ -3213,18 +3265,8 @@ void LLViewerLODTexture::processTextureStats()
 				//needs to release texture memory urgently
 				scaleDown() ;
 			}
-			// Limit the amount of GL memory bound each frame
-			if ( BYTES_TO_MEGA_BYTES(sBoundTextureMemoryInBytes) > sMaxBoundTextureMemInMegaBytes * texmem_middle_bound_scale &&
-				(!getBoundRecently() || mDesiredDiscardLevel >= mCachedRawDiscardLevel))
-			{
-				scaleDown() ;
-			}
-			// Only allow GL to have 2x the video card memory
-			else if ( BYTES_TO_MEGA_BYTES(sTotalTextureMemoryInBytes) > sMaxTotalTextureMemInMegaBytes*texmem_middle_bound_scale &&
-				(!getBoundRecently() || mDesiredDiscardLevel >= mCachedRawDiscardLevel))
-			{
-				scaleDown() ;
-			}
+			// The bound and total GL memory limits are kept by
+			// LLTextureMemoryManager, which picks what to evict.
 		}
 	}
 
@@ -3241,6 +3283,20 @@ void LLViewerLODTexture::processTextureStats()
 	}
 }
 
+bool LLViewerLODTexture::evict()
+{
+	S32 evicted_discard = mCachedRawDiscardLevel;
+	if (!scaleDown())
+	{
+		return false;
+	}
+	mEvictedDiscardLevel = (S8)evicted_discard;
+	mEvictedTime = sCurrentTime;
+	mEvictedVirtualSize = mMaxVirtualSize;
+	mDesiredDiscardLevel = llmax(mDesiredDiscardLevel, (S8)evicted_discard);
+	return true;
+}
+
 bool LLViewerLODTexture::scaleDown()
 {
 	if(hasGLTexture() && mCachedRawDiscardLevel > getDiscardLevel())
@@ -354,6 +354,7 @@ class LLViewerFetchedTexture : public LLViewerTexture
 {
 	friend class LLTextureBar; // debug info only
 	friend class LLTextureView; // debug info only
+	friend class LLTextureMemoryManager;
 
 protected:
 	/*virtual*/ ~LLViewerFetchedTexture();
@@ -425,6 +426,12 @@ public:
 	
 	void updateVirtualSize() ;
 
+	// GL bytes that dropping to the cached raw image would free, 0 if this
+	// texture should not be evicted right now.
+	S32  getEvictableBytes() const ;
+	// Virtual size expected once the camera has moved from camera_now to camera_future.
+	F32  getPredictedVirtualSize(const LLVector3& camera_now, const LLVector3& camera_future) const ;
+
 	S32  getDesiredDiscardLevel()			 { return mDesiredDiscardLevel; }
 	void setMinDiscardLevel(S32 discard) 	{ mMinDesiredDiscardLevel = llmin(mMinDesiredDiscardLevel,(S8)discard); }
 
@@ -446,6 +453,9 @@ public:
 	BOOL isInImageList() const {return mInImageList ;}
 	void setInImageList(BOOL flag) {mInImageList = flag ;}
 
+	BOOL isPriorityDirty() const {return mPriorityDirty ;}
+	void setPriorityDirty(BOOL flag) {mPriorityDirty = flag ;}
+
 	LLFrameTimer* getLastPacketTimer() {return &mLastPacketTimer;}
 
 	U32 getFetchPriority() const { return mFetchPriority ;}
@@ -577,6 +587,14 @@ protected:
 	LLFrameTimer mStopFetchingTimer;	// Time since mDecodePriority == 0.f.
 
 	BOOL  mInImageList;				// TRUE if image is in list (in which case don't reset priority!)
+	BOOL  mPriorityDirty;			// TRUE if queued for a decode priority update
+
+	// LLTextureMemoryManager bookkeeping
+	S8    mResidentDiscardLevel;	// discard level accounted as resident, -1 if none
+	S32   mResidentBytes;
+	S8    mEvictedDiscardLevel;		// level last evicted to, -1 once fetched back
+	F32   mEvictedTime;
+	F32   mEvictedVirtualSize;		// virtual size when evicted
 	BOOL  mNeedsCreateTexture;	
 
 	BOOL   mForSculpt ; //a flag if the texture is used as sculpt data.
@@ -607,6 +625,10 @@ public:
 	/*virtual*/ void processTextureStats();
 	BOOL isUpdateFrozen() ;
 
+	// Drops to the cached lower resolution to free GL memory, and holds
+	// there for a while unless the texture's need grows.
+	bool evict() ;
+
 private:
 	void init(bool firstinit) ;
 	bool scaleDown() ;		
@@ -57,6 +57,7 @@
 
 #include "lltexturecache.h"
 #include "lltexturefetch.h"
+#include "lltexturememorymanager.h"
 #include "llviewercontrol.h"
 #include "llviewertexture.h"
 #include "llviewermedia.h"
@@ -79,6 +80,9 @@ LLViewerTextureList gTextureList;
 
 LLViewerTextureList::LLViewerTextureList() 
 	: mForceResetTextureStats(FALSE),
+	mPriorityUpdateCount(0),
+	mPriorityChangeCount(0),
+	mPriorityDirtyCount(0),
 	mUpdateStats(FALSE),
 	mMaxResidentTexMemInMegaBytes(0),
 	mMaxTotalTextureMemInMegaBytes(0),
@@ -296,6 +300,11 @@ void LLViewerTextureList::shutdown()
 	
 	mImageList.clear();
 
+	for (S32 i = 0; i < PRIORITY_BUCKET_COUNT; i++)
+	{
+		mPriorityBuckets[i].clear();
+	}
+
 	mInitialized = FALSE ; //prevent loading textures again.
 }
 
@@ -314,17 +323,30 @@ void LLViewerTextureList::dump()
 		<< " http://asset.siva.lindenlab.com/" << image->getID() << ".texture"
 		<< llendl;
 	}
+	LLTextureMemoryManager::dumpStats();
 }
 
 void LLViewerTextureList::destroyGL(BOOL save_state)
 {
 	LLImageGL::destroyGL(save_state);
+	updateResidency();
 }
 
 void LLViewerTextureList::restoreGL()
 {
 	llassert_always(mInitialized) ;
 	LLImageGL::restoreGL();
+	updateResidency();
+}
+
+// LLImageGL releases and recreates GL textures behind the fetched
+// textures' backs, so their GL memory is accounted again afterwards.
+void LLViewerTextureList::updateResidency()
+{
+	for (uuid_map_t::iterator iter = mUUIDMap.begin(); iter != mUUIDMap.end(); ++iter)
+	{
+		LLTextureMemoryManager::updateResidency(iter->second);
+	}
 }
 
 /* Vertical tab container button image IDs
@@ -609,6 +631,22 @@ void LLViewerTextureList::dirtyImage(LLViewerFetchedTexture *image)
 	mDirtyTextureList.insert(image);
 }
 
+void LLViewerTextureList::dirtyImagePriority(LLViewerFetchedTexture *image, F32 virtual_size)
+{
+	if (image->isPriorityDirty() || !image->isInImageList())
+	{
+		return;
+	}
+	// Bucket 0 holds everything up to 16x16 pixels, bucket 7 from 1024x1024.
+	S32 bucket = 0;
+	if (virtual_size > 256.f)
+	{
+		bucket = llclamp((S32)(logf(virtual_size) / logf(4.f)) - 3, 0, PRIORITY_BUCKET_COUNT - 1);
+	}
+	image->setPriorityDirty(TRUE);
+	mPriorityBuckets[bucket].push_back(image);
+}
+
 ////////////////////////////////////////////////////////////////////////////
 //static LLFastTimer::DeclareTimer FTM_IMAGE_MARK_DIRTY("Dirty Images");
 
@@ -627,9 +665,8 @@ void LLViewerTextureList::updateImages(F32 max_time)
 	LLViewerStats::getInstance()->mRawMemStat.addValue((F32)BYTES_TO_MEGA_BYTES(global_raw_memory));
 	LLViewerStats::getInstance()->mFormattedMemStat.addValue((F32)BYTES_TO_MEGA_BYTES(LLImageFormatted::sGlobalFormattedMemory));
 	
-	updateImagesDecodePriorities();
-
 	F32 total_max_time = max_time;
+	max_time -= updateImagesDecodePriorities(max_time * .25f);
 	max_time -= updateImagesFetchTextures(max_time);
 	
 	max_time = llmax(max_time, total_max_time*.50f); // at least 50% of max_time
@@ -666,14 +703,45 @@ void LLViewerTextureList::updateImages(F32 max_time)
 	updateImagesUpdateStats();
 }
 
-void LLViewerTextureList::updateImagesDecodePriorities()
+// Returns the time spent. Images whose faces changed size are updated
+// first, largest first, within max_time; the rest of the budget goes to
+// the round robin over all images, which also flushes unused ones.
+F32 LLViewerTextureList::updateImagesDecodePriorities(F32 max_time)
 {
-	// Update the decode priority for N images each frame
+	LLTimer update_timer;
+	mPriorityUpdateCount = 0;
+	mPriorityChangeCount = 0;
+	mPriorityDirtyCount = 0;
+
+	for (S32 bucket = PRIORITY_BUCKET_COUNT - 1; bucket >= 0; bucket--)
+	{
+		std::vector<LLPointer<LLViewerFetchedTexture> >& dirty_list = mPriorityBuckets[bucket];
+		while (!dirty_list.empty() && update_timer.getElapsedTimeF32() < max_time)
+		{
+			LLPointer<LLViewerFetchedTexture> imagep = dirty_list.back();
+			dirty_list.pop_back();
+			imagep->setPriorityDirty(FALSE);
+			// Deleted or unlisted since it was queued.
+			if (imagep->isDeleted() || !imagep->isInImageList())
+			{
+				continue;
+			}
+			updateImageDecodePriority(imagep);
+			mPriorityDirtyCount++;
+		}
+	}
+
+	// Update the decode priority for N images each frame, and more while
+	// there is time left, up to a tenth of all images
 	{
 		const size_t max_update_count = llmin((S32) (1024*gFrameIntervalSeconds) + 1, 32); //target 1024 textures per second
-		S32 update_counter = llmin(max_update_count, mUUIDMap.size()/10);
+		const S32 min_update_count = llmin(max_update_count, mUUIDMap.size()/10);
+		const S32 max_budget_count = mUUIDMap.size()/10;
+		S32 update_count = 0;
+		S32 visit_counter = mUUIDMap.size(); // never go round more than once
 		uuid_map_t::iterator iter = mUUIDMap.upper_bound(mLastUpdateUUID);
-		while(update_counter > 0 && !mUUIDMap.empty())
+		while(update_count < max_budget_count && visit_counter-- > 0 && !mUUIDMap.empty()
+			  && (update_count < min_update_count || update_timer.getElapsedTimeF32() < max_time))
 		{
 			if (iter == mUUIDMap.end())
 			{
@@ -689,6 +757,10 @@ void LLViewerTextureList::updateImagesDecodePriorities()
 			const F32 LAZY_FLUSH_TIMEOUT = 30.f; // stop decoding
 			const F32 MAX_INACTIVE_TIME  = 50.f; // actually delete
 			S32 min_refs = 3; // 1 for mImageList, 1 for mUUIDMap, 1 for local reference
+			if (imagep->isPriorityDirty())
+			{
+				min_refs++; // 1 for mPriorityBuckets
+			}
 			
 			S32 num_refs = imagep->getNumRefs();
 			if (num_refs == min_refs)
@@ -737,22 +809,34 @@ void LLViewerTextureList::updateImagesDecodePriorities()
 				}
 			}
 			
-			imagep->processTextureStats();
-			F32 old_priority = imagep->getDecodePriority();
-			F32 old_priority_test = llmax(old_priority, 0.0f);
-			F32 decode_priority = imagep->calcDecodePriority();
-			F32 decode_priority_test = llmax(decode_priority, 0.0f);
-			// Ignore < 20% difference
-			if ((decode_priority_test < old_priority_test * .8f) ||
-				(decode_priority_test > old_priority_test * 1.25f))
-			{
-				removeImageFromList(imagep);
-				imagep->setDecodePriority(decode_priority);
-				addImageToList(imagep);
-			}
-			update_counter--;
+			updateImageDecodePriority(imagep);
+			update_count++;
 		}
 	}
+	return update_timer.getElapsedTimeF32();
+}
+
+// Recomputes the decode priority of one listed image. Returns true if it
+// changed enough to move the image in mImageList.
+bool LLViewerTextureList::updateImageDecodePriority(LLViewerFetchedTexture* imagep)
+{
+	mPriorityUpdateCount++;
+	imagep->processTextureStats();
+	F32 old_priority = imagep->getDecodePriority();
+	F32 old_priority_test = llmax(old_priority, 0.0f);
+	F32 decode_priority = imagep->calcDecodePriority();
+	F32 decode_priority_test = llmax(decode_priority, 0.0f);
+	// Ignore < 20% difference
+	if ((decode_priority_test < old_priority_test * .8f) ||
+		(decode_priority_test > old_priority_test * 1.25f))
+	{
+		removeImageFromList(imagep);
+		imagep->setDecodePriority(decode_priority);
+		addImageToList(imagep);
+		mPriorityChangeCount++;
+		return true;
+	}
+	return false;
 }
 
 /*
@@ -72,6 +72,7 @@ class LLViewerTextureList
 
 	friend class LLTextureView;
 	friend class LLViewerTextureManager;
+	friend class LLTextureMemoryManager;
 	
 public:
 	static BOOL createUploadFile(const std::string& filename, const std::string& out_filename, const U8 codec);
@@ -95,6 +96,9 @@ public:
 	LLViewerFetchedTexture *findImage(const LLUUID &image_id);
 
 	void dirtyImage(LLViewerFetchedTexture *image);
+	// Queues image for a decode priority update ahead of the round robin,
+	// bucketed by virtual_size so the largest on-screen changes go first.
+	void dirtyImagePriority(LLViewerFetchedTexture *image, F32 virtual_size);
 	
 	// Using image stats, determine what images are necessary, and perform image updates.
 	void updateImages(F32 max_time);
@@ -120,10 +124,12 @@ public:
 	static S32 getMaxVideoRamSetting(bool get_recommended = false);
 	
 private:
-	void updateImagesDecodePriorities();
+	F32  updateImagesDecodePriorities(F32 max_time);
+	bool updateImageDecodePriority(LLViewerFetchedTexture* imagep);
 	F32  updateImagesCreateTextures(F32 max_time);
 	F32  updateImagesFetchTextures(F32 max_time);
 	void updateImagesUpdateStats();
+	void updateResidency();
 
 public:
 	void addImage(LLViewerFetchedTexture *image);
@@ -184,6 +190,11 @@ public:
 	std::set<LLViewerFetchedTexture*> mDirtyTextureList;
 	
 	BOOL mForceResetTextureStats;
+
+	// Decode priority updates during the last frame
+	S32 mPriorityUpdateCount;	// priorities recomputed
+	S32 mPriorityChangeCount;	// priorities that moved the image in mImageList
+	S32 mPriorityDirtyCount;	// recomputed because a face changed size
     
 private:
 	typedef std::map< LLUUID, LLPointer<LLViewerFetchedTexture> > uuid_map_t;
@@ -194,6 +205,10 @@ private:
 	typedef std::set<LLPointer<LLViewerFetchedTexture>, LLViewerFetchedTexture::Compare> image_priority_list_t;	
 	image_priority_list_t mImageList;
 
+	// Images waiting for a priority update, one bucket per factor of 4 in virtual size.
+	enum { PRIORITY_BUCKET_COUNT = 8 };
+	std::vector<LLPointer<LLViewerFetchedTexture> > mPriorityBuckets[PRIORITY_BUCKET_COUNT];
+
 	// simply holds on to LLViewerFetchedTexture references to stop them from being purged too soon
 	std::set<LLPointer<LLViewerFetchedTexture> > mImagePreloads;
 
@@ -39,6 +39,9 @@
 #include "llframetimer.h"
 #include "llviewerstats.h"
 #include "lldatapacker.h"
+#include "llappviewer.h"
+#include "llassetstorage.h"
+#include "lltexturefetch.h"
 
 // consts
 
@@ -55,6 +58,9 @@ const F32 STEP_FRACTIONAL = 0.1f;
 const F32 TIGHTEN_THROTTLE_THRESHOLD = 3.0f; // packet loss % per s
 const F32 EASE_THROTTLE_THRESHOLD = 0.5f; // packet loss % per s
 const F32 DYNAMIC_UPDATE_DURATION = 5.0f; // seconds
+const F32 PENDING_REQUEST_BITS = 8000.f; // roughly one packet owed per outstanding request
+const F32 BACKLOG_DRAIN_TIME = 2.f; // seconds we'd like the sim to clear a backlog in
+const F32 REBALANCE_THRESHOLD = 0.1f; // fraction of a category's share worth re-sending for
 
 LLViewerThrottle gViewerThrottle;
 
@@ -308,30 +314,101 @@ void LLViewerThrottle::updateDynamicThrottle()
 	}
 	mUpdateTimer.reset();
 
+	BOOL changed = FALSE;
 	if (LLViewerStats::getInstance()->mPacketsLostPercentStat.getMean() > TIGHTEN_THROTTLE_THRESHOLD)
 	{
-		if (mThrottleFrac <= MIN_FRACTIONAL || mCurrentBandwidth / 1024.0f <= MIN_BANDWIDTH)
+		if (mThrottleFrac > MIN_FRACTIONAL && mCurrentBandwidth / 1024.0f > MIN_BANDWIDTH)
 		{
-			return;
+			mThrottleFrac -= STEP_FRACTIONAL;
+			mThrottleFrac = llmax(MIN_FRACTIONAL, mThrottleFrac);
+			mCurrentBandwidth = mMaxBandwidth * mThrottleFrac;
+			mCurrent = getThrottleGroup(mCurrentBandwidth / 1024.0f);
+			changed = TRUE;
+			llinfos << "Tightening network throttle to " << mCurrentBandwidth << llendl;
 		}
-		mThrottleFrac -= STEP_FRACTIONAL;
-		mThrottleFrac = llmax(MIN_FRACTIONAL, mThrottleFrac);
-		mCurrentBandwidth = mMaxBandwidth * mThrottleFrac;
-		mCurrent = getThrottleGroup(mCurrentBandwidth / 1024.0f);
-		mCurrent.sendToSim();
-		llinfos << "Tightening network throttle to " << mCurrentBandwidth << llendl;
 	}
 	else if (LLViewerStats::getInstance()->mPacketsLostPercentStat.getMean() <= EASE_THROTTLE_THRESHOLD)
 	{
-		if (mThrottleFrac >= MAX_FRACTIONAL || mCurrentBandwidth / 1024.0f >= MAX_BANDWIDTH)
+		if (mThrottleFrac < MAX_FRACTIONAL && mCurrentBandwidth / 1024.0f < MAX_BANDWIDTH)
 		{
-			return;
+			mThrottleFrac += STEP_FRACTIONAL;
+			mThrottleFrac = llmin(MAX_FRACTIONAL, mThrottleFrac);
+			mCurrentBandwidth = mMaxBandwidth * mThrottleFrac;
+			mCurrent = getThrottleGroup(mCurrentBandwidth/1024.0f);
+			changed = TRUE;
+			llinfos << "Easing network throttle to " << mCurrentBandwidth << llendl;
 		}
-		mThrottleFrac += STEP_FRACTIONAL;
-		mThrottleFrac = llmin(MAX_FRACTIONAL, mThrottleFrac);
-		mCurrentBandwidth = mMaxBandwidth * mThrottleFrac;
-		mCurrent = getThrottleGroup(mCurrentBandwidth/1024.0f);
+	}
+
+	if (LLThrottleGroup::getAdaptive())
+	{
+		changed = rebalanceThrottle(changed);
+	}
+
+	if (changed)
+	{
 		mCurrent.sendToSim();
-		llinfos << "Easing network throttle to " << mCurrentBandwidth << llendl;
 	}
 }
+
+// Re-split the current total across the categories by what the sim is
+// actually sending us in each, plus what we are still waiting for.  The
+// loss the sim's resends have to cover counts as resend demand.  Returns
+// TRUE if the split moved enough to be worth telling the sim, or if force
+// is set because the total changed anyway.
+BOOL LLViewerThrottle::rebalanceThrottle(BOOL force)
+{
+	LLViewerStats* stats = LLViewerStats::getInstance();
+	LLViewerThrottleGroup preset = getThrottleGroup(mCurrentBandwidth / 1024.0f);
+
+	F32 nominal[TC_EOF];
+	F32 demand[TC_EOF];
+	F32 priority[TC_EOF];
+	F32 alloc[TC_EOF];
+	S32 i;
+	for (i = 0; i < TC_EOF; i++)
+	{
+		nominal[i] = preset.mThrottles[i] * 1024.f;
+		priority[i] = LLThrottleGroup::getDefaultPriorityWeight(i);
+	}
+
+	F32 loss = llclamp(stats->mPacketsLostPercentStat.getMean() / 100.f, 0.f, 1.f);
+	demand[TC_RESEND] = stats->mKBitStat.getMeanPerSec() * 1024.f * loss;
+
+	// Land, wind and cloud are only measured together.
+	F32 layer_nominal = nominal[TC_LAND] + nominal[TC_WIND] + nominal[TC_CLOUD];
+	F32 layer_bps = stats->mLayersKBitStat.getMeanPerSec() * 1024.f;
+	demand[TC_LAND] = layer_nominal > 0.f ? layer_bps * nominal[TC_LAND] / layer_nominal : 0.f;
+	demand[TC_WIND] = layer_nominal > 0.f ? layer_bps * nominal[TC_WIND] / layer_nominal : 0.f;
+	demand[TC_CLOUD] = layer_nominal > 0.f ? layer_bps * nominal[TC_CLOUD] / layer_nominal : 0.f;
+
+	demand[TC_TASK] = stats->mObjectKBitStat.getMeanPerSec() * 1024.f;
+
+	// Textures fetched over HTTP don't use the sim's texture channel.
+	LLTextureFetch* fetch = LLAppViewer::getTextureFetch();
+	S32 udp_textures = fetch ? llmax(fetch->getNumRequests() - fetch->getNumHTTPRequests(), 0) : 0;
+	demand[TC_TEXTURE] = stats->mTextureKBitStat.getMeanPerSec() * 1024.f
+		+ udp_textures * PENDING_REQUEST_BITS / BACKLOG_DRAIN_TIME;
+
+	S32 assets = gAssetStorage ? gAssetStorage->getNumPendingDownloads() : 0;
+	demand[TC_ASSET] = stats->mAssetKBitStat.getMeanPerSec() * 1024.f
+		+ assets * PENDING_REQUEST_BITS / BACKLOG_DRAIN_TIME;
+
+	LLThrottleGroup::allocateByDemand(nominal, demand, priority, 1.f, alloc);
+
+	BOOL changed = force;
+	for (i = 0; i < TC_EOF; i++)
+	{
+		alloc[i] /= 1024.f;
+		if (fabs(alloc[i] - mCurrent.mThrottles[i]) > REBALANCE_THRESHOLD * preset.mThrottles[i])
+		{
+			changed = TRUE;
+		}
+	}
+	if (changed)
+	{
+		mCurrent = LLViewerThrottleGroup(alloc);
+		mCurrent.dump();
+	}
+	return changed;
+}
@@ -80,6 +80,8 @@ public:
 
 	static const std::string sNames[TC_EOF];
 protected:
+	BOOL rebalanceThrottle(BOOL force);
+
 	F32 mMaxBandwidth;
 	F32 mCurrentBandwidth;
 
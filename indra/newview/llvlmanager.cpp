@@ -38,12 +38,22 @@
 #include "bitpack.h"
 #include "patch_code.h"
 #include "patch_dct.h"
+#include "llpatchworker.h"
 #include "llviewerregion.h"
 #include "llframetimer.h"
 #include "llsurface.h"
+#include "llworld.h"
 
 LLVLManager gVLManager;
 
+LLVLManager::LLVLManager() :
+	mLandBits(0),
+	mWindBits(0),
+	mCloudBits(0),
+	mDecodeThread(NULL)
+{
+}
+
 LLVLManager::~LLVLManager()
 {
 	S32 i;
@@ -76,6 +86,21 @@ void LLVLManager::addLayerData(LLVLData *vl_datap, const S32 mesg_size)
 	mPacketData.put(vl_datap);
 }
 
+void LLVLManager::initThread(bool threaded)
+{
+	if (!mDecodeThread)
+	{
+		mDecodeThread = new LLPatchDecodeThread(threaded);
+	}
+}
+
+void LLVLManager::cleanupThread()
+{
+	// Whatever is still queued was for regions we're leaving anyway.
+	delete mDecodeThread;
+	mDecodeThread = NULL;
+}
+
 void LLVLManager::unpackData(const S32 num_packets)
 {
 	static LLFrameTimer decode_timer;
@@ -85,15 +110,36 @@ void LLVLManager::unpackData(const S32 num_packets)
 	{
 		LLVLData *datap = mPacketData[i];
 
+		if (LAND_LAYER_CODE == datap->mType)
+		{
+			// The patch bitstream and inverse DCTs are the expensive part
+			// of a land layer. Regions can go away before the thread gets
+			// to their packets, so results are matched up by handle.
+			if (mDecodeThread)
+			{
+				mDecodeThread->decode(datap->mRegionp->getHandle(), datap->mData, datap->mSize);
+			}
+			else
+			{
+				LLPatchDecodeThread::DecodedGroup group;
+				LLPatchDecodeThread::decodeGroup(datap->mData, datap->mSize, group);
+				datap->mRegionp->getLand().applyDecodedPatches(group);
+			}
+			continue;
+		}
+
+		// Wind and cloud layers are one or two small patches; decode them
+		// here, keeping the decode thread out of the shared decoder state.
+		LLMutex* decoder_mutex = mDecodeThread ? mDecodeThread->getDecoderMutex() : NULL;
+		if (decoder_mutex)
+		{
+			decoder_mutex->lock();
+		}
 		LLBitPack bit_pack(datap->mData, datap->mSize);
 		LLGroupHeader goph;
 
 		decode_patch_group_header(bit_pack, &goph);
-		if (LAND_LAYER_CODE == datap->mType)
-		{
-			datap->mRegionp->getLand().decompressDCTPatch(bit_pack, &goph, FALSE);
-		}
-		else if (WIND_LAYER_CODE == datap->mType)
+		if (WIND_LAYER_CODE == datap->mType)
 		{
 			datap->mRegionp->mWind.decompress(bit_pack, &goph);
 
@@ -102,6 +148,10 @@ void LLVLManager::unpackData(const S32 num_packets)
 		{
 			datap->mRegionp->mCloudLayer.decompress(bit_pack, &goph);
 		}
+		if (decoder_mutex)
+		{
+			decoder_mutex->unlock();
+		}
 	}
 
 	for (i = 0; i < mPacketData.count(); i++)
@@ -110,6 +160,23 @@ void LLVLManager::unpackData(const S32 num_packets)
 	}
 	mPacketData.reset();
 
+	if (mDecodeThread)
+	{
+		// Runs the queue here when the thread isn't threaded.
+		mDecodeThread->update(0);
+
+		std::vector<LLPatchDecodeThread::DecodedGroup> groups;
+		mDecodeThread->getDecoded(groups);
+		for (std::vector<LLPatchDecodeThread::DecodedGroup>::const_iterator iter = groups.begin();
+			 iter != groups.end(); ++iter)
+		{
+			LLViewerRegion* regionp = LLWorld::getInstance()->getRegionFromHandle(iter->mKey);
+			if (regionp)
+			{
+				regionp->getLand().applyDecodedPatches(*iter);
+			}
+		}
+	}
 }
 
 void LLVLManager::resetBitCounts()
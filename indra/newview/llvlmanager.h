@@ -40,12 +40,19 @@
 
 class LLVLData;
 class LLViewerRegion;
+class LLPatchDecodeThread;
 
 class LLVLManager
 {
 public:
+	LLVLManager();
 	~LLVLManager();
 
+	// Land layers are decoded by a worker thread from initThread() on, and
+	// on the main thread before that.
+	void initThread(bool threaded);
+	void cleanupThread();
+
 	void addLayerData(LLVLData *vl_datap, const S32 mesg_size);
 
 	void unpackData(const S32 num_packets = 10);
@@ -62,6 +69,7 @@ public:
 protected:
 
 	LLDynamicArray<LLVLData *> mPacketData;
+	LLPatchDecodeThread* mDecodeThread;
 	U32 mLandBits;
 	U32 mWindBits;
 	U32 mCloudBits;
@@ -9707,14 +9707,8 @@ BOOL LLVOAvatar::canGrabLocalTexture(ETextureIndex index)
 		if (texture_id != IMG_DEFAULT_AVATAR)
 		{
 			// Search inventory for this texture.
-			LLViewerInventoryCategory::cat_array_t cats;
 			LLViewerInventoryItem::item_array_t items;
-			LLAssetIDMatches asset_id_matches(texture_id);
-			gInventory.collectDescendentsIf(LLUUID::null,
-									cats,
-									items,
-									LLInventoryModel::INCLUDE_TRASH,
-									asset_id_matches);
+			gInventory.findItemsByAssetID(texture_id, items);
 
 			BOOL can_grab = FALSE;
 			lldebugs << "item count for asset " << texture_id << ": " << items.count() << llendl;
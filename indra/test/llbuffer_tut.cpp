@@ -274,4 +274,85 @@ namespace tut
 		it = bufferArray.constructSegmentAfter(NULL, segment);
 		ensure("constructSegmentAfter() function failed", (it == end));
 	}
+
+	// gatherSegments()
+	template<> template<>
+	void buffer_object_t::test<14>()
+	{
+		LLBufferArray bufferArray;
+		LLChannelDescriptors channels = bufferArray.nextChannel();
+		LLSegment segments[4];
+		ensure_equals("empty array", bufferArray.gatherSegments(channels.in(), NULL, segments, 4), 0);
+
+		bufferArray.append(channels.in(), (U8*)"hello ", 6);
+		bufferArray.append(channels.in(), (U8*)"world", 5);
+		S32 count = bufferArray.gatherSegments(channels.in(), NULL, segments, 4);
+		ensure_equals("adjacent appends merge", count, 1);
+		ensure_equals("merged size", segments[0].size(), 11);
+		ensure_equals("merged data", std::string((char*)segments[0].data(), segments[0].size()), std::string("hello world"));
+
+		// another channel in the middle splits the runs
+		bufferArray.append(channels.out(), (U8*)"xx", 2);
+		bufferArray.append(channels.in(), (U8*)"!", 1);
+		count = bufferArray.gatherSegments(channels.in(), NULL, segments, 4);
+		ensure_equals("split by other channel", count, 2);
+		ensure_equals("second run", std::string((char*)segments[1].data(), segments[1].size()), std::string("!"));
+		ensure_equals("max segments", bufferArray.gatherSegments(channels.in(), NULL, segments, 1), 1);
+
+		// start after the 'o' of hello
+		count = bufferArray.gatherSegments(channels.in(), segments[0].data() + 4, segments, 4);
+		ensure_equals("count after start", count, 2);
+		ensure_equals("data after start", std::string((char*)segments[0].data(), segments[0].size()), std::string(" world"));
+	}
+
+	// getContiguousData() and readContiguous()
+	template<> template<>
+	void buffer_object_t::test<15>()
+	{
+		LLBufferArray bufferArray;
+		LLChannelDescriptors channels = bufferArray.nextChannel();
+		S32 len = -1;
+		std::vector<U8> scratch;
+		ensure("empty channel", bufferArray.getContiguousData(channels.in(), len) == NULL);
+		ensure_equals("empty length", len, 0);
+		ensure("empty read", bufferArray.readContiguous(channels.in(), len, scratch) == NULL);
+
+		bufferArray.append(channels.in(), (U8*)"abc", 3);
+		bufferArray.append(channels.in(), (U8*)"def", 3);
+		U8* data = bufferArray.getContiguousData(channels.in(), len);
+		ensure("contiguous", data != NULL);
+		ensure_equals("contiguous length", len, 6);
+		ensure_equals("contiguous data", std::string((char*)data, len), std::string("abcdef"));
+		ensure("no copy", bufferArray.readContiguous(channels.in(), len, scratch) == data);
+		ensure("scratch unused", scratch.empty());
+
+		// more than one chunk can hold
+		std::string big(20000, 'x');
+		big[19999] = 'y';
+		bufferArray.append(channels.in(), (U8*)big.data(), (S32)big.size());
+		ensure("scattered", bufferArray.getContiguousData(channels.in(), len) == NULL);
+		data = bufferArray.readContiguous(channels.in(), len, scratch);
+		ensure_equals("gathered length", len, 20006);
+		ensure("gathered into scratch", data == &scratch[0]);
+		ensure_equals("gathered data", std::string((char*)data, len), std::string("abcdef") + big);
+	}
+
+	// default sized chunks are reused
+	template<> template<>
+	void buffer_object_t::test<16>()
+	{
+		U8* first = NULL;
+		S32 pooled = 0;
+		{
+			LLBufferArray bufferArray;
+			bufferArray.append(0, (U8*)"pooled", 6);
+			first = bufferArray.beginSegment()->data();
+			pooled = LLHeapBuffer::getPooledChunkCount();
+		}
+		ensure_equals("chunk returned to the pool", LLHeapBuffer::getPooledChunkCount(), pooled + 1);
+		LLBufferArray bufferArray;
+		bufferArray.append(0, (U8*)"again", 5);
+		ensure("chunk reused", bufferArray.beginSegment()->data() == first);
+		ensure_equals("chunk taken from the pool", LLHeapBuffer::getPooledChunkCount(), pooled);
+	}
 }
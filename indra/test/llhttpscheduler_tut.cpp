@@ -0,0 +1,376 @@
+/** 
+ * @file llhttpscheduler_tut.cpp
+ * @brief Tests for the shared HTTP fetch scheduler.
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+
+// These use a local server, as llhttpclient_tut does. JC
+#if !LL_WINDOWS
+
+#include <fstream>
+#include <sstream>
+
+#include "lltut.h"
+#include "llhttpscheduler.h"
+#include "llfile.h"
+#include "llformat.h"
+#include "llpumpio.h"
+#include "llsdhttpserver.h"
+#include "lliohttpserver.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	static const U16 ASSET_SERVER_PORT = 8889;
+	std::string gAssetDirectory;
+
+	// Stand-in for an asset server: serves files from gAssetDirectory.
+	class AssetFileNode : public LLHTTPNode
+	{
+	public:
+		virtual bool validate(const std::string& name, LLSD& context) const
+		{
+			return true;
+		}
+
+		void get(ResponsePtr r, const LLSD& context) const
+		{
+			std::string name = context["request"]["wildcard"]["name"].asString();
+			std::ifstream file((gAssetDirectory + "/" + name).c_str(), std::ios::binary);
+			if (!file)
+			{
+				r->notFound();
+				return;
+			}
+			std::ostringstream body;
+			body << file.rdbuf();
+			LLSD headers;
+			headers["Content-Type"] = "application/octet-stream";
+			r->extendedResult(200, body.str(), headers);
+		}
+	};
+
+	LLHTTPRegistration<AssetFileNode> gAssetFileNode("/test/asset/<name>");
+
+	struct HTTPSchedulerTestData
+	{
+		HTTPSchedulerTestData() :
+			mMaxActive(0),
+			mMaxHostActive(0)
+		{
+			static bool curl_initialized = false;
+			if (!curl_initialized)
+			{
+				LLCurl::initClass();
+				curl_initialized = true;
+			}
+
+			const char* tmp = getenv("TMPDIR");
+			gAssetDirectory = tmp ? tmp : "/tmp";
+
+			mServerPump = new LLPumpIO();
+			LLHTTPNode& root = LLIOHTTPServer::create(*mServerPump, ASSET_SERVER_PORT);
+			LLHTTPStandardServices::useServices();
+			LLHTTPRegistrar::buildAllServices(root);
+
+			mScheduler = LLHTTPScheduler::getInstance();
+			mScheduler->setMaxRequests(1);
+			mScheduler->setMaxRequestsPerHost(0);
+			mScheduler->setMinRequests(2);
+			mScheduler->setMaxBandwidth(0.f);
+
+			mClients.push_back(new LLCurlRequest);
+			mClients.push_back(new LLCurlRequest);
+		}
+
+		~HTTPSchedulerTestData()
+		{
+			for (std::vector<LLCurlRequest*>::iterator iter = mClients.begin();
+				 iter != mClients.end(); ++iter)
+			{
+				mScheduler->removeClient(*iter);
+				delete *iter;
+			}
+			for (std::vector<std::string>::iterator iter = mFiles.begin();
+				 iter != mFiles.end(); ++iter)
+			{
+				LLFile::remove(*iter);
+			}
+			delete mServerPump;
+		}
+
+		std::string makeAsset(const std::string& name, S32 size)
+		{
+			std::string path = gAssetDirectory + "/" + name;
+			std::ofstream file(path.c_str(), std::ios::binary);
+			std::string data;
+			for (S32 i = 0; i < size; ++i)
+			{
+				data += (char)('a' + (i % 26));
+			}
+			file << data;
+			mFiles.push_back(path);
+			return data;
+		}
+
+		std::string assetURL(const std::string& name)
+		{
+			return llformat("http://127.0.0.1:%d/test/asset/", ASSET_SERVER_PORT) + name;
+		}
+
+		std::string assetHost()
+		{
+			return llformat("127.0.0.1:%d", ASSET_SERVER_PORT);
+		}
+
+		class Recorder : public LLCurl::Responder
+		{
+		public:
+			Recorder(HTTPSchedulerTestData& test, const std::string& name) :
+				mTest(test),
+				mName(name)
+			{
+			}
+
+			virtual void completedRaw(
+				U32 status,
+				const std::string& reason,
+				const LLChannelDescriptors& channels,
+				const LLIOPipe::buffer_ptr_t& buffer)
+			{
+				std::string body;
+				S32 size = buffer->countAfter(channels.in(), NULL);
+				if (size > 0)
+				{
+					body.resize(size);
+					buffer->readAfter(channels.in(), NULL, (U8*)&body[0], size);
+				}
+				mTest.mOrder.push_back(mName);
+				mTest.mStatus[mName] = status;
+				mTest.mBodies[mName] = body;
+			}
+
+		private:
+			HTTPSchedulerTestData& mTest;
+			std::string mName;
+		};
+
+		LLHTTPScheduler::handle_t fetch(
+			S32 client,
+			const std::string& name,
+			S32 size,
+			F32 priority)
+		{
+			return mScheduler->getByteRange(
+				mClients[client],
+				assetURL(name),
+				LLCurlRequest::headers_t(),
+				0,
+				size,
+				priority,
+				new Recorder(*this, name));
+		}
+
+		void updateClients()
+		{
+			for (std::vector<LLCurlRequest*>::iterator iter = mClients.begin();
+				 iter != mClients.end(); ++iter)
+			{
+				mScheduler->update(*iter);
+			}
+		}
+
+		void runUntil(U32 count, F32 timeout = 30.f)
+		{
+			LLTimer timer;
+			timer.setTimerExpirySec(timeout);
+			while (mOrder.size() < count && !timer.hasExpired())
+			{
+				updateClients();
+				mMaxActive = llmax(mMaxActive, mScheduler->getNumActive());
+				mMaxHostActive = llmax(mMaxHostActive, mScheduler->getNumActive(assetHost()));
+				mServerPump->pump();
+				mServerPump->callback();
+				for (std::vector<LLCurlRequest*>::iterator iter = mClients.begin();
+					 iter != mClients.end(); ++iter)
+				{
+					(*iter)->process();
+				}
+			}
+		}
+
+		LLPumpIO* mServerPump;
+		LLHTTPScheduler* mScheduler;
+		std::vector<LLCurlRequest*> mClients;
+		std::vector<std::string> mFiles;
+
+		std::vector<std::string> mOrder;
+		std::map<std::string, U32> mStatus;
+		std::map<std::string, std::string> mBodies;
+		U32 mMaxActive;
+		U32 mMaxHostActive;
+	};
+
+	typedef test_group<HTTPSchedulerTestData> HTTPSchedulerTestGroup;
+	typedef HTTPSchedulerTestGroup::object HTTPSchedulerTestObject;
+	HTTPSchedulerTestGroup httpSchedulerTestGroup("http_scheduler");
+
+	template<> template<>
+	void HTTPSchedulerTestObject::test<1>()
+	{
+		// one request at a time completes in priority order.
+		std::string low = makeAsset("llhttpscheduler_low.j2c", 1000);
+		std::string high = makeAsset("llhttpscheduler_high.j2c", 3000);
+		std::string mid = makeAsset("llhttpscheduler_mid.j2c", 2000);
+		fetch(0, "llhttpscheduler_low.j2c", low.size(), 0.1f);
+		fetch(0, "llhttpscheduler_high.j2c", high.size(), 0.9f);
+		fetch(0, "llhttpscheduler_mid.j2c", mid.size(), 0.5f);
+		ensure_equals("queued", mScheduler->getNumQueued(), 3U);
+
+		runUntil(3);
+		ensure_equals("completed", mOrder.size(), 3U);
+		ensure_equals("first", mOrder[0], std::string("llhttpscheduler_high.j2c"));
+		ensure_equals("second", mOrder[1], std::string("llhttpscheduler_mid.j2c"));
+		ensure_equals("third", mOrder[2], std::string("llhttpscheduler_low.j2c"));
+		ensure_equals("status", mStatus["llhttpscheduler_mid.j2c"], 200U);
+		ensure("body", mBodies["llhttpscheduler_high.j2c"] == high);
+		ensure_equals("one at a time", mMaxActive, 1U);
+		ensure_equals("nothing left", mScheduler->getNumActive() + mScheduler->getNumQueued(), 0U);
+	}
+
+	template<> template<>
+	void HTTPSchedulerTestObject::test<2>()
+	{
+		// priority order holds across clients, even though the first
+		// client always gets to update first.
+		updateClients();
+		const char* names[] = { "llhttpscheduler_a1.j2c", "llhttpscheduler_a2.j2c",
+								"llhttpscheduler_b1.j2c", "llhttpscheduler_b2.j2c" };
+		for (S32 i = 0; i < 4; ++i)
+		{
+			makeAsset(names[i], 500);
+		}
+		fetch(0, names[0], 500, 0.2f);
+		fetch(0, names[1], 500, 0.1f);
+		fetch(1, names[2], 500, 0.8f);
+		fetch(1, names[3], 500, 0.7f);
+
+		runUntil(4);
+		ensure_equals("completed", mOrder.size(), 4U);
+		ensure_equals("first", mOrder[0], std::string(names[2]));
+		ensure_equals("second", mOrder[1], std::string(names[3]));
+		ensure_equals("third", mOrder[2], std::string(names[0]));
+		ensure_equals("fourth", mOrder[3], std::string(names[1]));
+	}
+
+	template<> template<>
+	void HTTPSchedulerTestObject::test<3>()
+	{
+		// queued requests can be reprioritized and cancelled.
+		makeAsset("llhttpscheduler_a.j2c", 500);
+		makeAsset("llhttpscheduler_b.j2c", 500);
+		makeAsset("llhttpscheduler_c.j2c", 500);
+		LLHTTPScheduler::handle_t a = fetch(0, "llhttpscheduler_a.j2c", 500, 0.5f);
+		LLHTTPScheduler::handle_t b = fetch(0, "llhttpscheduler_b.j2c", 500, 0.4f);
+		LLHTTPScheduler::handle_t c = fetch(0, "llhttpscheduler_c.j2c", 500, 0.3f);
+		ensure("cancel", mScheduler->cancel(b));
+		ensure("raise", mScheduler->setPriority(c, 0.6f));
+		ensure_equals("queued", mScheduler->getNumQueued(), 2U);
+
+		runUntil(2);
+		runUntil(3, 0.5f);
+		ensure_equals("completed", mOrder.size(), 2U);
+		ensure_equals("first", mOrder[0], std::string("llhttpscheduler_c.j2c"));
+		ensure_equals("second", mOrder[1], std::string("llhttpscheduler_a.j2c"));
+		ensure("cancel after issue", !mScheduler->cancel(a));
+		ensure("priority after issue", !mScheduler->setPriority(a, 1.f));
+	}
+
+	template<> template<>
+	void HTTPSchedulerTestObject::test<4>()
+	{
+		// the per host limit holds even with slots to spare.
+		mScheduler->setMaxRequests(8);
+		mScheduler->setMaxRequestsPerHost(2);
+		std::string data;
+		for (S32 i = 0; i < 6; ++i)
+		{
+			std::string name = llformat("llhttpscheduler_host%d.j2c", i);
+			data = makeAsset(name, 20000);
+			fetch(i % 2, name, data.size(), 0.5f);
+		}
+
+		runUntil(6);
+		ensure_equals("completed", mOrder.size(), 6U);
+		ensure("host limit", mMaxHostActive <= 2);
+		ensure("body", mBodies["llhttpscheduler_host5.j2c"] == data);
+	}
+
+	template<> template<>
+	void HTTPSchedulerTestObject::test<5>()
+	{
+		// over the bandwidth limit only the minimum requests are
+		// admitted, but everything still gets through.
+		mScheduler->setMaxRequests(8);
+		mScheduler->setMinRequests(1);
+		mScheduler->setMaxBandwidth(1.f);
+		for (S32 i = 0; i < 4; ++i)
+		{
+			std::string name = llformat("llhttpscheduler_slow%d.j2c", i);
+			makeAsset(name, 1000);
+			fetch(0, name, 1000, 0.5f);
+		}
+
+		runUntil(4);
+		ensure_equals("completed", mOrder.size(), 4U);
+		ensure_equals("bandwidth limited", mMaxActive, 1U);
+	}
+
+	template<> template<>
+	void HTTPSchedulerTestObject::test<6>()
+	{
+		// with no per host limit set, one host can have every slot.
+		mScheduler->setMaxRequests(12);
+		for (S32 i = 0; i < 12; ++i)
+		{
+			std::string name = llformat("llhttpscheduler_one_host%d.j2c", i);
+			makeAsset(name, 1000);
+			fetch(i % 2, name, 1000, 0.5f);
+		}
+
+		runUntil(12);
+		ensure_equals("completed", mOrder.size(), 12U);
+		ensure_equals("whole limit", mMaxHostActive, 12U);
+	}
+}
+
+#endif	// !LL_WINDOWS
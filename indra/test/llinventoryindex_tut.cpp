@@ -0,0 +1,226 @@
+/** 
+ * @file llinventoryindex_tut.cpp
+ * @brief Tests and timings for LLInventoryIndex
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "lltut.h"
+
+#include "llinventory.h"
+#include "llinventoryindex.h"
+#include "../newview/hippogridmanager.h"
+
+// llinventory reaches into the viewer's grid manager when it sees links or
+// money; nothing here does, so these only have to link.
+HippoGridManager* gHippoGridManager = NULL;
+
+HippoGridInfo* HippoGridManager::getConnectedGrid() const
+{
+	return NULL;
+}
+
+void HippoGridInfo::setSupportsInvLinks(bool b)
+{
+}
+
+const std::string& HippoGridInfo::getCurrencySymbol() const
+{
+	return LLStringUtil::null;
+}
+
+namespace tut
+{
+	static const S32 LARGE_INVENTORY_SIZE = 10000;
+	static const S32 SHARED_ASSET_COUNT = 100;
+
+	struct inventory_index_data
+	{
+		inventory_index_data()
+		{
+			mParentID.generate();
+			mPerm.init(LLUUID::null, LLUUID::null, LLUUID::null, LLUUID::null);
+		}
+
+		LLPointer<LLInventoryItem> makeItem(const LLUUID& asset_id,
+											LLAssetType::EType type,
+											LLInventoryType::EType inv_type,
+											const std::string& name)
+		{
+			LLUUID item_id;
+			item_id.generate();
+			return new LLInventoryItem(item_id, mParentID, mPerm, asset_id,
+									   type, inv_type, name, std::string(),
+									   LLSaleInfo::DEFAULT, 0, 0);
+		}
+
+		// Synthetic inventory: every item shares its asset with
+		// LARGE_INVENTORY_SIZE / SHARED_ASSET_COUNT others, every tenth
+		// item is a link to the item before it.
+		void buildLargeInventory(LLInventoryIndex& index)
+		{
+			std::vector<LLUUID> assets(SHARED_ASSET_COUNT);
+			for (S32 i = 0; i < SHARED_ASSET_COUNT; ++i)
+			{
+				assets[i].generate();
+			}
+			for (S32 i = 0; i < LARGE_INVENTORY_SIZE; ++i)
+			{
+				LLPointer<LLInventoryItem> item;
+				if ((i % 10) == 9)
+				{
+					item = makeItem(mItems.back()->getUUID(), LLAssetType::AT_LINK,
+									mItems.back()->getInventoryType(), mItems.back()->getName());
+				}
+				else
+				{
+					item = makeItem(assets[i % SHARED_ASSET_COUNT],
+									(i & 1) ? LLAssetType::AT_NOTECARD : LLAssetType::AT_OBJECT,
+									(i & 1) ? LLInventoryType::IT_NOTECARD : LLInventoryType::IT_OBJECT,
+									llformat("Item %d", i % 5000));
+				}
+				mItems.push_back(item);
+				index.addItem(item);
+			}
+		}
+
+		LLUUID mParentID;
+		LLPermissions mPerm;
+		std::vector<LLPointer<LLInventoryItem> > mItems;
+	};
+	typedef test_group<inventory_index_data> inventory_index_test;
+	typedef inventory_index_test::object inventory_index_object;
+	tut::inventory_index_test inventory_index("llinventoryindex");
+
+	template<> template<>
+	void inventory_index_object::test<1>()
+	{
+		LLInventoryIndex index;
+		LLUUID asset_id;
+		asset_id.generate();
+		LLPointer<LLInventoryItem> item = makeItem(asset_id, LLAssetType::AT_NOTECARD,
+												   LLInventoryType::IT_NOTECARD, "My Notecard");
+		index.addItem(item);
+
+		ensure_equals("item count", index.getItemCount(), 1);
+		ensure("by asset", index.getItemsByAsset(asset_id) && index.getItemsByAsset(asset_id)->count(item->getUUID()));
+		ensure("by type", index.getItemsByType(LLInventoryType::IT_NOTECARD) != NULL);
+		ensure("no links", index.getLinksTo(item->getUUID()) == NULL);
+
+		// Modify in place and reindex; old keys must go away.
+		LLUUID new_asset_id;
+		new_asset_id.generate();
+		item->setAssetUUID(new_asset_id);
+		index.addItem(item);
+		ensure("old asset dropped", index.getItemsByAsset(asset_id) == NULL);
+		ensure("new asset found", index.getItemsByAsset(new_asset_id) != NULL);
+		ensure_equals("still one item", index.getItemCount(), 1);
+
+		index.removeObject(item->getUUID());
+		ensure_equals("removed", index.getItemCount(), 0);
+		ensure("asset key dropped", index.getItemsByAsset(new_asset_id) == NULL);
+		ensure("type key dropped", index.getItemsByType(LLInventoryType::IT_NOTECARD) == NULL);
+	}
+
+	template<> template<>
+	void inventory_index_object::test<2>()
+	{
+		LLInventoryIndex index;
+		LLUUID asset_id;
+		asset_id.generate();
+		LLPointer<LLInventoryItem> item = makeItem(asset_id, LLAssetType::AT_CLOTHING,
+												   LLInventoryType::IT_WEARABLE, "Shirt");
+		LLPointer<LLInventoryItem> link = makeItem(item->getUUID(), LLAssetType::AT_LINK,
+												   LLInventoryType::IT_WEARABLE, "Shirt");
+		index.addItem(item);
+		index.addItem(link);
+
+		const LLInventoryIndex::id_set_t* links = index.getLinksTo(item->getUUID());
+		ensure("link found", links && (links->size() == 1) && links->count(link->getUUID()));
+		ensure("links are not indexed by asset", index.getItemsByAsset(item->getUUID()) == NULL);
+		ensure_equals("links are not indexed by type", index.getItemsByType(LLInventoryType::IT_WEARABLE)->size(), (size_t)1);
+
+		LLUUID cat_id;
+		cat_id.generate();
+		LLPointer<LLInventoryCategory> cat = new LLInventoryCategory(cat_id, mParentID, LLFolderType::FT_NONE, "Outfits");
+		index.addCategory(cat);
+		ensure("category by name is case insensitive", index.getCategoriesByName("OUTFITS") != NULL);
+		ensure("items are not indexed by name", index.getCategoriesByName("shirt") == NULL);
+		ensure_equals("categories are counted apart from items", index.getItemCount(), 2);
+
+		// Renaming in place and reindexing moves the name key.
+		cat->rename("Looks");
+		index.addCategory(cat);
+		ensure("old name dropped", index.getCategoriesByName("outfits") == NULL);
+		ensure("new name found", index.getCategoriesByName("looks") != NULL);
+		ensure_equals("still one category", index.getCategoryCount(), 1);
+
+		index.clear();
+		ensure_equals("cleared items", index.getItemCount(), 0);
+		ensure_equals("cleared categories", index.getCategoryCount(), 0);
+	}
+
+	template<> template<>
+	void inventory_index_object::test<3>()
+	{
+		// Indexed lookups must find exactly what the linear scan they
+		// replace finds.
+		LLInventoryIndex index;
+		buildLargeInventory(index);
+
+		const LLUUID& asset_id = mItems[0]->getAssetUUID();
+		const LLUUID& target_id = mItems[LARGE_INVENTORY_SIZE / 2 - 2]->getUUID();
+
+		S32 scan_assets = 0;
+		S32 scan_links = 0;
+		for (std::vector<LLPointer<LLInventoryItem> >::const_iterator it = mItems.begin(); it != mItems.end(); ++it)
+		{
+			if ((*it)->getIsLinkType())
+			{
+				if ((*it)->getLinkedUUID() == target_id) ++scan_links;
+			}
+			else if ((*it)->getAssetUUID() == asset_id)
+			{
+				++scan_assets;
+			}
+		}
+
+		const LLInventoryIndex::id_set_t* assets = index.getItemsByAsset(asset_id);
+		const LLInventoryIndex::id_set_t* links = index.getLinksTo(target_id);
+		ensure("assets found", assets != NULL);
+		ensure_equals("asset lookup matches scan", (S32)assets->size(), scan_assets);
+		ensure_equals("link lookup matches scan", links ? (S32)links->size() : 0, scan_links);
+
+		for (std::vector<LLPointer<LLInventoryItem> >::const_iterator it = mItems.begin(); it != mItems.end(); ++it)
+		{
+			index.removeObject((*it)->getUUID());
+		}
+		ensure_equals("index empty", index.getItemCount(), 0);
+	}
+}
@@ -0,0 +1,248 @@
+/** 
+ * @file llkeywords_tut.cpp
+ * @brief Tests for incremental LLKeywords segmentation
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "llkeywords.h"
+#include "lltexteditor.h"
+#include "llui.h"
+#include "lltut.h"
+
+// llkeywords.cpp and llstyle.cpp are built into this test without the rest
+// of llui; these are the remaining pieces they need.
+LLTextSegment::LLTextSegment( const LLColor4& color, S32 start, S32 end ) :
+	mStyle(new LLStyle(TRUE, color, LLStringUtil::null)),
+	mStart(start),
+	mEnd(end),
+	mToken(NULL),
+	mIsDefault(FALSE)
+{
+}
+
+LLTextSegment::LLTextSegment( const LLColor3& color, S32 start, S32 end ) :
+	mStyle(new LLStyle(TRUE, color, LLStringUtil::null)),
+	mStart(start),
+	mEnd(end),
+	mToken(NULL),
+	mIsDefault(FALSE)
+{
+}
+
+// static
+LLPointer<LLUIImage> LLUI::getUIImageByID(const LLUUID& image_id, S32 priority)
+{
+	return NULL;
+}
+
+namespace tut
+{
+	const LLColor4 DEFAULT_COLOR(1.f, 1.f, 1.f, 1.f);
+
+	// Pieces of LSL-ish text.  Comments, strings and escapes are what make
+	// a line start unsafe to restart from, so they are over represented.
+	const char* const FRAGMENTS[] =
+	{
+		"default", "state_entry", "llSay", "integer", "if", "else", "return",
+		"foo", "bar_2", "x", "(", ")", "{", "}", ";", " ", "  ", "\t",
+		"\n", "\n", "\n", "\n\n", "// note", "//", "/*", "*/", "/* a\nb */",
+		"\"", "\"text\"", "\\", "\\\"", "\\\\", "*", "/", "0", "42", "#", "# x"
+	};
+	const S32 NUM_FRAGMENTS = sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0]);
+
+	struct keywords_data
+	{
+		LLKeywords mKeywords;
+		U32 mSeed;
+
+		keywords_data() : mSeed(12345)
+		{
+			addTokens(mKeywords);
+		}
+
+		static void addTokens(LLKeywords& keywords)
+		{
+			keywords.addToken(LLKeywordToken::WORD, "default", LLColor3(1.f, 0.f, 0.f));
+			keywords.addToken(LLKeywordToken::WORD, "state_entry", LLColor3(0.f, 1.f, 0.f));
+			keywords.addToken(LLKeywordToken::WORD, "llSay", LLColor3(0.f, 0.f, 1.f));
+			keywords.addToken(LLKeywordToken::WORD, "integer", LLColor3(1.f, 1.f, 0.f));
+			keywords.addToken(LLKeywordToken::WORD, "if", LLColor3(0.f, 1.f, 1.f));
+			keywords.addToken(LLKeywordToken::WORD, "return", LLColor3(1.f, 0.f, 1.f));
+			keywords.addToken(LLKeywordToken::LINE, "#", LLColor3(0.5f, 0.f, 0.f));
+			keywords.addToken(LLKeywordToken::ONE_SIDED_DELIMITER, "//", LLColor3(0.f, 0.5f, 0.f));
+			keywords.addToken(LLKeywordToken::TWO_SIDED_DELIMITER, "/*", LLColor3(0.f, 0.f, 0.5f));
+			keywords.addToken(LLKeywordToken::TWO_SIDED_DELIMITER, "\"", LLColor3(0.5f, 0.5f, 0.f));
+		}
+
+		U32 random(U32 range)
+		{
+			mSeed = mSeed * 1664525 + 1013904223;
+			return (mSeed >> 8) % range;
+		}
+
+		LLWString randomText(S32 fragments)
+		{
+			std::string text;
+			for (S32 i = 0; i < fragments; i++)
+			{
+				text += FRAGMENTS[random(NUM_FRAGMENTS)];
+			}
+			return utf8str_to_wstring(text);
+		}
+
+		static void clearSegments(std::vector<LLTextSegment*>& segs)
+		{
+			std::for_each(segs.begin(), segs.end(), DeletePointer());
+			segs.clear();
+		}
+
+		void ensureSameSegments(const std::string& msg, const std::vector<LLTextSegment*>& actual,
+								const std::vector<LLTextSegment*>& expected)
+		{
+			ensure_equals(msg + " segment count", actual.size(), expected.size());
+			for (U32 i = 0; i < expected.size(); i++)
+			{
+				ensure_equals(msg + " start", actual[i]->getStart(), expected[i]->getStart());
+				ensure_equals(msg + " end", actual[i]->getEnd(), expected[i]->getEnd());
+				// the two LLKeywords own separate token objects, so compare
+				// the tokens by text
+				const LLKeywordToken* actual_token = actual[i]->getToken();
+				const LLKeywordToken* expected_token = expected[i]->getToken();
+				ensure(msg + " token", (actual_token == NULL) == (expected_token == NULL));
+				if (expected_token)
+				{
+					ensure(msg + " token text", actual_token->getToken() == expected_token->getToken());
+				}
+				ensure(msg + " color", actual[i]->getColor() == expected[i]->getColor());
+			}
+		}
+
+		// Applies count random edit batches to text, updating segs through
+		// updateSegments() and checking each result against a fresh
+		// findSegments().  Edits within a batch are combined the way
+		// LLTextEditor::textChanged() combines edits between reflows.
+		void checkRandomEdits(LLWString& text, S32 count, S32 max_batch)
+		{
+			std::vector<LLTextSegment*> segs;
+			std::vector<LLTextSegment*> expected;
+			LLKeywords full;
+			addTokens(full);
+			mKeywords.findSegments(&segs, text, DEFAULT_COLOR);
+
+			for (S32 n = 0; n < count; n++)
+			{
+				S32 edit_start = S32_MAX;
+				S32 edit_end = -1;
+				S32 edit_delta = 0;
+				S32 batch = 1 + random(max_batch);
+				for (S32 b = 0; b < batch; b++)
+				{
+					S32 pos = random(text.size() + 1);
+					S32 removed = llmin((S32)random(12), (S32)text.size() - pos);
+					LLWString inserted = random(3) ? randomText(1 + random(3)) : LLWString();
+					text.replace(pos, removed, inserted);
+
+					S32 delta = (S32)inserted.size() - removed;
+					if (edit_start == S32_MAX)
+					{
+						edit_start = pos;
+						edit_end = pos + inserted.size();
+						edit_delta = delta;
+					}
+					else
+					{
+						edit_start = llmin(edit_start, pos);
+						edit_end = llmax(edit_end, pos + removed) + delta;
+						edit_delta += delta;
+					}
+				}
+
+				mKeywords.updateSegments(&segs, text, DEFAULT_COLOR, edit_start, edit_end, edit_delta);
+				full.findSegments(&expected, text, DEFAULT_COLOR);
+				ensureSameSegments(llformat("edit %d", n), segs, expected);
+			}
+
+			clearSegments(segs);
+			clearSegments(expected);
+		}
+	};
+	typedef test_group<keywords_data> keywords_test;
+	typedef keywords_test::object keywords_object;
+	tut::keywords_test keywords("LLKeywords");
+
+	// single edits
+	template<> template<>
+	void keywords_object::test<1>()
+	{
+		LLWString text = randomText(400);
+		checkRandomEdits(text, 2000, 1);
+	}
+
+	// several edits between updates
+	template<> template<>
+	void keywords_object::test<2>()
+	{
+		LLWString text = randomText(400);
+		checkRandomEdits(text, 2000, 4);
+	}
+
+	// edits that empty the text and grow it back
+	template<> template<>
+	void keywords_object::test<3>()
+	{
+		LLWString text = randomText(5);
+		checkRandomEdits(text, 500, 2);
+	}
+
+	// adding a token invalidates the incremental state
+	template<> template<>
+	void keywords_object::test<4>()
+	{
+		LLWString text = utf8str_to_wstring("foo bar\n/* baz */ foo\n");
+		std::vector<LLTextSegment*> segs;
+		mKeywords.findSegments(&segs, text, DEFAULT_COLOR);
+
+		mKeywords.addToken(LLKeywordToken::WORD, "foo", LLColor3(0.2f, 0.2f, 0.2f));
+		text.insert(4, utf8str_to_wstring("x"));
+		mKeywords.updateSegments(&segs, text, DEFAULT_COLOR, 4, 5, 1);
+
+		std::vector<LLTextSegment*> expected;
+		LLKeywords full;
+		addTokens(full);
+		full.addToken(LLKeywordToken::WORD, "foo", LLColor3(0.2f, 0.2f, 0.2f));
+		full.findSegments(&expected, text, DEFAULT_COLOR);
+		ensureSameSegments("after addToken", segs, expected);
+
+		clearSegments(segs);
+		clearSegments(expected);
+	}
+}
@@ -0,0 +1,229 @@
+/** 
+ * @file lllogchatindex_tut.cpp
+ * @brief Tests for the chat transcript line and word indexes
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lldir.h"
+#include "lldiriterator.h"
+#include "../newview/lllogchatindex.h"
+#include "lltut.h"
+
+namespace tut
+{
+	struct logchatindex_data
+	{
+		LLLogChatIndexer mIndexer;
+		std::string mDir;
+
+		// Indexes on this thread, so every request is done by the time
+		// index() returns.
+		logchatindex_data() : mIndexer(false)
+		{
+			mDir = gDirUtilp->getTempDir() + gDirUtilp->getDirDelimiter() + "lllogchatindex_tut";
+			LLFile::mkdir(mDir);
+			gDirUtilp->deleteFilesInDir(mDir, "*");
+		}
+
+		~logchatindex_data()
+		{
+			gDirUtilp->deleteFilesInDir(mDir, "*");
+			LLFile::rmdir(mDir);
+		}
+
+		std::string path(const std::string& file_name) const
+		{
+			return mDir + gDirUtilp->getDirDelimiter() + file_name;
+		}
+
+		void appendLines(const std::string& file_name, S32 first, S32 count, const char* words = "")
+		{
+			LLFILE* fp = LLFile::fopen(path(file_name), "a");
+			ensure("transcript opened", fp != NULL);
+			for (S32 i = first; i < first + count; i++)
+			{
+				fprintf(fp, "[12:00]  Someone: message %d %s\n", i, words);
+			}
+			fclose(fp);
+		}
+
+		void index(const std::string& file_name, U32 time)
+		{
+			mIndexer.index(mDir, file_name, time);
+			mIndexer.update(0);
+		}
+
+		S32 fileSize(const std::string& file_name) const
+		{
+			llstat stat;
+			return LLFile::stat(path(file_name), &stat) ? -1 : (S32)stat.st_size;
+		}
+
+		void readLines(const std::string& file_name, std::vector<std::string>& lines) const
+		{
+			lines.clear();
+			LLFILE* fp = LLFile::fopen(path(file_name), "rb");
+			char buffer[256];
+			while (fp && fgets(buffer, sizeof(buffer), fp))
+			{
+				lines.push_back(buffer);
+			}
+			if (fp)
+			{
+				fclose(fp);
+			}
+		}
+
+		static std::string message(S32 i)
+		{
+			return llformat("[12:00]  Someone: message %d ", i);
+		}
+	};
+	typedef test_group<logchatindex_data> logchatindex_test;
+	typedef logchatindex_test::object logchatindex_object;
+	tut::logchatindex_test lci("logchatindex");
+
+	// recalling the last lines through the line index
+	template<> template<>
+	void logchatindex_object::test<1>()
+	{
+		appendLines("alice.txt", 0, 50);
+		index("alice.txt", 1000);
+		ensure_equals("one record per line", fileSize("alice.idx"), 50 * 8);
+
+		std::deque<std::string> lines;
+		ensure("read", LLLogChatIndexer::readRecentLines(path("alice.txt"), 30, lines));
+		ensure_equals("line count", (S32)lines.size(), 30);
+		ensure_equals("first line", lines.front(), message(20));
+		ensure_equals("last line", lines.back(), message(49));
+
+		ensure("no transcript", !LLLogChatIndexer::readRecentLines(path("nobody.txt"), 30, lines));
+	}
+
+	// lines saved since the index last caught up are still recalled
+	template<> template<>
+	void logchatindex_object::test<2>()
+	{
+		appendLines("alice.txt", 0, 50);
+		index("alice.txt", 1000);
+		appendLines("alice.txt", 50, 5);
+
+		std::deque<std::string> lines;
+		LLLogChatIndexer::readRecentLines(path("alice.txt"), 30, lines);
+		ensure_equals("line count", (S32)lines.size(), 30);
+		ensure_equals("first line", lines.front(), message(25));
+		ensure_equals("last line", lines.back(), message(54));
+
+		// too far behind for the index to help; read the tail instead
+		appendLines("alice.txt", 55, 3000);
+		LLLogChatIndexer::readRecentLines(path("alice.txt"), 30, lines);
+		ensure_equals("tail line count", (S32)lines.size(), 30);
+		ensure_equals("tail last line", lines.back(), message(3054));
+
+		// and once indexed, through the index again
+		index("alice.txt", 2000);
+		ensure_equals("caught up", fileSize("alice.idx"), 3055 * 8);
+		LLLogChatIndexer::readRecentLines(path("alice.txt"), 30, lines);
+		ensure_equals("indexed first line", lines.front(), message(3025));
+		ensure_equals("indexed last line", lines.back(), message(3054));
+	}
+
+	// searching needs every word, finds the newest lines first and only
+	// covers what has been indexed
+	template<> template<>
+	void logchatindex_object::test<3>()
+	{
+		// A transcript's first lines are indexed without a time, as if
+		// they predated indexing.
+		appendLines("alice.txt", 0, 10, "apple");
+		index("alice.txt", 500);
+		appendLines("alice.txt", 10, 3, "apple banana");
+		index("alice.txt", 1000);
+		appendLines("bob.txt", 0, 1);
+		index("bob.txt", 500);
+		appendLines("bob.txt", 1, 2, "Banana APPLE");
+		index("bob.txt", 2000);
+		appendLines("bob.txt", 3, 1, "apple banana");
+
+		std::vector<LLLogChatIndexer::Match> matches;
+		mIndexer.search(mDir, "banana apple", matches, 100);
+		ensure_equals("matches", (S32)matches.size(), 5);
+		ensure_equals("newest file first", matches[0].mFileName, std::string("bob.txt"));
+		ensure_equals("newest line first", matches[0].mLine, 2);
+		ensure_equals("time", matches[0].mTime, (U32)2000);
+		ensure_equals("text", matches[2].mText, message(12) + "apple banana");
+
+		mIndexer.search(mDir, "apple", matches, 4);
+		ensure_equals("limited", (S32)matches.size(), 4);
+		mIndexer.search(mDir, "apple cherry", matches, 100);
+		ensure("not every word", matches.empty());
+		mIndexer.search(mDir, "a", matches, 100);
+		ensure("too short to index", matches.empty());
+	}
+
+	// the journal is merged into the sorted word index, dropping duplicate
+	// postings and postings of lines that no longer exist
+	template<> template<>
+	void logchatindex_object::test<4>()
+	{
+		mIndexer.setMinJournalMergeSize(0);
+		appendLines("alice.txt", 0, 20, "apple");
+		appendLines("alice.txt", 20, 20, "cherry");
+		index("alice.txt", 1000);
+		ensure("journal merged", fileSize("chat_words.new") < 0);
+
+		std::vector<std::string> postings;
+		readLines("chat_words.idx", postings);
+		ensure("word index written", !postings.empty());
+		for (size_t i = 1; i < postings.size(); i++)
+		{
+			ensure("sorted and unique", postings[i - 1] < postings[i]);
+		}
+
+		std::vector<LLLogChatIndexer::Match> matches;
+		mIndexer.search(mDir, "cherry", matches, 100);
+		ensure_equals("cherry", (S32)matches.size(), 20);
+
+		// the transcript is replaced by a shorter one
+		LLFile::remove(path("alice.txt"));
+		appendLines("alice.txt", 0, 10, "apple");
+		index("alice.txt", 3000);
+		readLines("chat_words.idx", postings);
+		for (size_t i = 0; i < postings.size(); i++)
+		{
+			ensure("no postings past the end", atoi(postings[i].c_str() + postings[i].rfind('\t') + 1) < 10);
+		}
+		mIndexer.search(mDir, "cherry", matches, 100);
+		ensure("cherry gone", matches.empty());
+		mIndexer.search(mDir, "apple", matches, 100);
+		ensure_equals("apple", (S32)matches.size(), 10);
+	}
+}
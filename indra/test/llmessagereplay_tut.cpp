@@ -0,0 +1,196 @@
+/** 
+ * @file llmessagereplay_tut.cpp
+ * @brief Tests for message capture files and LLMessageReplay loading
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "llmessagelog.h"
+#include "llmessagereplay.h"
+#include "llfile.h"
+#include "llcircuit.h"
+#include "lltemplatemessagebuilder.h"
+#include "lltut.h"
+#include "message.h"
+#include "message_prehash.h"
+
+namespace tut
+{
+	static S32 sTestMessageCount = 0;
+	static U32 sTestMessageValue = 0;
+
+	static void test_message_handler(LLMessageSystem* msg, void**)
+	{
+		sTestMessageCount++;
+		msg->getU32Fast(_PREHASH_TestBlock1, _PREHASH_Test1, sTestMessageValue);
+	}
+
+	struct message_replay_data
+	{
+		std::string mFilename;
+
+		message_replay_data()
+		{
+#if LL_WINDOWS
+			mFilename = "C:\\message-replay-test.cap";
+#else
+			mFilename = "/tmp/message-replay-test.cap";
+#endif
+		}
+
+		~message_replay_data()
+		{
+			LLMessageLog::stopCapture();
+			LLFile::remove(mFilename);
+		}
+	};
+	typedef test_group<message_replay_data> message_replay_test;
+	typedef message_replay_test::object message_replay_object;
+	tut::message_replay_test message_replay("message_replay");
+
+	// capture round trip
+	template<> template<>
+	void message_replay_object::test<1>()
+	{
+		LLHost sim_a("127.0.0.1:13000");
+		LLHost sim_b("127.0.0.1:13001");
+		U8 packet_a[] = { 0x40, 0, 0, 0, 1, 0, 0xff, 0x01, 0x02 };
+		U8 packet_b[] = { 0x00, 0, 0, 0, 2, 0, 0x05, 0x10, 0x20, 0x30, 0x40, 0x50 };
+
+		ensure("capture started", LLMessageLog::startCapture(mFilename));
+		ensure("capturing", LLMessageLog::isCapturing());
+		LLMessageLog::capture(sim_a, packet_a, sizeof(packet_a));
+		LLMessageLog::capture(sim_b, packet_b, sizeof(packet_b));
+		LLMessageLog::capture(sim_a, packet_a, 0);		// nothing received, not recorded
+		LLMessageLog::stopCapture();
+		ensure("capture stopped", !LLMessageLog::isCapturing());
+
+		LLMessageReplay replay;
+		ensure("loaded", replay.load(mFilename));
+		ensure_equals("packet count", replay.getPacketCount(), 2);
+		ensure_equals("first sender", replay.getPacket(0).mHost, sim_a);
+		ensure_equals("second sender", replay.getPacket(1).mHost, sim_b);
+		ensure_equals("first size", replay.getPacket(0).mData.size(), sizeof(packet_a));
+		ensure("first data", !memcmp(&replay.getPacket(0).mData[0], packet_a, sizeof(packet_a)));
+		ensure("second data", !memcmp(&replay.getPacket(1).mData[0], packet_b, sizeof(packet_b)));
+		ensure("capture order", replay.getPacket(0).mTime <= replay.getPacket(1).mTime);
+	}
+
+	// a capture cut off mid packet keeps the complete packets
+	template<> template<>
+	void message_replay_object::test<2>()
+	{
+		U8 packet[] = { 0x00, 0, 0, 0, 7, 0, 0x05, 0x10 };
+		LLMessageLog::startCapture(mFilename);
+		LLMessageLog::capture(LLHost("127.0.0.1:13000"), packet, sizeof(packet));
+		LLMessageLog::capture(LLHost("127.0.0.1:13000"), packet, sizeof(packet));
+		LLMessageLog::stopCapture();
+
+		llstat stat_data;
+		LLFile::stat(mFilename, &stat_data);
+		std::vector<U8> contents(stat_data.st_size);
+		LLFILE* fp = LLFile::fopen(mFilename, "rb");
+		fread(&contents[0], 1, contents.size(), fp);
+		fclose(fp);
+		fp = LLFile::fopen(mFilename, "wb");
+		fwrite(&contents[0], 1, contents.size() - 3, fp);
+		fclose(fp);
+
+		LLMessageReplay replay;
+		ensure("truncated capture loads", replay.load(mFilename));
+		ensure_equals("complete packets only", replay.getPacketCount(), 1);
+	}
+
+	// not a capture
+	template<> template<>
+	void message_replay_object::test<3>()
+	{
+		LLFILE* fp = LLFile::fopen(mFilename, "wb");
+		fputs("<?xml version=\"1.0\"?><llsd/>", fp);
+		fclose(fp);
+
+		LLMessageReplay replay;
+		ensure("rejected", !replay.load(mFilename));
+		ensure_equals("no packets", replay.getPacketCount(), 0);
+	}
+
+	// replay runs the handlers of a message system of its own, and replayed
+	// resends are neither dropped as duplicates nor acked
+	template<> template<>
+	void message_replay_object::test<4>()
+	{
+		std::string template_file = mFilename + ".msg";
+		llofstream file(template_file);
+		file << "version 2.0\n"
+			 << "{\n\tTestMessage Low 1 NotTrusted Unencoded\n"
+			 << "\t{\n\t\tTestBlock1 Single\n\t\t{ Test1 U32 }\n\t}\n}\n";
+		file.close();
+
+		LLMessageSystem msg(template_file, 0, 1, 0, 0, false, 5.f, 100.f);
+		LLFile::remove(template_file);
+		ensure("isolated message system", msg.isOK());
+		msg.setHandlerFuncFast(_PREHASH_TestMessage, test_message_handler);
+
+		LLTemplateMessageBuilder builder(msg.mMessageTemplates);
+		builder.newMessage(_PREHASH_TestMessage);
+		builder.nextBlock(_PREHASH_TestBlock1);
+		builder.addU32(_PREHASH_Test1, 42);
+		U8 packet[MAX_BUFFER_SIZE];
+		memset(packet, 0, LL_PACKET_ID_SIZE);
+		U32 size = builder.buildMessage(packet, MAX_BUFFER_SIZE, 0);
+		packet[0] = LL_RELIABLE_FLAG | LL_RESENT_FLAG;
+		packet[4] = 7;		// packet ID
+
+		LLHost sim("127.0.0.1:13002");
+		msg.enableCircuit(sim, TRUE);
+
+		LLMessageReplay replay;
+		replay.addPacket(0.0, sim, packet, size);
+		replay.addPacket(0.1, sim, packet, size);	// the same resend again
+
+		LLMessageSystem* live_msg = gMessageSystem;
+		sTestMessageCount = 0;
+		ensure_equals("both packets valid", replay.replay(&msg), 2);
+		ensure_equals("handler ran for both", sTestMessageCount, 2);
+		ensure_equals("handler read the message", sTestMessageValue, (U32)42);
+		ensure("live message system restored", gMessageSystem == live_msg);
+		ensure_equals("no reliable packets recorded", msg.mReliablePacketsIn, (U32)0);
+
+		LLCircuitData* cdp = msg.mCircuitInfo.findCircuit(sim);
+		ensure("circuit kept", cdp != NULL);
+		ensure_equals("circuit packet tracking untouched", cdp->getPacketsIn(), (U32)0);
+
+		if (live_msg)
+		{
+			ensure_equals("live message system refused", replay.replay(live_msg), 0);
+		}
+	}
+}
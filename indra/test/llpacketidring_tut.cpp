@@ -0,0 +1,179 @@
+/** 
+ * @file llpacketidring_tut.cpp
+ * @brief Tests for LLPacketIDRing
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "llpacketidring.h"
+#include "lltut.h"
+
+#include <vector>
+
+namespace tut
+{
+	const TPACKETID TEST_ID_SPACE = 0x01000000;
+
+	struct packet_id_ring_data
+	{
+		// Replay of an incoming reliable stream the way the sim sends it:
+		// consecutive IDs with some lost, some delivered out of order and
+		// resends of the lost ones arriving a little later.
+		// Returns the number of duplicates in the capture.
+		S32 buildCapture(std::vector<TPACKETID>& ids, S32 count, TPACKETID first)
+		{
+			S32 duplicates = 0;
+			U32 seed = 12345;
+			std::vector<TPACKETID> lost;
+			TPACKETID id = first;
+			for (S32 i = 0; i < count; i++)
+			{
+				seed = seed*1664525 + 1013904223;
+				U32 roll = (seed >> 16) % 100;
+				if (roll < 2)
+				{
+					lost.push_back(id);
+				}
+				else if (roll < 5 && !ids.empty())
+				{
+					// reordered with the previous packet
+					TPACKETID prev = ids.back();
+					ids.back() = id;
+					ids.push_back(prev);
+				}
+				else
+				{
+					ids.push_back(id);
+				}
+				if (lost.size() > 8)
+				{
+					ids.push_back(lost.front());
+					ids.push_back(lost.front());	// and a duplicate of the resend
+					lost.erase(lost.begin());
+					duplicates++;
+				}
+				id = (id + 1) % TEST_ID_SPACE;
+			}
+			return duplicates;
+		}
+	};
+	typedef test_group<packet_id_ring_data> packet_id_ring_test;
+	typedef packet_id_ring_test::object packet_id_ring_object;
+	tut::packet_id_ring_test packet_id_ring("packet_id_ring");
+
+	// insert, find, remove
+	template<> template<>
+	void packet_id_ring_object::test<1>()
+	{
+		LLPacketIDRing<S32*> ring(TEST_ID_SPACE, TEST_ID_SPACE);
+		S32 a = 1, b = 2, c = 3;
+		ring.insert(100, &a);
+		ring.insert(105, &b);
+		ring.insert(98, &c);
+		ensure_equals("size", ring.size(), 3);
+		ensure("find 100", ring.find(100) == &a);
+		ensure("find 105", ring.find(105) == &b);
+		ensure("find 98", ring.find(98) == &c);
+		ensure("missing id in window", ring.find(101) == NULL);
+		ensure("missing id outside window", ring.find(5000) == NULL);
+		ensure_equals("oldest", ring.oldestID(), (TPACKETID)98);
+
+		ensure("remove returns entry", ring.remove(98) == &c);
+		ensure_equals("oldest after remove", ring.oldestID(), (TPACKETID)100);
+		ring.remove(100);
+		ring.remove(105);
+		ensure("empty", ring.empty());
+		ensure_equals("no slots left", ring.slotCount(), 0);
+	}
+
+	// iteration stays in send order across the wrap of the ID space
+	template<> template<>
+	void packet_id_ring_object::test<2>()
+	{
+		LLPacketIDRing<U8> ring(TEST_ID_SPACE, TEST_ID_SPACE);
+		ring.insert(TEST_ID_SPACE - 2, 1);
+		ring.insert(TEST_ID_SPACE - 1, 1);
+		ring.insert(0, 1);
+		ring.insert(1, 1);
+		ensure_equals("oldest before wrap", ring.oldestID(), TEST_ID_SPACE - 2);
+		ensure_equals("four slots", ring.slotCount(), 4);
+		ensure_equals("third slot wrapped", ring.slotID(2), (TPACKETID)0);
+		ensure("wrapped id is newer", ring.isOlder(TEST_ID_SPACE - 1, 0));
+
+		ring.removeBefore(0);
+		ensure_equals("ids before the wrap dropped", ring.size(), 2);
+		ensure("0 kept", ring.find(0) != 0);
+		ensure("pre wrap id gone", ring.find(TEST_ID_SPACE - 1) == 0);
+	}
+
+	// bounded window forgets the oldest IDs
+	template<> template<>
+	void packet_id_ring_object::test<3>()
+	{
+		LLPacketIDRing<U8> ring(TEST_ID_SPACE, 16);
+		for (TPACKETID id = 0; id < 40; id++)
+		{
+			ring.insert(id, 1);
+		}
+		ensure("window bounded", ring.slotCount() <= 16);
+		ensure("newest kept", ring.find(39) != 0);
+		ensure("oldest forgotten", ring.find(0) == 0);
+		ensure("too old to insert", !ring.insert(0, 1));
+	}
+
+	// duplicate suppression over a replayed stream that wraps the ID space
+	template<> template<>
+	void packet_id_ring_object::test<4>()
+	{
+		const S32 PACKETS = 20000;
+		std::vector<TPACKETID> capture;
+		S32 expected = buildCapture(capture, PACKETS, TEST_ID_SPACE - PACKETS / 2);	// wraps half way
+
+		S32 duplicates = 0;
+		LLPacketIDRing<U8> recent(TEST_ID_SPACE, 65536);
+		for (U32 i = 0; i < capture.size(); i++)
+		{
+			if (recent.find(capture[i]))
+			{
+				duplicates++;
+			}
+			recent.insert(capture[i], 1);
+			if ((i & 1023) == 0 && recent.slotCount() > 2048)
+			{
+				// what the OldestUnacked ping would trim
+				recent.removeBefore((recent.slotID(recent.slotCount() - 1) + TEST_ID_SPACE - 1024) % TEST_ID_SPACE);
+			}
+		}
+
+		ensure("capture has duplicates", expected > 0);
+		ensure_equals("ring duplicates", duplicates, expected);
+	}
+}
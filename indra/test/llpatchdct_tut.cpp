@@ -0,0 +1,239 @@
+/** 
+ * @file llpatchdct_tut.cpp
+ * @brief Tests for the terrain patch inverse DCT
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "patch_dct.h"
+#include "patch_code.h"
+#include "bitpack.h"
+#include "llpatchworker.h"
+#include "lltimer.h"
+#include "lltut.h"
+
+
+namespace tut
+{
+	// patches per coded layer packet
+	const S32 PATCH_COUNT = 5;
+
+	struct patch_dct_data
+	{
+		// deterministic pseudo random coefficients, mostly zero at high
+		// frequencies like real terrain data
+		void fillCoefficients(S32 *cpatch, S32 size, U32 seed)
+		{
+			for (S32 i = 0; i < size*size; i++)
+			{
+				seed = seed*1664525 + 1013904223;
+				S32 value = (S32)((seed >> 16) & 0xFF) - 128;
+				cpatch[i] = (i < size*2 || (seed & 0x7) == 0) ? value : 0;
+			}
+		}
+
+		void decompress(F32 *patch, S32 *cpatch, S32 size, BOOL vectorized)
+		{
+			LLPatchHeader ph;
+			ph.dc_offset = 20.f;
+			ph.range = 57;
+			ph.quant_wbits = 0x88;
+			ph.patchids = 0;
+			decompress(patch, cpatch, size, vectorized, ph);
+		}
+
+		void decompress(F32 *patch, S32 *cpatch, S32 size, BOOL vectorized, LLPatchHeader ph)
+		{
+			LLGroupHeader gh;
+			gh.patch_size = size;
+			gh.stride = size;
+			gh.layer_type = 0;
+
+			set_group_of_patch_header(&gh);
+			init_patch_decompressor(size);
+
+			BOOL saved = gPatchIDCTVectorized;
+			gPatchIDCTVectorized = vectorized;
+			decompress_patch(patch, cpatch, &ph);
+			gPatchIDCTVectorized = saved;
+		}
+
+		void compareWithScalar(S32 size)
+		{
+			S32 cpatch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+			F32 expected[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+			F32 actual[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+
+			for (U32 seed = 1; seed < 50; seed++)
+			{
+				fillCoefficients(cpatch, size, seed);
+				decompress(expected, cpatch, size, FALSE);
+				decompress(actual, cpatch, size, TRUE);
+				// Not bit exact: -ffast-math may reorder the scalar sums, and the
+				// SIMD path pre-weights the DC row. 16 fraction bits allows an
+				// error of about 3e-5m, several ulps for these heights.
+				for (S32 i = 0; i < size*size; i++)
+				{
+					ensure_approximately_equals("SIMD idct matches scalar decompress_patch", actual[i], expected[i], 16);
+				}
+			}
+		}
+
+		// Codes PATCH_COUNT patches of coefficients into a layer packet the
+		// way the simulator does, keeping each patch's expected heights.
+		U8 mPacket[8192];
+		S32 mPacketSize;
+		F32 mExpected[PATCH_COUNT][LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+
+		void buildPacket(S32 size, U32 seed)
+		{
+			LLBitPack bitpack(mPacket, sizeof(mPacket));
+			init_patch_coding(bitpack);
+			LLGroupHeader gh;
+			gh.stride = 256;
+			gh.patch_size = size;
+			gh.layer_type = 'L';
+			code_patch_group_header(bitpack, &gh);
+
+			S32 cpatch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+			for (S32 p = 0; p < PATCH_COUNT; p++)
+			{
+				LLPatchHeader ph;
+				ph.dc_offset = 20.f + p;
+				ph.range = 57;
+				ph.quant_wbits = 0x80;
+				ph.patchids = (p << 5) | (PATCH_COUNT - p);
+
+				fillCoefficients(cpatch, size, seed + p);
+				decompress(mExpected[p], cpatch, size, TRUE, ph);
+				code_patch_header(bitpack, &ph, cpatch);
+				code_patch(bitpack, cpatch, 0);
+			}
+			code_end_of_data(bitpack);
+			mPacketSize = bitpack.flushBitPack();
+		}
+
+		void checkDecoded(const LLPatchDecodeThread::DecodedGroup& group, S32 size)
+		{
+			ensure_equals("patch size", (S32)group.mGroupHeader.patch_size, size);
+			ensure_equals("patch count", (S32)group.mHeaders.size(), PATCH_COUNT);
+			ensure_equals("heights", (S32)group.mHeights.size(), PATCH_COUNT * size * size);
+			for (S32 p = 0; p < PATCH_COUNT; p++)
+			{
+				ensure_equals("patch ids", (S32)group.mHeaders[p].patchids, (p << 5) | (PATCH_COUNT - p));
+				const F32* heights = &group.mHeights[p * size * size];
+				for (S32 i = 0; i < size*size; i++)
+				{
+					ensure_equals("decoded like decompress_patch", heights[i], mExpected[p][i]);
+				}
+			}
+		}
+	};
+	typedef test_group<patch_dct_data> patch_dct_test;
+	typedef patch_dct_test::object patch_dct_object;
+	tut::patch_dct_test patch_dct("patch_dct");
+
+	// 16x16 patches (land, wind, cloud)
+	template<> template<>
+	void patch_dct_object::test<1>()
+	{
+		compareWithScalar(NORMAL_PATCH_SIZE);
+	}
+
+	// 32x32 patches
+	template<> template<>
+	void patch_dct_object::test<2>()
+	{
+		compareWithScalar(LARGE_PATCH_SIZE);
+	}
+
+	// a lone DC coefficient decodes to a flat patch
+	template<> template<>
+	void patch_dct_object::test<3>()
+	{
+		S32 cpatch[NORMAL_PATCH_SIZE*NORMAL_PATCH_SIZE];
+		F32 patch[NORMAL_PATCH_SIZE*NORMAL_PATCH_SIZE];
+		memset(cpatch, 0, sizeof(cpatch));
+		cpatch[0] = 100;
+
+		decompress(patch, cpatch, NORMAL_PATCH_SIZE, TRUE);
+		for (S32 i = 1; i < NORMAL_PATCH_SIZE*NORMAL_PATCH_SIZE; i++)
+		{
+			ensure_approximately_equals("DC only patch is flat", patch[i], patch[0], 16);
+		}
+	}
+
+	// a coded layer decodes to what decompress_patch() gives for each
+	// patch's coefficients
+	template<> template<>
+	void patch_dct_object::test<4>()
+	{
+		LLPatchDecodeThread::DecodedGroup group;
+		buildPacket(NORMAL_PATCH_SIZE, 7);
+		LLPatchDecodeThread::decodeGroup(mPacket, mPacketSize, group);
+		checkDecoded(group, NORMAL_PATCH_SIZE);
+
+		buildPacket(LARGE_PATCH_SIZE, 11);
+		LLPatchDecodeThread::decodeGroup(mPacket, mPacketSize, group);
+		checkDecoded(group, LARGE_PATCH_SIZE);
+
+		LLPatchDecodeThread::decodeGroup(mPacket, 0, group);
+		ensure("empty packet", group.mHeaders.empty() && group.mHeights.empty());
+	}
+
+	// through the decode thread, packets come back in the order queued
+	template<> template<>
+	void patch_dct_object::test<5>()
+	{
+		LLPatchDecodeThread thread(true);
+		buildPacket(NORMAL_PATCH_SIZE, 3);
+		for (U64 key = 1; key <= 20; key++)
+		{
+			thread.decode(key, mPacket, mPacketSize);
+		}
+
+		std::vector<LLPatchDecodeThread::DecodedGroup> decoded;
+		std::vector<LLPatchDecodeThread::DecodedGroup> groups;
+		LLTimer timer;
+		while (decoded.size() < 20 && timer.getElapsedTimeF32() < 10.f)
+		{
+			thread.update(0);
+			thread.getDecoded(groups);
+			decoded.insert(decoded.end(), groups.begin(), groups.end());
+			ms_sleep(1);
+		}
+		ensure_equals("all decoded", (S32)decoded.size(), 20);
+		for (S32 i = 0; i < 20; i++)
+		{
+			ensure_equals("in order", decoded[i].mKey, (U64)(i + 1));
+			checkDecoded(decoded[i], NORMAL_PATCH_SIZE);
+		}
+	}
+}
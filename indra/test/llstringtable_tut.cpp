@@ -0,0 +1,194 @@
+/** 
+ * @file llstringtable_tut.cpp
+ * @brief Tests for the sharded, thread cached LLStringTable
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "llstringtable.h"
+#include "llthread.h"
+#include "lltimer.h"
+#include "lltut.h"
+
+namespace tut
+{
+	const S32 STRING_TABLE_TEST_STRINGS = 64;
+
+	std::string string_table_test_string(S32 i)
+	{
+		return llformat("string table test %d", i);
+	}
+
+	// Repeatedly interns, looks up and releases a shared set of strings,
+	// counting every lookup that comes back wrong.
+	class StringTableHammer : public LLThread
+	{
+	public:
+		StringTableHammer(LLStringTable& table, S32 seed, S32 passes) :
+			LLThread("StringTableHammer"),
+			mTable(table),
+			mSeed(seed),
+			mPasses(passes),
+			mErrors(0)
+		{
+		}
+
+		S32 mErrors;
+
+	protected:
+		/*virtual*/ void run()
+		{
+			for (S32 pass = 0; pass < mPasses; pass++)
+			{
+				S32 i = (mSeed + pass * 7) % STRING_TABLE_TEST_STRINGS;
+				std::string str = string_table_test_string(i);
+
+				char* added = mTable.addString(str);
+				if (!added || str != added)
+				{
+					mErrors++;
+				}
+				// We hold a reference, so the string can't go away
+				char* found = mTable.checkString(str);
+				if (found != added)
+				{
+					mErrors++;
+				}
+				mTable.removeString(str.c_str());
+			}
+		}
+
+	private:
+		LLStringTable& mTable;
+		S32 mSeed;
+		S32 mPasses;
+	};
+
+	struct stringtable_data
+	{
+	};
+	typedef test_group<stringtable_data> stringtable_test;
+	typedef stringtable_test::object stringtable_object;
+	tut::stringtable_test st("stringtable");
+
+	template<> template<>
+	void stringtable_object::test<1>()
+	{
+		// Single threaded add / check / remove
+		LLStringTable table(256);
+		char* a = table.addString("alpha");
+		ensure("added", a && !strcmp(a, "alpha"));
+		ensure_equals("same entry", table.addString("alpha"), a);
+		ensure_equals("found", table.checkString("alpha"), a);
+		ensure_equals("unique", (S32)table.mUniqueEntries, 1);
+
+		table.removeString("alpha");
+		ensure_equals("still referenced", table.checkString("alpha"), a);
+		table.removeString("alpha");
+		ensure("removed", table.checkString("alpha") == NULL);
+		ensure_equals("empty", (S32)table.mUniqueEntries, 0);
+	}
+
+	template<> template<>
+	void stringtable_object::test<2>()
+	{
+		// Cache hits are counted on the table that was looked in
+		LLStringTable table_a(256);
+		LLStringTable table_b(256);
+		table_a.addString("shared name");
+		table_b.addString("shared name");
+
+		U32 hits_a = table_a.getCacheHits();
+		U32 hits_b = table_b.getCacheHits();
+		for (S32 i = 0; i < 10; i++)
+		{
+			table_a.checkString("shared name");
+		}
+		ensure("hits counted on a", table_a.getCacheHits() > hits_a);
+		ensure_equals("no hits counted on b", table_b.getCacheHits(), hits_b);
+	}
+
+	template<> template<>
+	void stringtable_object::test<3>()
+	{
+		// Concurrent add / check / remove over overlapping strings
+		const S32 THREADS = 4;
+		LLStringTable table(64);
+		table.initThreadSafety();
+
+		StringTableHammer* threads[THREADS];
+		for (S32 t = 0; t < THREADS; t++)
+		{
+			threads[t] = new StringTableHammer(table, t * 3, 20000);
+			threads[t]->start();
+		}
+
+		// Meanwhile keep a few strings permanently interned and look them up
+		S32 main_errors = 0;
+		bool running = true;
+		char* held = table.addString(string_table_test_string(0));
+		while (running)
+		{
+			if (table.checkString(string_table_test_string(0)) != held)
+			{
+				main_errors++;
+			}
+			running = false;
+			for (S32 t = 0; t < THREADS; t++)
+			{
+				running = running || !threads[t]->isStopped();
+			}
+			LLThread::yield();
+		}
+
+		S32 errors = main_errors;
+		for (S32 t = 0; t < THREADS; t++)
+		{
+			errors += threads[t]->mErrors;
+			delete threads[t];
+		}
+		ensure_equals("lookup errors", errors, 0);
+
+		table.removeString(string_table_test_string(0).c_str());
+		ensure_equals("all released", (S32)table.mUniqueEntries, 0);
+		for (S32 i = 0; i < STRING_TABLE_TEST_STRINGS; i++)
+		{
+			ensure("string gone", table.checkString(string_table_test_string(i)) == NULL);
+		}
+
+		// Everything released was retired; freeing it mustn't disturb re-adding
+		table.freeRetiredEntries();
+		char* again = table.addString(string_table_test_string(5));
+		ensure("re-added", again && string_table_test_string(5) == again);
+		ensure_equals("found again", table.checkString(string_table_test_string(5)), again);
+		table.removeString(string_table_test_string(5).c_str());
+		table.cleanupThreadSafety();
+	}
+}
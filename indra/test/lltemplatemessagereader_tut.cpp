@@ -0,0 +1,389 @@
+/** 
+ * @file lltemplatemessagereader_tut.cpp
+ * @brief Tests and decode benchmark for compiled template message fields
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+
+#include "llmessagetemplate.h"
+#include "lltemplatemessagebuilder.h"
+#include "lltemplatemessagereader.h"
+#include "llversionserver.h"
+#include "message.h"
+#include "message_prehash.h"
+#include "v3math.h"
+
+namespace tut
+{
+	static void null_handler(LLMessageSystem*, void**)
+	{
+	}
+
+	struct template_reader_data
+	{
+		LLMessageTemplate* mTemplate;
+		LLTemplateMessageBuilder::message_template_name_map_t mNameMap;
+		LLTemplateMessageReader::message_template_number_map_t mNumberMap;
+		U8 mBuffer[MAX_BUFFER_SIZE];
+		U32 mSize;
+
+		template_reader_data() : mSize(0)
+		{
+			static bool init = false;
+			if (!init)
+			{
+				start_messaging_system("notafile", 13035,
+									   LL_VERSION_MAJOR,
+									   LL_VERSION_MINOR,
+									   LL_VERSION_PATCH,
+									   FALSE,
+									   "notasharedsecret",
+									   NULL,
+									   false,
+									   5.f,
+									   100.f);
+				init = true;
+			}
+
+			// the parts of ObjectUpdate that matter for layout: a fixed
+			// block, then a variable block mixing fixed and variable
+			// length fields
+			mTemplate = new LLMessageTemplate(_PREHASH_ObjectUpdate, 12, MFT_HIGH);
+			LLMessageBlock* region = new LLMessageBlock(_PREHASH_RegionData, MBT_SINGLE);
+			region->addVariable((char*)_PREHASH_RegionHandle, MVT_U64, 8);
+			region->addVariable((char*)_PREHASH_TimeDilation, MVT_U16, 2);
+			mTemplate->addBlock(region);
+			LLMessageBlock* objects = new LLMessageBlock(_PREHASH_ObjectData, MBT_VARIABLE);
+			objects->addVariable((char*)_PREHASH_ID, MVT_U32, 4);
+			objects->addVariable((char*)_PREHASH_FullID, MVT_LLUUID, 16);
+			objects->addVariable((char*)_PREHASH_CRC, MVT_U32, 4);
+			objects->addVariable((char*)_PREHASH_PCode, MVT_U8, 1);
+			objects->addVariable((char*)_PREHASH_Material, MVT_U8, 1);
+			objects->addVariable((char*)_PREHASH_Scale, MVT_LLVector3, 12);
+			objects->addVariable((char*)_PREHASH_ObjectData, MVT_VARIABLE, 1);
+			objects->addVariable((char*)_PREHASH_ParentID, MVT_U32, 4);
+			objects->addVariable((char*)_PREHASH_TextureEntry, MVT_VARIABLE, 2);
+			objects->addVariable((char*)_PREHASH_NameValue, MVT_VARIABLE, 2);
+			objects->addVariable((char*)_PREHASH_Sound, MVT_LLUUID, 16);
+			objects->addVariable((char*)_PREHASH_OwnerID, MVT_LLUUID, 16);
+			objects->addVariable((char*)_PREHASH_Gain, MVT_F32, 4);
+			objects->addVariable((char*)_PREHASH_Flags, MVT_U8, 1);
+			mTemplate->addBlock(objects);
+			mTemplate->setHandlerFunc(null_handler, NULL);
+
+			mNameMap[_PREHASH_ObjectUpdate] = mTemplate;
+			mNumberMap[12] = mTemplate;
+		}
+
+		~template_reader_data()
+		{
+			delete mTemplate;
+		}
+
+		void buildObjectUpdate(S32 num_objects)
+		{
+			LLTemplateMessageBuilder builder(mNameMap);
+			builder.newMessage(_PREHASH_ObjectUpdate);
+			builder.nextBlock(_PREHASH_RegionData);
+			builder.addU64(_PREHASH_RegionHandle, 0x0003e8000003e800ULL);
+			builder.addU16(_PREHASH_TimeDilation, 65535);
+
+			U8 object_data[60];
+			U8 texture_entry[140];
+			for (S32 i = 0; i < (S32)sizeof(object_data); i++) object_data[i] = (U8)i;
+			for (S32 i = 0; i < (S32)sizeof(texture_entry); i++) texture_entry[i] = (U8)(255 - i);
+			for (S32 i = 0; i < num_objects; i++)
+			{
+				LLUUID id;
+				id.mData[0] = (U8)i;
+				id.mData[15] = 0x42;
+				builder.nextBlock(_PREHASH_ObjectData);
+				builder.addU32(_PREHASH_ID, 1000 + i);
+				builder.addUUID(_PREHASH_FullID, id);
+				builder.addU32(_PREHASH_CRC, 0xdeadbeef + i);
+				builder.addU8(_PREHASH_PCode, 9);
+				builder.addU8(_PREHASH_Material, 3);
+				builder.addVector3(_PREHASH_Scale, LLVector3(0.5f, 1.f + i, 2.f));
+				builder.addBinaryData(_PREHASH_ObjectData, object_data, (i & 1) ? 60 : 32);
+				builder.addU32(_PREHASH_ParentID, i ? 1000 : 0);
+				builder.addBinaryData(_PREHASH_TextureEntry, texture_entry, 40 + i);
+				builder.addString(_PREHASH_NameValue, i ? "" : "AttachItemID STRING RW SV 00000000-0000-0000-0000-000000000000");
+				builder.addUUID(_PREHASH_Sound, LLUUID::null);
+				builder.addUUID(_PREHASH_OwnerID, id);
+				builder.addF32(_PREHASH_Gain, 0.25f * i);
+				builder.addU8(_PREHASH_Flags, (U8)i);
+			}
+			memset(mBuffer, 0, LL_PACKET_ID_SIZE);
+			mSize = builder.buildMessage(mBuffer, MAX_BUFFER_SIZE, 0);
+		}
+
+		void decode(LLTemplateMessageReader& reader)
+		{
+			reader.clearMessage();
+			ensure("valid", reader.validateMessage(mBuffer, mSize, LLHost()));
+			ensure("decoded", reader.readMessage(mBuffer, LLHost()));
+		}
+	};
+	typedef test_group<template_reader_data> template_reader_test;
+	typedef template_reader_test::object template_reader_object;
+	tut::template_reader_test template_reader("LLTemplateMessageReader");
+
+	// compiled fields agree with the name based getters
+	template<> template<>
+	void template_reader_object::test<1>()
+	{
+		buildObjectUpdate(6);
+		LLTemplateMessageReader reader(mNumberMap);
+		decode(reader);
+
+		LLMessageField id_field(mTemplate, _PREHASH_ObjectData, _PREHASH_ID);
+		LLMessageField full_id_field(mTemplate, _PREHASH_ObjectData, _PREHASH_FullID);
+		LLMessageField scale_field(mTemplate, _PREHASH_ObjectData, _PREHASH_Scale);
+		LLMessageField parent_field(mTemplate, _PREHASH_ObjectData, _PREHASH_ParentID);
+		LLMessageField te_field(mTemplate, _PREHASH_ObjectData, _PREHASH_TextureEntry);
+		LLMessageField gain_field(mTemplate, _PREHASH_ObjectData, _PREHASH_Gain);
+		LLMessageField handle_field(mTemplate, _PREHASH_RegionData, _PREHASH_RegionHandle);
+		ensure("fields resolved", id_field.isValid() && te_field.isValid() && handle_field.isValid());
+		ensure("unknown field", !LLMessageField(mTemplate, _PREHASH_ObjectData, _PREHASH_UpdateFlags).isValid());
+
+		ensure_equals("block count", reader.getNumberOfBlocks(id_field), 6);
+		ensure_equals("block count by name", reader.getNumberOfBlocks(_PREHASH_ObjectData), 6);
+
+		U64 handle = 0;
+		ensure("region handle", reader.getField(handle_field, handle));
+		ensure("region handle value", handle == 0x0003e8000003e800ULL);
+
+		for (S32 i = 0; i < 6; i++)
+		{
+			U32 id = 0, by_name = 0;
+			reader.getField(id_field, id, i);
+			reader.getU32(_PREHASH_ObjectData, _PREHASH_ID, by_name, i);
+			ensure_equals("id", id, (U32)(1000 + i));
+			ensure_equals("id by name", by_name, id);
+
+			LLUUID full_id;
+			reader.getField(full_id_field, full_id, i);
+			ensure_equals("full id", (S32)full_id.mData[0], i);
+
+			// fixed fields after a variable length one
+			U32 parent = 1;
+			reader.getField(parent_field, parent, i);
+			ensure_equals("parent", parent, (U32)(i ? 1000 : 0));
+			LLVector3 scale;
+			reader.getField(scale_field, scale.mV, i);
+			ensure_equals("scale", scale.mV[VY], 1.f + i);
+			F32 gain = -1.f, gain_by_name = -1.f;
+			reader.getField(gain_field, gain, i);
+			reader.getF32(_PREHASH_ObjectData, _PREHASH_Gain, gain_by_name, i);
+			ensure_equals("gain", gain, 0.25f * i);
+			ensure_equals("gain by name", gain_by_name, gain);
+
+			S32 te_size = 0;
+			const U8* te = reader.getFieldData(te_field, i, te_size);
+			ensure_equals("texture entry size", te_size, 40 + i);
+			ensure_equals("texture entry size by name",
+						  reader.getSize(_PREHASH_ObjectData, i, _PREHASH_TextureEntry), te_size);
+			ensure_equals("texture entry data", (S32)te[1], 254);
+		}
+
+		S32 size = 0;
+		ensure("past the last block", reader.getFieldData(id_field, 6, size) == NULL);
+		U32 untouched = 7;
+		ensure("wrong size", !reader.getField(id_field, (U8&)untouched, 0));
+		ensure_equals("left alone", untouched, (U32)7);
+	}
+
+	// a message cut short reads zeros for the missing fields, and
+	// variable length fields never reach past the end of the packet
+	template<> template<>
+	void template_reader_object::test<2>()
+	{
+		buildObjectUpdate(1);
+		LLTemplateMessageReader reader(mNumberMap);
+		mSize -= 30;	// lose the tail of the last block
+		decode(reader);
+
+		LLMessageField gain_field(mTemplate, _PREHASH_ObjectData, _PREHASH_Gain);
+		LLMessageField owner_field(mTemplate, _PREHASH_ObjectData, _PREHASH_OwnerID);
+		F32 gain = 1.f;
+		ensure("gain present", reader.getField(gain_field, gain, 0));
+		ensure_equals("missing gain reads zero", gain, 0.f);
+		LLUUID owner;
+		owner.generate();
+		reader.getField(owner_field, owner, 0);
+		ensure("owner id partially missing", owner.mData[15] == 0);
+
+		// the texture entry length claims more than is left
+		buildObjectUpdate(1);
+		LLMessageField te_field(mTemplate, _PREHASH_ObjectData, _PREHASH_TextureEntry);
+		mSize -= 110;
+		decode(reader);
+		S32 te_size = 0;
+		const U8* te = reader.getFieldData(te_field, 0, te_size);
+		ensure("texture entry present", te != NULL);
+		ensure("texture entry clamped", te_size < 40);
+	}
+
+	// every ObjectUpdate field reads the same by name and compiled
+	template<> template<>
+	void template_reader_object::test<3>()
+	{
+		const S32 OBJECTS = 8;
+		buildObjectUpdate(OBJECTS);
+		LLTemplateMessageReader reader(mNumberMap);
+		decode(reader);
+
+		LLMessageField id_field(mTemplate, _PREHASH_ObjectData, _PREHASH_ID);
+		LLMessageField full_id_field(mTemplate, _PREHASH_ObjectData, _PREHASH_FullID);
+		LLMessageField crc_field(mTemplate, _PREHASH_ObjectData, _PREHASH_CRC);
+		LLMessageField pcode_field(mTemplate, _PREHASH_ObjectData, _PREHASH_PCode);
+		LLMessageField material_field(mTemplate, _PREHASH_ObjectData, _PREHASH_Material);
+		LLMessageField scale_field(mTemplate, _PREHASH_ObjectData, _PREHASH_Scale);
+		LLMessageField object_data_field(mTemplate, _PREHASH_ObjectData, _PREHASH_ObjectData);
+		LLMessageField parent_field(mTemplate, _PREHASH_ObjectData, _PREHASH_ParentID);
+		LLMessageField te_field(mTemplate, _PREHASH_ObjectData, _PREHASH_TextureEntry);
+		LLMessageField sound_field(mTemplate, _PREHASH_ObjectData, _PREHASH_Sound);
+		LLMessageField owner_field(mTemplate, _PREHASH_ObjectData, _PREHASH_OwnerID);
+		LLMessageField gain_field(mTemplate, _PREHASH_ObjectData, _PREHASH_Gain);
+		LLMessageField flags_field(mTemplate, _PREHASH_ObjectData, _PREHASH_Flags);
+
+		S32 count = reader.getNumberOfBlocks(id_field);
+		ensure_equals("block count", count, reader.getNumberOfBlocks(_PREHASH_ObjectData));
+		ensure_equals("all objects", count, OBJECTS);
+		for (S32 i = 0; i < count; i++)
+		{
+			U32 id, crc, parent, field_id, field_crc, field_parent;
+			U8 pcode, material, flags, field_pcode, field_material, field_flags;
+			LLUUID full_id, sound, owner, field_full_id, field_sound, field_owner;
+			LLVector3 scale, field_scale;
+			F32 gain, field_gain;
+			U8 data[256];
+
+			reader.getU32(_PREHASH_ObjectData, _PREHASH_ID, id, i);
+			reader.getUUID(_PREHASH_ObjectData, _PREHASH_FullID, full_id, i);
+			reader.getU32(_PREHASH_ObjectData, _PREHASH_CRC, crc, i);
+			reader.getU8(_PREHASH_ObjectData, _PREHASH_PCode, pcode, i);
+			reader.getU8(_PREHASH_ObjectData, _PREHASH_Material, material, i);
+			reader.getVector3(_PREHASH_ObjectData, _PREHASH_Scale, scale, i);
+			reader.getU32(_PREHASH_ObjectData, _PREHASH_ParentID, parent, i);
+			reader.getUUID(_PREHASH_ObjectData, _PREHASH_Sound, sound, i);
+			reader.getUUID(_PREHASH_ObjectData, _PREHASH_OwnerID, owner, i);
+			reader.getF32(_PREHASH_ObjectData, _PREHASH_Gain, gain, i);
+			reader.getU8(_PREHASH_ObjectData, _PREHASH_Flags, flags, i);
+
+			ensure("id", reader.getField(id_field, field_id, i));
+			ensure("full id", reader.getField(full_id_field, field_full_id, i));
+			ensure("crc", reader.getField(crc_field, field_crc, i));
+			ensure("pcode", reader.getField(pcode_field, field_pcode, i));
+			ensure("material", reader.getField(material_field, field_material, i));
+			ensure("scale", reader.getField(scale_field, field_scale.mV, i));
+			ensure("parent", reader.getField(parent_field, field_parent, i));
+			ensure("sound", reader.getField(sound_field, field_sound, i));
+			ensure("owner", reader.getField(owner_field, field_owner, i));
+			ensure("gain", reader.getField(gain_field, field_gain, i));
+			ensure("flags", reader.getField(flags_field, field_flags, i));
+
+			ensure_equals("id matches", field_id, id);
+			ensure_equals("full id matches", field_full_id, full_id);
+			ensure_equals("crc matches", field_crc, crc);
+			ensure_equals("pcode matches", field_pcode, pcode);
+			ensure_equals("material matches", field_material, material);
+			ensure_equals("scale matches", field_scale, scale);
+			ensure_equals("parent matches", field_parent, parent);
+			ensure_equals("sound matches", field_sound, sound);
+			ensure_equals("owner matches", field_owner, owner);
+			ensure_equals("gain matches", field_gain, gain);
+			ensure_equals("flags matches", field_flags, flags);
+
+			S32 length = reader.getSize(_PREHASH_ObjectData, i, _PREHASH_ObjectData);
+			reader.getBinaryData(_PREHASH_ObjectData, _PREHASH_ObjectData, data, length, i);
+			S32 field_length = 0;
+			const U8* object_data = reader.getFieldData(object_data_field, i, field_length);
+			ensure_equals("object data length", field_length, length);
+			ensure("object data", object_data && !memcmp(object_data, data, length));
+
+			length = reader.getSize(_PREHASH_ObjectData, i, _PREHASH_TextureEntry);
+			reader.getBinaryData(_PREHASH_ObjectData, _PREHASH_TextureEntry, data, length, i);
+			const U8* te = reader.getFieldData(te_field, i, field_length);
+			ensure_equals("texture entry length", field_length, length);
+			ensure("texture entry", te && !memcmp(te, data, length));
+		}
+	}
+
+	// a field resolved against another message's template is refused
+	template<> template<>
+	void template_reader_object::test<4>()
+	{
+		buildObjectUpdate(2);
+		LLTemplateMessageReader reader(mNumberMap);
+		decode(reader);
+
+		LLMessageTemplate other(_PREHASH_ImprovedTerseObjectUpdate, 15, MFT_HIGH);
+		LLMessageBlock* objects = new LLMessageBlock(_PREHASH_ObjectData, MBT_VARIABLE);
+		objects->addVariable((char*)_PREHASH_ID, MVT_U32, 4);
+		other.addBlock(objects);
+		LLMessageField foreign_field(&other, _PREHASH_ObjectData, _PREHASH_ID);
+		ensure("foreign field resolved", foreign_field.isValid());
+
+		ensure_equals("no blocks", reader.getNumberOfBlocks(foreign_field), 0);
+		S32 size = -1;
+		ensure("no data", reader.getFieldData(foreign_field, 0, size) == NULL);
+		U32 id = 7;
+		ensure("not read", !reader.getField(foreign_field, id, 0));
+		ensure_equals("value untouched", id, (U32)7);
+	}
+
+	// a field cached from a template that has since been replaced, as
+	// when a second message system loads the same messages, is refused
+	// even though it names the same message and block
+	template<> template<>
+	void template_reader_object::test<5>()
+	{
+		LLMessageField cached(mTemplate, _PREHASH_ObjectData, _PREHASH_CRC);
+		ensure("current template", cached.mTemplateSerial == mTemplate->mSerial);
+
+		template_reader_data replacement;
+		replacement.buildObjectUpdate(1);
+		LLTemplateMessageReader reader(replacement.mNumberMap);
+		replacement.decode(reader);
+		ensure("stale field", !reader.isFieldOfCurrentMessage(cached));
+		U32 crc = 7;
+		ensure("stale field not read", !reader.getField(cached, crc, 0));
+		ensure_equals("value untouched", crc, (U32)7);
+
+		LLMessageField resolved(replacement.mTemplate, _PREHASH_ObjectData, _PREHASH_CRC);
+		ensure("resolved again", reader.isFieldOfCurrentMessage(resolved));
+		ensure("read", reader.getField(resolved, crc, 0));
+		ensure_equals("crc", crc, (U32)0xdeadbeef);
+	}
+}
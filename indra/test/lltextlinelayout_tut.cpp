@@ -0,0 +1,233 @@
+/** 
+ * @file lltextlinelayout_tut.cpp
+ * @brief Tests for incremental LLTextLineLayout wrapping
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltextlinelayout.h"
+#include "lltut.h"
+
+namespace tut
+{
+	// Words, spaces and newlines, with a few words longer than a line so
+	// that lines also get broken mid-word.
+	const char* const FRAGMENTS[] =
+	{
+		"a", "if", "foo", "llSay", "integer", "state_entry", "WWW", "iiii",
+		"MMMMMMMMMMMMMMMM", "abcdefghijklmnopqrstuvwxyz", " ", " ", " ", "  ",
+		"\t", "\n", "\n", "\n\n", " \n", "x y z", "Wi lM"
+	};
+	const S32 NUM_FRAGMENTS = sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0]);
+
+	// Fixed advance per character, broken the way LLFontGL::maxDrawableChars()
+	// breaks: at the start of the last word if word wrapping and there is one,
+	// otherwise at the first character that does not fit.
+	class TestMeasure : public LLTextLineLayout::Measure
+	{
+	public:
+		TestMeasure(S32 width, BOOL word_wrap) : mWidth(width), mWordWrap(word_wrap) {}
+
+		static S32 advance(llwchar wch)
+		{
+			switch (wch)
+			{
+			case 'W': case 'M': return 3;
+			case 'i': case 'l': case ' ': return 1;
+			default: return 2;
+			}
+		}
+
+		/*virtual*/ S32 fitChars(const llwchar* str, S32 max_chars) const
+		{
+			S32 x = 0;
+			S32 start_of_last_word = 0;
+			BOOL in_word = FALSE;
+			for (S32 i = 0; i < max_chars; i++)
+			{
+				llwchar wch = str[i];
+				BOOL space = (wch == ' ' || wch == '\t');
+				if (in_word)
+				{
+					in_word = !space;
+				}
+				else
+				{
+					start_of_last_word = i;
+					in_word = !space;
+				}
+				x += advance(wch);
+				if (x > mWidth)
+				{
+					return (mWordWrap && start_of_last_word != 0) ? start_of_last_word : i;
+				}
+			}
+			return max_chars;
+		}
+
+	private:
+		S32 mWidth;
+		BOOL mWordWrap;
+	};
+
+	struct textlinelayout_data
+	{
+		U32 mSeed;
+
+		textlinelayout_data() : mSeed(54321) {}
+
+		U32 random(U32 range)
+		{
+			mSeed = mSeed * 1664525 + 1013904223;
+			return (mSeed >> 8) % range;
+		}
+
+		LLWString randomText(S32 fragments)
+		{
+			std::string text;
+			for (S32 i = 0; i < fragments; i++)
+			{
+				text += FRAGMENTS[random(NUM_FRAGMENTS)];
+			}
+			return utf8str_to_wstring(text);
+		}
+
+		void ensureSameLines(const std::string& msg, const LLTextLineLayout& actual, const LLTextLineLayout& expected)
+		{
+			ensure_equals(msg + " line count", actual.getLineCount(), expected.getLineCount());
+			for (S32 i = 0; i < expected.getLineCount(); i++)
+			{
+				ensure_equals(llformat("%s line %d", msg.c_str(), i), actual.getLineStart(i), expected.getLineStart(i));
+			}
+		}
+
+		// Applies count random batches of inserts, removes and overwrites to
+		// text, reflowing layout incrementally after each batch and checking
+		// it against a layout of the whole text from scratch.
+		void checkRandomEdits(LLWString& text, const TestMeasure& measure, S32 count, S32 max_batch)
+		{
+			LLTextLineLayout layout;
+			layout.reflow(text, measure);
+
+			for (S32 n = 0; n < count; n++)
+			{
+				S32 batch = 1 + random(max_batch);
+				for (S32 b = 0; b < batch; b++)
+				{
+					S32 pos = random(text.size() + 1);
+					switch (random(3))
+					{
+					case 0:
+						{
+							LLWString inserted = randomText(1 + random(3));
+							text.insert(pos, inserted);
+							layout.textChanged(pos, 0, inserted.size());
+						}
+						break;
+					case 1:
+						{
+							S32 removed = llmin((S32)random(20), (S32)text.size() - pos);
+							text.erase(pos, removed);
+							layout.textChanged(pos, removed, 0);
+						}
+						break;
+					default:
+						// overwrite mode replaces one character at a time
+						if (pos < (S32)text.size())
+						{
+							text[pos] = FRAGMENTS[random(NUM_FRAGMENTS)][0];
+							layout.textChanged(pos, 1, 1);
+						}
+						break;
+					}
+				}
+
+				layout.reflow(text, measure);
+				LLTextLineLayout full;
+				full.reflow(text, measure);
+				ensureSameLines(llformat("edit %d", n), layout, full);
+			}
+		}
+	};
+	typedef test_group<textlinelayout_data> textlinelayout_test;
+	typedef textlinelayout_test::object textlinelayout_object;
+	tut::textlinelayout_test textlinelayout("LLTextLineLayout");
+
+	// single edits, word wrapped
+	template<> template<>
+	void textlinelayout_object::test<1>()
+	{
+		LLWString text = randomText(400);
+		checkRandomEdits(text, TestMeasure(40, TRUE), 2000, 1);
+	}
+
+	// several edits between reflows, word wrapped
+	template<> template<>
+	void textlinelayout_object::test<2>()
+	{
+		LLWString text = randomText(400);
+		checkRandomEdits(text, TestMeasure(40, TRUE), 2000, 4);
+	}
+
+	// wrapping anywhere, on lines narrower than most words
+	template<> template<>
+	void textlinelayout_object::test<3>()
+	{
+		LLWString text = randomText(400);
+		checkRandomEdits(text, TestMeasure(7, FALSE), 2000, 3);
+	}
+
+	// edits that empty the text and grow it back
+	template<> template<>
+	void textlinelayout_object::test<4>()
+	{
+		LLWString text = randomText(5);
+		checkRandomEdits(text, TestMeasure(12, TRUE), 500, 2);
+	}
+
+	// invalidate() re-wraps everything for a new width
+	template<> template<>
+	void textlinelayout_object::test<5>()
+	{
+		LLWString text = randomText(200);
+		LLTextLineLayout layout;
+		layout.reflow(text, TestMeasure(40, TRUE));
+
+		layout.invalidate();
+		ensure("reflow pending", layout.needsReflow());
+		layout.reflow(text, TestMeasure(25, TRUE));
+		ensure_not("reflowed", layout.needsReflow());
+
+		LLTextLineLayout full;
+		full.reflow(text, TestMeasure(25, TRUE));
+		ensureSameLines("new width", layout, full);
+	}
+}
@@ -0,0 +1,186 @@
+/** 
+ * @file llthrottle_tut.cpp
+ * @brief Tests for the adaptive LLThrottleGroup redistribution
+ *
+ * $LicenseInfo:firstyear=2011&license=viewergpl$
+ * 
+ * Copyright (c) 2011, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "llthrottle.h"
+#include "lltut.h"
+
+namespace tut
+{
+	// Exposes the measurements adaptiveAdjust() works from, so the tests
+	// don't have to wait out real adjustment periods.
+	class TestThrottleGroup : public LLThrottleGroup
+	{
+	public:
+		void setDemand(S32 throttle_cat, F32 achieved_bps, F32 queued_bits)
+		{
+			mAchievedBPS[throttle_cat] = achieved_bps;
+			mQueueDepth[throttle_cat] = queued_bits;
+		}
+		void setLinkScale(F32 scale)	{ mLinkScale = scale; }
+		void adjust(S32 times)
+		{
+			for (S32 i = 0; i < times; i++)
+			{
+				adaptiveAdjust();
+			}
+		}
+		F32 getCurrentTotal() const
+		{
+			F32 total = 0.f;
+			for (S32 i = 0; i < TC_EOF; i++)
+			{
+				total += mCurrentBPS[i];
+			}
+			return total;
+		}
+	};
+
+	struct throttle_data
+	{
+		throttle_data()
+		{
+			// Roughly the viewer's 500kbps preset
+			F32 nominal[TC_EOF] = { 50000.f, 70000.f, 14000.f, 14000.f, 136000.f, 136000.f, 80000.f };
+			mNominalTotal = 0.f;
+			for (S32 i = 0; i < TC_EOF; i++)
+			{
+				mNominal[i] = nominal[i];
+				mNominalTotal += nominal[i];
+			}
+			mGroup.setNominalBPS(mNominal);
+		}
+
+		TestThrottleGroup mGroup;
+		F32 mNominal[TC_EOF];
+		F32 mNominalTotal;
+	};
+	typedef test_group<throttle_data> throttle_test;
+	typedef throttle_test::object throttle_object;
+	tut::throttle_test throttle("throttle");
+
+	template<> template<>
+	void throttle_object::test<1>()
+	{
+		// A backlogged category takes bandwidth from idle ones without
+		// growing the total.
+		mGroup.setDemand(TC_TEXTURE, mNominal[TC_TEXTURE], 400000.f);
+		mGroup.adjust(10);
+
+		ensure("backlogged texture gets more than its share",
+			   mGroup.getCurrentBPS(TC_TEXTURE) > mNominal[TC_TEXTURE] * 1.5f);
+		ensure("idle land gives some up", mGroup.getCurrentBPS(TC_LAND) < mNominal[TC_LAND]);
+		ensure_distance("total is unchanged", mGroup.getCurrentTotal(), mNominalTotal, mNominalTotal * 0.01f);
+	}
+
+	template<> template<>
+	void throttle_object::test<2>()
+	{
+		// With more demand than budget, spare bandwidth goes to the higher
+		// priority category, and nobody drops below their floor.
+		mGroup.setDemand(TC_TASK, mNominal[TC_TASK], 2000000.f);
+		mGroup.setDemand(TC_ASSET, mNominal[TC_ASSET], 2000000.f);
+		mGroup.adjust(10);
+
+		F32 task_gain = mGroup.getCurrentBPS(TC_TASK) - mNominal[TC_TASK];
+		F32 asset_gain = mGroup.getCurrentBPS(TC_ASSET) - mNominal[TC_ASSET];
+		ensure("task gains", task_gain > 0.f);
+		ensure("task outranks asset", task_gain > asset_gain);
+		ensure("wind keeps its floor", mGroup.getCurrentBPS(TC_WIND) >= 4000.f * 0.99f);
+		ensure_distance("total is unchanged", mGroup.getCurrentTotal(), mNominalTotal, mNominalTotal * 0.01f);
+	}
+
+	template<> template<>
+	void throttle_object::test<3>()
+	{
+		// A congested link scales the whole budget down.
+		mGroup.setLinkScale(0.5f);
+		mGroup.setDemand(TC_TASK, mNominal[TC_TASK], 0.f);
+		mGroup.adjust(10);
+
+		ensure_distance("total follows the link scale", mGroup.getCurrentTotal(), mNominalTotal * 0.5f, mNominalTotal * 0.01f);
+		ensure("busy task keeps most of its share", mGroup.getCurrentBPS(TC_TASK) > mNominal[TC_TASK] * 0.5f);
+	}
+
+	template<> template<>
+	void throttle_object::test<4>()
+	{
+		// Resends back the link scale off, and a clean link recovers it.
+		U32 out = 0;
+		U32 resent = 0;
+		mGroup.updateLinkStats(100.f, out, resent);
+		for (S32 i = 0; i < 5; i++)
+		{
+			out += 1000;
+			resent += 100;
+			mGroup.updateLinkStats(100.f, out, resent);
+		}
+		F32 backed_off = mGroup.getLinkScale();
+		ensure("loss backs off", backed_off < 1.f);
+
+		for (S32 i = 0; i < 50; i++)
+		{
+			out += 1000;
+			mGroup.updateLinkStats(100.f, out, resent);
+		}
+		ensure_distance("clean link recovers", mGroup.getLinkScale(), 1.f, 0.001f);
+	}
+
+	template<> template<>
+	void throttle_object::test<5>()
+	{
+		// The split LLViewerThrottle asks the sim for: with no demand at
+		// all the budget is handed back in nominal proportions.
+		F32 demand[TC_EOF];
+		F32 priority[TC_EOF];
+		F32 alloc[TC_EOF];
+		for (S32 i = 0; i < TC_EOF; i++)
+		{
+			demand[i] = 0.f;
+			priority[i] = LLThrottleGroup::getDefaultPriorityWeight(i);
+		}
+		LLThrottleGroup::allocateByDemand(mNominal, demand, priority, 1.f, alloc);
+
+		F32 total = 0.f;
+		for (S32 i = 0; i < TC_EOF; i++)
+		{
+			total += alloc[i];
+		}
+		ensure_distance("whole budget handed out", total, mNominalTotal, 1.f);
+		ensure("task still outweighs wind", alloc[TC_TASK] > alloc[TC_WIND]);
+
+		demand[TC_ASSET] = mNominal[TC_ASSET] * 3.f;
+		LLThrottleGroup::allocateByDemand(mNominal, demand, priority, 1.f, alloc);
+		ensure("demand pulls bandwidth", alloc[TC_ASSET] > mNominal[TC_ASSET] * 2.f);
+	}
+}
@@ -35,11 +35,284 @@
 #include "lltut.h"
 
 #include "llxfer_file.h"
+#include "llxfermanager.h"
+#include "llfile.h"
+#include "lltemplatemessagebuilder.h"
+#include "message.h"
+#include "message_prehash.h"
+
+#include <map>
+
+namespace
+{
+	struct XferLinkSim;
+
+	// The receiving end is the real LLXferManager.  Its confirmations go
+	// onto the simulated wire instead of out through the message system,
+	// and the RequestXfer is skipped since the simulated sender doesn't
+	// need asking.
+	class SimXferManager : public LLXferManager
+	{
+	public:
+		SimXferManager(XferLinkSim* sim) : LLXferManager(NULL), mSim(sim) {}
+
+		virtual void sendConfirmPacket(LLMessageSystem* mesgsys, U64 id, S32 packetnum, const LLHost& remote_host);
+
+	protected:
+		virtual void startPendingDownloads()
+		{
+			for (LLXfer* xferp = mReceiveList; xferp; xferp = xferp->mNext)
+			{
+				if (xferp->mStatus == e_LL_XFER_PENDING)
+				{
+					xferp->mStatus = e_LL_XFER_IN_PROGRESS;
+				}
+			}
+		}
+
+	private:
+		XferLinkSim* mSim;
+	};
+
+	// Runs an LLXferSendWindow against a receiving LLXferManager over a
+	// simulated link with fixed one way latency and random loss in both
+	// directions.  Data packets are built as SendXferPacket messages and
+	// fed through the message system to processReceiveData(), so
+	// reordering and confirmation are the manager's own.  Time is virtual;
+	// the sender's retransmit check runs once per tick like it does once
+	// per frame in the viewer.
+	struct XferLinkSim
+	{
+		enum { CHUNK_SIZE = 100 };
+
+		struct Message
+		{
+			S32 mPacket;
+			bool mIsConfirm;
+		};
+		typedef std::multimap<F64, Message> wire_t;
+
+		XferLinkSim(LLMessageSystem* msg, S32 window, S32 num_packets, F64 latency, F32 loss)
+		:	mMsg(msg),
+			mReceiver(this),
+			mHost("127.0.0.1:13050"),
+			mNumPackets(num_packets),
+			mLatency(latency),
+			mLoss(loss),
+			mSeed(12345),
+			mNow(0.0),
+			mResult(LL_ERR_EOF)
+		{
+			mSender.init(window);
+			mReceiver.requestFile("xfer-link-sim", LL_PATH_NONE, mHost, FALSE, onComplete, (void**)this);
+			mXferID = mReceiver.mReceiveList->mID;
+		}
+
+		static void onComplete(void* data, S32 size, void** user_data, S32 result, LLExtStat)
+		{
+			XferLinkSim* sim = (XferLinkSim*)user_data;
+			sim->mResult = result;
+			sim->mData.assign((char*)data, (char*)data + size);
+		}
+
+		static void receiveXferPacket(LLMessageSystem* msg, void** user_data)
+		{
+			XferLinkSim* sim = (XferLinkSim*)user_data;
+			sim->mReceiver.processReceiveData(msg, user_data);
+		}
+
+		static char dataByte(S32 packet, S32 offset)
+		{
+			return (char)(packet * 7 + offset);
+		}
+
+		// True if the manager assembled every packet, in order.
+		bool receivedAll() const
+		{
+			if (mResult != LL_ERR_NOERR || (S32)mData.size() != mNumPackets * CHUNK_SIZE)
+			{
+				return false;
+			}
+			for (S32 i = 0; i < (S32)mData.size(); i++)
+			{
+				if (mData[i] != dataByte(i / CHUNK_SIZE, i % CHUNK_SIZE))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool lost()
+		{
+			mSeed = mSeed * 1103515245 + 12345;
+			return ((mSeed >> 16) & 0x7fff) / 32768.f < mLoss;
+		}
+
+		void put(F64 now, S32 packet, bool is_confirm)
+		{
+			if (!lost())
+			{
+				Message msg;
+				msg.mPacket = packet;
+				msg.mIsConfirm = is_confirm;
+				mWire.insert(std::make_pair(now + mLatency, msg));
+			}
+		}
+
+		void sendAvailable(F64 now)
+		{
+			while (mSender.canSendNew())
+			{
+				S32 packet = mSender.sendNew(now);
+				if (packet == mNumPackets - 1)
+				{
+					mSender.setLastPacket(packet);
+				}
+				put(now, packet, false);
+			}
+		}
+
+		void receive(F64 now, S32 packet)
+		{
+			// The first packet leads with the size of the whole xfer.
+			std::vector<char> payload;
+			if (packet == 0)
+			{
+				S32 xfer_size = mNumPackets * CHUNK_SIZE;
+				payload.resize(sizeof(S32));
+				htonmemcpy(&payload[0], &xfer_size, MVT_S32, sizeof(S32));
+			}
+			for (S32 i = 0; i < CHUNK_SIZE; i++)
+			{
+				payload.push_back(dataByte(packet, i));
+			}
+
+			LLTemplateMessageBuilder builder(mMsg->mMessageTemplates);
+			builder.newMessage(_PREHASH_SendXferPacket);
+			builder.nextBlock(_PREHASH_XferID);
+			builder.addU64(_PREHASH_ID, mXferID);
+			builder.addU32(_PREHASH_Packet, (U32)mReceiver.encodePacketNum(packet, packet == mNumPackets - 1));
+			builder.nextBlock(_PREHASH_DataPacket);
+			builder.addBinaryData(_PREHASH_Data, &payload[0], (S32)payload.size());
+			U8 buffer[MAX_BUFFER_SIZE];
+			memset(buffer, 0, LL_PACKET_ID_SIZE);
+			U32 size = builder.buildMessage(buffer, MAX_BUFFER_SIZE, 0);
+
+			mNow = now;
+			mMsg->checkMessages(0, true, buffer, mHost, size);
+		}
+
+		// Returns seconds taken, or a negative number if the xfer gave up.
+		F64 run()
+		{
+			const F64 TICK = 0.01;
+			const F64 GIVE_UP = 600.0;
+
+			LLMessageSystem* live_msg = gMessageSystem;
+			gMessageSystem = mMsg;
+			mMsg->setHandlerFuncFast(_PREHASH_SendXferPacket, receiveXferPacket, (void**)this);
+			mMsg->enableCircuit(mHost, TRUE);
+
+			F64 now = 0.0;
+			bool gave_up = false;
+			sendAvailable(now);
+			while (!mSender.isDone() && now < GIVE_UP && !gave_up)
+			{
+				F64 next = now + TICK;
+				while (!mWire.empty() && mWire.begin()->first <= next)
+				{
+					F64 when = mWire.begin()->first;
+					Message msg = mWire.begin()->second;
+					mWire.erase(mWire.begin());
+					if (msg.mIsConfirm)
+					{
+						mSender.ack(msg.mPacket, when);
+						sendAvailable(when);
+					}
+					else
+					{
+						receive(when, msg.mPacket);
+					}
+				}
+				now = next;
+
+				std::vector<S32> expired;
+				gave_up = !mSender.collectExpired(now, expired);
+				for (std::vector<S32>::iterator it = expired.begin(); it != expired.end(); ++it)
+				{
+					put(now, *it, false);
+				}
+			}
+
+			gMessageSystem = live_msg;
+			return mSender.isDone() ? now : -1.0;
+		}
+
+		LLMessageSystem* mMsg;
+		LLXferSendWindow mSender;
+		SimXferManager mReceiver;
+		LLHost mHost;
+		U64 mXferID;
+		wire_t mWire;
+		S32 mNumPackets;
+		F64 mLatency;
+		F32 mLoss;
+		U32 mSeed;
+		F64 mNow;
+		S32 mResult;
+		std::vector<char> mData;
+	};
+
+	void SimXferManager::sendConfirmPacket(LLMessageSystem*, U64, S32 packetnum, const LLHost&)
+	{
+		mSim->put(mSim->mNow, packetnum, true);
+	}
+}
 
 namespace tut
 {
 	struct llxfer_data
 	{
+		LLMessageSystem* mMsg;
+
+		llxfer_data() : mMsg(NULL) {}
+
+		~llxfer_data()
+		{
+			if (mMsg)
+			{
+				// circuit teardown reports to gMessageSystem
+				LLMessageSystem* live_msg = gMessageSystem;
+				gMessageSystem = mMsg;
+				delete mMsg;
+				gMessageSystem = live_msg;
+			}
+		}
+
+		// A message system of its own that knows just the xfer data packet
+		LLMessageSystem* getMessageSystem()
+		{
+			if (!mMsg)
+			{
+#if LL_WINDOWS
+				std::string template_file = "C:\\llxfer-test.msg";
+#else
+				std::string template_file = "/tmp/llxfer-test.msg";
+#endif
+				llofstream file(template_file);
+				file << "version 2.0\n"
+					 << "{\n\tSendXferPacket High 18 NotTrusted Unencoded\n"
+					 << "\t{\n\t\tXferID Single\n\t\t{ ID U64 }\n\t\t{ Packet U32 }\n\t}\n"
+					 << "\t{\n\t\tDataPacket Single\n\t\t{ Data Variable 2 }\n\t}\n}\n";
+				file.close();
+
+				mMsg = new LLMessageSystem(template_file, 0, 1, 0, 0, false, 5.f, 100.f);
+				LLFile::remove(template_file);
+				ensure("xfer message system", mMsg->isOK());
+			}
+			return mMsg;
+		}
 	};
 	typedef test_group<llxfer_data> llxfer_test;
 	typedef llxfer_test::object llxfer_object;
@@ -60,4 +333,148 @@ namespace tut
 		ensure("oversized local_filename nul-terminated",
 		       xff.getFileName().length() < LL_MAX_PATH);
 	}
+
+	template<> template<>
+	void llxfer_object::test<2>()
+	{
+		// Slow start opens the window, then only the overdue packet is
+		// resent and the window halves.
+		LLXferSendWindow window;
+		window.init(16);
+		ensure("starts small", window.getWindow() < 16.f);
+
+		S32 next = 0;
+		F64 now = 0.0;
+		S32 i;
+		while (window.getWindow() < 16.f && now < 10.0)
+		{
+			S32 first = next;
+			while (window.canSendNew())
+			{
+				ensure_equals("packet number", window.sendNew(now), next++);
+			}
+			now += 0.1;
+			for (i = first; i < next; ++i)
+			{
+				ensure("ack in flight", window.ack(i, now));
+			}
+		}
+		ensure_equals("window opened", window.getWindow(), 16.f);
+
+		S32 first = next;
+		for (i = 0; i < 16; ++i)
+		{
+			ensure("room in window", window.canSendNew());
+			window.sendNew(now);
+			next++;
+		}
+		ensure("window full", !window.canSendNew());
+		window.setLastPacket(next - 1);
+
+		S32 hole = first + 4;
+		for (i = first; i < next; ++i)
+		{
+			if (i != hole)
+			{
+				window.ack(i, now + 0.1);
+			}
+		}
+		ensure("duplicate ack ignored", !window.ack(first, now + 0.1));
+		ensure("not done with a hole", !window.isDone());
+
+		std::vector<S32> expired;
+		ensure("under retry limit", window.collectExpired(now + 5.0, expired));
+		ensure_equals("one packet resent", (S32)expired.size(), 1);
+		ensure_equals("the missing one", expired[0], hole);
+		ensure_equals("retransmit count", window.getRetransmits(), 1U);
+		ensure_equals("window halved", window.getWindow(), 8.f);
+
+		window.ack(hole, now + 5.1);
+		ensure("done", window.isDone());
+	}
+
+	template<> template<>
+	void llxfer_object::test<3>()
+	{
+		// A packet that is never confirmed eventually gives up.
+		LLXferSendWindow window;
+		window.init(4);
+		window.sendNew(0.0);
+		window.setLastPacket(0);
+
+		F64 now = 0.0;
+		std::vector<S32> expired;
+		S32 resends = 0;
+		while (resends < 100)
+		{
+			now += 100.0;
+			expired.clear();
+			if (!window.collectExpired(now, expired))
+			{
+				break;
+			}
+			resends += (S32)expired.size();
+		}
+		ensure_equals("resent up to the limit", resends, 10);
+	}
+
+	template<> template<>
+	void llxfer_object::test<4>()
+	{
+		LLXferReorderBuffer buffer;
+		char data[] = "abc";
+		ensure("ahead is kept", buffer.store(0, 3, TRUE, data, 3));
+		ensure("expected one is not", !buffer.store(0, 0, FALSE, data, 3));
+		ensure("behind is not", !buffer.store(5, 2, FALSE, data, 3));
+		ensure("too far ahead is not", !buffer.store(0, LL_XFER_MAX_WINDOW + 1, FALSE, data, 3));
+		ensure("has it", buffer.has(3));
+
+		std::vector<char> out;
+		BOOL is_eof = FALSE;
+		ensure("nothing at 1", !buffer.take(1, out, is_eof));
+		ensure("take 3", buffer.take(3, out, is_eof));
+		ensure_equals("size", (S32)out.size(), 3);
+		ensure("data", out[0] == 'a' && out[2] == 'c');
+		ensure("eof", is_eof);
+		ensure_equals("empty", buffer.size(), 0);
+	}
+
+	template<> template<>
+	void llxfer_object::test<5>()
+	{
+		// Loopback with 50ms each way and no loss: a window should beat
+		// stop-and-wait by a wide margin.
+		const S32 NUM_PACKETS = 200;
+		XferLinkSim stop_and_wait(getMessageSystem(), 1, NUM_PACKETS, 0.05, 0.f);
+		XferLinkSim windowed(getMessageSystem(), 16, NUM_PACKETS, 0.05, 0.f);
+		F64 slow = stop_and_wait.run();
+		F64 fast = windowed.run();
+
+		ensure("stop-and-wait finished", slow > 0.0);
+		ensure("windowed finished", fast > 0.0);
+		ensure("stop-and-wait received", stop_and_wait.receivedAll());
+		ensure("windowed received in order", windowed.receivedAll());
+		ensure_equals("nothing resent", windowed.mSender.getRetransmits(), 0U);
+		ensure("window is faster", fast * 4.0 < slow);
+	}
+
+	template<> template<>
+	void llxfer_object::test<6>()
+	{
+		// Same link with 5% loss each way.  Everything still arrives in
+		// order, resends stay close to what was actually lost, and the
+		// window still wins.
+		const S32 NUM_PACKETS = 200;
+		XferLinkSim stop_and_wait(getMessageSystem(), 1, NUM_PACKETS, 0.05, 0.05f);
+		XferLinkSim windowed(getMessageSystem(), 16, NUM_PACKETS, 0.05, 0.05f);
+		F64 slow = stop_and_wait.run();
+		F64 fast = windowed.run();
+
+		ensure("stop-and-wait finished", slow > 0.0);
+		ensure("windowed finished", fast > 0.0);
+		ensure("stop-and-wait received", stop_and_wait.receivedAll());
+		ensure("windowed received in order", windowed.receivedAll());
+		ensure("selective resend", windowed.mSender.getRetransmits() < (U32)(NUM_PACKETS / 4));
+		ensure("window is faster", fast * 2.0 < slow);
+	}
 }